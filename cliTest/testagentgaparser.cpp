@@ -0,0 +1,102 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../depthmapXcli/agentgaparser.h"
+#include "argumentholder.h"
+
+TEST_CASE("AgentGAParser", "Error cases")
+{
+    SECTION("Missing argument to -gagen")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gagen"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-gagen requires an argument"));
+    }
+
+    SECTION("Invalid mode")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gam", "foo", "-gagen", "10"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("Invalid AGENTGA mode: foo"));
+    }
+
+    SECTION("No generations")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gam", "length"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("Number of generations (-gagen <generations>) is required"));
+    }
+
+    SECTION("Rubbish input to -gagen")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gagen", "foo"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-gagen must be a number >0, got foo"));
+    }
+
+    SECTION("Zero timesteps")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gagen", "10", "-gats", "0"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-gats must be a number >0, got 0"));
+    }
+
+    SECTION("Population too small")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gagen", "10", "-gapop", "1"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-gapop must be at least 2, got 1"));
+    }
+
+    SECTION("Rubbish input to -gath")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gagen", "10", "-gath", "foo"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-gath must be a number >=0, got foo"));
+    }
+}
+
+TEST_CASE("AgentGAParserSuccess", "Read successfully")
+{
+    SECTION("Defaults")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gagen", "10"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getAgentMode() == AgentGAParser::LENGTH);
+        REQUIRE(parser.generations() == 10);
+        REQUIRE(parser.populationSize() == 500);
+        REQUIRE(parser.assays() == 3);
+        REQUIRE(parser.timesteps() == 1600);
+        REQUIRE(parser.randomSeed() == 0);
+        REQUIRE(parser.getNumThreads() == 1);
+    }
+
+    SECTION("All options")
+    {
+        AgentGAParser parser;
+        ArgumentHolder ah{"prog", "-gam", "comparative-optic-flow", "-gagen", "20", "-gapop", "50", "-gaassays", "5",
+                          "-gats", "800", "-gaseed", "7", "-gath", "0"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getAgentMode() == AgentGAParser::COMPARATIVE_OPTIC_FLOW);
+        REQUIRE(parser.generations() == 20);
+        REQUIRE(parser.populationSize() == 50);
+        REQUIRE(parser.assays() == 5);
+        REQUIRE(parser.timesteps() == 800);
+        REQUIRE(parser.randomSeed() == 7);
+        REQUIRE(parser.getNumThreads() == 0);
+    }
+}
@@ -157,6 +157,27 @@ TEST_CASE("AgentParserFail", "Parsing errors")
         REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("Invalid starting location seed provided (foo). Should only contain digits"));
     }
 
+    SECTION("Rubbish input to -aseed")
+    {
+        AgentParser parser;
+        ArgumentHolder ah{"prog", "-aseed", "foo"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-aseed must be a number >=0, got foo"));
+    }
+
+    SECTION("Rubbish input to -ath")
+    {
+        AgentParser parser;
+        ArgumentHolder ah{"prog", "-ath", "-1"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-ath must be a number >=0, got -1"));
+    }
+
+    SECTION("Rubbish input to -arep")
+    {
+        AgentParser parser;
+        ArgumentHolder ah{"prog", "-arep", "0"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-arep must be a number >0, got 0"));
+    }
+
     SECTION("Rubbish input to -aloc")
     {
         AgentParser parser;
@@ -371,6 +392,28 @@ TEST_CASE("AgentParserSuccess", "Read successfully")
         REQUIRE(parser.randomReleaseLocationSeed() == 1);
     }
 
+    SECTION("Random seed and threads")
+    {
+        ArgumentHolder ah{"prog", "-ats", ats.str(), "-arr", arr.str(), "-afov", afov.str(), "-asteps", asteps.str(), "-alife", alife.str(), "-alocseed", "0"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.randomSeed() == 0);
+        REQUIRE(parser.getNumThreads() == 1);
+
+        AgentParser otherParser;
+        ArgumentHolder otherAh{"prog", "-ats", ats.str(), "-arr", arr.str(), "-afov", afov.str(), "-asteps", asteps.str(), "-alife", alife.str(), "-alocseed", "0", "-aseed", "42", "-ath", "4"};
+        otherParser.parse(otherAh.argc(), otherAh.argv());
+        REQUIRE(otherParser.randomSeed() == 42);
+        REQUIRE(otherParser.getNumThreads() == 4);
+        REQUIRE(otherParser.replicates() == 1);
+    }
+
+    SECTION("Replicates")
+    {
+        ArgumentHolder ah{"prog", "-ats", ats.str(), "-arr", arr.str(), "-afov", afov.str(), "-asteps", asteps.str(), "-alife", alife.str(), "-alocseed", "0", "-arep", "20"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.replicates() == 20);
+    }
+
     SECTION("Read from commandline")
     {
         std::stringstream p1;
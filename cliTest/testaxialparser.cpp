@@ -33,6 +33,7 @@ TEST_CASE("Test mode and help")
                                 "   -xal Include local measures\n"\
                                 "   -xar Include RA, RRA and total depth\n"\
                                 "   -xaw <map attribute name> perform weighted analysis using this attribute\n"\
+                                "   -xth <threads> number of threads to use, 0 for all available cores (default 1)\n"\
                                 "\n");
 
 }
@@ -51,6 +52,12 @@ TEST_CASE("Test Parsing Exceptions","")
         ArgumentHolder ah{"prog", "-xl"};
         REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), "-xl requires an argument" );
     }
+
+    SECTION("Non-numeric thread count")
+    {
+        ArgumentHolder ah{"prog", "-xa", "n", "-xth", "all"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), "-xth must be a number >=0, got all" );
+    }
 }
 
 TEST_CASE("Test mode parsing", "")
@@ -88,6 +95,7 @@ TEST_CASE("Test mode parsing", "")
         REQUIRE_FALSE(parser.calculateRRA());
         REQUIRE_FALSE(parser.useChoice());
         REQUIRE_FALSE(parser.useLocal());
+        REQUIRE(parser.getNumThreads() == 1);
     }
     SECTION("Analysis -rra")
     {
@@ -125,6 +133,14 @@ TEST_CASE("Test mode parsing", "")
         REQUIRE_FALSE(parser.useChoice());
         REQUIRE(parser.useLocal());
     }
+    SECTION("Analysis with threads")
+    {
+        ArgumentHolder ah{"prog", "-xa", "n", "-xac", "-xth", "4"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.runAnalysis());
+        REQUIRE(parser.useChoice());
+        REQUIRE(parser.getNumThreads() == 4);
+    }
 
     SECTION("Multiple")
     {
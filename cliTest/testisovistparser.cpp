@@ -30,6 +30,12 @@ TEST_CASE("Isovistparser string constants")
                                 "    the relevant headers must be called x, y, angle and viewangle\n"\
                                 "    the latter two are optional.\n"\
                                 "  Those two arguments cannot be mixed\n"\
+                                "  -ib store the BSP tree of the drawing in the output graph, so that later\n"\
+                                "    isovists made from it do not have to make it again\n"\
+                                "  -io <csv|wkt> instead of adding the isovists to the graph, write their\n"\
+                                "    measures to the output file as csv, with wkt also the polygons as WKT.\n"\
+                                "    Isovist files are read a part at a time, so can be of any length\n"\
+                                "  -ith <threads> number of threads to use for -io, 0 for all available cores (default 1)\n"\
                                 "  Angles for partial isovists are in degrees, counted anti-clockwise with 0°\n"\
                                 "  pointing to the right.\n\n" );
 }
@@ -46,7 +52,55 @@ TEST_CASE("Parse isovist on the command line")
 
     REQUIRE(parser.getIsovists()[1].getLocation().y == Approx(5.0));
     REQUIRE(parser.getIsovists()[1].getViewAngle() == Approx(3.141592));
+    REQUIRE_FALSE(parser.storeBSPTree());
+}
+
+TEST_CASE("Parse storing the BSP tree")
+{
+    ArgumentHolder ah{"prog", "-ii", "1,2", "-ib"};
+    IsovistParser parser;
+    parser.parse(ah.argc(), ah.argv());
+
+    REQUIRE(parser.getIsovists().size() == 1);
+    REQUIRE(parser.storeBSPTree());
+}
+
+TEST_CASE("Parse streamed isovist output")
+{
+    SECTION("Isovists on the command line")
+    {
+        ArgumentHolder ah{"prog", "-ii", "1,2", "-io", "wkt", "-ith", "4"};
+        IsovistParser parser;
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getOutputFormat() == IsovistParser::OutputFormat::WKT);
+        REQUIRE(parser.getNumThreads() == 4);
+        REQUIRE(parser.getIsovists().size() == 1);
+        REQUIRE(parser.getIsovistFile().empty());
+    }
+
+    SECTION("Isovists from a file are read while running")
+    {
+        SelfCleaningFile scf("streamedisovists.csv");
+        {
+            std::ofstream file(scf.Filename());
+            file << "x,y\n1,1\n2,2\n" << std::flush;
+        }
+        ArgumentHolder ah{"prog", "-io", "csv", "-if", scf.Filename()};
+        IsovistParser parser;
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getOutputFormat() == IsovistParser::OutputFormat::CSV);
+        REQUIRE(parser.getNumThreads() == 1);
+        REQUIRE(parser.getIsovists().empty());
+        REQUIRE(parser.getIsovistFile() == scf.Filename());
+    }
 
+    SECTION("Default output to the graph")
+    {
+        ArgumentHolder ah{"prog", "-ii", "1,2"};
+        IsovistParser parser;
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getOutputFormat() == IsovistParser::OutputFormat::GRAPH);
+    }
 }
 
 
@@ -139,5 +193,29 @@ TEST_CASE("Command line failures")
         REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("No isovists defined. Use -ii or -if"));
     }
 
+    SECTION("Unknown output format")
+    {
+        ArgumentHolder ah{"prog", "-ii", "1,1", "-io", "shp"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("Invalid isovist output format: shp"));
+    }
+
+    SECTION("Using -io twice")
+    {
+        ArgumentHolder ah{"prog", "-ii", "1,1", "-io", "csv", "-io", "wkt"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-io can only be used once"));
+    }
+
+    SECTION("Non-numeric thread count")
+    {
+        ArgumentHolder ah{"prog", "-ii", "1,1", "-io", "csv", "-ith", "foo"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-ith must be a number >=0, got foo"));
+    }
+
+    SECTION("Storing the BSP tree without a graph")
+    {
+        ArgumentHolder ah{"prog", "-ii", "1,1", "-io", "csv", "-ib"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-ib cannot be used together with -io"));
+    }
+
 
 }
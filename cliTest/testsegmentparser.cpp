@@ -35,7 +35,9 @@ TEST_CASE("Test segment mode and help")
                                 "       angular\n"\
                                 "  -sic to include choice (only for Tulip)\n"\
                                 "  -stb <tulip bins> (4 to 1024, 1024 approximates full angular)\n"\
-                                "  -swa <map attribute name> perform weighted analysis using this attribute (only for Tulip)\n");
+                                "  -swa <map attribute name> perform weighted analysis using this attribute (only for Tulip)\n"\
+                                "  -sth <threads> number of threads to use (only for Tulip, topological and metric), 0 for all available cores\n"\
+                                "       (default 1)\n");
 
 }
 
@@ -131,6 +133,18 @@ TEST_CASE("Test Segment Parsing Exceptions","")
         ArgumentHolder ah{"prog", "-st", "tulip", "-sr", "n", "-srt", "steps", "-stb", "1025"};
         REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), "-stb must be a number between 4 and 1024, got 1025" );
     }
+
+    SECTION("Non-numeric thread count")
+    {
+        ArgumentHolder ah{"prog", "-st", "tulip", "-sr", "n", "-srt", "steps", "-stb", "1024", "-sth", "all"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), "-sth must be a number >=0, got all" );
+    }
+
+    SECTION("Thread count for full angular analysis")
+    {
+        ArgumentHolder ah{"prog", "-st", "angular", "-sr", "n", "-sth", "4"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), "-sth can not be used with full angular analysis" );
+    }
 }
 
 TEST_CASE("Test segment mode parsing", "")
@@ -180,5 +194,19 @@ TEST_CASE("Test segment mode parsing", "")
         REQUIRE(parser.getRadii().size() == 1);
         REQUIRE(int(parser.getRadii()[0]) == -1);
     }
+    SECTION("Analysis Tulip with threads")
+    {
+        ArgumentHolder ah{"prog", "-st", "tulip", "-sr", "n", "-srt", "steps", "-stb", "1024", "-sth", "0"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getAnalysisType() == SegmentParser::AnalysisType::ANGULAR_TULIP);
+        REQUIRE(parser.getNumThreads() == 0);
+    }
+    SECTION("Analysis Metric with threads")
+    {
+        ArgumentHolder ah{"prog", "-st", "metric", "-sr", "n,500", "-sth", "4"};
+        parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getAnalysisType() == SegmentParser::AnalysisType::METRIC);
+        REQUIRE(parser.getNumThreads() == 4);
+    }
 
 }
@@ -62,6 +62,12 @@ TEST_CASE("VGA args invalid", "")
         VgaParser p;
         REQUIRE_THROWS_WITH(p.parse(ah.argc(), ah.argv()), Catch::Contains("Metric vga requires a radius, use -vr <radius>"));
     }
+
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "VGA", "-vm", "visibility", "-vg", "-vr", "n", "-vth", "foo"};
+        VgaParser p;
+        REQUIRE_THROWS_WITH(p.parse(ah.argc(), ah.argv()), Catch::Contains("-vth must be a number >=0, got foo"));
+    }
 }
 
 TEST_CASE("VGA args valid", "valid")
@@ -98,6 +104,23 @@ TEST_CASE("VGA args valid", "valid")
         REQUIRE(cmdP.globalMeasures());
         REQUIRE(cmdP.localMeasures());
         REQUIRE(cmdP.getRadius() == "4");
+        REQUIRE(cmdP.getNumThreads() == 1);
+    }
+
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "VGA", "-vm", "visibility", "-vg", "-vr", "n", "-vth", "4"};
+        VgaParser cmdP;
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.globalMeasures());
+        REQUIRE(cmdP.getNumThreads() == 4);
+    }
+
+    {
+        ArgumentHolder ah{"prog", "-f", "infile", "-o", "outfile", "-m", "VGA", "-vm", "isovist", "-vth", "0"};
+        VgaParser cmdP;
+        cmdP.parse(ah.argc(), ah.argv());
+        REQUIRE(cmdP.getVgaMode() == VgaParser::VgaMode::ISOVIST);
+        REQUIRE(cmdP.getNumThreads() == 0);
     }
 
     {
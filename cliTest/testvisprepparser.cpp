@@ -149,6 +149,13 @@ TEST_CASE("VisPrepParserFail", "Error cases")
         ArgumentHolder ah{"prog", "-pg", "1", "-pu"};
         REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-pu can not be used with any other option apart from -pl"));
     }
+
+    SECTION("Non-numeric thread count")
+    {
+        VisPrepParser parser;
+        ArgumentHolder ah{"prog", "-pm", "-pth", "foo"};
+        REQUIRE_THROWS_WITH(parser.parse(ah.argc(), ah.argv()), Catch::Contains("-pth must be a number >=0, got foo"));
+    }
 }
 
 TEST_CASE("VisprepParserMakeSuccess", "Read successfully - Make")
@@ -169,8 +176,10 @@ TEST_CASE("VisprepParserMakeSuccess", "Read successfully - Make")
         std::stringstream p2;
         p2 << x2 << "," << y2 << std::flush;
 
-        ArgumentHolder ah{"prog", "-pg", gstring.str(), "-pp", p1.str(), "-pp", p2.str(), "-pb", "-pr", "2.1", "-pm"};
+        ArgumentHolder ah{"prog", "-pg", gstring.str(), "-pp", p1.str(), "-pp", p2.str(), "-pb", "-pr", "2.1", "-pm",
+                          "-pth", "4"};
         parser.parse(ah.argc(), ah.argv());
+        REQUIRE(parser.getNumThreads() == 4);
         REQUIRE(parser.getBoundaryGraph());
         REQUIRE(parser.getMakeGraph());
         REQUIRE_FALSE(parser.getUnmakeGraph());
@@ -188,6 +197,7 @@ TEST_CASE("VisprepParserMakeSuccess", "Read successfully - Make")
         }
         ArgumentHolder ah{"prog", "-pg", gstring.str(), "-pf", scf.Filename()};
         parser.parse(ah.argc(), ah.argv() );
+        REQUIRE(parser.getNumThreads() == 1);
         REQUIRE_FALSE(parser.getBoundaryGraph());
         REQUIRE_FALSE(parser.getMakeGraph());
         REQUIRE_FALSE(parser.getUnmakeGraph());
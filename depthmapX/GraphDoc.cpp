@@ -1700,6 +1700,29 @@ void QGraphDoc::OnToolsMakeGraph()
    m_thread.render(this);
 }
 
+void QGraphDoc::OnLineLayerShown(int file, int layer, bool show)
+{
+   if (m_communicator) {
+      QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"), QMessageBox::Ok, QMessageBox::Ok);
+      return;
+   }
+   if (!m_meta_graph->viewingProcessedPoints()) {
+      // no graph to remake, so the layer is just shown or hidden
+      m_meta_graph->setLineLayerShown(NULL, file, layer, show, m_make_maxdist);
+      SetRedrawFlag(VIEW_ALL, REDRAW_GRAPH, NEW_LINESET );
+      return;
+   }
+
+   m_communicator = new CMSCommunicator();
+   CreateWaitDialog(tr("Regenerating graph..."));
+   m_communicator->SetFunction( CMSCommunicator::REGENERATEGRAPH );
+   m_communicator->SetOption( file, 0 );
+   m_communicator->SetOption( layer, 1 );
+   m_communicator->SetOption( show ? 1 : 0, 2 );
+
+   m_thread.render(this);
+}
+
 void QGraphDoc::OnToolsUnmakeGraph()
 {
     int state = m_meta_graph->getState();
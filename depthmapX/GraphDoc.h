@@ -76,7 +76,7 @@ class QGraphDoc; // forward declaration required by CMSCommunicator::run(QGraphD
 class CMSCommunicator : public Communicator
 {
 public:
-   enum { IMPORT, IMPORTMIF, MAKEPOINTS, MAKEGRAPH, ANALYSEGRAPH,
+   enum { IMPORT, IMPORTMIF, MAKEPOINTS, MAKEGRAPH, REGENERATEGRAPH, ANALYSEGRAPH,
           POINTDEPTH, METRICPOINTDEPTH, ANGULARPOINTDEPTH, TOPOLOGICALPOINTDEPTH,
           MAKEISOVIST, MAKEISOVISTPATH, MAKEISOVISTSFROMFILE,
           MAKEALLLINEMAP, MAKEFEWESTLINEMAP, MAKEDRAWING,
@@ -278,6 +278,7 @@ public:
    void OnFillPoints(const Point2f& p, int fill_type = 0 );
    void OnMakeIsovist(const Point2f& seed, double angle = -1.0);
    void OnToolsAxialMap( const Point2f& seed );
+   void OnLineLayerShown(int file, int layer, bool show);
    int RenameColumn(AttributeTable *tab, int col);
    bool ReplaceColumnContents(PointMap* pointmap, ShapeMap *shapemap, int col);
    bool SelectByQuery(PointMap* pointmap, ShapeMap *shapemap);
@@ -1422,18 +1422,12 @@ void MainWindow::OnSelchangingTree(QTreeWidgetItem* hItem, int col)
         if (iter != m_treedrawingmap.end()) {
             ItemTreeEntry entry = iter->second;
             if (entry.m_subcat != -1) {
-                if (graph->getLineLayer(entry.m_cat,entry.m_subcat).isShown()) {
-                    graph->getLineLayer(entry.m_cat,entry.m_subcat).setShow(false);
-                    graph->redoPointMapBlockLines();
-                    graph->resetBSPtree();
-                }
-                else {
-                    graph->getLineLayer(entry.m_cat,entry.m_subcat).setShow(true);
-                    graph->redoPointMapBlockLines();
-                    graph->resetBSPtree();
-                }
+                bool show = !graph->getLineLayer(entry.m_cat,entry.m_subcat).isShown();
+                m_treeDoc->OnLineLayerShown(entry.m_cat, entry.m_subcat, show);
+            }
+            else {
+                m_treeDoc->SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_LINESET );
             }
-            m_treeDoc->SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_LINESET );
         }
     }
 }
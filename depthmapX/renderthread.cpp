@@ -152,6 +152,15 @@ void RenderThread::run()
          pDoc->SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA );
          break;
 
+      case CMSCommunicator::REGENERATEGRAPH:
+         // the graph is made again only where the lines of the layer change what can be seen, with the
+         // visibility restriction last used to make a graph
+         pDoc->m_meta_graph->setLineLayerShown( comm, comm->GetOption(0), comm->GetOption(1), comm->GetOption(2) != 0,
+                                                pDoc->m_make_maxdist );
+         pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
+         pDoc->SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_LINESET );
+         break;
+
       case CMSCommunicator::ANALYSEGRAPH:
          ok = pDoc->m_meta_graph->analyseGraph( comm, pMain->m_options, comm->simple_version);
          pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
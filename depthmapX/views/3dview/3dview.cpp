@@ -195,7 +195,8 @@ void Q3DView::timerEvent(QTimerEvent *event) {
                     }
                 } else {
                     int j = m_mannequins[i].m_agent_id;
-                    m_agents[j].onMove();
+                    AgentCounts counts; // n.b. the agents here do not count anything
+                    m_agents[j].onMove(counts);
                     Point2f p = m_agents[j].getLocation();
                     p.normalScale(m_region);
                     m_mannequins[i].advance(p);
@@ -692,12 +693,15 @@ void Q3DView::CreateAgent(QPoint point) {
             p.denormalScale(m_region);
             PixelRef pix = pointmap.pixelate(p);
             if (pointmap.getPoint(pix).filled()) {
-                m_agents.push_back(Agent(&m_agent_program, &pointmap));
+                // every agent needs a random stream of its own:
+                m_agents.push_back(
+                    Agent(&m_agent_program, &pointmap, Agent::OUTPUT_NOTHING, PafRandomStream(pafrand(), m_agents.size())));
                 m_agents.back().onInit(pix);
                 Point2f p2 = m_agents.back().getLocation();
                 p2.normalScale(m_region);
                 m_mannequins.push_back(QMannequin(p2, m_agents.size() - 1));
-                m_agents.back().onMove();
+                AgentCounts counts;
+                m_agents.back().onMove(counts);
                 p2 = m_agents.back().getLocation();
                 p2.normalScale(m_region);
                 m_mannequins.back().advance(p2);
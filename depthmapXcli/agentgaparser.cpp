@@ -0,0 +1,116 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "agentgaparser.h"
+#include "exceptions.h"
+#include "parsingutils.h"
+#include "runmethods.h"
+#include <cstring>
+
+using namespace depthmapX;
+
+namespace {
+    int parsePositive(const char *option, const char *value)
+    {
+        if (!has_only_digits(value) || std::atoi(value) <= 0)
+        {
+            throw CommandLineException(std::string(option) + " must be a number >0, got " + value);
+        }
+        return std::atoi(value);
+    }
+}
+
+void AgentGAParser::parse(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-gam") == 0)
+        {
+            ENFORCE_ARGUMENT("-gam", i)
+            if (std::strcmp(argv[i], "length") == 0)
+            {
+                m_agentMode = AgentMode::LENGTH;
+            }
+            else if (std::strcmp(argv[i], "optic-flow") == 0)
+            {
+                m_agentMode = AgentMode::OPTIC_FLOW;
+            }
+            else if (std::strcmp(argv[i], "comparative-length") == 0)
+            {
+                m_agentMode = AgentMode::COMPARATIVE_LENGTH;
+            }
+            else if (std::strcmp(argv[i], "comparative-optic-flow") == 0)
+            {
+                m_agentMode = AgentMode::COMPARATIVE_OPTIC_FLOW;
+            }
+            else
+            {
+                throw CommandLineException(std::string("Invalid AGENTGA mode: ") + argv[i]);
+            }
+        }
+        else if (std::strcmp(argv[i], "-gagen") == 0)
+        {
+            ENFORCE_ARGUMENT("-gagen", i)
+            m_generations = parsePositive("-gagen", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "-gapop") == 0)
+        {
+            ENFORCE_ARGUMENT("-gapop", i)
+            m_populationSize = parsePositive("-gapop", argv[i]);
+            if (m_populationSize < 2)
+            {
+                throw CommandLineException(std::string("-gapop must be at least 2, got ") + argv[i]);
+            }
+        }
+        else if (std::strcmp(argv[i], "-gaassays") == 0)
+        {
+            ENFORCE_ARGUMENT("-gaassays", i)
+            m_assays = parsePositive("-gaassays", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "-gats") == 0)
+        {
+            ENFORCE_ARGUMENT("-gats", i)
+            m_timesteps = parsePositive("-gats", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "-gaseed") == 0)
+        {
+            ENFORCE_ARGUMENT("-gaseed", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-gaseed must be a number >=0, got ") + argv[i]);
+            }
+            m_randomSeed = static_cast<unsigned int>(std::strtoul(argv[i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "-gath") == 0)
+        {
+            ENFORCE_ARGUMENT("-gath", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-gath must be a number >=0, got ") + argv[i]);
+            }
+            m_numThreads = std::atoi(argv[i]);
+        }
+    }
+
+    if (m_generations == 0)
+    {
+        throw CommandLineException("Number of generations (-gagen <generations>) is required");
+    }
+}
+
+void AgentGAParser::run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const
+{
+    dm_runmethods::runAgentGA(clp, *this, perfWriter);
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "imodeparser.h"
+#include "commandlineparser.h"
+#include <string>
+
+class AgentGAParser : public IModeParser
+{
+public:
+    virtual std::string getModeName() const
+    {
+        return "AGENTGA";
+    }
+
+    virtual std::string getHelp() const
+    {
+        return "Mode options for AGENTGA (evolve the rules of Gibsonian agents, and write the fittest program to\n"\
+               "the output file):\n"\
+               "-gam <agent mode> one of:\n"\
+               "    length (Gibsonian length, default)\n"\
+               "    optic-flow (Gibsonian optic flow)\n"\
+               "    comparative-length (Gibsonian comparative length)\n"\
+               "    comparative-optic-flow (Gibsonian comparative optic flow)\n"\
+               "-gagen <generations> number of generations to evolve\n"\
+               "-gapop <population> number of programs in the population (default 500)\n"\
+               "-gaassays <assays> number of agents to evaluate each program with (default 3)\n"\
+               "-gats <timesteps> number of timesteps each of these agents moves for (default 1600)\n"\
+               "-gaseed <seed> seed for the random numbers (default 0), the same seed gives the same results\n"\
+               "-gath <threads> number of threads to use, 0 for all available cores (default 1)\n";
+    }
+
+public:
+    virtual void parse(int argc, char *argv[]);
+    virtual void run(const CommandLineParser &clp, IPerformanceSink& perfWriter) const;
+
+    enum AgentMode{
+        LENGTH,
+        OPTIC_FLOW,
+        COMPARATIVE_LENGTH,
+        COMPARATIVE_OPTIC_FLOW
+    };
+
+    AgentMode getAgentMode() const { return m_agentMode; }
+    int generations() const { return m_generations; }
+    int populationSize() const { return m_populationSize; }
+    int assays() const { return m_assays; }
+    int timesteps() const { return m_timesteps; }
+    unsigned int randomSeed() const { return m_randomSeed; }
+    int getNumThreads() const { return m_numThreads; }
+
+private:
+    AgentMode m_agentMode = AgentMode::LENGTH;
+    int m_generations = 0;
+    int m_populationSize = 500;
+    int m_assays = 3;
+    int m_timesteps = 1600;
+    unsigned int m_randomSeed = 0;
+    int m_numThreads = 1;
+};
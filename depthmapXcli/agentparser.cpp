@@ -254,6 +254,37 @@ void AgentParser::parse(int argc, char *argv[])
             }
             points.push_back(argv[i]);
         }
+        else if (std::strcmp(argv[i], "-aseed") == 0)
+        {
+            ENFORCE_ARGUMENT("-aseed", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-aseed must be a number >=0, got ") + argv[i]);
+            }
+            m_randomSeed = static_cast<unsigned int>(std::strtoul(argv[i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "-ath") == 0)
+        {
+            ENFORCE_ARGUMENT("-ath", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-ath must be a number >=0, got ") + argv[i]);
+            }
+            m_numThreads = std::atoi(argv[i]);
+        }
+        else if (std::strcmp(argv[i], "-arep") == 0)
+        {
+            ENFORCE_ARGUMENT("-arep", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-arep must be a number >0, got ") + argv[i]);
+            }
+            m_replicates = std::atoi(argv[i]);
+            if (m_replicates <= 0)
+            {
+                throw CommandLineException(std::string("-arep must be a number >0, got ") + argv[i]);
+            }
+        }
         else if (std::strcmp(argv[i], "-ot") == 0)
         {
             ENFORCE_ARGUMENT("-ot", i)
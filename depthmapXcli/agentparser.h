@@ -54,6 +54,11 @@ public:
                   "-alocfile <agent starting points file>\n"\
                   "-aloc <single agent starting point coordinates> provided in csv (x1,y1) "\
                   "for example \"0.1,0.2\". Provide multiple times for multiple links\n"\
+                  "-aseed <seed> seed for the random numbers of the agents (default 0), the same seed gives "\
+                  "the same results\n"\
+                  "-ath <threads> number of threads to use, 0 for all available cores (default 1)\n"\
+                  "-arep <replicates> run the agents this many times, with seeds counting up from the -aseed one, "\
+                  "and output the counts of each run with their mean and variance (default 1)\n"\
                   "-ot <output type> available output types (may use more than one):"\
                   "    graph (graph file, default)"\
                   "    gatecounts (csv with cells of grid with gate counts)"\
@@ -93,6 +98,9 @@ public:
     double releaseRate() const { return m_releaseRate; }
     int recordTrailsForAgents() const { return m_recordTrailsForAgents; }
     int randomReleaseLocationSeed() const { return m_randomReleaseLocationSeed; }
+    unsigned int randomSeed() const { return m_randomSeed; }
+    int getNumThreads() const { return m_numThreads; }
+    int replicates() const { return m_replicates; }
 
     int agentFOV() const { return m_agentFOV; }
     int agentStepsBeforeTurnDecision() const { return m_agentStepsBeforeTurnDecision; }
@@ -117,6 +125,10 @@ private:
     int m_randomReleaseLocationSeed = -1;
     std::vector<Point2f> m_releasePoints;
 
+    unsigned int m_randomSeed = 0;
+    int m_numThreads = 1;
+    int m_replicates = 1;
+
     std::vector<OutputType> m_outputTypes;
 };
 
@@ -23,7 +23,7 @@
 
 using namespace depthmapX;
 
-AxialParser::AxialParser() :  m_runFewestLines(false), m_runAnalysis(false), m_choice(false), m_local(false), m_rra(false)
+AxialParser::AxialParser() :  m_runFewestLines(false), m_runAnalysis(false), m_choice(false), m_local(false), m_rra(false), m_numThreads(1)
 {
 
 }
@@ -47,6 +47,7 @@ std::string AxialParser::getHelp() const
             "   -xal Include local measures\n"\
             "   -xar Include RA, RRA and total depth\n"\
             "   -xaw <map attribute name> perform weighted analysis using this attribute\n"\
+            "   -xth <threads> number of threads to use, 0 for all available cores (default 1)\n"\
             "\n";
 }
 
@@ -90,6 +91,15 @@ void AxialParser::parse(int argc, char **argv)
             ENFORCE_ARGUMENT("-xaw", i)
             m_attribute = argv[i];
         }
+        else if (std::strcmp(argv[i], "-xth") == 0)
+        {
+            ENFORCE_ARGUMENT("-xth", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-xth must be a number >=0, got ") + argv[i]);
+            }
+            m_numThreads = std::atoi(argv[i]);
+        }
     }
 
     if (!runAllLines() && !runFewestLines() && !runUnlink() && !runAnalysis())
@@ -18,11 +18,12 @@
 #include "salalib/entityparsing.h"
 #include <sstream>
 #include "runmethods.h"
+#include "parsingutils.h"
 #include <cstring>
 
 using namespace depthmapX;
 
-IsovistParser::IsovistParser()
+IsovistParser::IsovistParser() : m_storeBSPTree(false), m_outputFormat(OutputFormat::GRAPH), m_numThreads(1)
 {
 
 }
@@ -42,6 +43,12 @@ std::string IsovistParser::getHelp() const
            "    the relevant headers must be called x, y, angle and viewangle\n"\
            "    the latter two are optional.\n"\
            "  Those two arguments cannot be mixed\n"\
+           "  -ib store the BSP tree of the drawing in the output graph, so that later\n"\
+           "    isovists made from it do not have to make it again\n"\
+           "  -io <csv|wkt> instead of adding the isovists to the graph, write their\n"\
+           "    measures to the output file as csv, with wkt also the polygons as WKT.\n"\
+           "    Isovist files are read a part at a time, so can be of any length\n"\
+           "  -ith <threads> number of threads to use for -io, 0 for all available cores (default 1)\n"\
            "  Angles for partial isovists are in degrees, counted anti-clockwise with 0°\n"\
            "  pointing to the right.\n\n";
 }
@@ -49,6 +56,7 @@ std::string IsovistParser::getHelp() const
 void IsovistParser::parse(int argc, char **argv)
 {
     std::string isovistFile;
+    bool outputFormatSet = false;
 
     for( int i = 1; i < argc; ++i)
     {
@@ -74,6 +82,40 @@ void IsovistParser::parse(int argc, char **argv)
             ENFORCE_ARGUMENT("-if",i);
             isovistFile = argv[i];
         }
+        else if (std::strcmp(argv[i], "-ib") == 0)
+        {
+            m_storeBSPTree = true;
+        }
+        else if (std::strcmp(argv[i], "-io") == 0)
+        {
+            if (outputFormatSet)
+            {
+                throw CommandLineException("-io can only be used once");
+            }
+            ENFORCE_ARGUMENT("-io", i);
+            if (std::strcmp(argv[i], "csv") == 0)
+            {
+                m_outputFormat = OutputFormat::CSV;
+            }
+            else if (std::strcmp(argv[i], "wkt") == 0)
+            {
+                m_outputFormat = OutputFormat::WKT;
+            }
+            else
+            {
+                throw CommandLineException(std::string("Invalid isovist output format: ") + argv[i]);
+            }
+            outputFormatSet = true;
+        }
+        else if (std::strcmp(argv[i], "-ith") == 0)
+        {
+            ENFORCE_ARGUMENT("-ith", i);
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-ith must be a number >=0, got ") + argv[i]);
+            }
+            m_numThreads = std::atoi(argv[i]);
+        }
     }
 
     if (!isovistFile.empty())
@@ -85,16 +127,37 @@ void IsovistParser::parse(int argc, char **argv)
             message << "Failed to find file " << isovistFile;
             throw depthmapX::CommandLineException(message.str());
         }
-        m_isovists = EntityParsing::parseIsovists(file, ',');
+        if (m_outputFormat == OutputFormat::GRAPH)
+        {
+            m_isovists = EntityParsing::parseIsovists(file, ',');
+        }
+        else
+        {
+            // check the header now, the isovists are read when running
+            EntityParsing::IsovistReader reader(file, ',');
+            m_isovistFile = isovistFile;
+        }
     }
-    if (m_isovists.empty())
+    if (m_isovists.empty() && m_isovistFile.empty())
     {
         throw CommandLineException("No isovists defined. Use -ii or -if");
     }
+    if (m_storeBSPTree && m_outputFormat != OutputFormat::GRAPH)
+    {
+        throw CommandLineException("-ib cannot be used together with -io, no graph is written");
+    }
 
 }
 
 void IsovistParser::run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const
 {
-    dm_runmethods::runIsovists(clp, m_isovists, perfWriter);
+    if (m_outputFormat == OutputFormat::GRAPH)
+    {
+        dm_runmethods::runIsovists(clp, m_isovists, m_storeBSPTree, perfWriter);
+    }
+    else
+    {
+        dm_runmethods::runIsovistBatch(clp, m_isovists, m_isovistFile, m_outputFormat == OutputFormat::WKT,
+                                       m_numThreads, perfWriter);
+    }
 }
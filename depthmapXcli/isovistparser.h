@@ -31,7 +31,18 @@ public:
     void parse(int argc, char **argv);
     void run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const;
 
+    enum class OutputFormat { GRAPH, CSV, WKT };
+
+    // with -if and streamed output the isovists are read from the file while running, and this is empty
     const std::vector<IsovistDefinition> &getIsovists() const{ return m_isovists;}
+    const std::string &getIsovistFile() const { return m_isovistFile; }
+    bool storeBSPTree() const { return m_storeBSPTree; }
+    OutputFormat getOutputFormat() const { return m_outputFormat; }
+    int getNumThreads() const { return m_numThreads; }
 private:
     std::vector<IsovistDefinition> m_isovists;
+    std::string m_isovistFile;
+    bool m_storeBSPTree;
+    OutputFormat m_outputFormat;
+    int m_numThreads;
 };
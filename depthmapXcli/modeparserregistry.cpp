@@ -21,6 +21,7 @@
 #include "axialparser.h"
 #include "segmentparser.h"
 #include "agentparser.h"
+#include "agentgaparser.h"
 #include "isovistparser.h"
 #include "exportparser.h"
 #include "stepdepthparser.h"
@@ -37,6 +38,7 @@ void ModeParserRegistry::populateParsers()
     REGISTER_PARSER(AxialParser);
     REGISTER_PARSER(SegmentParser);
     REGISTER_PARSER(AgentParser);
+    REGISTER_PARSER(AgentGAParser);
     REGISTER_PARSER(IsovistParser);
     REGISTER_PARSER(ExportParser);
     REGISTER_PARSER(ImportParser);
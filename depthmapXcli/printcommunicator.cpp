@@ -26,12 +26,20 @@ void PrintCommunicator::CommPostMessage(int m, int x) const {
         break;
     case Communicator::NUM_RECORDS:
         num_records = x;
+        m_recordsStart = std::chrono::steady_clock::now();
         break;
     case Communicator::CURRENT_RECORD:
         record = x;
         if (record > num_records) record = num_records;
         std::cout << "step: " << step << "/" << num_steps << " "
-                  << "record: " << record << "/" << num_records << std::endl;
+                  << "record: " << record << "/" << num_records;
+        if (record > 0 && record < num_records) {
+            // assuming the records left take as long as those done so far
+            double elapsed =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - m_recordsStart).count();
+            std::cout << " eta: " << static_cast<long>(elapsed * (num_records - record) / record + 0.5) << "s";
+        }
+        std::cout << std::endl;
         break;
     default:
         break;
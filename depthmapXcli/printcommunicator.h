@@ -17,6 +17,8 @@
 
 #include "genlib/comm.h"
 
+#include <chrono>
+
 class PrintCommunicator : public ICommunicator {
   public:
     PrintCommunicator() {
@@ -27,4 +29,8 @@ class PrintCommunicator : public ICommunicator {
     }
     virtual ~PrintCommunicator() {}
     virtual void CommPostMessage(int m, int x) const;
+
+  private:
+    // when the current count of records started, to estimate the time left
+    mutable std::chrono::steady_clock::time_point m_recordsStart;
 };
@@ -25,13 +25,17 @@
 #include <sstream>
 #include <vector>
 #include "salalib/entityparsing.h"
+#include "salalib/isovist.h"
+#include "salalib/agents/agentga.h"
+#include "genlib/parallel.h"
 #include <salalib/gridproperties.h>
 #include <salalib/importutils.h>
 
 namespace dm_runmethods
 {
-    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter) {
+    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter, int numThreads) {
         std::unique_ptr<MetaGraph> mgraph(new MetaGraph);
+        mgraph->setNumThreads(numThreads);
         std::cout << "Loading graph " << filename << std::flush;
         DO_TIMED( "Load graph file", auto result = mgraph->readFromFile(filename);)
         if ( result != MetaGraph::OK)
@@ -226,7 +230,7 @@ namespace dm_runmethods
 
     void runVga(const CommandLineParser &cmdP, const VgaParser &vgaP, const IRadiusConverter &converter, IPerformanceSink &perfWriter)
     {
-        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter);
+        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter, vgaP.getNumThreads());
 
         std::unique_ptr<Options> options(new Options());
 
@@ -241,6 +245,7 @@ namespace dm_runmethods
                 {
                     options->radius = converter.ConvertForVisibility(vgaP.getRadius());
                 }
+                options->num_threads = vgaP.getNumThreads();
                 break;
             case VgaParser::VgaMode::METRIC:
                 options->output_type = Options::OUTPUT_METRIC;
@@ -251,6 +256,7 @@ namespace dm_runmethods
                 break;
             case VgaParser::VgaMode::ISOVIST:
                 options->output_type = Options::OUTPUT_ISOVIST;
+                options->num_threads = vgaP.getNumThreads();
                 break;
             case VgaParser::VgaMode::THRU_VISION:
                 options->output_type = Options::OUTPUT_THRU_VISION;
@@ -284,9 +290,10 @@ namespace dm_runmethods
             bool makeGraph,
             bool unmakeGraph,
             bool removeLinksWhenUnmaking,
+            int numThreads,
             IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(),perfWriter);
+        auto mGraph = loadGraph(clp.getFileName().c_str(),perfWriter, numThreads);
 
         std::cout << "Initial checks... " << std::flush;
         auto state = mGraph->getState();
@@ -331,7 +338,7 @@ namespace dm_runmethods
             }
             if(makeGraph) {
                 std::cout << "ok\nMaking graph... " << std::flush;
-                DO_TIMED("Making graph", mGraph->makeGraph(getCommunicator(clp).get(), boundaryGraph ? 1 : 0, maxVisibility))
+                DO_TIMED("Making graph", mGraph->makeGraph(getCommunicator(clp).get(), boundaryGraph ? 1 : 0, maxVisibility, numThreads))
             }
         }
 
@@ -342,7 +349,7 @@ namespace dm_runmethods
 
     void runAxialAnalysis(const CommandLineParser &clp, const AxialParser &ap, IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(), perfWriter);
+        auto mGraph = loadGraph(clp.getFileName().c_str(), perfWriter, ap.getNumThreads());
 
         auto state = mGraph->getState();
         if ( ap.runAllLines())
@@ -381,6 +388,7 @@ namespace dm_runmethods
             options.choice = ap.useChoice();
             options.local = ap.useLocal();
             options.fulloutput = ap.calculateRRA();
+            options.num_threads = ap.getNumThreads();
             options.weighted_measure_col = -1;
 
             if(!ap.getAttribute().empty()) {
@@ -408,7 +416,7 @@ namespace dm_runmethods
 
     void runSegmentAnalysis(const CommandLineParser &clp, const SegmentParser &sp, IPerformanceSink &perfWriter)
     {
-        auto mGraph = loadGraph(clp.getFileName().c_str(), perfWriter);
+        auto mGraph = loadGraph(clp.getFileName().c_str(), perfWriter, sp.getNumThreads());
 
         auto state = mGraph->getState();
 
@@ -418,6 +426,7 @@ namespace dm_runmethods
         options.radius_set.insert(radii.begin(), radii.end());
         options.choice = sp.includeChoice();
         options.tulip_bins = sp.getTulipBins();
+        options.num_threads = sp.getNumThreads();
         options.weighted_measure_col = -1;
 
         if(!sp.getAttribute().empty()) {
@@ -482,7 +491,7 @@ namespace dm_runmethods
 
     void runAgentAnalysis(const CommandLineParser &cmdP, const AgentParser &agentP, IPerformanceSink &perfWriter) {
 
-        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter);
+        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter, agentP.getNumThreads());
 
         PointMap& currentMap = mgraph->getDisplayedPointMap();
 
@@ -540,6 +549,10 @@ namespace dm_runmethods
                 break;
         }
 
+        eng.m_random_seed = agentP.randomSeed();
+        eng.m_num_threads = agentP.getNumThreads();
+        eng.m_replicates = agentP.replicates();
+
         // if the m_release_locations is not set the locations are
         // set later by picking random pixels
         if(agentP.randomReleaseLocationSeed() >= 0) {
@@ -632,9 +645,50 @@ namespace dm_runmethods
         }
     }
 
-    void runIsovists(const CommandLineParser &clp, const std::vector<IsovistDefinition> &isovists, IPerformanceSink &perfWriter)
+    void runAgentGA(const CommandLineParser &cmdP, const AgentGAParser &gaP, IPerformanceSink &perfWriter) {
+
+        auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter, gaP.getNumThreads());
+
+        PointMap& currentMap = mgraph->getDisplayedPointMap();
+
+        AgentProgram program;
+        switch(gaP.getAgentMode()) {
+            case AgentGAParser::LENGTH:
+                program.m_sel_type = AgentProgram::SEL_LENGTH;
+                break;
+            case AgentGAParser::OPTIC_FLOW:
+                program.m_sel_type = AgentProgram::SEL_OPTIC_FLOW;
+                break;
+            case AgentGAParser::COMPARATIVE_LENGTH:
+                program.m_sel_type = AgentProgram::SEL_COMPARATIVE_LENGTH;
+                break;
+            case AgentGAParser::COMPARATIVE_OPTIC_FLOW:
+                program.m_sel_type = AgentProgram::SEL_COMPARATIVE_OPTIC_FLOW;
+                break;
+        }
+
+        ProgramPopulation population(gaP.populationSize());
+        population.m_assays = gaP.assays();
+        population.m_timesteps = gaP.timesteps();
+        population.m_random_seed = gaP.randomSeed();
+        population.m_num_threads = gaP.getNumThreads();
+        population.init(program);
+
+        std::cout << "ok\nEvolving agent programs... " << std::flush;
+        DO_TIMED("Evolving agent programs", population.evolve(getCommunicator(cmdP).get(), currentMap, gaP.generations()))
+        std::cout << " ok\nFittest program: " << population.m_population[0].m_fitness << std::endl;
+        std::cout << "Writing out result..." << std::flush;
+        DO_TIMED("Writing program", population.m_population[0].save(cmdP.getOuputFile()))
+        std::cout << " ok" << std::endl;
+    }
+
+    void runIsovists(const CommandLineParser &clp, const std::vector<IsovistDefinition> &isovists, bool storeBSPTree, IPerformanceSink &perfWriter)
     {
         auto mGraph = loadGraph(clp.getFileName().c_str(),perfWriter);
+        if (storeBSPTree) {
+            // a graph read with a tree in it keeps storing it anyway
+            mGraph->setStoreBSPtree(true);
+        }
 
         std::cout << "Making " << isovists.size() << " isovists... "  << std::flush;
         DO_TIMED("Make isovists", std::for_each(isovists.begin(), isovists.end(),
@@ -646,6 +700,136 @@ namespace dm_runmethods
         std::cout << " ok" << std::endl;
     }
 
+    void runIsovistBatch(const CommandLineParser &clp, const std::vector<IsovistDefinition> &isovists, const std::string &isovistFile, bool writePolygons, int numThreads, IPerformanceSink &perfWriter)
+    {
+        auto mGraph = loadGraph(clp.getFileName().c_str(),perfWriter, numThreads);
+
+        // made before the threads start, after which making isovists only reads it
+        std::cout << "Making BSP tree... " << std::flush;
+        DO_TIMED("Make BSP tree", bool treeMade = mGraph->makeBSPtree(getCommunicator(clp).get()))
+        if (!treeMade)
+        {
+            throw depthmapX::RuntimeException("No visible drawing lines to make isovists with");
+        }
+
+        std::ofstream outfile(clp.getOuputFile().c_str());
+        if (!outfile.good())
+        {
+            std::stringstream message;
+            message << "Failed to open output file " << clp.getOuputFile() << std::flush;
+            throw depthmapX::RuntimeException(message.str().c_str());
+        }
+        outfile << "Index,x,y,Isovist Area";
+        if (!clp.simpleMode())
+        {
+            outfile << ",Isovist Compactness,Isovist Drift Angle,Isovist Drift Magnitude,Isovist Min Radial"
+                    << ",Isovist Max Radial,Isovist Occlusivity,Isovist Perimeter";
+        }
+        if (writePolygons)
+        {
+            outfile << ",WKT";
+        }
+        outfile << "\n";
+
+        std::ifstream file;
+        std::unique_ptr<EntityParsing::IsovistReader> reader;
+        if (!isovistFile.empty())
+        {
+            file.open(isovistFile);
+            if (!file.is_open())
+            {
+                std::stringstream message;
+                message << "Failed to open isovist file " << isovistFile << std::flush;
+                throw depthmapX::RuntimeException(message.str().c_str());
+            }
+            reader = std::unique_ptr<EntityParsing::IsovistReader>(new EntityParsing::IsovistReader(file, ','));
+        }
+
+        // the isovists are taken a chunk at a time, made and formatted in parallel, and written out in order
+        const size_t chunkSize = 4096;
+        int threadCount = depthmapX::resolveThreadCount(numThreads);
+        std::vector<std::unique_ptr<Isovist>> threadIsovists(static_cast<size_t>(threadCount));
+        std::vector<IsovistDefinition> chunk;
+        std::vector<std::string> lines;
+        size_t count = 0;
+        auto makeChunk = [&]() {
+            lines.resize(chunk.size());
+            depthmapX::parallelFor(threadCount, chunk.size(), [&](int threadIndex, size_t index) {
+                const IsovistDefinition &isovistDef = chunk[index];
+                std::unique_ptr<Isovist> &isovist = threadIsovists[static_cast<size_t>(threadIndex)];
+                if (!isovist)
+                {
+                    isovist = std::unique_ptr<Isovist>(new Isovist());
+                }
+                mGraph->makeIsovist(isovistDef.getLocation(), *isovist, isovistDef.getLeftAngle(), isovistDef.getRightAngle());
+                Isovist::Measures measures = isovist->getMeasures();
+
+                // coordinates as in the point exports, the single precision measures as in the data exports
+                std::stringstream line;
+                line.precision(12);
+                line << (count + index) << "," << isovistDef.getLocation().x << "," << isovistDef.getLocation().y;
+                line.precision(8);
+                line << "," << measures.area;
+                if (!clp.simpleMode())
+                {
+                    line << "," << measures.compactness << "," << measures.drift_angle << "," << measures.drift_magnitude
+                         << "," << measures.min_radial << "," << measures.max_radial << "," << measures.occlusivity
+                         << "," << measures.perimeter;
+                }
+                if (writePolygons)
+                {
+                    line.precision(12);
+                    const std::vector<Point2f> &polygon = isovist->getPolygon();
+                    if (polygon.empty())
+                    {
+                        line << ",POLYGON EMPTY";
+                    }
+                    else
+                    {
+                        line << ",\"POLYGON((";
+                        for (const Point2f &point : polygon)
+                        {
+                            line << point.x << " " << point.y << ",";
+                        }
+                        line << polygon.front().x << " " << polygon.front().y << "))\"";
+                    }
+                }
+                line << "\n";
+                lines[index] = line.str();
+            }, 16);
+            for (const std::string &line : lines)
+            {
+                outfile << line;
+            }
+            count += chunk.size();
+        };
+        auto makeAll = [&]() {
+            if (reader)
+            {
+                bool more = true;
+                while (more)
+                {
+                    chunk.clear();
+                    more = reader->read(chunk, chunkSize);
+                    makeChunk();
+                }
+            }
+            else
+            {
+                for (size_t first = 0; first < isovists.size(); first += chunkSize)
+                {
+                    chunk.assign(isovists.begin() + first, isovists.begin() + std::min(isovists.size(), first + chunkSize));
+                    makeChunk();
+                }
+            }
+        };
+
+        std::cout << "ok\nMaking and writing isovists... " << std::flush;
+        DO_TIMED("Make isovists", makeAll())
+        outfile.close();
+        std::cout << "ok, " << count << " isovists" << std::endl;
+    }
+
     void exportData(const CommandLineParser &cmdP, const ExportParser &exportP, IPerformanceSink &perfWriter ) {
 
         auto mgraph = loadGraph(cmdP.getFileName().c_str(), perfWriter);
@@ -25,6 +25,7 @@
 #include "mapconvertparser.h"
 #include "segmentparser.h"
 #include "agentparser.h"
+#include "agentgaparser.h"
 #include "exportparser.h"
 #include "linkparser.h"
 #include "importparser.h"
@@ -43,15 +44,18 @@ class Line;
 class Point2f;
 
 namespace dm_runmethods{
-    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter);
+    // numThreads is what the points are decoded on, and coded on when the graph is written back
+    std::unique_ptr<MetaGraph> loadGraph(const std::string& filename, IPerformanceSink &perfWriter, int numThreads = 1);
     void importFiles(const CommandLineParser &cmdP, const ImportParser &parser, IPerformanceSink &perfWriter);
     void linkGraph(const CommandLineParser &cmdP, const LinkParser &parser, IPerformanceSink &perfWriter );
     void runVga(const CommandLineParser &cmdP, const VgaParser &vgaP, const IRadiusConverter &converter, IPerformanceSink &perfWriter );
-    void runVisualPrep(const CommandLineParser &clp, double gridSize, const std::vector<Point2f> &fillPoints, double maxVisibility, bool boundaryGraph, bool makeGraph, bool unmakeGraph, bool removeLinksWhenUnmaking, IPerformanceSink &perfWriter);
+    void runVisualPrep(const CommandLineParser &clp, double gridSize, const std::vector<Point2f> &fillPoints, double maxVisibility, bool boundaryGraph, bool makeGraph, bool unmakeGraph, bool removeLinksWhenUnmaking, int numThreads, IPerformanceSink &perfWriter);
     void runAxialAnalysis(const CommandLineParser& clp, const AxialParser &ap, IPerformanceSink &perfWriter);
     void runSegmentAnalysis(const CommandLineParser& clp, const SegmentParser &sp, IPerformanceSink &perfWriter);
     void runAgentAnalysis(const CommandLineParser &cmdP, const AgentParser &agentP, IPerformanceSink &perfWriter );
-    void runIsovists(const CommandLineParser &cmdP, const std::vector<IsovistDefinition> &isovists, IPerformanceSink &perfWriter );
+    void runAgentGA(const CommandLineParser &cmdP, const AgentGAParser &gaP, IPerformanceSink &perfWriter);
+    void runIsovists(const CommandLineParser &cmdP, const std::vector<IsovistDefinition> &isovists, bool storeBSPTree, IPerformanceSink &perfWriter );
+    void runIsovistBatch(const CommandLineParser &cmdP, const std::vector<IsovistDefinition> &isovists, const std::string &isovistFile, bool writePolygons, int numThreads, IPerformanceSink &perfWriter );
     void exportData(const CommandLineParser &cmdP, const ExportParser &exportP, IPerformanceSink &perfWriter );
     void runStepDepth(const CommandLineParser &clp, const StepDepthParser::StepType &stepType, const std::vector<Point2f> &stepDepthPoints, IPerformanceSink &perfWriter);
     void runMapConversion(const CommandLineParser& clp, const MapConvertParser &mcp, IPerformanceSink &perfWriter);
@@ -24,7 +24,7 @@
 using namespace depthmapX;
 
 SegmentParser::SegmentParser() :  m_analysisType(AnalysisType::NONE), m_radiusType(RadiusType::NONE), m_includeChoice(false),
-    m_tulipBins(0)
+    m_tulipBins(0), m_numThreads(1)
 {
 
 }
@@ -49,7 +49,9 @@ std::string SegmentParser::getHelp() const
             "       angular\n"\
             "  -sic to include choice (only for Tulip)\n"\
             "  -stb <tulip bins> (4 to 1024, 1024 approximates full angular)\n"\
-            "  -swa <map attribute name> perform weighted analysis using this attribute (only for Tulip)\n";
+            "  -swa <map attribute name> perform weighted analysis using this attribute (only for Tulip)\n"\
+            "  -sth <threads> number of threads to use (only for Tulip, topological and metric), 0 for all available cores\n"\
+            "       (default 1)\n";
 }
 
 void SegmentParser::parse(int argc, char **argv)
@@ -136,6 +138,15 @@ void SegmentParser::parse(int argc, char **argv)
             ENFORCE_ARGUMENT("-swa", i)
             m_attribute = argv[i];
         }
+        else if (std::strcmp(argv[i], "-sth") == 0)
+        {
+            ENFORCE_ARGUMENT("-sth", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-sth must be a number >=0, got ") + argv[i]);
+            }
+            m_numThreads = std::atoi(argv[i]);
+        }
     }
 
     if (getAnalysisType() == AnalysisType::NONE)
@@ -163,6 +174,11 @@ void SegmentParser::parse(int argc, char **argv)
     {
         throw CommandLineException("-stb, -srt and -sic can only be used with tulip analysis");
     }
+
+    if (getAnalysisType() == AnalysisType::ANGULAR_FULL && m_numThreads != 1)
+    {
+        throw CommandLineException("-sth can not be used with full angular analysis");
+    }
 }
 
 void SegmentParser::run(const CommandLineParser &clp, IPerformanceSink &perfWriter) const
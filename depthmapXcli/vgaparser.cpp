@@ -15,6 +15,7 @@
 
 #include "vgaparser.h"
 #include "exceptions.h"
+#include <cstdlib>
 #include <cstring>
 #include "radiusconverter.h"
 #include "runmethods.h"
@@ -23,7 +24,7 @@
 using namespace depthmapX;
 
 
-VgaParser::VgaParser() : m_vgaMode(VgaMode::NONE), m_localMeasures(false), m_globalMeasures(false)
+VgaParser::VgaParser() : m_vgaMode(VgaMode::NONE), m_localMeasures(false), m_globalMeasures(false), m_numThreads(1)
 {}
 
 void VgaParser::parse(int argc, char *argv[])
@@ -76,6 +77,15 @@ void VgaParser::parse(int argc, char *argv[])
             ENFORCE_ARGUMENT("-vr", i)
             m_radius = argv[i];
         }
+        else if (std::strcmp(argv[i], "-vth") == 0)
+        {
+            ENFORCE_ARGUMENT("-vth", i)
+            if (!has_only_digits(argv[i]))
+            {
+                throw CommandLineException(std::string("-vth must be a number >=0, got ") + argv[i]);
+            }
+            m_numThreads = std::atoi(argv[i]);
+        }
         ++i;
     }
 
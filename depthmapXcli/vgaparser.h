@@ -33,7 +33,9 @@ public:
                   "-vm <vga mode> one of isovist, visiblity, metric, angular, thruvision\n"\
                   "-vg turn on global measures for visibility, requires radius between 1 and 99 or n\n"\
                   "-vl turn on local measures for visibility\n"\
-                  "-vr set visibility radius\n";
+                  "-vr set visibility radius. With a radius, visibility and metric go through the map in tiles to save time,\n"\
+                  "    but the whole graph is still read into memory\n"\
+                  "-vth <threads> number of threads to use for global visibility and isovists, 0 for all available cores (default 1)\n";
     }
 
 public:
@@ -55,11 +57,13 @@ public:
     bool localMeasures() const { return m_localMeasures; }
     bool globalMeasures() const { return m_globalMeasures; }
     const std::string & getRadius() const { return m_radius; }
+    int getNumThreads() const { return m_numThreads; }
 private:
     // vga options
     VgaMode m_vgaMode;
     bool m_localMeasures;
     bool m_globalMeasures;
     std::string m_radius;
+    int m_numThreads;
 };
 
@@ -17,6 +17,8 @@
 
 #include "bsptree.h"
 
+#include "genlib/exceptions.h"
+
 #include <stack>
 
 // Binary Space Partition
@@ -180,3 +182,74 @@ BSPTree::makeLines(Communicator *, time_t, const std::vector<TaggedLine> &lines,
 
     return std::make_pair(leftlines, rightlines);
 }
+
+/* Writes the tree depth first, left before right. As with making the tree, this is done with
+ * a stack and not by recursion, as the trees of some drawings are very deep.
+ */
+
+void BSPTree::write(std::ostream &stream, const BSPNode &root) {
+    std::stack<const BSPNode *> nodeStack;
+    nodeStack.push(&root);
+    while (!nodeStack.empty()) {
+        const BSPNode *currNode = nodeStack.top();
+        nodeStack.pop();
+
+        // the line is written by its ends, in its direction, so that reading it back makes the same line
+        Point2f start = currNode->getLine().t_start();
+        Point2f end = currNode->getLine().t_end();
+        int tag = currNode->getTag();
+        char children = (currNode->m_left ? 1 : 0) | (currNode->m_right ? 2 : 0);
+        stream.write((char *)&start.x, sizeof(start.x));
+        stream.write((char *)&start.y, sizeof(start.y));
+        stream.write((char *)&end.x, sizeof(end.x));
+        stream.write((char *)&end.y, sizeof(end.y));
+        stream.write((char *)&tag, sizeof(tag));
+        stream.write(&children, sizeof(children));
+
+        // right first so that left comes off the stack first
+        if (currNode->m_right) {
+            nodeStack.push(currNode->m_right.get());
+        }
+        if (currNode->m_left) {
+            nodeStack.push(currNode->m_left.get());
+        }
+    }
+}
+
+void BSPTree::read(std::istream &stream, BSPNode &root) {
+    root.m_left.reset();
+    root.m_right.reset();
+
+    std::stack<BSPNode *> nodeStack;
+    nodeStack.push(&root);
+    while (!nodeStack.empty()) {
+        BSPNode *currNode = nodeStack.top();
+        nodeStack.pop();
+
+        Point2f start, end;
+        int tag;
+        char children;
+        stream.read((char *)&start.x, sizeof(start.x));
+        stream.read((char *)&start.y, sizeof(start.y));
+        stream.read((char *)&end.x, sizeof(end.x));
+        stream.read((char *)&end.y, sizeof(end.y));
+        stream.read((char *)&tag, sizeof(tag));
+        stream.read(&children, sizeof(children));
+        if (stream.fail()) {
+            throw depthmapX::RuntimeException("Unexpected end of BSP tree data");
+        }
+        currNode->setLine(Line(start, end));
+        currNode->setTag(tag);
+
+        if (children & 1) {
+            currNode->m_left = std::unique_ptr<BSPNode>(new BSPNode(currNode));
+        }
+        if (children & 2) {
+            currNode->m_right = std::unique_ptr<BSPNode>(new BSPNode(currNode));
+            nodeStack.push(currNode->m_right.get());
+        }
+        if (children & 1) {
+            nodeStack.push(currNode->m_left.get());
+        }
+    }
+}
@@ -19,6 +19,7 @@
 
 #include "genlib/p2dpoly.h"
 
+#include <iostream>
 #include <memory>
 
 // Binary Space Partition
@@ -62,4 +63,7 @@ namespace BSPTree {
     int pickMidpointLine(const std::vector<TaggedLine> &lines, BSPNode *par);
     std::pair<std::vector<TaggedLine>, std::vector<TaggedLine>>
     makeLines(Communicator *communicator, time_t atime, const std::vector<TaggedLine> &lines, BSPNode *base);
+    // the tree is stored in pre-order, each node as its line and tag followed by which children it has
+    void write(std::ostream &stream, const BSPNode &root);
+    void read(std::istream &stream, BSPNode &root);
 } // namespace BSPTree
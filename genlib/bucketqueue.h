@@ -0,0 +1,144 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     * Priority queue for shortest path searches where the keys popped never decrease, such as Dijkstra's
+     * algorithm with non-negative edge weights.
+     *
+     * Values are sorted into buckets by their key quantised to the bucket width, and only the bucket holding the
+     * smallest keys is kept in order (as a binary heap), so a push or pop mostly works on a handful of values
+     * instead of a tree of all of them. The buckets keep their memory through clear(), so a queue reused for many
+     * searches stops allocating after the first few.
+     *
+     * Values come out in exactly the order of a std::set<T> with the same operator<: smallest value first, and
+     * of values that compare equal, the one pushed first. A key smaller than those already popped is allowed, the
+     * value simply goes into the current bucket. Keys beyond the last bucket (MAX_BUCKETS widths), including
+     * infinite ones and NaN, all share that bucket, where they are still kept in order.
+     */
+    template <typename T> class BucketQueue {
+      public:
+        static const size_t MAX_BUCKETS = size_t(1) << 20;
+
+        /**
+         * @param bucketWidth the range of keys sharing a bucket. Ideally about the smallest step between a key
+         * and the keys pushed from it, so that buckets stay small without many of them being empty
+         */
+        explicit BucketQueue(double bucketWidth) : m_bucketWidth(bucketWidth) {
+            if (!(bucketWidth > 0)) {
+                throw std::invalid_argument("Bucket width must be positive");
+            }
+        }
+
+        bool empty() const { return m_size == 0; }
+        size_t size() const { return m_size; }
+
+        /**
+         * @param key the key the value is sorted by. It must agree with the order of the values, i.e. a value
+         * with a smaller key must compare smaller
+         */
+        void push(double key, const T &value) {
+            size_t index = m_current;
+            if (!(key <= m_bucketWidth * double(m_current))) {
+                double bucket = key / m_bucketWidth;
+                // only a bucket that is in range can be converted to an index
+                index = bucket < double(MAX_BUCKETS - 1) ? static_cast<size_t>(bucket) : MAX_BUCKETS - 1;
+                index = std::max(m_current, index);
+            }
+            if (index >= m_buckets.size()) {
+                m_buckets.resize(index + 1);
+            }
+            std::vector<Entry> &bucket = m_buckets[index];
+            bucket.push_back(Entry{value, m_pushed++});
+            std::push_heap(bucket.begin(), bucket.end(), Entry::later);
+            m_last = std::max(m_last, index);
+            m_size++;
+        }
+
+        /**
+         * @brief The smallest value in the queue. The queue must not be empty
+         */
+        const T &top() {
+            return currentBucket().front().value;
+        }
+
+        /**
+         * @brief Remove and return the smallest value in the queue. The queue must not be empty
+         */
+        T pop() {
+            std::vector<Entry> &bucket = currentBucket();
+            std::pop_heap(bucket.begin(), bucket.end(), Entry::later);
+            T value = bucket.back().value;
+            bucket.pop_back();
+            m_size--;
+            return value;
+        }
+
+        /**
+         * @brief Remove all values, keeping the memory of the buckets
+         */
+        void clear() {
+            for (size_t i = m_current; i <= m_last && i < m_buckets.size(); i++) {
+                m_buckets[i].clear();
+            }
+            m_current = 0;
+            m_last = 0;
+            m_size = 0;
+            m_pushed = 0;
+        }
+
+      private:
+        struct Entry {
+            T value;
+            size_t order; // order of pushing, to keep equal values first-in first-out
+
+            // heap order, with the earliest entry at the front
+            static bool later(const Entry &a, const Entry &b) {
+                if (b.value < a.value) {
+                    return true;
+                }
+                if (a.value < b.value) {
+                    return false;
+                }
+                return a.order > b.order;
+            }
+        };
+
+        std::vector<Entry> &currentBucket() {
+            if (m_size == 0) {
+                throw std::out_of_range("Bucket queue is empty");
+            }
+            while (m_buckets[m_current].empty()) {
+                m_current++;
+            }
+            return m_buckets[m_current];
+        }
+
+        double m_bucketWidth;
+        std::vector<std::vector<Entry>> m_buckets;
+        size_t m_current = 0; // no bucket below this one holds any values
+        size_t m_last = 0;    // no bucket above this one holds any values
+        size_t m_size = 0;
+        size_t m_pushed = 0;
+    };
+} // namespace depthmapX
@@ -0,0 +1,103 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "genlib/exceptions.h"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     * Appends values to a byte buffer in a compact form: unsigned integers as varints, 7 bits to a byte with
+     * the high bit set on every byte but the last, so that small numbers take a single byte; signed integers
+     * zigzag coded first (0, -1, 1, -2, ... to 0, 1, 2, 3, ...) so that small negative numbers stay short too;
+     * and anything else as its raw bytes.
+     */
+    class ByteWriter {
+      public:
+        void writeVarint(uint64_t value) {
+            while (value >= 0x80) {
+                m_bytes.push_back(static_cast<unsigned char>(value | 0x80));
+                value >>= 7;
+            }
+            m_bytes.push_back(static_cast<unsigned char>(value));
+        }
+        void writeSignedVarint(int64_t value) {
+            writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        }
+        template <typename T> void writeRaw(const T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written raw");
+            const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+            m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(T));
+        }
+
+        const std::vector<unsigned char> &bytes() const { return m_bytes; }
+        size_t size() const { return m_bytes.size(); }
+        void clear() { m_bytes.clear(); }
+
+      private:
+        std::vector<unsigned char> m_bytes;
+    };
+
+    /**
+     * Reads back the values of a ByteWriter, in the same order. Reading past the end of the data, or a varint
+     * that does not fit, throws a RuntimeException
+     */
+    class ByteReader {
+      public:
+        ByteReader(const unsigned char *data, size_t size) : m_data(data), m_end(data + size) {}
+
+        uint64_t readVarint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (m_data == m_end) {
+                    throw RuntimeException("Unexpected end of coded data");
+                }
+                unsigned char byte = *m_data++;
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+            throw RuntimeException("Varint too long in coded data");
+        }
+        int64_t readSignedVarint() {
+            uint64_t value = readVarint();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+        template <typename T> T readRaw() {
+            static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read raw");
+            if (static_cast<size_t>(m_end - m_data) < sizeof(T)) {
+                throw RuntimeException("Unexpected end of coded data");
+            }
+            T value;
+            std::memcpy(&value, m_data, sizeof(T));
+            m_data += sizeof(T);
+            return value;
+        }
+
+        bool atEnd() const { return m_data == m_end; }
+
+      private:
+        const unsigned char *m_data;
+        const unsigned char *m_end;
+    };
+} // namespace depthmapX
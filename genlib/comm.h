@@ -17,6 +17,7 @@
 #pragma once
 
 //#include <io.h>
+#include <atomic>
 #include <fstream>
 #include <string>
 #include <chrono>
@@ -66,7 +67,8 @@ class Communicator {
     enum { NUM_STEPS, CURRENT_STEP, NUM_RECORDS, CURRENT_RECORD };
 
   protected:
-    bool m_cancelled;
+    // set by the interface while an analysis, possibly running on several threads, checks it
+    std::atomic<bool> m_cancelled;
     bool m_delete_flag;
     // nb. converted to Win32 UTF-16 Unicode path (AT 31.01.11) Linux, MacOS use UTF-8 (AT 29.04.11)
     std::string m_infilename;
@@ -0,0 +1,158 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     * Row matrix of scratch values that can be cleared in constant time, meant for traversals that need
+     * to reset their per-cell state (visited flags, distances etc.) many times, such as one search per root.
+     *
+     * Every cell carries the epoch in which it was last written. Clearing the matrix only moves on to the
+     * next epoch, and any cell stamped with an older epoch is treated as holding its initial value the next
+     * time it is accessed. Checking whether a cell has been touched since the last clear is therefore a single
+     * integer comparison, and the cost of a traversal only depends on the number of cells it actually visits.
+     *
+     * The matrix may also be smaller than the grid it is used for and moved over it as a window, for
+     * traversals that stay within a known distance of where they start. Cells are always addressed by their
+     * position in the grid, and only those within the window may be accessed.
+     *
+     * As with std::vector, the accessors used in the traversals do not check that the cell is in the window,
+     * only at() does.
+     */
+    template <typename T> class EpochMatrix {
+      public:
+        /**
+         * @param rows number of rows
+         * @param columns number of columns
+         * @param defaultValue the value every cell holds after a clear
+         */
+        EpochMatrix(size_t rows, size_t columns, T const &defaultValue = T())
+            : m_cells(rows * columns, Cell{0, defaultValue}), m_epoch(1), m_rows(rows), m_columns(columns),
+              m_defaultValue(defaultValue) {}
+
+        /**
+         * @brief Reset all cells to their initial value. This is O(1), apart from the rare occasion the epoch
+         * counter wraps around, where all the stamps are cleared once.
+         */
+        void clear() {
+            m_epoch++;
+            if (m_epoch == 0) {
+                for (auto &cell : m_cells) {
+                    cell.epoch = 0;
+                }
+                m_epoch = 1;
+            }
+        }
+
+        /**
+         * @brief Move the window over the grid, so that its first row and column are at the given position
+         * (which may be outside the grid), and clear it
+         */
+        void moveTo(long firstRow, long firstColumn) {
+            m_firstRow = firstRow;
+            m_firstColumn = firstColumn;
+            clear();
+        }
+
+        /**
+         * @brief Whether a cell of the grid is within the window
+         */
+        bool contains(size_t row, size_t column) const {
+            return long(row) >= m_firstRow && long(row) < m_firstRow + long(m_rows) && long(column) >= m_firstColumn &&
+                   long(column) < m_firstColumn + long(m_columns);
+        }
+
+        /**
+         * @brief Whether a cell has been accessed for writing since the last clear
+         */
+        bool isSet(size_t row, size_t column) const { return m_cells[index(row, column)].epoch == m_epoch; }
+
+        /**
+         * @brief Access a cell for writing. If the cell has not been accessed since the last clear it is first
+         * set to the default value
+         * @return non-const reference to the data
+         */
+        T &operator()(size_t row, size_t column) { return get(row, column, m_defaultValue); }
+
+        /**
+         * @brief Access a cell for writing. If the cell has not been accessed since the last clear it is first
+         * set to initialValue, for cells where the initial value depends on the position
+         * @return non-const reference to the data
+         */
+        T &get(size_t row, size_t column, T const &initialValue) {
+            Cell &cell = m_cells[index(row, column)];
+            if (cell.epoch != m_epoch) {
+                cell.epoch = m_epoch;
+                cell.value = initialValue;
+            }
+            return cell.value;
+        }
+
+        /**
+         * @brief Read a cell without stamping it
+         * @return the value of the cell, or the default value if it has not been set since the last clear
+         */
+        T const &value(size_t row, size_t column) const {
+            const Cell &cell = m_cells[index(row, column)];
+            return cell.epoch == m_epoch ? cell.value : m_defaultValue;
+        }
+
+        /**
+         * @brief Access a cell for writing as operator(), checking that it is in the window
+         * @throws std::out_of_range if the cell is outside the window
+         */
+        T &at(size_t row, size_t column) {
+            checkInWindow(row, column);
+            return get(row, column, m_defaultValue);
+        }
+
+        size_t rows() const { return m_rows; }
+        size_t columns() const { return m_columns; }
+
+      private:
+        // the stamp is kept next to the value so that checking and accessing a cell touches the same memory
+        struct Cell {
+            unsigned int epoch;
+            T value;
+        };
+        std::vector<Cell> m_cells;
+        unsigned int m_epoch;
+        size_t m_rows;
+        size_t m_columns;
+        T m_defaultValue;
+        long m_firstRow = 0;
+        long m_firstColumn = 0;
+
+        size_t index(size_t row, size_t column) const {
+            return size_t(long(column) - m_firstColumn) + size_t(long(row) - m_firstRow) * m_columns;
+        }
+
+        void checkInWindow(size_t row, size_t column) const {
+            // n.b. a cell before the window wraps around to a large index
+            if (size_t(long(row) - m_firstRow) >= m_rows) {
+                throw std::out_of_range("row out of range");
+            }
+            if (size_t(long(column) - m_firstColumn) >= m_columns) {
+                throw std::out_of_range("column out of range");
+            }
+        }
+    };
+} // namespace depthmapX
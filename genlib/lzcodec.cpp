@@ -0,0 +1,157 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "genlib/lzcodec.h"
+
+#include "genlib/exceptions.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_OFFSET = 0xffff;
+    const int HASH_BITS = 14;
+    const uint32_t NO_POSITION = 0xffffffff;
+
+    uint32_t read32(const unsigned char *data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+    // a length that does not fit in its nibble of the token carries on in bytes of up to 255
+    void writeLength(std::vector<unsigned char> &out, size_t length) {
+        while (length >= 255) {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(static_cast<unsigned char>(length));
+    }
+
+    void writeSequence(std::vector<unsigned char> &out, const unsigned char *literals, size_t literalLength,
+                       size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength == 0 ? 0 : matchLength - MIN_MATCH;
+        unsigned char token = static_cast<unsigned char>(((literalLength < 15 ? literalLength : 15) << 4) |
+                                                         (matchCode < 15 ? matchCode : 15));
+        out.push_back(token);
+        if (literalLength >= 15) {
+            writeLength(out, literalLength - 15);
+        }
+        out.insert(out.end(), literals, literals + literalLength);
+        if (matchLength == 0) {
+            // the last sequence has no match
+            return;
+        }
+        out.push_back(static_cast<unsigned char>(offset & 0xff));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if (matchCode >= 15) {
+            writeLength(out, matchCode - 15);
+        }
+    }
+
+    size_t readLength(const unsigned char *&in, const unsigned char *end, size_t length) {
+        if (length == 15) {
+            unsigned char byte;
+            do {
+                if (in == end) {
+                    throw depthmapX::RuntimeException("Unexpected end of compressed data");
+                }
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+        }
+        return length;
+    }
+} // namespace
+
+std::vector<unsigned char> depthmapX::lz::compress(const unsigned char *data, size_t size) {
+    std::vector<unsigned char> out;
+    out.reserve(size + size / 255 + 16);
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, NO_POSITION);
+
+    size_t anchor = 0; // the start of the literals not yet written
+    size_t pos = 0;
+    while (pos + MIN_MATCH <= size) {
+        uint32_t sequence = read32(data + pos);
+        uint32_t &entry = table[hash(sequence)];
+        size_t candidate = entry;
+        entry = static_cast<uint32_t>(pos);
+        if (candidate != NO_POSITION && pos - candidate <= MAX_OFFSET && read32(data + candidate) == sequence) {
+            size_t length = MIN_MATCH;
+            while (pos + length < size && data[candidate + length] == data[pos + length]) {
+                length++;
+            }
+            writeSequence(out, data + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        } else {
+            pos++;
+        }
+    }
+    writeSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+void depthmapX::lz::decompress(const unsigned char *compressed, size_t compressedSize, unsigned char *data,
+                               size_t size) {
+    const unsigned char *in = compressed;
+    const unsigned char *inEnd = compressed + compressedSize;
+    unsigned char *out = data;
+    unsigned char *outEnd = data + size;
+    while (true) {
+        if (in == inEnd) {
+            throw depthmapX::RuntimeException("Unexpected end of compressed data");
+        }
+        unsigned char token = *in++;
+        size_t literalLength = readLength(in, inEnd, token >> 4);
+        if (literalLength > static_cast<size_t>(inEnd - in) || literalLength > static_cast<size_t>(outEnd - out)) {
+            throw depthmapX::RuntimeException("Compressed data runs past the end of the block");
+        }
+        std::memcpy(out, in, literalLength);
+        in += literalLength;
+        out += literalLength;
+        if (in == inEnd) {
+            // the last sequence
+            break;
+        }
+        if (inEnd - in < 2) {
+            throw depthmapX::RuntimeException("Unexpected end of compressed data");
+        }
+        size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+        in += 2;
+        size_t matchLength = readLength(in, inEnd, token & 0x0f) + MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(out - data) ||
+            matchLength > static_cast<size_t>(outEnd - out)) {
+            throw depthmapX::RuntimeException("Compressed data runs past the end of the block");
+        }
+        const unsigned char *match = out - offset;
+        if (offset >= matchLength) {
+            std::memcpy(out, match, matchLength);
+        } else {
+            // the match overlaps the bytes it makes, repeating them
+            for (size_t i = 0; i < matchLength; i++) {
+                out[i] = match[i];
+            }
+        }
+        out += matchLength;
+    }
+    if (out != outEnd) {
+        throw depthmapX::RuntimeException("Compressed data does not fill the block");
+    }
+}
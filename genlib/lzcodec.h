@@ -0,0 +1,41 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     * A small and fast LZ77 block codec, in the manner of LZ4: the data is coded as a series of sequences, each
+     * a run of literal bytes followed by a copy of earlier output (a match) of at least four bytes from at most
+     * 64KB back. Matches are found through a hash table of the last position of each four byte prefix, so
+     * compression is a single pass, and decompression is little more than copying memory.
+     *
+     * It does well on data with many short repeats, such as the varint coded runs of a visibility graph, and
+     * needs no external library. The uncompressed size is not stored, it has to be kept alongside.
+     */
+    namespace lz {
+        std::vector<unsigned char> compress(const unsigned char *data, size_t size);
+        /**
+         * @brief Decompress a block into exactly size bytes at data. Corrupted input, or input that does not
+         * decompress to exactly size bytes, throws a RuntimeException
+         */
+        void decompress(const unsigned char *compressed, size_t compressedSize, unsigned char *data, size_t size);
+    } // namespace lz
+} // namespace depthmapX
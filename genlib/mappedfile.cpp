@@ -0,0 +1,81 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "mappedfile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace depthmapX {
+
+#ifndef _WIN32
+    MappedFile::MappedFile(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return;
+        }
+        struct stat info;
+        // an empty file can not be mapped, but neither is it a graph file
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = static_cast<char *>(data);
+                m_size = static_cast<size_t>(info.st_size);
+                // the file is read from start to end
+                madvise(data, m_size, MADV_SEQUENTIAL);
+            }
+        }
+        // the mapping stays valid after the file is closed
+        close(fd);
+        setg(m_data, m_data, m_data + m_size);
+    }
+
+    MappedFile::~MappedFile() {
+        if (m_data) {
+            munmap(m_data, m_size);
+        }
+    }
+#else
+    // not mapped on windows, where the file is read through a stream instead
+    MappedFile::MappedFile(const std::string &) {}
+
+    MappedFile::~MappedFile() {}
+#endif
+
+    MappedFile::pos_type MappedFile::seekoff(off_type off, std::ios_base::seekdir dir,
+                                             std::ios_base::openmode which) {
+        off_type base = 0;
+        if (dir == std::ios_base::cur) {
+            base = gptr() - eback();
+        } else if (dir == std::ios_base::end) {
+            base = static_cast<off_type>(m_size);
+        }
+        return seekpos(pos_type(base + off), which);
+    }
+
+    MappedFile::pos_type MappedFile::seekpos(pos_type pos, std::ios_base::openmode which) {
+        off_type offset = off_type(pos);
+        if (!(which & std::ios_base::in) || offset < 0 || offset > static_cast<off_type>(m_size)) {
+            return pos_type(off_type(-1));
+        }
+        setg(m_data, m_data + offset, m_data + m_size);
+        return pos;
+    }
+} // namespace depthmapX
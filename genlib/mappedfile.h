@@ -0,0 +1,53 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <streambuf>
+#include <string>
+
+namespace depthmapX {
+
+    /**
+     * A whole file mapped into memory for reading, used as the buffer of an std::istream.
+     *
+     * The get area of the buffer is the mapping itself, so the stream never has to refill it: every read is
+     * a copy straight out of the mapped pages (and a read of a whole array, as in dXreadwrite::readIntoVector,
+     * is a single copy into its destination), and the file is never held twice in memory. Where mapping is not
+     * available, or the file cannot be mapped, isOpen() is false and the file should be read through an
+     * std::ifstream instead.
+     */
+    class MappedFile : public std::streambuf {
+      public:
+        explicit MappedFile(const std::string &filename);
+        ~MappedFile() override;
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool isOpen() const { return m_data != nullptr; }
+        const char *data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+      protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which = std::ios_base::in) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+
+      private:
+        char *m_data = nullptr;
+        size_t m_size = 0;
+    };
+} // namespace depthmapX
@@ -48,9 +48,62 @@ void pafsrand(unsigned int seed, int set) // = 0
 
 unsigned int pafrand(int set) // = 0
 {
-    g_rand[set] = g_mult * g_rand[set] + g_const;
+    return pafrandnext(g_rand[set]);
+}
+
+uint64_t pafrandstate(int set) // = 0
+{
+    return g_rand[set];
+}
+
+void pafsetrandstate(uint64_t state, int set) // = 0
+{
+    g_rand[set] = state;
+}
+
+unsigned int pafrandnext(uint64_t &state)
+{
+    state = g_mult * state + g_const;
+
+    return (unsigned int)((state >> 32) & PAF_RAND_MAX);
+}
 
-    return (unsigned int)((g_rand[set] >> 32) & PAF_RAND_MAX);
+// n steps of the generator are themselves a linear congruential step, with multiplier g_mult^n and
+// increment g_const * (g_mult^(n-1) + ... + 1), which are built up here by repeated squaring
+uint64_t pafrandskip(uint64_t state, uint64_t count)
+{
+    uint64_t mult = 1, plus = 0;
+    uint64_t stepmult = g_mult, stepplus = g_const;
+    while (count != 0) {
+        if (count & 1) {
+            mult *= stepmult;
+            plus = plus * stepmult + stepplus;
+        }
+        stepplus = (stepmult + 1) * stepplus;
+        stepmult *= stepmult;
+        count >>= 1;
+    }
+    return mult * state + plus;
+}
+
+// the SplitMix64 finaliser, which maps consecutive numbers to well mixed ones
+static uint64_t pafmix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+PafRandomStream::PafRandomStream(uint64_t seed, uint64_t stream) // = 0, = 0
+{
+    m_key = pafmix(pafmix(seed + 0x9E3779B97F4A7C15ULL) ^ stream);
+    m_counter = 0;
+}
+
+unsigned int PafRandomStream::rand()
+{
+    m_counter++;
+    return (unsigned int)((pafmix(m_key + m_counter * 0x9E3779B97F4A7C15ULL) >> 32) & PAF_RAND_MAX);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
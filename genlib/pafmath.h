@@ -27,6 +27,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 #ifndef M_PI
 #define M_PI 3.1415926535897932384626433832795
@@ -48,6 +49,16 @@ const unsigned int PAF_RAND_MAX = 0x0FFFFFFF;
 void pafsrand(unsigned int seed, int set = 0);
 unsigned int pafrand(int set = 0);
 
+// The state of a random number set can also be copied out and advanced separately, so that work which
+// draws its numbers in sequence can be split up (for example between threads) and still draw exactly
+// the same numbers as pafrand would have given it
+uint64_t pafrandstate(int set = 0);
+void pafsetrandstate(uint64_t state, int set = 0);
+// the next number from a copied state, as pafrand
+unsigned int pafrandnext(uint64_t &state);
+// the state after count more numbers have been drawn from it, in O(log count)
+uint64_t pafrandskip(uint64_t state, uint64_t count);
+
 // a random number from 0 to 1
 inline double prandom(int set = 0) { return double(pafrand(set)) / double(PAF_RAND_MAX); }
 
@@ -55,6 +66,22 @@ inline double prandom(int set = 0) { return double(pafrand(set)) / double(PAF_RA
 
 inline double prandomr(int set = 0) { return double(pafrand(set)) / double(PAF_RAND_MAX + 1); }
 
+// A counter-based stream of random numbers: the n-th number of a stream only depends on the seed, the
+// stream number and n, and not on any shared state, so that many streams (e.g., one per agent) can be
+// drawn from at the same time on different threads and still give the same numbers for the same seed
+class PafRandomStream
+{
+public:
+    PafRandomStream(uint64_t seed = 0, uint64_t stream = 0);
+    // as pafrand, prandom and prandomr
+    unsigned int rand();
+    double random() { return double(rand()) / double(PAF_RAND_MAX); }
+    double randomr() { return double(rand()) / double(PAF_RAND_MAX + 1); }
+private:
+    uint64_t m_key;
+    uint64_t m_counter;
+};
+
 // note, in order to stop confusing myself I have ln defined:
 #define ln(X) log(X)
 
@@ -0,0 +1,113 @@
+// genlib - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace depthmapX {
+
+    /**
+     * @brief Number of threads to use when the caller asks for "as many as possible" (a thread count of 0)
+     * @return the hardware concurrency, or 1 if that can not be determined
+     */
+    inline int getDefaultThreadCount() {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads == 0 ? 1 : static_cast<int>(hardwareThreads);
+    }
+
+    /**
+     * @brief Resolve a user supplied thread count: 0 (or less) means use all available cores
+     */
+    inline int resolveThreadCount(int threadCount) {
+        return threadCount <= 0 ? getDefaultThreadCount() : threadCount;
+    }
+
+    /**
+     * @brief Split the items [0, itemCount) over a set of threads. Items are handed out in chunks through
+     * a shared counter, so each thread processes increasing item indices, but the interleaving between threads
+     * is not defined. The calling thread takes part in the work as thread 0, so a thread count of 1 runs
+     * everything serially on the calling thread without starting any others.
+     *
+     * func is called as func(threadIndex, itemIndex). Anything that is shared between threads (for example
+     * results) should be stored by item index, and any scratch space by thread index.
+     *
+     * If func throws on any thread, the other threads stop after the item they are on rather than finishing
+     * their chunk, and the first exception is rethrown on the calling thread once all the threads have finished.
+     * To stop promptly on a cancel, every thread should check for it, not only thread 0.
+     *
+     * @param threadCount number of threads, 0 for the default thread count
+     * @param itemCount number of items to process
+     * @param func the function to call for each item
+     * @param chunkSize number of consecutive items a thread takes at once
+     */
+    template <typename F> void parallelFor(int threadCount, size_t itemCount, F &&func, size_t chunkSize = 1) {
+        threadCount = resolveThreadCount(threadCount);
+        if (itemCount == 0) {
+            return;
+        }
+        chunkSize = std::max<size_t>(1, chunkSize);
+        size_t chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+        if (static_cast<size_t>(threadCount) > chunkCount) {
+            threadCount = static_cast<int>(chunkCount);
+        }
+
+        std::atomic<size_t> nextChunk(0);
+        std::atomic<bool> stop(false);
+        std::exception_ptr firstException;
+        std::mutex exceptionMutex;
+
+        auto worker = [&](int threadIndex) {
+            try {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                    if (chunk >= chunkCount) {
+                        break;
+                    }
+                    size_t first = chunk * chunkSize;
+                    size_t last = std::min(itemCount, first + chunkSize);
+                    for (size_t item = first; item < last && !stop.load(std::memory_order_relaxed); item++) {
+                        func(threadIndex, item);
+                    }
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!firstException) {
+                    firstException = std::current_exception();
+                }
+                stop = true;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(static_cast<size_t>(threadCount - 1));
+        for (int threadIndex = 1; threadIndex < threadCount; threadIndex++) {
+            threads.emplace_back(worker, threadIndex);
+        }
+        worker(0);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        if (firstException) {
+            std::rethrow_exception(firstException);
+        }
+    }
+} // namespace depthmapX
@@ -18,6 +18,8 @@
 #include "genlib/p2dpoly.h"
 #include "genlib/bsptree.h"
 
+#include <sstream>
+
 TEST_CASE("BSPTree::pickMidpointLine")
 {
     std::vector<TaggedLine> lines;
@@ -217,3 +219,51 @@ TEST_CASE("BSPTree::make (all vertical lines)", "split tree")
     REQUIRE(node->m_right->m_left->m_left == nullptr);
     REQUIRE(node->m_right->m_left->m_right == nullptr);
 }
+
+void compareTrees(const BSPNode &n1, const BSPNode &n2, const BSPNode *parent2) {
+    // the lines are read back exactly as written
+    REQUIRE(n1.getLine().t_start() == n2.getLine().t_start());
+    REQUIRE(n1.getLine().t_end() == n2.getLine().t_end());
+    REQUIRE(n1.getTag() == n2.getTag());
+    REQUIRE(n2.m_parent == parent2);
+    REQUIRE((n1.m_left == nullptr) == (n2.m_left == nullptr));
+    REQUIRE((n1.m_right == nullptr) == (n2.m_right == nullptr));
+    if (n1.m_left) {
+        compareTrees(*n1.m_left, *n2.m_left, &n2);
+    }
+    if (n1.m_right) {
+        compareTrees(*n1.m_right, *n2.m_right, &n2);
+    }
+}
+
+TEST_CASE("BSPTree::write and BSPTree::read")
+{
+    std::vector<TaggedLine> lines;
+    lines.push_back(TaggedLine(Line(Point2f(1.5, 1), Point2f(1.5, 3)), 0));
+    lines.push_back(TaggedLine(Line(Point2f(2.5, 1), Point2f(2.5, 3)), 1));
+    lines.push_back(TaggedLine(Line(Point2f(3.5, 1), Point2f(3.5, 3)), 2));
+    lines.push_back(TaggedLine(Line(Point2f(4.5, 1), Point2f(4.5, 3)), 3));
+    lines.push_back(TaggedLine(Line(Point2f(1, 2), Point2f(5, 2)), 4));
+
+    BSPNode node;
+    BSPTree::make(0, 0, lines, &node);
+
+    std::stringstream stream;
+    BSPTree::write(stream, node);
+
+    BSPNode readNode;
+    BSPTree::read(stream, readNode);
+    compareTrees(node, readNode, nullptr);
+
+    // nothing is left over
+    char c;
+    stream.read(&c, 1);
+    REQUIRE(stream.eof());
+
+    SECTION("Truncated data") {
+        std::string data = stream.str();
+        std::stringstream truncated(data.substr(0, data.size() - 1));
+        BSPNode truncatedNode;
+        REQUIRE_THROWS(BSPTree::read(truncated, truncatedNode));
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../genlib/bucketqueue.h"
+
+#include <limits>
+#include <random>
+#include <set>
+
+namespace {
+    struct KeyedValue {
+        float key;
+        int id;
+        int tag; // not compared, to tell apart values that compare equal
+    };
+    bool operator<(const KeyedValue &a, const KeyedValue &b) {
+        return a.key < b.key || (a.key == b.key && a.id < b.id);
+    }
+} // namespace
+
+TEST_CASE("Bucket queue pops in order") {
+    depthmapX::BucketQueue<KeyedValue> queue(1.0);
+    REQUIRE(queue.empty());
+    queue.push(2.5, KeyedValue{2.5f, 1, 0});
+    queue.push(0.5, KeyedValue{0.5f, 2, 0});
+    queue.push(0.5, KeyedValue{0.5f, 1, 0});
+    queue.push(7.0, KeyedValue{7.0f, 0, 0});
+    REQUIRE(queue.size() == 4);
+    REQUIRE(queue.top().id == 1);
+    REQUIRE(queue.pop().key == 0.5f);
+    REQUIRE(queue.pop().id == 2);
+    REQUIRE(queue.pop().key == 2.5f);
+    // a key smaller than those already popped still comes out first
+    queue.push(1.0, KeyedValue{1.0f, 0, 0});
+    REQUIRE(queue.pop().key == 1.0f);
+    REQUIRE(queue.pop().key == 7.0f);
+    REQUIRE(queue.empty());
+    REQUIRE_THROWS_AS(queue.pop(), std::out_of_range);
+}
+
+TEST_CASE("Bucket queue takes keys beyond its buckets") {
+    depthmapX::BucketQueue<KeyedValue> queue(1.0);
+    const float infinity = std::numeric_limits<float>::infinity();
+    queue.push(std::numeric_limits<double>::infinity(), KeyedValue{infinity, 0, 0});
+    queue.push(1e30, KeyedValue{1e30f, 0, 0});
+    queue.push(1e20, KeyedValue{1e20f, 0, 0});
+    queue.push(std::numeric_limits<double>::quiet_NaN(), KeyedValue{infinity, 1, 0});
+    queue.push(3.0, KeyedValue{3.0f, 0, 0});
+    REQUIRE(queue.pop().key == 3.0f);
+    REQUIRE(queue.pop().key == 1e20f);
+    REQUIRE(queue.pop().key == 1e30f);
+    REQUIRE(queue.pop().id == 0);
+    REQUIRE(queue.pop().id == 1);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Bucket queue matches the order of a set") {
+    // a set keeps the first of equal values, and the bucket queue pops that one first
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> ids(0, 20);
+    std::uniform_real_distribution<float> steps(0.0f, 3.0f);
+    depthmapX::BucketQueue<KeyedValue> queue(0.5);
+    for (int run = 0; run < 3; run++) {
+        queue.clear();
+        std::set<KeyedValue> expected;
+        int tag = 0;
+        float last = 0.0f;
+        for (int i = 0; i < 2000; i++) {
+            // search-like: a few pushes above the last popped key, then a pop
+            for (int j = 0; j < 3; j++) {
+                // quantise the steps so that many keys are equal
+                float key = last + float(int(steps(generator) * 4)) / 4.0f;
+                KeyedValue value{key, ids(generator), tag++};
+                queue.push(key, value);
+                expected.insert(value);
+            }
+            KeyedValue popped = queue.pop();
+            KeyedValue setFirst = *expected.begin();
+            expected.erase(expected.begin());
+            REQUIRE(popped.key == setFirst.key);
+            REQUIRE(popped.id == setFirst.id);
+            REQUIRE(popped.tag == setFirst.tag);
+            last = popped.key;
+            // drop the duplicates the set ignored
+            while (!queue.empty() && !(setFirst < queue.top()) && !(queue.top() < setFirst)) {
+                queue.pop();
+            }
+        }
+    }
+}
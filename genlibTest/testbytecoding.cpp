@@ -0,0 +1,57 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../genlib/bytecoding.h"
+
+#include <limits>
+
+TEST_CASE("Values read back as they were written") {
+    depthmapX::ByteWriter writer;
+    writer.writeVarint(0);
+    writer.writeVarint(127);
+    writer.writeVarint(128);
+    writer.writeVarint(std::numeric_limits<uint64_t>::max());
+    writer.writeSignedVarint(-1);
+    writer.writeSignedVarint(63);
+    writer.writeSignedVarint(-64);
+    writer.writeSignedVarint(std::numeric_limits<int64_t>::min());
+    writer.writeRaw(1.5f);
+    // small numbers take a single byte whatever their sign
+    REQUIRE(writer.size() == 1 + 1 + 2 + 10 + 1 + 1 + 1 + 10 + sizeof(float));
+
+    depthmapX::ByteReader reader(writer.bytes().data(), writer.size());
+    REQUIRE(reader.readVarint() == 0);
+    REQUIRE(reader.readVarint() == 127);
+    REQUIRE(reader.readVarint() == 128);
+    REQUIRE(reader.readVarint() == std::numeric_limits<uint64_t>::max());
+    REQUIRE(reader.readSignedVarint() == -1);
+    REQUIRE(reader.readSignedVarint() == 63);
+    REQUIRE(reader.readSignedVarint() == -64);
+    REQUIRE(reader.readSignedVarint() == std::numeric_limits<int64_t>::min());
+    REQUIRE(reader.readRaw<float>() == 1.5f);
+    REQUIRE(reader.atEnd());
+    REQUIRE_THROWS_AS(reader.readVarint(), depthmapX::RuntimeException);
+}
+
+TEST_CASE("Reading past the end of coded data") {
+    depthmapX::ByteWriter writer;
+    writer.writeVarint(300);
+    // the first byte of the varint says there is more to come
+    depthmapX::ByteReader truncated(writer.bytes().data(), 1);
+    REQUIRE_THROWS_AS(truncated.readVarint(), depthmapX::RuntimeException);
+    depthmapX::ByteReader tooShort(writer.bytes().data(), writer.size());
+    REQUIRE_THROWS_AS(tooShort.readRaw<double>(), depthmapX::RuntimeException);
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../genlib/epochmatrix.h"
+
+TEST_CASE("Epoch matrix starts with default values") {
+    depthmapX::EpochMatrix<int> matrix(2, 3, -1);
+    REQUIRE(matrix.rows() == 2);
+    REQUIRE(matrix.columns() == 3);
+    for (size_t row = 0; row < 2; row++) {
+        for (size_t column = 0; column < 3; column++) {
+            REQUIRE_FALSE(matrix.isSet(row, column));
+            REQUIRE(matrix.value(row, column) == -1);
+        }
+    }
+    REQUIRE(matrix(1, 2) == -1);
+    REQUIRE(matrix.isSet(1, 2));
+    REQUIRE_FALSE(matrix.isSet(1, 1));
+}
+
+TEST_CASE("Epoch matrix values are kept until cleared") {
+    depthmapX::EpochMatrix<int> matrix(2, 3, 0);
+    matrix(0, 1) = 5;
+    matrix(1, 0) |= 2;
+    matrix(1, 0) |= 4;
+    REQUIRE(matrix.value(0, 1) == 5);
+    REQUIRE(matrix.value(1, 0) == 6);
+    REQUIRE(matrix.value(0, 0) == 0);
+    REQUIRE_FALSE(matrix.isSet(0, 0));
+
+    matrix.clear();
+    REQUIRE_FALSE(matrix.isSet(0, 1));
+    REQUIRE_FALSE(matrix.isSet(1, 0));
+    REQUIRE(matrix.value(0, 1) == 0);
+    REQUIRE(matrix(1, 0) == 0);
+
+    matrix(0, 1) = 7;
+    REQUIRE(matrix.value(0, 1) == 7);
+}
+
+TEST_CASE("Epoch matrix position dependent initial values") {
+    depthmapX::EpochMatrix<int> matrix(3, 3);
+    REQUIRE(matrix.get(2, 1, 21) == 21);
+    matrix.get(2, 1, 21)++;
+    // the initial value is only used the first time the cell is accessed
+    REQUIRE(matrix.get(2, 1, 21) == 22);
+    matrix.clear();
+    REQUIRE(matrix.get(2, 1, 21) == 21);
+}
+
+TEST_CASE("Epoch matrix out of range access") {
+    depthmapX::EpochMatrix<int> matrix(2, 3);
+    REQUIRE_THROWS_AS(matrix.at(2, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(matrix.at(0, 3), std::out_of_range);
+    matrix.at(1, 2) = 4;
+    REQUIRE(matrix.value(1, 2) == 4);
+}
+
+TEST_CASE("Epoch matrix moved as a window over a larger grid") {
+    depthmapX::EpochMatrix<int> matrix(3, 3, -1);
+    matrix.moveTo(10, 20);
+    REQUIRE(matrix.contains(10, 20));
+    REQUIRE(matrix.contains(12, 22));
+    REQUIRE_FALSE(matrix.contains(9, 20));
+    REQUIRE_FALSE(matrix.contains(10, 23));
+    matrix(11, 21) = 5;
+    REQUIRE(matrix.value(11, 21) == 5);
+    REQUIRE_THROWS_AS(matrix.at(0, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(matrix.at(13, 21), std::out_of_range);
+
+    // moving clears the window, and it may hang over the edge of the grid
+    matrix.moveTo(-1, -1);
+    REQUIRE(matrix.contains(0, 0));
+    REQUIRE(matrix.contains(1, 1));
+    REQUIRE_FALSE(matrix.contains(2, 0));
+    REQUIRE(matrix.value(1, 1) == -1);
+    matrix(1, 1) = 3;
+    REQUIRE(matrix.isSet(1, 1));
+    REQUIRE_FALSE(matrix.isSet(0, 1));
+}
@@ -0,0 +1,84 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../genlib/exceptions.h"
+#include "../genlib/lzcodec.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+    std::vector<unsigned char> roundTrip(const std::vector<unsigned char> &data) {
+        std::vector<unsigned char> compressed = depthmapX::lz::compress(data.data(), data.size());
+        std::vector<unsigned char> decompressed(data.size());
+        depthmapX::lz::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size());
+        return decompressed;
+    }
+} // namespace
+
+TEST_CASE("Compressed blocks decompress to the same data") {
+    REQUIRE(roundTrip({}).empty());
+    std::vector<unsigned char> shortData{1, 2, 3};
+    REQUIRE(roundTrip(shortData) == shortData);
+
+    // long runs, which make matches overlapping the bytes they copy, and long lengths
+    std::vector<unsigned char> runs(100000, 7);
+    runs[5000] = 8;
+    REQUIRE(roundTrip(runs) == runs);
+    REQUIRE(depthmapX::lz::compress(runs.data(), runs.size()).size() < 1000);
+
+    // noise that cannot be compressed, and repeats further apart than the codec can see
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> bytes(0, 255);
+    std::vector<unsigned char> noise(200000);
+    for (auto &byte : noise) {
+        byte = static_cast<unsigned char>(bytes(generator));
+    }
+    std::copy(noise.begin(), noise.begin() + 1000, noise.begin() + 100000);
+    REQUIRE(roundTrip(noise) == noise);
+
+    // short repeats mixed with noise
+    std::vector<unsigned char> mixed;
+    for (int i = 0; i < 20000; i++) {
+        mixed.push_back(static_cast<unsigned char>(i % 5));
+        mixed.push_back(static_cast<unsigned char>(bytes(generator) % 3));
+    }
+    REQUIRE(roundTrip(mixed) == mixed);
+}
+
+TEST_CASE("Decompressing damaged blocks") {
+    std::vector<unsigned char> data(1000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<unsigned char>(i % 17);
+    }
+    std::vector<unsigned char> compressed = depthmapX::lz::compress(data.data(), data.size());
+    std::vector<unsigned char> out(data.size());
+
+    // too small or too large for the data
+    REQUIRE_THROWS_AS(depthmapX::lz::decompress(compressed.data(), compressed.size(), out.data(), out.size() - 1),
+                      depthmapX::RuntimeException);
+    std::vector<unsigned char> larger(data.size() + 1);
+    REQUIRE_THROWS_AS(depthmapX::lz::decompress(compressed.data(), compressed.size(), larger.data(), larger.size()),
+                      depthmapX::RuntimeException);
+    // cut short
+    REQUIRE_THROWS_AS(depthmapX::lz::decompress(compressed.data(), compressed.size() / 2, out.data(), out.size()),
+                      depthmapX::RuntimeException);
+    // a match from before the start of the block
+    std::vector<unsigned char> badOffset{0x00, 0x10, 0x00};
+    REQUIRE_THROWS_AS(depthmapX::lz::decompress(badOffset.data(), badOffset.size(), out.data(), out.size()),
+                      depthmapX::RuntimeException);
+}
@@ -0,0 +1,62 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../cliTest/selfcleaningfile.h"
+#include "../genlib/mappedfile.h"
+#include "../genlib/readwritehelpers.h"
+
+#include <fstream>
+
+TEST_CASE("Reading through a mapped file") {
+    SelfCleaningFile testFile("mappedfile.bin");
+    std::vector<int> values{1, 2, 3, 4, 5};
+    {
+        std::ofstream outfile(testFile.Filename(), std::ios::binary);
+        int header = 42;
+        outfile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        dXreadwrite::writeVector(outfile, values);
+    }
+
+    depthmapX::MappedFile file(testFile.Filename());
+#ifndef _WIN32
+    REQUIRE(file.isOpen());
+    REQUIRE(file.size() == sizeof(int) + sizeof(unsigned int) + values.size() * sizeof(int));
+
+    std::istream stream(&file);
+    int header = 0;
+    stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+    REQUIRE(header == 42);
+    auto mark = stream.tellg();
+    REQUIRE(dXreadwrite::readVector<int>(stream) == values);
+    REQUIRE(stream.good());
+
+    // read again from the mark, as is done for the all-line maps
+    stream.seekg(mark);
+    REQUIRE(dXreadwrite::readVector<int>(stream) == values);
+
+    // nothing is left
+    stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+    REQUIRE(stream.eof());
+#else
+    REQUIRE_FALSE(file.isOpen());
+#endif
+}
+
+TEST_CASE("Mapping a file that does not exist") {
+    depthmapX::MappedFile file("doesnotexist.bin");
+    REQUIRE_FALSE(file.isOpen());
+    REQUIRE(file.size() == 0);
+}
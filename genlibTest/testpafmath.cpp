@@ -0,0 +1,84 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../genlib/pafmath.h"
+
+#include <vector>
+
+TEST_CASE("Copied random states draw the same numbers as pafrand") {
+    // use a set of its own so that the sequence of the other tests is not disturbed
+    const int set = 10;
+    pafsrand(1234, set);
+    uint64_t state = pafrandstate(set);
+    std::vector<unsigned int> expected;
+    for (int i = 0; i < 100; i++) {
+        expected.push_back(pafrand(set));
+    }
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(pafrandnext(state) == expected[i]);
+    }
+    REQUIRE(state == pafrandstate(set));
+}
+
+TEST_CASE("Skipping random numbers") {
+    const int set = 10;
+    pafsrand(42, set);
+    uint64_t start = pafrandstate(set);
+    std::vector<uint64_t> states;
+    states.push_back(start);
+    for (int i = 0; i < 1000; i++) {
+        pafrand(set);
+        states.push_back(pafrandstate(set));
+    }
+    for (uint64_t count : {0, 1, 2, 3, 7, 64, 513, 1000}) {
+        REQUIRE(pafrandskip(start, count) == states[count]);
+    }
+    // skips add up
+    REQUIRE(pafrandskip(pafrandskip(start, 300), 700) == states[1000]);
+
+    pafsetrandstate(states[10], set);
+    uint64_t copy = states[10];
+    REQUIRE(pafrand(set) == pafrandnext(copy));
+}
+
+TEST_CASE("Random streams") {
+    const int count = 1000;
+    auto draw = [](PafRandomStream stream) {
+        std::vector<unsigned int> numbers;
+        for (int i = 0; i < count; i++) {
+            numbers.push_back(stream.rand());
+        }
+        return numbers;
+    };
+    std::vector<unsigned int> numbers = draw(PafRandomStream(7, 3));
+    // the same seed and stream always give the same numbers, whatever else is drawn in between
+    pafrand();
+    REQUIRE(draw(PafRandomStream(7, 3)) == numbers);
+    // while another stream or another seed does not
+    REQUIRE(draw(PafRandomStream(7, 4)) != numbers);
+    REQUIRE(draw(PafRandomStream(8, 3)) != numbers);
+
+    double sum = 0.0;
+    PafRandomStream stream(7, 3);
+    for (int i = 0; i < count; i++) {
+        REQUIRE(numbers[i] <= PAF_RAND_MAX);
+        double value = stream.randomr();
+        REQUIRE(value >= 0.0);
+        REQUIRE(value < 1.0);
+        sum += value;
+    }
+    REQUIRE(sum / count == Approx(0.5).epsilon(0.1));
+}
@@ -0,0 +1,92 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "../genlib/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parallelFor visits every item once") {
+    for (int threads : {1, 3, 8}) {
+        for (size_t chunk : {1, 7}) {
+            std::vector<int> visits(1000, 0);
+            std::vector<int> threadOfItem(1000, -1);
+            depthmapX::parallelFor(threads, visits.size(), [&](int threadIndex, size_t item) {
+                visits[item]++;
+                threadOfItem[item] = threadIndex;
+            }, chunk);
+            bool allVisitedOnce = std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; });
+            bool allValidThreads = std::all_of(threadOfItem.begin(), threadOfItem.end(),
+                                               [threads](int t) { return t >= 0 && t < threads; });
+            REQUIRE(allVisitedOnce);
+            REQUIRE(allValidThreads);
+        }
+    }
+}
+
+TEST_CASE("parallelFor with a single thread runs in order on the calling thread") {
+    std::vector<size_t> order;
+    depthmapX::parallelFor(1, 10, [&](int threadIndex, size_t item) {
+        REQUIRE(threadIndex == 0);
+        order.push_back(item);
+    });
+    std::vector<size_t> expected{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    REQUIRE(order == expected);
+}
+
+TEST_CASE("parallelFor rethrows on the calling thread") {
+    std::atomic<int> processed(0);
+    auto throwingFunc = [&](int, size_t item) {
+        if (item == 10) {
+            throw std::runtime_error("stop");
+        }
+        processed++;
+    };
+    REQUIRE_THROWS_AS(depthmapX::parallelFor(4, 100000, throwingFunc), std::runtime_error);
+    REQUIRE(processed < 100000);
+}
+
+TEST_CASE("parallelFor stops the other threads within their chunk") {
+    // one chunk per thread, and the chunk of item 0 throws once the other threads are into theirs
+    const size_t chunk = 1000;
+    std::atomic<int> started(0);
+    std::atomic<int> processed(0);
+    auto throwingFunc = [&](int, size_t item) {
+        if (item == 0) {
+            while (started < 3) {
+                std::this_thread::yield();
+            }
+            throw std::runtime_error("cancelled");
+        }
+        if (item % chunk == 0) {
+            started++;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        processed++;
+    };
+    REQUIRE_THROWS_AS(depthmapX::parallelFor(4, 4 * chunk, throwingFunc, chunk), std::runtime_error);
+    REQUIRE(processed < 3 * int(chunk));
+}
+
+TEST_CASE("Thread count resolution") {
+    REQUIRE(depthmapX::resolveThreadCount(3) == 3);
+    REQUIRE(depthmapX::resolveThreadCount(0) == depthmapX::getDefaultThreadCount());
+    REQUIRE(depthmapX::getDefaultThreadCount() >= 1);
+}
@@ -17,6 +17,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "segmmetricshortestpath.h"
+#include "salalib/segmentgraph.h"
 
 #include "genlib/stringutils.h"
 
@@ -46,6 +47,7 @@ bool SegmentMetricShortestPath::run(Communicator *) {
 
     int maxbin = 512;
 
+    const SegmentGraph graph(m_map.getConnections());
     std::vector<unsigned int> seen(shapeCount, 0xffffffff);
     std::vector<TopoMetSegmentRef> audittrail(shapeCount);
     std::vector<int> list[512]; // 512 bins!
@@ -91,22 +93,8 @@ bool SegmentMetricShortestPath::run(Communicator *) {
             here.done = true;
         }
 
-        Connector &axline = m_map.getConnections().at(here.ref);
-        int connected_cursor = -2;
-
-        auto iter = axline.m_back_segconns.begin();
-        bool backsegs = true;
-
-        while (connected_cursor != -1) {
-            if (backsegs && iter == axline.m_back_segconns.end()) {
-                iter = axline.m_forward_segconns.begin();
-                backsegs = false;
-            }
-            if (!backsegs && iter == axline.m_forward_segconns.end()) {
-                break;
-            }
-
-            connected_cursor = iter->first.ref;
+        for (SegmentGraph::Link link : graph.links(here.ref)) {
+            int connected_cursor = link.segment.ref;
             if (seen[connected_cursor] > segdepth) {
                 float length = seglengths[connected_cursor];
                 seen[connected_cursor] = segdepth;
@@ -125,7 +113,6 @@ bool SegmentMetricShortestPath::run(Communicator *) {
                 refFound = true;
                 break;
             }
-            iter++;
         }
     }
 
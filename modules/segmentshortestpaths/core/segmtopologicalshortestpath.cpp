@@ -17,6 +17,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "segmtopologicalshortestpath.h"
+#include "salalib/segmentgraph.h"
 
 #include "genlib/stringutils.h"
 
@@ -46,6 +47,7 @@ bool SegmentTopologicalShortestPath::run(Communicator *comm) {
 
     int maxbin = 2;
 
+    const SegmentGraph graph(m_map.getConnections());
     std::vector<unsigned int> seen(shapeCount, 0xffffffff);
     std::vector<TopoMetSegmentRef> audittrail(shapeCount);
     std::vector<int> list[512]; // 512 bins!
@@ -90,22 +92,8 @@ bool SegmentTopologicalShortestPath::run(Communicator *comm) {
             here.done = true;
         }
 
-        Connector &axline = m_map.getConnections().at(here.ref);
-        int connected_cursor = -2;
-
-        auto iter = axline.m_back_segconns.begin();
-        bool backsegs = true;
-
-        while (connected_cursor != -1) {
-            if (backsegs && iter == axline.m_back_segconns.end()) {
-                iter = axline.m_forward_segconns.begin();
-                backsegs = false;
-            }
-            if (!backsegs && iter == axline.m_forward_segconns.end()) {
-                break;
-            }
-
-            connected_cursor = iter->first.ref;
+        for (SegmentGraph::Link link : graph.links(here.ref)) {
+            int connected_cursor = link.segment.ref;
             AttributeRow &row = m_map.getAttributeRowFromShapeIndex(connected_cursor);
             if (seen[connected_cursor] > segdepth) {
                 float length = seglengths[connected_cursor];
@@ -135,7 +123,6 @@ bool SegmentTopologicalShortestPath::run(Communicator *comm) {
                 refFound = true;
                 break;
             }
-            iter++;
         }
         if (refFound)
             break;
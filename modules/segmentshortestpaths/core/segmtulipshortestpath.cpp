@@ -18,6 +18,8 @@
 
 #include "segmtulipshortestpath.h"
 
+#include "salalib/segmentgraph.h"
+
 #include "genlib/stringutils.h"
 
 // revised to use tulip bins for faster analysis of large spaces
@@ -33,6 +35,7 @@ bool SegmentTulipShortestPath::run(Communicator *) {
     // in order to duplicate previous code (using a semicircle of tulip bins)
     size_t tulip_bins = 513;
 
+    const SegmentGraph graph(m_map.getConnections());
     std::vector<bool> covered(m_map.getConnections().size());
     for (size_t i = 0; i < m_map.getConnections().size(); i++) {
         covered[i] = false;
@@ -85,33 +88,32 @@ bool SegmentTulipShortestPath::run(Communicator *) {
         opencount--;
         if (!covered[lineindex.ref]) {
             covered[lineindex.ref] = true;
-            Connector &line = m_map.getConnections()[lineindex.ref];
             // convert depth from tulip_bins normalised to standard angle
             // (note the -1)
             double depth_to_line = depthlevel / ((tulip_bins - 1) * 0.5);
             m_map.getAttributeRowFromShapeIndex(lineindex.ref).setValue(angle_col, depth_to_line);
             int extradepth;
             if (lineindex.dir != -1) {
-                for (auto &segconn : line.m_forward_segconns) {
-                    if (!covered[segconn.first.ref]) {
-                        extradepth = (int)floor(segconn.second * tulip_bins * 0.5);
+                for (SegmentGraph::Link link : graph.forwardLinks(lineindex.ref)) {
+                    if (!covered[link.segment.ref]) {
+                        extradepth = (int)floor(link.weight * tulip_bins * 0.5);
                         bins[(currentbin + tulip_bins + extradepth) % tulip_bins].push_back(
-                            SegmentData(segconn.first, lineindex.ref, lineindex.segdepth + 1, 0.0, 0));
-                        if(parents.find(segconn.first.ref) == parents.end()) {
-                            parents[segconn.first.ref] = lineindex.ref;
+                            SegmentData(link.segment, lineindex.ref, lineindex.segdepth + 1, 0.0, 0));
+                        if(parents.find(link.segment.ref) == parents.end()) {
+                            parents[link.segment.ref] = lineindex.ref;
                         }
                         opencount++;
                     }
                 }
             }
             if (lineindex.dir != 1) {
-                for (auto &segconn : line.m_back_segconns) {
-                    if (!covered[segconn.first.ref]) {
-                        extradepth = (int)floor(segconn.second * tulip_bins * 0.5);
+                for (SegmentGraph::Link link : graph.backLinks(lineindex.ref)) {
+                    if (!covered[link.segment.ref]) {
+                        extradepth = (int)floor(link.weight * tulip_bins * 0.5);
                         bins[(currentbin + tulip_bins + extradepth) % tulip_bins].push_back(
-                            SegmentData(segconn.first, lineindex.ref, lineindex.segdepth + 1, 0.0, 0));
-                        if(parents.find(segconn.first.ref) == parents.end()) {
-                            parents[segconn.first.ref] = lineindex.ref;
+                            SegmentData(link.segment, lineindex.ref, lineindex.segdepth + 1, 0.0, 0));
+                        if(parents.find(link.segment.ref) == parents.end()) {
+                            parents[link.segment.ref] = lineindex.ref;
                         }
                         opencount++;
                     }
@@ -0,0 +1,164 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/agents/agentengine.h"
+#include "salalib/agents/agentga.h"
+#include "salalib/agents/agenthelpers.h"
+#include "salalib/mgraph.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    // A 10x10 room with a wall in the middle of it
+    std::unique_ptr<MetaGraph> makeAgentGraph() {
+        std::unique_ptr<MetaGraph> mgraph(new MetaGraph);
+        mgraph->m_drawingFiles.emplace_back("Drawing file");
+        mgraph->m_drawingFiles.back().m_spacePixels.emplace_back("Drawing Map");
+        ShapeMap &drawingMap = mgraph->m_drawingFiles.back().m_spacePixels.back();
+        drawingMap.makePolyShape({Point2f(0.0, 0.0), Point2f(0.0, 10.0), Point2f(10.0, 10.0), Point2f(10.0, 0.0)},
+                                 false);
+        drawingMap.makeLineShape(Line(Point2f(5.0, 3.0), Point2f(5.0, 7.0)));
+        mgraph->updateParentRegions(drawingMap);
+
+        mgraph->addNewPointMap("VGA Map");
+        PointMap &vgaMap = mgraph->getPointMaps().back();
+        vgaMap.setGrid(0.5);
+        vgaMap.makePoints(Point2f(2.51, 5.01), 0);
+        vgaMap.sparkGraph2(nullptr, false, -1);
+        return mgraph;
+    }
+
+    std::unique_ptr<MetaGraph> runAgents(int selType, unsigned int seed, int numThreads, int replicates = 1) {
+        std::unique_ptr<MetaGraph> mgraph = makeAgentGraph();
+        PointMap &map = mgraph->getPointMaps().back();
+
+        AgentEngine engine;
+        engine.agentSets.push_back(AgentSet());
+        AgentSet &agentSet = engine.agentSets.back();
+        agentSet.m_sel_type = selType;
+        agentSet.m_release_rate = 0.5;
+        agentSet.m_lifetime = 100;
+        agentSet.m_vbin = 7;
+        agentSet.m_steps = 3;
+        engine.m_timesteps = 300;
+        engine.m_random_seed = seed;
+        engine.m_num_threads = numThreads;
+        engine.m_replicates = replicates;
+        engine.run(nullptr, &map);
+        return mgraph;
+    }
+
+    std::vector<float> getCounts(MetaGraph &mgraph, const std::string &column = g_col_total_counts) {
+        const AttributeTable &table = mgraph.getPointMaps().back().getAttributeTable();
+        size_t col = table.getColumnIndex(column);
+        std::vector<float> counts;
+        for (auto iter = table.begin(); iter != table.end(); iter++) {
+            counts.push_back(iter->getRow().getValue(col));
+        }
+        return counts;
+    }
+} // namespace
+
+TEST_CASE("Agents give the same counts for the same seed on any number of threads") {
+    for (int selType : {AgentProgram::SEL_STANDARD, AgentProgram::SEL_LOS}) {
+        std::vector<float> serialCounts = getCounts(*runAgents(selType, 1, 1));
+        float total = 0.0f;
+        for (float count : serialCounts) {
+            total += std::max(count, 0.0f);
+        }
+        REQUIRE(total > 1000.0f);
+
+        REQUIRE(getCounts(*runAgents(selType, 1, 1)) == serialCounts);
+        REQUIRE(getCounts(*runAgents(selType, 1, 3)) == serialCounts);
+        REQUIRE(getCounts(*runAgents(selType, 2, 1)) != serialCounts);
+    }
+}
+
+TEST_CASE("Replicated agent runs") {
+    const int replicates = 4;
+    std::unique_ptr<MetaGraph> mgraph = runAgents(AgentProgram::SEL_STANDARD, 5, 2, replicates);
+
+    // each replicate is the same as a single run with its seed
+    std::vector<std::vector<float>> replicateCounts;
+    for (int r = 0; r < replicates; r++) {
+        replicateCounts.push_back(
+            getCounts(*mgraph, g_col_total_counts + g_col_replicate_suffix + std::to_string(r + 1)));
+        REQUIRE(replicateCounts.back() == getCounts(*runAgents(AgentProgram::SEL_STANDARD, 5 + r, 1)));
+    }
+
+    std::vector<float> means = getCounts(*mgraph, g_col_total_counts + g_col_mean_suffix);
+    std::vector<float> variances = getCounts(*mgraph, g_col_total_counts + g_col_variance_suffix);
+    for (size_t i = 0; i < means.size(); i++) {
+        double sum = 0.0, sumSquares = 0.0;
+        for (int r = 0; r < replicates; r++) {
+            double count = std::max(replicateCounts[r][i], 0.0f);
+            sum += count;
+            sumSquares += count * count;
+        }
+        if (sum == 0.0) {
+            REQUIRE(means[i] == -1.0f);
+            continue;
+        }
+        double mean = sum / replicates;
+        REQUIRE(means[i] == Approx(mean));
+        REQUIRE(variances[i] == Approx((sumSquares - replicates * mean * mean) / (replicates - 1)));
+    }
+
+    // the same, whatever the number of threads
+    std::unique_ptr<MetaGraph> serialGraph = runAgents(AgentProgram::SEL_STANDARD, 5, 1, replicates);
+    REQUIRE(getCounts(*serialGraph, g_col_total_counts + g_col_variance_suffix) == variances);
+}
+
+TEST_CASE("Evolving agent programs gives the same programs on any number of threads") {
+    std::unique_ptr<MetaGraph> mgraph = makeAgentGraph();
+    PointMap &map = mgraph->getPointMaps().back();
+
+    AgentProgram program;
+    program.m_sel_type = AgentProgram::SEL_LENGTH;
+
+    auto evolve = [&](int numThreads) {
+        ProgramPopulation population(8);
+        population.m_assays = 2;
+        population.m_timesteps = 100;
+        population.m_random_seed = 3;
+        population.m_num_threads = numThreads;
+        population.init(program);
+        population.evolve(nullptr, map, 3);
+        return population;
+    };
+
+    ProgramPopulation serial = evolve(1);
+    ProgramPopulation parallel = evolve(3);
+    REQUIRE(serial.m_population.size() == 8);
+    for (size_t i = 0; i < serial.m_population.size(); i++) {
+        const AgentProgram &a = serial.m_population[i];
+        const AgentProgram &b = parallel.m_population[i];
+        REQUIRE(a.m_sel_type == AgentProgram::SEL_LENGTH);
+        REQUIRE(a.m_fitness == b.m_fitness);
+        for (int rule = 0; rule < 4; rule++) {
+            REQUIRE(a.m_rule_order[rule] == b.m_rule_order[rule]);
+            REQUIRE(a.m_rule_threshold[rule] == b.m_rule_threshold[rule]);
+        }
+        // best first
+        if (i > 0) {
+            REQUIRE(serial.m_population[i - 1].m_fitness >= a.m_fitness);
+        }
+    }
+    REQUIRE(serial.m_population[0].m_fitness > 1.0);
+}
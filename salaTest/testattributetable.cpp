@@ -18,6 +18,8 @@
 #include <salalib/attributetable.h>
 #include <cliTest/selfcleaningfile.h>
 #include <fstream>
+#include <cmath>
+#include <limits>
 #include <salalib/mgraph_consts.h>
 #include <salalib/layermanagerimpl.h>
 
@@ -392,6 +394,114 @@ TEST_CASE("attibute table iterations")
     REQUIRE(table.getRow(AttributeKey(1)).getValue(1) == Approx(3.2));
 }
 
+TEST_CASE("attribute table rows out of key order")
+{
+    AttributeTable table;
+    table.getOrInsertColumn("col1");
+
+    // rows added out of order are still iterated in key order, and keep their values
+    table.addRow(AttributeKey(5)).setValue(0, 5.0f);
+    table.addRow(AttributeKey(1)).setValue(0, 1.0f);
+    AttributeRow& row3 = table.addRow(AttributeKey(3));
+    row3.setValue(0, 3.0f);
+    REQUIRE_THROWS(table.addRow(AttributeKey(3)));
+
+    std::vector<int> keys;
+    for (auto& item : table)
+    {
+        keys.push_back(item.getKey().value);
+        REQUIRE(item.getRow().getValue(0) == Approx(float(item.getKey().value)));
+    }
+    REQUIRE(keys == std::vector<int>({1, 3, 5}));
+    REQUIRE(table.getColumnValues(0) == std::vector<float>({1.0f, 3.0f, 5.0f}));
+
+    // a new column covers all the rows, in the same order
+    table.getOrInsertColumn("col2");
+    REQUIRE(table.getColumnValues(1) == std::vector<float>({-1.0f, -1.0f, -1.0f}));
+    table.getRow(AttributeKey(5)).setValue(1, 0.5f);
+    REQUIRE(table.getColumnValues(1) == std::vector<float>({-1.0f, -1.0f, 0.5f}));
+
+    // rows keep working when others are added or removed before them
+    table.addRow(AttributeKey(0)).setValue(0, 0.0f);
+    table.removeRow(AttributeKey(1));
+    REQUIRE(row3.getValue(0) == Approx(3.0f));
+    row3.setValue(1, 0.3f);
+    REQUIRE(table.getRow(AttributeKey(3)).getValue(1) == Approx(0.3f));
+    REQUIRE(table.getRowPtr(AttributeKey(1)) == 0);
+    REQUIRE(table.find(AttributeKey(1)) == table.end());
+    REQUIRE(table.find(AttributeKey(5))->getRow().getValue(1) == Approx(0.5f));
+    REQUIRE(table.getColumnValues(0) == std::vector<float>({0.0f, 3.0f, 5.0f}));
+
+    // and when the table is moved
+    AttributeTable moved(std::move(table));
+    REQUIRE(row3.getValue(1) == Approx(0.3f));
+    REQUIRE(moved.getRow(AttributeKey(5)).getValue("col2") == Approx(0.5f));
+    REQUIRE(moved.getNumRows() == 3);
+
+    // several removals and additions made together are all sorted out once they are done
+    {
+        AttributeRowChanges rowChanges(moved);
+        moved.removeRow(AttributeKey(0));
+        moved.removeRow(AttributeKey(5));
+        moved.addRow(AttributeKey(4)).setValue(0, 4.0f);
+        moved.addRow(AttributeKey(2)).setValue(0, 2.0f);
+        REQUIRE(moved.getNumRows() == 3);
+        REQUIRE(moved.getRow(AttributeKey(2)).getValue(0) == Approx(2.0f));
+    }
+    REQUIRE(moved.getNumRows() == 3);
+    REQUIRE(moved.getRowIndex(AttributeKey(4)) == 2);
+    REQUIRE(moved.getColumnValues(0) == std::vector<float>({2.0f, 3.0f, 4.0f}));
+    REQUIRE(moved.back().getKey().value == 4);
+}
+
+TEST_CASE("attribute table bulk column writes")
+{
+    AttributeTable rowTable;
+    AttributeTable bulkTable;
+    for (AttributeTable* table : {&rowTable, &bulkTable})
+    {
+        table->getOrInsertColumn("col1");
+        table->getOrInsertColumn("col2");
+        for (int key : {4, 2, 8, 6})
+        {
+            table->addRow(AttributeKey(key)).setValue(1, float(key));
+        }
+    }
+    REQUIRE(bulkTable.getRowIndex(AttributeKey(6)) == 2);
+    REQUIRE_THROWS_AS(bulkTable.getRowIndex(AttributeKey(5)), std::out_of_range);
+
+    // the same values, including the -1 of rows without a value, written row by row and in bulk
+    std::vector<float> values({2.5f, -1.0f, 0.5f, 4.0f});
+    size_t i = 0;
+    for (auto& item : rowTable)
+    {
+        item.getRow().setValue(0, values[i++]);
+    }
+    AttributeBulkWriter writer(bulkTable);
+    for (size_t row = 0; row < values.size(); row++)
+    {
+        writer.value(row, 0) = values[row];
+    }
+    // unwritten values leave the row as it was, and written values are kept even if they are not a number
+    writer.value(3, 1) = 10.0f;
+    writer.value(1, 1) = std::numeric_limits<float>::quiet_NaN();
+    REQUIRE(bulkTable.getColumnValues(0) == values);
+    writer.commit();
+
+    REQUIRE(bulkTable.getColumnValues(0) == rowTable.getColumnValues(0));
+    const std::vector<float>& col2 = bulkTable.getColumnValues(1);
+    REQUIRE(col2[0] == 2.0f);
+    REQUIRE(std::isnan(col2[1]));
+    REQUIRE(col2[2] == 6.0f);
+    REQUIRE(col2[3] == 10.0f);
+    const AttributeColumnStats& rowStats = rowTable.getColumn(0).getStats();
+    const AttributeColumnStats& bulkStats = bulkTable.getColumn(0).getStats();
+    REQUIRE(bulkStats.min == rowStats.min);
+    REQUIRE(bulkStats.max == rowStats.max);
+    REQUIRE(bulkStats.total == rowStats.total);
+    REQUIRE(bulkTable.getColumn(1).getStats().max == Approx(10.0f));
+}
+
 #include <salalib/attributetablehelpers.h>
 
 TEST_CASE("Attribute Table - serialisation")
@@ -0,0 +1,86 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "genlib/pafmath.h"
+#include "salalib/axialmap.h"
+#include "salalib/axialmodules/axialintegration.h"
+#include "salalib/mapconverter.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+    // A grid of streets with a few diagonals, so that there are many shortest paths of equal length for choice
+    // to pick between
+    std::unique_ptr<ShapeGraph> makeTestAxialMap() {
+        std::vector<SpacePixelFile> drawingFiles;
+        drawingFiles.emplace_back("Drawing file");
+        drawingFiles.back().m_spacePixels.emplace_back("Drawing Map");
+        ShapeMap &drawingMap = drawingFiles.back().m_spacePixels.back();
+        for (int i = 1; i < 6; i++) {
+            drawingMap.makeLineShape(Line(Point2f(0.5, i), Point2f(5.5, i)));
+            drawingMap.makeLineShape(Line(Point2f(i, 0.5), Point2f(i, 5.5)));
+        }
+        drawingMap.makeLineShape(Line(Point2f(0.7, 0.5), Point2f(2.6, 2.4)));
+        drawingMap.makeLineShape(Line(Point2f(3.4, 5.5), Point2f(5.5, 3.4)));
+        drawingMap.makeLineShape(Line(Point2f(1.3, 4.9), Point2f(4.9, 1.3)));
+        return MapConverter::convertDrawingToAxial(nullptr, "Axial map", drawingFiles);
+    }
+
+    std::vector<std::vector<float>> getColumnValues(const AttributeTable &table) {
+        std::vector<std::vector<float>> values;
+        for (size_t col = 0; col < table.getNumColumns(); col++) {
+            values.push_back(table.getColumnValues(col));
+        }
+        return values;
+    }
+} // namespace
+
+TEST_CASE("Parallel axial analysis matches the serial analysis", "") {
+    std::unique_ptr<ShapeGraph> serialMap = makeTestAxialMap();
+    std::unique_ptr<ShapeGraph> parallelMap = makeTestAxialMap();
+    REQUIRE(serialMap->getShapeCount() > 10);
+
+    int lengthCol = serialMap->getAttributeTable().getColumnIndex("Line Length");
+    std::set<double> radii{-1.0, 2.0};
+
+    // choice draws random numbers, so both analyses start from the same point in the sequence
+    pafsrand(1);
+    REQUIRE(AxialIntegration(radii, lengthCol, true, true, true, 1).run(nullptr, *serialMap, false));
+    uint64_t serialRandState = pafrandstate();
+    pafsrand(1);
+    REQUIRE(AxialIntegration(radii, lengthCol, true, true, true, 3).run(nullptr, *parallelMap, false));
+    // and the sequence is left where the serial analysis leaves it
+    REQUIRE(pafrandstate() == serialRandState);
+
+    const AttributeTable &serialTable = serialMap->getAttributeTable();
+    const AttributeTable &parallelTable = parallelMap->getAttributeTable();
+    REQUIRE(serialTable.getNumColumns() == parallelTable.getNumColumns());
+    REQUIRE(serialTable.hasColumn("Choice [Line Length Wgt] R2"));
+    REQUIRE(serialTable.hasColumn("Control"));
+    REQUIRE(getColumnValues(serialTable) == getColumnValues(parallelTable));
+    for (size_t col = 0; col < serialTable.getNumColumns(); col++) {
+        REQUIRE(serialTable.getColumnName(col) == parallelTable.getColumnName(col));
+        REQUIRE(serialTable.getColumn(col).getStats().total == parallelTable.getColumn(col).getStats().total);
+    }
+
+    // the map is connected, so every line is reached from every root at radius n
+    size_t countCol = serialTable.getColumnIndex("Node Count");
+    for (float count : serialTable.getColumnValues(countCol)) {
+        REQUIRE(count == float(serialMap->getShapeCount()));
+    }
+    REQUIRE(serialTable.getColumn(serialTable.getColumnIndex("Choice")).getStats().max > 0);
+}
@@ -0,0 +1,138 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "cliTest/selfcleaningfile.h"
+#include "salalib/bspcache.h"
+#include "salalib/mgraph.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace {
+    // the plan of the simple isovist test, on one layer, and a line across it on another
+    void addPlan(std::vector<SpacePixelFile> &drawingFiles) {
+        std::vector<Line> planLines = {
+            Line(Point2f(1, 1), Point2f(1, 3)), //
+            Line(Point2f(1, 3), Point2f(3, 3)), //
+            Line(Point2f(3, 3), Point2f(3, 2)), //
+            Line(Point2f(3, 2), Point2f(2, 2)), //
+            Line(Point2f(2, 2), Point2f(2, 1)), //
+            Line(Point2f(2, 1), Point2f(1, 1))  //
+        };
+        drawingFiles.emplace_back("Test SpacePixelGroup");
+        drawingFiles.back().m_spacePixels.emplace_back("Test ShapeMap");
+        for (Line &line : planLines) {
+            drawingFiles.back().m_spacePixels.back().makeLineShape(line);
+        }
+        drawingFiles.back().m_spacePixels.emplace_back("Test Partition");
+        drawingFiles.back().m_spacePixels.back().makeLineShape(Line(Point2f(1, 2), Point2f(1.5, 3)));
+    }
+} // namespace
+
+TEST_CASE("BSP cache makes the tree only when the shown lines change") {
+    std::vector<SpacePixelFile> drawingFiles;
+    addPlan(drawingFiles);
+    BSPCache cache;
+    REQUIRE_FALSE(cache.hasTree());
+
+    BSPNode *tree = cache.getTree(nullptr, drawingFiles);
+    REQUIRE(tree != nullptr);
+    REQUIRE(cache.hasTree());
+    REQUIRE(cache.getTree(nullptr, drawingFiles) == tree);
+
+    std::vector<TaggedLine> allLines = BSPCache::getPartitionLines(drawingFiles);
+    REQUIRE(allLines.size() == 7);
+
+    // hiding a layer changes the lines, so a new tree is made
+    drawingFiles.back().m_spacePixels.back().setShow(false);
+    std::vector<TaggedLine> planLines = BSPCache::getPartitionLines(drawingFiles);
+    REQUIRE(planLines.size() == 6);
+    REQUIRE(BSPCache::makeKey(planLines) != BSPCache::makeKey(allLines));
+    BSPNode *planTree = cache.getTree(nullptr, drawingFiles);
+    REQUIRE(planTree != nullptr);
+    REQUIRE(planTree != tree);
+    REQUIRE(cache.getTree(nullptr, drawingFiles) == planTree);
+
+    // the same lines with other tags are other lines
+    std::vector<TaggedLine> retagged = planLines;
+    retagged[0].tag++;
+    REQUIRE(BSPCache::makeKey(retagged) != BSPCache::makeKey(planLines));
+
+    // no lines, no tree
+    drawingFiles.back().m_spacePixels.front().setShow(false);
+    REQUIRE(cache.getTree(nullptr, drawingFiles) == nullptr);
+
+    cache.clear();
+    REQUIRE_FALSE(cache.hasTree());
+}
+
+TEST_CASE("BSP tree stored in the graph") {
+    const float EPSILON = 0.001;
+    Point2f isovistOrigin(2.5, 2.5);
+
+    SelfCleaningFile plainFile("bspplain.graph");
+    SelfCleaningFile storedFile("bspstored.graph");
+    std::vector<Point2f> isovistPoints;
+    {
+        MetaGraph metaGraph("Test MetaGraph");
+        addPlan(metaGraph.m_drawingFiles);
+        metaGraph.setState(metaGraph.getState() | MetaGraph::LINEDATA);
+        metaGraph.makeIsovist(nullptr, isovistOrigin, 0, 0, false);
+        isovistPoints = metaGraph.getDataMaps().front().getAllShapes().begin()->second.m_points;
+
+        REQUIRE(metaGraph.write(plainFile.Filename(), METAGRAPH_VERSION) == MetaGraph::OK);
+        metaGraph.setStoreBSPtree(true);
+        REQUIRE(metaGraph.write(storedFile.Filename(), METAGRAPH_VERSION) == MetaGraph::OK);
+    }
+
+    MetaGraph plainGraph;
+    REQUIRE(plainGraph.readFromFile(plainFile.Filename()) == MetaGraph::OK);
+    REQUIRE_FALSE(plainGraph.getStoreBSPtree());
+
+    MetaGraph storedGraph;
+    REQUIRE(storedGraph.readFromFile(storedFile.Filename()) == MetaGraph::OK);
+    REQUIRE(storedGraph.getStoreBSPtree());
+    REQUIRE(storedGraph.getDataMaps().size() == 1);
+
+    auto requireSameIsovist = [&](MetaGraph &graph) {
+        graph.makeIsovist(nullptr, isovistOrigin, 0, 0, false);
+        auto &shapes = graph.getDataMaps().front().getAllShapes();
+        REQUIRE(shapes.size() == 2);
+        const std::vector<Point2f> &points = shapes.rbegin()->second.m_points;
+        REQUIRE(points.size() == isovistPoints.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            REQUIRE(points[i].x == Approx(isovistPoints[i].x).epsilon(EPSILON));
+            REQUIRE(points[i].y == Approx(isovistPoints[i].y).epsilon(EPSILON));
+        }
+    };
+
+    // the isovist made with the stored tree is the one made before
+    requireSameIsovist(storedGraph);
+
+    SECTION("A stored tree cut short is made again") {
+        SelfCleaningFile truncatedFile("bsptruncated.graph");
+        {
+            std::ifstream in(storedFile.Filename(), std::ios::binary);
+            std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            std::ofstream out(truncatedFile.Filename(), std::ios::binary);
+            out << data.substr(0, data.size() - 10);
+        }
+        MetaGraph truncatedGraph;
+        REQUIRE(truncatedGraph.readFromFile(truncatedFile.Filename()) == MetaGraph::OK);
+        REQUIRE(truncatedGraph.getDataMaps().size() == 1);
+        requireSameIsovist(truncatedGraph);
+    }
+}
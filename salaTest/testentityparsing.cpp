@@ -197,6 +197,26 @@ TEST_CASE("Successful Isovist parser")
     }
 }
 
+TEST_CASE("Reading isovists a number at a time")
+{
+    std::stringstream stream;
+    stream << "x,y\n1.0,2.0\n\n3.0,4.0\n5.0,6.0\n" << std::flush;
+    EntityParsing::IsovistReader reader(stream, ',');
+
+    std::vector<IsovistDefinition> isovists;
+    REQUIRE(reader.read(isovists, 2));
+    REQUIRE(isovists.size() == 2);
+    REQUIRE(isovists[1].getLocation().x == Approx(3.0));
+
+    // the rest, the empty line at the end is skipped
+    REQUIRE_FALSE(reader.read(isovists, 2));
+    REQUIRE(isovists.size() == 3);
+    REQUIRE(isovists[2].getLocation().y == Approx(6.0));
+
+    REQUIRE_FALSE(reader.read(isovists, 2));
+    REQUIRE(isovists.size() == 3);
+}
+
 TEST_CASE("Failing Isovist parser")
 {
     {
@@ -14,6 +14,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "catch.hpp"
+#include "salalib/isovist.h"
 #include "salalib/mgraph.h"
 
 TEST_CASE("Simple Isovist") {
@@ -100,3 +101,42 @@ TEST_CASE("Simple Isovist") {
     REQUIRE(isovist.m_points[11].x == Approx(3.0).epsilon(EPSILON));
     REQUIRE(isovist.m_points[11].y == Approx(2.5).epsilon(EPSILON));
 }
+
+TEST_CASE("Reused Isovist") {
+    // the same plan as above, with isovists made one after another in the same object
+    std::vector<Line> planLines = {
+        Line(Point2f(1, 1), Point2f(1, 3)), //
+        Line(Point2f(1, 3), Point2f(3, 3)), //
+        Line(Point2f(3, 3), Point2f(3, 2)), //
+        Line(Point2f(3, 2), Point2f(2, 2)), //
+        Line(Point2f(2, 2), Point2f(2, 1)), //
+        Line(Point2f(2, 1), Point2f(1, 1))  //
+    };
+
+    std::unique_ptr<MetaGraph> metaGraph(new MetaGraph("Test MetaGraph"));
+    metaGraph->m_drawingFiles.emplace_back("Test SpacePixelGroup");
+    metaGraph->m_drawingFiles.back().m_spacePixels.emplace_back("Test ShapeMap");
+    for (Line &line : planLines) {
+        metaGraph->m_drawingFiles.back().m_spacePixels.back().makeLineShape(line);
+    }
+
+    std::vector<Point2f> origins = {Point2f(2.5, 2.5), Point2f(1.5, 1.5), Point2f(1.2, 2.8), Point2f(2.9, 2.1)};
+    Isovist reused;
+    for (const Point2f &origin : origins) {
+        Isovist fresh;
+        REQUIRE(metaGraph->makeIsovist(origin, fresh));
+        REQUIRE(metaGraph->makeIsovist(origin, reused));
+        REQUIRE(reused.getPolygon().size() == fresh.getPolygon().size());
+        for (size_t i = 0; i < fresh.getPolygon().size(); i++) {
+            REQUIRE(reused.getPolygon()[i] == fresh.getPolygon()[i]);
+        }
+        REQUIRE(reused.getOcclusionPoints().size() == fresh.getOcclusionPoints().size());
+        REQUIRE(reused.getMeasures().area == fresh.getMeasures().area);
+        REQUIRE(reused.getMeasures().perimeter == fresh.getMeasures().perimeter);
+    }
+
+    // a point in the corridor sees the whole plan, area 3
+    Isovist isovist;
+    REQUIRE(metaGraph->makeIsovist(Point2f(1.5, 2.5), isovist));
+    REQUIRE(isovist.getMeasures().area == Approx(3.0));
+}
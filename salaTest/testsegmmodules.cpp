@@ -0,0 +1,215 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/axialmap.h"
+#include "salalib/mapconverter.h"
+#include "salalib/mgraph.h"
+#include "salalib/options.h"
+#include "salalib/segmentgraph.h"
+#include "salalib/segmmodules/segmmetric.h"
+#include "salalib/segmmodules/segmtopological.h"
+#include "salalib/segmmodules/segmtulip.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+    // A 5x5 street grid with a few diagonal shortcuts, so that the angular analysis has turns of different
+    // angles and paths of equal depth to choose between
+    std::unique_ptr<ShapeGraph> makeTestSegmentMap() {
+        std::vector<SpacePixelFile> drawingFiles;
+        drawingFiles.emplace_back("Drawing file");
+        drawingFiles.back().m_spacePixels.emplace_back("Drawing Map");
+        ShapeMap &drawingMap = drawingFiles.back().m_spacePixels.back();
+        for (int i = 0; i < 5; i++) {
+            for (int j = 0; j < 4; j++) {
+                drawingMap.makeLineShape(Line(Point2f(j, i), Point2f(j + 1, i)));
+                drawingMap.makeLineShape(Line(Point2f(i, j), Point2f(i, j + 1)));
+            }
+        }
+        drawingMap.makeLineShape(Line(Point2f(0, 0), Point2f(1, 1)));
+        drawingMap.makeLineShape(Line(Point2f(1, 1), Point2f(2, 2)));
+        drawingMap.makeLineShape(Line(Point2f(2, 3), Point2f(3, 4)));
+        drawingMap.makeLineShape(Line(Point2f(4, 0), Point2f(3, 1)));
+        return MapConverter::convertDrawingToSegment(nullptr, "Segment map", drawingFiles);
+    }
+
+    std::vector<std::vector<float>> getColumnValues(const AttributeTable &table) {
+        std::vector<std::vector<float>> values;
+        for (size_t col = 0; col < table.getNumColumns(); col++) {
+            values.push_back(table.getColumnValues(col));
+        }
+        return values;
+    }
+} // namespace
+
+TEST_CASE("Segment graph holds the connections of the connectors", "") {
+    std::unique_ptr<ShapeGraph> segmentMap = makeTestSegmentMap();
+    const std::vector<Connector> &connectors = segmentMap->getConnections();
+    SegmentGraph graph(connectors);
+    REQUIRE(graph.getSegmentCount() == connectors.size());
+
+    auto requireSameLinks = [](const SegmentGraph::Links &links, const std::map<SegmentRef, float> &segconns) {
+        REQUIRE(links.size() == segconns.size());
+        auto segconn = segconns.begin();
+        for (SegmentGraph::Link link : links) {
+            REQUIRE(link.segment.ref == segconn->first.ref);
+            REQUIRE(link.segment.dir == segconn->first.dir);
+            REQUIRE(link.weight == segconn->second);
+            ++segconn;
+        }
+    };
+
+    size_t linkCount = 0;
+    for (size_t i = 0; i < connectors.size(); i++) {
+        int ref = static_cast<int>(i);
+        requireSameLinks(graph.backLinks(ref), connectors[i].m_back_segconns);
+        requireSameLinks(graph.forwardLinks(ref), connectors[i].m_forward_segconns);
+        REQUIRE(graph.links(ref).size() ==
+                connectors[i].m_back_segconns.size() + connectors[i].m_forward_segconns.size());
+        // links() gives the back connections first
+        if (!connectors[i].m_back_segconns.empty()) {
+            REQUIRE((*graph.links(ref).begin()).segment.ref == connectors[i].m_back_segconns.begin()->first.ref);
+        }
+        linkCount += graph.links(ref).size();
+    }
+    REQUIRE(linkCount > 0);
+    REQUIRE(graph.getMemoryUsage() >= linkCount * (sizeof(int) + sizeof(char) + sizeof(float)));
+}
+
+TEST_CASE("Segment map keeps its segment graph until the connections change", "") {
+    std::unique_ptr<ShapeGraph> segmentMap = makeTestSegmentMap();
+    const SegmentGraph *graph = &segmentMap->getSegmentGraph();
+    REQUIRE(&segmentMap->getSegmentGraph() == graph);
+    size_t forwardCount = graph->forwardLinks(0).size();
+
+    // link the first segment to one it is not linked to yet
+    int target = -1;
+    for (int ref = 1; ref < static_cast<int>(segmentMap->getShapeCount()) && target == -1; ref++) {
+        bool linked = false;
+        for (SegmentGraph::Link link : graph->forwardLinks(0)) {
+            linked |= link.segment.ref == ref;
+        }
+        if (!linked) {
+            target = ref;
+        }
+    }
+    REQUIRE(target != -1);
+    segmentMap->linkShapes(0, 1, target, 1, 0.5f);
+
+    const SegmentGraph &updated = segmentMap->getSegmentGraph();
+    REQUIRE(updated.forwardLinks(0).size() == forwardCount + 1);
+    REQUIRE(updated.getSegmentCount() == segmentMap->getShapeCount());
+}
+
+TEST_CASE("Parallel tulip analysis matches the serial analysis", "") {
+    std::unique_ptr<ShapeGraph> serialMap = makeTestSegmentMap();
+    std::unique_ptr<ShapeGraph> parallelMap = makeTestSegmentMap();
+    REQUIRE(serialMap->getShapeCount() > 40);
+
+    int lengthCol = serialMap->getAttributeTable().getColumnIndex("Segment Length");
+    for (int radiusType : {Options::RADIUS_ANGULAR, Options::RADIUS_METRIC}) {
+        std::set<double> radii{-1.0, 2.0};
+        REQUIRE(SegmentTulip(radii, false, 1024, lengthCol, radiusType, true, false, -1, -1, 1)
+                    .run(nullptr, *serialMap, false));
+        REQUIRE(SegmentTulip(radii, false, 1024, lengthCol, radiusType, true, false, -1, -1, 4)
+                    .run(nullptr, *parallelMap, false));
+    }
+
+    const AttributeTable &serialTable = serialMap->getAttributeTable();
+    const AttributeTable &parallelTable = parallelMap->getAttributeTable();
+    REQUIRE(serialTable.getNumColumns() == parallelTable.getNumColumns());
+    REQUIRE(serialTable.hasColumn("T1024 Choice [Segment Length Wgt]"));
+    for (size_t col = 0; col < serialTable.getNumColumns(); col++) {
+        REQUIRE(serialTable.getColumnName(col) == parallelTable.getColumnName(col));
+        REQUIRE(parallelTable.getColumn(col).getStats().max == serialTable.getColumn(col).getStats().max);
+        REQUIRE(parallelTable.getColumn(col).getStats().total == serialTable.getColumn(col).getStats().total);
+    }
+    // the choice of each root is added in root order, so even the weighted choice is the same to the last bit
+    REQUIRE(getColumnValues(parallelTable) == getColumnValues(serialTable));
+
+    // on a connected map every segment is reached from every root at radius n, and there is through movement
+    size_t countCol = serialTable.getColumnIndex("T1024 Node Count");
+    size_t choiceCol = serialTable.getColumnIndex("T1024 Choice");
+    for (float count : serialTable.getColumnValues(countCol)) {
+        REQUIRE(count == float(serialMap->getShapeCount()));
+    }
+    REQUIRE(serialTable.getColumn(choiceCol).getStats().max > 0);
+}
+
+TEST_CASE("Topological and metric analysis of several radii matches analysing each radius alone", "") {
+    std::set<double> radii{-1.0, 2.0, 4.0};
+    for (bool topological : {true, false}) {
+        std::unique_ptr<ShapeGraph> separateMap = makeTestSegmentMap();
+        std::unique_ptr<ShapeGraph> fusedMap = makeTestSegmentMap();
+        for (double radius : radii) {
+            if (topological) {
+                REQUIRE(SegmentTopological(radius, false).run(nullptr, *separateMap, false));
+            } else {
+                REQUIRE(SegmentMetric(radius, false).run(nullptr, *separateMap, false));
+            }
+        }
+        if (topological) {
+            REQUIRE(SegmentTopological(radii, false).run(nullptr, *fusedMap, false));
+        } else {
+            REQUIRE(SegmentMetric(radii, false).run(nullptr, *fusedMap, false));
+        }
+
+        const AttributeTable &separateTable = separateMap->getAttributeTable();
+        const AttributeTable &fusedTable = fusedMap->getAttributeTable();
+        REQUIRE(separateTable.getNumColumns() == fusedTable.getNumColumns());
+        for (size_t col = 0; col < separateTable.getNumColumns(); col++) {
+            REQUIRE(separateTable.getColumnName(col) == fusedTable.getColumnName(col));
+        }
+        REQUIRE(getColumnValues(separateTable) == getColumnValues(fusedTable));
+        REQUIRE(separateMap->getDisplayedAttribute() == fusedMap->getDisplayedAttribute());
+
+        // the radii cut the search short, so the smallest one reaches fewer segments than radius n
+        std::string prefix = topological ? "Topological " : "Metric ";
+        const AttributeColumn &countN = fusedTable.getColumn(fusedTable.getColumnIndex(prefix + "Total Nodes"));
+        const AttributeColumn &count2 =
+            fusedTable.getColumn(fusedTable.getColumnIndex(prefix + "Total Nodes R2 metric"));
+        REQUIRE(countN.getStats().min == float(fusedMap->getShapeCount()));
+        REQUIRE(count2.getStats().max < countN.getStats().min);
+        REQUIRE(fusedTable.getColumn(fusedTable.getColumnIndex(prefix + "Choice R4 metric")).getStats().max > 0);
+    }
+}
+
+TEST_CASE("Parallel topological and metric analysis matches the serial analysis", "") {
+    std::set<double> radii{-1.0, 3.0};
+    for (bool topological : {true, false}) {
+        std::unique_ptr<ShapeGraph> serialMap = makeTestSegmentMap();
+        std::unique_ptr<ShapeGraph> parallelMap = makeTestSegmentMap();
+        if (topological) {
+            REQUIRE(SegmentTopological(radii, false, 1).run(nullptr, *serialMap, false));
+            REQUIRE(SegmentTopological(radii, false, 4).run(nullptr, *parallelMap, false));
+        } else {
+            REQUIRE(SegmentMetric(radii, false, 1).run(nullptr, *serialMap, false));
+            REQUIRE(SegmentMetric(radii, false, 4).run(nullptr, *parallelMap, false));
+        }
+
+        const AttributeTable &serialTable = serialMap->getAttributeTable();
+        const AttributeTable &parallelTable = parallelMap->getAttributeTable();
+        REQUIRE(serialTable.getNumColumns() == parallelTable.getNumColumns());
+        for (size_t col = 0; col < serialTable.getNumColumns(); col++) {
+            REQUIRE(serialTable.getColumnName(col) == parallelTable.getColumnName(col));
+        }
+        // the choice of each root is added in root order, so even the weighted choice is the same to the last bit
+        REQUIRE(getColumnValues(parallelTable) == getColumnValues(serialTable));
+        std::string prefix = topological ? "Topological " : "Metric ";
+        REQUIRE(serialTable.getColumn(serialTable.getColumnIndex(prefix + "Choice")).getStats().max > 0);
+    }
+}
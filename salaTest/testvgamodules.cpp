@@ -0,0 +1,285 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/mgraph.h"
+#include "salalib/pointdata.h"
+#include "salalib/shapemap.h"
+#include "salalib/spacepixfile.h"
+#include "salalib/vgamodules/vgaangular.h"
+#include "salalib/vgamodules/vgaisovist.h"
+#include "salalib/vgamodules/vgametric.h"
+#include "salalib/vgamodules/vgatiles.h"
+#include "salalib/vgamodules/vgavisualglobal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+    // A 10x10 room with an internal wall, leaving a doorway at the top, so that the visibility
+    // graph has more than one step of depth. Two cells either side of the wall are merged.
+    std::unique_ptr<MetaGraph> makeTestGraph(double spacing, bool merge = true, double maxDist = -1) {
+        std::unique_ptr<MetaGraph> mgraph(new MetaGraph);
+        mgraph->m_drawingFiles.emplace_back("Drawing file");
+        mgraph->m_drawingFiles.back().m_spacePixels.emplace_back("Drawing Map");
+        ShapeMap &drawingMap = mgraph->m_drawingFiles.back().m_spacePixels.back();
+        drawingMap.makePolyShape({Point2f(0.0, 0.0), Point2f(0.0, 10.0), Point2f(10.0, 10.0), Point2f(10.0, 0.0)},
+                                 false);
+        drawingMap.makeLineShape(Line(Point2f(5.0, 0.0), Point2f(5.0, 7.0)));
+        mgraph->updateParentRegions(drawingMap);
+
+        mgraph->addNewPointMap("VGA Map");
+        PointMap &vgaMap = mgraph->getPointMaps().back();
+        vgaMap.setGrid(spacing);
+        vgaMap.makePoints(Point2f(2.51, 5.01), 0);
+        vgaMap.sparkGraph2(nullptr, false, maxDist);
+        if (merge) {
+            vgaMap.mergePixels(vgaMap.pixelate(Point2f(4.51, 1.01)), vgaMap.pixelate(Point2f(5.51, 1.01)));
+        }
+        return mgraph;
+    }
+
+    std::vector<std::vector<float>> getColumnValues(const AttributeTable &table) {
+        std::vector<std::vector<float>> values;
+        for (auto iter = table.begin(); iter != table.end(); iter++) {
+            values.emplace_back();
+            for (size_t col = 0; col < table.getNumColumns(); col++) {
+                values.back().push_back(iter->getRow().getValue(col));
+            }
+        }
+        return values;
+    }
+} // namespace
+
+TEST_CASE("Parallel global visibility matches the serial analysis", "") {
+    std::unique_ptr<MetaGraph> serialGraph = makeTestGraph(0.5);
+    std::unique_ptr<MetaGraph> parallelGraph = makeTestGraph(0.5);
+    PointMap &serialMap = serialGraph->getPointMaps().back();
+    PointMap &parallelMap = parallelGraph->getPointMaps().back();
+    REQUIRE(serialMap.getFilledPointCount() > 100);
+
+    for (double radius : {-1.0, 3.0}) {
+        REQUIRE(VGAVisualGlobal(radius, false, 1).run(nullptr, serialMap, false));
+        REQUIRE(VGAVisualGlobal(radius, false, 4).run(nullptr, parallelMap, false));
+    }
+
+    const AttributeTable &serialTable = serialMap.getAttributeTable();
+    const AttributeTable &parallelTable = parallelMap.getAttributeTable();
+    REQUIRE(serialTable.getNumColumns() == parallelTable.getNumColumns());
+    REQUIRE(getColumnValues(serialTable) == getColumnValues(parallelTable));
+    for (size_t col = 0; col < serialTable.getNumColumns(); col++) {
+        REQUIRE(serialTable.getColumn(col).getStats().min == parallelTable.getColumn(col).getStats().min);
+        REQUIRE(serialTable.getColumn(col).getStats().max == parallelTable.getColumn(col).getStats().max);
+        REQUIRE(serialTable.getColumn(col).getStats().total == parallelTable.getColumn(col).getStats().total);
+    }
+}
+
+TEST_CASE("Parallel isovist analysis matches the serial analysis", "") {
+    std::unique_ptr<MetaGraph> serialGraph = makeTestGraph(0.5);
+    std::unique_ptr<MetaGraph> parallelGraph = makeTestGraph(0.5);
+    PointMap &serialMap = serialGraph->getPointMaps().back();
+    PointMap &parallelMap = parallelGraph->getPointMaps().back();
+
+    // the BSP tree picks its split lines at random, so both analyses share one tree to see the same isovists
+    BSPCache bspCache;
+    REQUIRE(VGAIsovist(&bspCache, 1).run(nullptr, serialMap, false));
+    REQUIRE(VGAIsovist(&bspCache, 4).run(nullptr, parallelMap, false));
+
+    const AttributeTable &serialTable = serialMap.getAttributeTable();
+    const AttributeTable &parallelTable = parallelMap.getAttributeTable();
+    REQUIRE(serialTable.getColumnIndex("Isovist Area") == parallelTable.getColumnIndex("Isovist Area"));
+    REQUIRE(serialTable.getNumColumns() == parallelTable.getNumColumns());
+    REQUIRE(getColumnValues(serialTable) == getColumnValues(parallelTable));
+    for (size_t col = 0; col < serialTable.getNumColumns(); col++) {
+        REQUIRE(serialTable.getColumn(col).getStats().min == parallelTable.getColumn(col).getStats().min);
+        REQUIRE(serialTable.getColumn(col).getStats().max == parallelTable.getColumn(col).getStats().max);
+        REQUIRE(serialTable.getColumn(col).getStats().total == parallelTable.getColumn(col).getStats().total);
+    }
+
+    // the occlusion bins the agents look along
+    bool anyOcclusion = false;
+    for (auto iter = serialTable.begin(); iter != serialTable.end(); iter++) {
+        PixelRef pix = iter->getKey().value;
+        Node &serialNode = serialMap.getPoint(pix).getNode();
+        Node &parallelNode = parallelMap.getPoint(pix).getNode();
+        for (int k = 0; k < 32; k++) {
+            REQUIRE(serialNode.m_occlusion_bins[k] == parallelNode.m_occlusion_bins[k]);
+            REQUIRE(serialNode.bin(k).occdistance() == parallelNode.bin(k).occdistance());
+            anyOcclusion |= !serialNode.m_occlusion_bins[k].empty();
+        }
+    }
+    REQUIRE(anyOcclusion);
+}
+
+TEST_CASE("Global visibility of batches of roots matches a search from each root", "") {
+    // without merges the roots are searched many at a time
+    std::unique_ptr<MetaGraph> mgraph = makeTestGraph(0.5, false);
+    PointMap &map = mgraph->getPointMaps().back();
+    AttributeTable &table = map.getAttributeTable();
+    // more than one batch, and the last one not full
+    REQUIRE(map.getFilledPointCount() > 64);
+    REQUIRE(map.getFilledPointCount() % 64 != 0);
+
+    REQUIRE(VGAVisualGlobal(-1, false).run(nullptr, map, false));
+    REQUIRE(VGAVisualGlobal(3, false, 2).run(nullptr, map, false));
+
+    const VisibilityGraph &graph = map.getVisibilityGraph();
+    for (int radius : {-1, 3}) {
+        std::string radiusText = radius == -1 ? "" : " R3";
+        size_t countCol = table.getColumnIndex("Visual Node Count" + radiusText);
+        size_t depthCol = table.getColumnIndex("Visual Mean Depth" + radiusText);
+        for (auto iter = table.begin(); iter != table.end(); iter++) {
+            PixelRef root = iter->getKey().value;
+            std::set<PixelRef> reached{root};
+            std::vector<PixelRef> level{root};
+            int totalDepth = 0;
+            for (int depth = 1; !level.empty() && (radius == -1 || depth <= radius); depth++) {
+                std::vector<PixelRef> nextLevel;
+                for (PixelRef pix : level) {
+                    PixelRefVector visible;
+                    graph.contents(pix, visible);
+                    for (PixelRef other : visible) {
+                        if (map.getPoint(other).filled() && reached.insert(other).second) {
+                            nextLevel.push_back(other);
+                            totalDepth += depth;
+                        }
+                    }
+                }
+                level = nextLevel;
+            }
+            int totalNodes = static_cast<int>(reached.size());
+            REQUIRE(iter->getRow().getValue(countCol) == float(totalNodes));
+            REQUIRE(iter->getRow().getValue(depthCol) == float(double(totalDepth) / double(totalNodes - 1)));
+        }
+    }
+}
+
+TEST_CASE("Every root of a VGA analysis starts from a clean traversal state", "") {
+    std::unique_ptr<MetaGraph> mgraph = makeTestGraph(0.5);
+    PointMap &map = mgraph->getPointMaps().back();
+    AttributeTable &table = map.getAttributeTable();
+
+    REQUIRE(VGAVisualGlobal(-1, false).run(nullptr, map, false));
+    REQUIRE(VGAMetric(-1, false).run(nullptr, map, false));
+    REQUIRE(VGAAngular(-1, false).run(nullptr, map, false));
+
+    // the room is connected, so every root should reach every cell, apart from one of the two merged
+    // cells, which is entered through the other and then not counted
+    float filledCount = static_cast<float>(map.getFilledPointCount());
+    for (const char *colName : {"Visual Node Count", "Metric Node Count", "Angular Node Count"}) {
+        REQUIRE(table.hasColumn(colName));
+        size_t col = table.getColumnIndex(colName);
+        for (auto iter = table.begin(); iter != table.end(); iter++) {
+            REQUIRE(iter->getRow().getValue(col) == filledCount - 1);
+        }
+    }
+
+    // with a radius the reachable neighbourhood is smaller, and the same for the same root in a repeated run
+    REQUIRE(VGAMetric(2.0, false).run(nullptr, map, false));
+    REQUIRE(table.hasColumn("Metric Node Count R2.00"));
+    size_t metricCol = table.getColumnIndex("Metric Node Count R2.00");
+    std::vector<float> firstRun;
+    for (auto iter = table.begin(); iter != table.end(); iter++) {
+        firstRun.push_back(iter->getRow().getValue(metricCol));
+        REQUIRE(firstRun.back() < filledCount);
+    }
+    REQUIRE(VGAMetric(2.0, false).run(nullptr, map, false));
+    std::vector<float> secondRun;
+    for (auto iter = table.begin(); iter != table.end(); iter++) {
+        secondRun.push_back(iter->getRow().getValue(metricCol));
+    }
+    REQUIRE(firstRun == secondRun);
+}
+
+TEST_CASE("Tiles of a point map cover the cells within reach of their roots", "") {
+    std::unique_ptr<MetaGraph> mgraph = makeTestGraph(0.2, false);
+    PointMap &map = mgraph->getPointMaps().back();
+
+    // without a reach, or with one about the size of the map, there is a single tile
+    REQUIRE_FALSE(VGATiles(map, -1).isTiled());
+    REQUIRE_FALSE(VGATiles(map, 20).isTiled());
+    REQUIRE_FALSE(VGATiles(map, 5, 0).isTiled());
+    REQUIRE(VGATiles(map, 20).getTiles().size() == 1);
+
+    VGATiles tiles(map, 5, 16);
+    REQUIRE(tiles.isTiled());
+    REQUIRE(tiles.getTiles().size() > 1);
+    std::vector<int> covered(map.getCols() * map.getRows(), 0);
+    for (short i = 0; i < short(map.getCols()); i++) {
+        for (short j = 0; j < short(map.getRows()); j++) {
+            PixelRef root(i, j);
+            const VGATiles::Tile &tile = tiles.getTiles()[tiles.getTileIndex(root)];
+            REQUIRE(root.x >= tile.first.x);
+            REQUIRE(root.x <= tile.last.x);
+            REQUIRE(root.y >= tile.first.y);
+            REQUIRE(root.y <= tile.last.y);
+            REQUIRE(tile.windowFirst.x == std::max(0, tile.first.x - 5));
+            REQUIRE(tile.windowLast.y == std::min(int(map.getRows()) - 1, tile.last.y + 5));
+        }
+    }
+    for (const VGATiles::Tile &tile : tiles.getTiles()) {
+        for (short i = tile.first.x; i <= tile.last.x; i++) {
+            for (short j = tile.first.y; j <= tile.last.y; j++) {
+                covered[size_t(i) * map.getRows() + size_t(j)]++;
+            }
+        }
+    }
+    REQUIRE(std::count(covered.begin(), covered.end(), 1) == long(covered.size()));
+
+    // the window of a root follows it, even over the edge of the grid
+    depthmapX::EpochMatrix<int> window = tiles.makeRootWindow<int>();
+    REQUIRE(window.rows() == 11);
+    tiles.moveToRoot(window, PixelRef(0, 3));
+    REQUIRE(window.contains(0, 5));
+    REQUIRE(window.contains(8, 0));
+    REQUIRE_FALSE(window.contains(9, 0));
+    REQUIRE_FALSE(window.contains(3, 6));
+
+    // the longest view is across the room, in grid units
+    REQUIRE(VGATiles::getLongestView(map) > 40.0);
+    REQUIRE(VGATiles::getLongestView(map) < 10.0 * std::sqrt(2.0) / 0.2);
+}
+
+TEST_CASE("Analyses with a radius give the same results in tiles as over the whole map", "") {
+    // metric radius, where the tiles only depend on the radius
+    {
+        std::unique_ptr<MetaGraph> tiledGraph = makeTestGraph(0.2, false);
+        std::unique_ptr<MetaGraph> wholeGraph = makeTestGraph(0.2, false);
+        PointMap &tiledMap = tiledGraph->getPointMaps().back();
+        PointMap &wholeMap = wholeGraph->getPointMaps().back();
+        REQUIRE(VGATiles(tiledMap, 9, 16).isTiled());
+
+        REQUIRE(VGAMetric(1.5, false, 16).run(nullptr, tiledMap, false));
+        REQUIRE(VGAMetric(1.5, false, 0).run(nullptr, wholeMap, false));
+        REQUIRE(getColumnValues(tiledMap.getAttributeTable()) == getColumnValues(wholeMap.getAttributeTable()));
+    }
+    // visual steps, which only keep to a neighbourhood when the graph has a restricted visual range
+    {
+        std::unique_ptr<MetaGraph> tiledGraph = makeTestGraph(0.2, false, 1.0);
+        std::unique_ptr<MetaGraph> wholeGraph = makeTestGraph(0.2, false, 1.0);
+        PointMap &tiledMap = tiledGraph->getPointMaps().back();
+        PointMap &wholeMap = wholeGraph->getPointMaps().back();
+        double reach = std::ceil(2.0 * VGATiles::getLongestView(tiledMap)) + 1.0;
+        REQUIRE(VGATiles(tiledMap, int(reach), 16).isTiled());
+
+        REQUIRE(VGAVisualGlobal(2, false, 2, 16).run(nullptr, tiledMap, false));
+        REQUIRE(VGAVisualGlobal(2, false, 2, 0).run(nullptr, wholeMap, false));
+        REQUIRE(getColumnValues(tiledMap.getAttributeTable()) == getColumnValues(wholeMap.getAttributeTable()));
+    }
+}
@@ -0,0 +1,318 @@
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "catch.hpp"
+#include "salalib/mgraph.h"
+#include "salalib/pointdata.h"
+#include "salalib/visibilitygraph.h"
+
+#include <memory>
+#include <sstream>
+
+namespace {
+    std::unique_ptr<MetaGraph> makeRoomGraph() {
+        std::unique_ptr<MetaGraph> mgraph(new MetaGraph);
+        mgraph->m_drawingFiles.emplace_back("Drawing file");
+        mgraph->m_drawingFiles.back().m_spacePixels.emplace_back("Drawing Map");
+        ShapeMap &drawingMap = mgraph->m_drawingFiles.back().m_spacePixels.back();
+        drawingMap.makePolyShape({Point2f(0.0, 0.0), Point2f(0.0, 6.0), Point2f(8.0, 6.0), Point2f(8.0, 0.0)}, false);
+        drawingMap.makeLineShape(Line(Point2f(4.0, 0.0), Point2f(4.0, 4.0)));
+        mgraph->updateParentRegions(drawingMap);
+
+        mgraph->addNewPointMap("VGA Map");
+        PointMap &vgaMap = mgraph->getPointMaps().back();
+        vgaMap.setGrid(0.5);
+        vgaMap.makePoints(Point2f(1.01, 1.01), 0);
+        return mgraph;
+    }
+
+    // what the legacy node iterator visits
+    PixelRefVector nodeContents(Node &node) {
+        PixelRefVector pixels;
+        node.first();
+        while (!node.is_tail()) {
+            pixels.push_back(node.cursor());
+            node.next();
+        }
+        return pixels;
+    }
+} // namespace
+
+TEST_CASE("Visibility graph holds the same connections as the nodes", "") {
+    std::unique_ptr<MetaGraph> mgraph = makeRoomGraph();
+    PointMap &map = mgraph->getPointMaps().back();
+    PixelRef pix = map.pixelate(Point2f(1.01, 1.01));
+    // no graph yet, so no connections
+    REQUIRE(map.getVisibilityGraph().bins(pix).size() == 0);
+
+    map.sparkGraph2(nullptr, false, -1);
+    const VisibilityGraph &graph = map.getVisibilityGraph();
+    REQUIRE(graph.isBuilt());
+
+    int filledCount = 0;
+    for (size_t i = 0; i < map.getCols(); i++) {
+        for (size_t j = 0; j < map.getRows(); j++) {
+            PixelRef pix(static_cast<short>(i), static_cast<short>(j));
+            Point &point = map.getPoint(pix);
+            PixelRefVector pixels;
+            graph.contents(pix, pixels);
+            if (point.hasNode()) {
+                filledCount++;
+                REQUIRE(pixels == nodeContents(point.getNode()));
+                for (const VisibilityGraph::BinRuns &bin : graph.bins(pix)) {
+                    REQUIRE(bin.dir == point.getNode().bin(bin.bin).m_dir);
+                    REQUIRE(graph.runs(bin).size() == point.getNode().bin(bin.bin).m_pixel_vecs.size());
+                }
+            } else {
+                REQUIRE(pixels.empty());
+            }
+        }
+    }
+    REQUIRE(filledCount == map.getFilledPointCount());
+    REQUIRE(graph.getMemoryUsage() > 0);
+}
+
+TEST_CASE("Visibility graph follows the state of the point map", "") {
+    std::unique_ptr<MetaGraph> mgraph = makeRoomGraph();
+    PointMap &map = mgraph->getPointMaps().back();
+    map.sparkGraph2(nullptr, false, -1);
+    PixelRef pix = map.pixelate(Point2f(1.01, 1.01));
+    REQUIRE(map.getVisibilityGraph().bins(pix).size() > 0);
+
+    // removing the graph removes the connections
+    map.unmake(true);
+    REQUIRE(map.getVisibilityGraph().bins(pix).size() == 0);
+
+    // as does reading a map back in
+    map.sparkGraph2(nullptr, false, -1);
+    std::stringstream stream;
+    map.write(stream);
+    PointMap readMap(mgraph->getRegion(), mgraph->m_drawingFiles);
+    readMap.read(stream);
+    PixelRefVector original, copy;
+    map.getVisibilityGraph().contents(pix, original);
+    readMap.getVisibilityGraph().contents(pix, copy);
+    REQUIRE_FALSE(original.empty());
+    REQUIRE(original == copy);
+}
+
+TEST_CASE("Making the visibility graph in parallel gives the same graph as making it serially", "") {
+    for (double maxDist : {-1.0, 3.0}) {
+        std::unique_ptr<MetaGraph> serialGraph = makeRoomGraph();
+        std::unique_ptr<MetaGraph> parallelGraph = makeRoomGraph();
+        PointMap &serialMap = serialGraph->getPointMaps().back();
+        PointMap &parallelMap = parallelGraph->getPointMaps().back();
+        REQUIRE(serialMap.sparkGraph2(nullptr, false, maxDist, 1));
+        REQUIRE(parallelMap.sparkGraph2(nullptr, false, maxDist, 4));
+
+        for (size_t i = 0; i < serialMap.getCols(); i++) {
+            for (size_t j = 0; j < serialMap.getRows(); j++) {
+                PixelRef pix(static_cast<short>(i), static_cast<short>(j));
+                Point &serialPoint = serialMap.getPoint(pix);
+                Point &parallelPoint = parallelMap.getPoint(pix);
+                REQUIRE(serialPoint.hasNode() == parallelPoint.hasNode());
+                if (serialPoint.hasNode()) {
+                    REQUIRE(nodeContents(serialPoint.getNode()) == nodeContents(parallelPoint.getNode()));
+                    for (int b = 0; b < 32; b++) {
+                        REQUIRE(serialPoint.getNode().bin(b).distance() ==
+                                parallelPoint.getNode().bin(b).distance());
+                    }
+                    REQUIRE(serialPoint.getGridConnections() == parallelPoint.getGridConnections());
+                }
+            }
+        }
+
+        // the point stats are entered in the same order, so the columns and their stats match exactly
+        const AttributeTable &serialTable = serialMap.getAttributeTable();
+        const AttributeTable &parallelTable = parallelMap.getAttributeTable();
+        REQUIRE(serialTable.getNumRows() == parallelTable.getNumRows());
+        REQUIRE(serialTable.getNumColumns() == parallelTable.getNumColumns());
+        for (size_t col = 0; col < serialTable.getNumColumns(); col++) {
+            auto parallelIter = parallelTable.begin();
+            for (auto serialIter = serialTable.begin(); serialIter != serialTable.end(); serialIter++) {
+                REQUIRE(serialIter->getKey().value == parallelIter->getKey().value);
+                REQUIRE(serialIter->getRow().getValue(col) == parallelIter->getRow().getValue(col));
+                parallelIter++;
+            }
+            REQUIRE(serialTable.getColumn(col).getStats().min == parallelTable.getColumn(col).getStats().min);
+            REQUIRE(serialTable.getColumn(col).getStats().max == parallelTable.getColumn(col).getStats().max);
+            REQUIRE(serialTable.getColumn(col).getStats().total == parallelTable.getColumn(col).getStats().total);
+        }
+    }
+}
+
+TEST_CASE("Regenerating the visibility graph after moving a wall gives the same graph as remaking it", "") {
+    // the room is drawn on one layer, and each wall that may be moved in on a layer of its own. The walls
+    // that are not there when the points are made miss the centres of the points, as the graph cannot
+    // be made from a point on a line. A partition with a door keeps most of the far half of the room
+    // out of sight of the walls
+    const std::vector<Line> walls{Line(Point2f(4.0, 0.0), Point2f(4.0, 4.0)),
+                                  Line(Point2f(5.25, 2.25), Point2f(5.25, 6.0)),
+                                  Line(Point2f(1.25, 3.0), Point2f(3.25, 4.25))};
+    auto makeGraph = [&walls]() {
+        std::unique_ptr<MetaGraph> mgraph(new MetaGraph);
+        mgraph->m_drawingFiles.emplace_back("Drawing file");
+        mgraph->m_drawingFiles.back().m_spacePixels.emplace_back("Drawing Map");
+        mgraph->m_drawingFiles.back().m_spacePixels.back().makePolyShape(
+            {Point2f(0.0, 0.0), Point2f(0.0, 6.0), Point2f(16.0, 6.0), Point2f(16.0, 0.0)}, false);
+        mgraph->m_drawingFiles.back().m_spacePixels.back().makeLineShape(Line(Point2f(8.0, 1.5), Point2f(8.0, 6.0)));
+        for (size_t i = 0; i < walls.size(); i++) {
+            mgraph->m_drawingFiles.back().m_spacePixels.emplace_back("Wall " + std::to_string(i));
+            ShapeMap &wallMap = mgraph->m_drawingFiles.back().m_spacePixels.back();
+            wallMap.makeLineShape(walls[i]);
+            wallMap.setShow(i == 0);
+        }
+        // a region with a corner at the origin counts as unset, so the room is added last
+        std::deque<ShapeMap> &layers = mgraph->m_drawingFiles.back().m_spacePixels;
+        for (auto iter = layers.rbegin(); iter != layers.rend(); iter++) {
+            mgraph->updateParentRegions(*iter);
+        }
+
+        mgraph->addNewPointMap("VGA Map");
+        PointMap &vgaMap = mgraph->getPointMaps().back();
+        vgaMap.setGrid(0.5);
+        vgaMap.makePoints(Point2f(1.01, 1.01), 0);
+        return mgraph;
+    };
+    auto showWalls = [&walls](MetaGraph &mgraph, std::vector<bool> shown) {
+        for (size_t i = 0; i < walls.size(); i++) {
+            mgraph.m_drawingFiles.back().m_spacePixels[i + 1].setShow(shown[i]);
+        }
+    };
+
+    // moving the first wall, adding a wall, and taking both of the first walls away
+    const std::vector<std::pair<std::vector<bool>, std::vector<Line>>> edits{
+        {{false, true, false}, {walls[0], walls[1]}},
+        {{true, false, true}, {walls[2]}},
+        {{false, false, false}, {walls[0]}}};
+
+    for (double maxDist : {-1.0, 3.0}) {
+        for (const auto &edit : edits) {
+            std::unique_ptr<MetaGraph> updatedGraph = makeGraph();
+            std::unique_ptr<MetaGraph> remadeGraph = makeGraph();
+            PointMap &updatedMap = updatedGraph->getPointMaps().back();
+            PointMap &remadeMap = remadeGraph->getPointMaps().back();
+            REQUIRE(updatedMap.regenerateGraph(nullptr, edit.second, maxDist) == -1);
+            REQUIRE(updatedMap.sparkGraph2(nullptr, false, maxDist));
+
+            if (edit.second.size() == 1) {
+                // a single wall is shown or hidden through its layer, as from the layer list
+                size_t wall = 0;
+                while (walls[wall].start() != edit.second[0].start()) {
+                    wall++;
+                }
+                REQUIRE(updatedGraph->setLineLayerShown(nullptr, 0, int(wall) + 1, edit.first[wall], maxDist, 2));
+            } else {
+                showWalls(*updatedGraph, edit.first);
+                int regenerated = updatedMap.regenerateGraph(nullptr, edit.second, maxDist, 2);
+                REQUIRE(regenerated > 0);
+                REQUIRE(regenerated < updatedMap.getFilledPointCount());
+            }
+
+            // the lines stay blocked until the graph is unmade
+            showWalls(*remadeGraph, edit.first);
+            remadeMap.unmake(true);
+            REQUIRE(remadeMap.sparkGraph2(nullptr, false, maxDist));
+
+            for (size_t i = 0; i < remadeMap.getCols(); i++) {
+                for (size_t j = 0; j < remadeMap.getRows(); j++) {
+                    PixelRef pix(static_cast<short>(i), static_cast<short>(j));
+                    Point &updatedPoint = updatedMap.getPoint(pix);
+                    Point &remadePoint = remadeMap.getPoint(pix);
+                    REQUIRE(updatedPoint.hasNode() == remadePoint.hasNode());
+                    if (remadePoint.hasNode()) {
+                        REQUIRE(nodeContents(updatedPoint.getNode()) == nodeContents(remadePoint.getNode()));
+                        for (int b = 0; b < 32; b++) {
+                            REQUIRE(updatedPoint.getNode().bin(b).distance() ==
+                                    remadePoint.getNode().bin(b).distance());
+                        }
+                        REQUIRE(updatedPoint.getGridConnections() == remadePoint.getGridConnections());
+                        PixelRefVector updatedPixels, remadePixels;
+                        updatedMap.getVisibilityGraph().contents(pix, updatedPixels);
+                        remadeMap.getVisibilityGraph().contents(pix, remadePixels);
+                        REQUIRE(updatedPixels == remadePixels);
+                    }
+                }
+            }
+
+            const AttributeTable &updatedTable = updatedMap.getAttributeTable();
+            const AttributeTable &remadeTable = remadeMap.getAttributeTable();
+            REQUIRE(updatedTable.getNumRows() == remadeTable.getNumRows());
+            REQUIRE(updatedTable.getNumColumns() == remadeTable.getNumColumns());
+            for (size_t col = 0; col < remadeTable.getNumColumns(); col++) {
+                auto updatedIter = updatedTable.begin();
+                for (auto remadeIter = remadeTable.begin(); remadeIter != remadeTable.end(); remadeIter++) {
+                    REQUIRE(remadeIter->getKey().value == updatedIter->getKey().value);
+                    REQUIRE(remadeIter->getRow().getValue(col) == updatedIter->getRow().getValue(col));
+                    updatedIter++;
+                }
+                REQUIRE(updatedTable.getColumn(col).getStats().min == remadeTable.getColumn(col).getStats().min);
+                REQUIRE(updatedTable.getColumn(col).getStats().max == remadeTable.getColumn(col).getStats().max);
+            }
+        }
+    }
+}
+
+TEST_CASE("Points read back the same from the compressed and the older file format", "") {
+    std::unique_ptr<MetaGraph> mgraph = makeRoomGraph();
+    PointMap &map = mgraph->getPointMaps().back();
+    map.sparkGraph2(nullptr, false, -1);
+    map.mergePixels(map.pixelate(Point2f(3.76, 1.01)), map.pixelate(Point2f(4.26, 1.01)));
+    // what an isovist analysis and the agents leave on the nodes
+    Node &node = map.getPoint(map.pixelate(Point2f(1.01, 1.01))).getNode();
+    node.bin(3).setOccDistance(2.5f);
+    node.m_occlusion_bins[3] = {PixelRef(2, 2), PixelRef(5, 1), PixelRef(1, 7)};
+
+    std::stringstream compressedStream, olderStream, parallelStream;
+    map.write(compressedStream, METAGRAPH_VERSION);
+    map.write(olderStream, VERSION_ALWAYS_RECORD_BINDISTANCES);
+    REQUIRE(compressedStream.str().size() < olderStream.str().size() / 2);
+    // the blocks are the same whatever the number of threads they are coded on
+    map.write(parallelStream, METAGRAPH_VERSION, 3);
+    REQUIRE(parallelStream.str() == compressedStream.str());
+
+    PointMap compressedMap(mgraph->getRegion(), mgraph->m_drawingFiles);
+    PointMap olderMap(mgraph->getRegion(), mgraph->m_drawingFiles);
+    PointMap parallelMap(mgraph->getRegion(), mgraph->m_drawingFiles);
+    compressedMap.read(compressedStream, METAGRAPH_VERSION);
+    olderMap.read(olderStream, VERSION_ALWAYS_RECORD_BINDISTANCES);
+    parallelMap.read(parallelStream, METAGRAPH_VERSION, 3);
+    for (PointMap *readMap : {&compressedMap, &olderMap, &parallelMap}) {
+        REQUIRE(readMap->getFilledPointCount() == map.getFilledPointCount());
+        REQUIRE(readMap->isProcessed());
+        for (size_t i = 0; i < map.getCols(); i++) {
+            for (size_t j = 0; j < map.getRows(); j++) {
+                PixelRef pix(static_cast<short>(i), static_cast<short>(j));
+                Point &point = map.getPoint(pix);
+                Point &readPoint = readMap->getPoint(pix);
+                REQUIRE(readPoint.getState() == point.getState());
+                REQUIRE(readPoint.getGridConnections() == point.getGridConnections());
+                REQUIRE(readPoint.getMergePixel() == point.getMergePixel());
+                REQUIRE(readPoint.getLocation().x == point.getLocation().x);
+                REQUIRE(readPoint.getLocation().y == point.getLocation().y);
+                REQUIRE(readPoint.hasNode() == point.hasNode());
+                if (point.hasNode()) {
+                    REQUIRE(nodeContents(readPoint.getNode()) == nodeContents(point.getNode()));
+                    for (int b = 0; b < 32; b++) {
+                        REQUIRE(readPoint.getNode().bin(b).count() == point.getNode().bin(b).count());
+                        REQUIRE(readPoint.getNode().bin(b).distance() == point.getNode().bin(b).distance());
+                        REQUIRE(readPoint.getNode().bin(b).occdistance() == point.getNode().bin(b).occdistance());
+                        REQUIRE(readPoint.getNode().m_occlusion_bins[b] == point.getNode().m_occlusion_bins[b]);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -19,11 +19,31 @@
 #include "agent.h"
 #include "agenthelpers.h"
 
-Agent::Agent(AgentProgram *program, PointMap *pointmap, int output_mode) {
+namespace {
+    // the n-th pixel of a bin, as Bin::first() followed by n Bin::next() would give, but without moving the cursor
+    // of the bin, which is shared by all the agents looking from the same cell
+    PixelRef binPixel(const Bin &bin, int n) {
+        for (const PixelVec &pixVec : bin.m_pixel_vecs) {
+            int runlength = pixVec.end().col(bin.m_dir) - pixVec.start().col(bin.m_dir) + 1;
+            if (n < runlength) {
+                PixelRef pix = pixVec.start();
+                for (; n > 0; n--) {
+                    pix.move(bin.m_dir);
+                }
+                return pix;
+            }
+            n -= runlength;
+        }
+        return NoPixel;
+    }
+} // namespace
+
+Agent::Agent(AgentProgram *program, PointMap *pointmap, int output_mode, const PafRandomStream &random) {
     m_program = program;
     m_pointmap = pointmap;
     m_output_mode = output_mode;
     m_trail_num = -1;
+    m_random = random;
 }
 
 void Agent::onInit(PixelRef node, int trail_num) {
@@ -57,7 +77,7 @@ void Agent::onInit(PixelRef node, int trail_num) {
     m_target_pix = NoPixel;
 }
 
-void Agent::onMove() {
+void Agent::onMove(AgentCounts &counts) {
     m_at_target = false;
     m_frame++;
     if (m_program->m_destination_directed && dist(m_loc, m_destination) < 10.0) {
@@ -69,7 +89,7 @@ void Agent::onMove() {
         m_step = 0;
         onTarget();
         m_vector = onLook(false);
-    } else if (prandomr() < (1.0 / m_program->m_steps) && !m_target_lock) { // note, on average, will change 1 in steps
+    } else if (m_random.randomr() < (1.0 / m_program->m_steps) && !m_target_lock) { // note, on average, will change 1 in steps
         m_step = 0;
         m_vector = onLook(false);
         /*
@@ -91,16 +111,16 @@ void Agent::onMove() {
     onStep();
     if (m_node != lastnode && m_output_mode != OUTPUT_NOTHING) {
         if (m_pointmap->getPoint(m_node).filled()) {
-            AttributeRow &row = m_pointmap->getAttributeTable().getRow(AttributeKey(m_node));
             if (m_output_mode & OUTPUT_COUNTS) {
-                row.incrValue(g_col_total_counts);
+                counts.entered.push_back(m_node);
             }
             if (m_output_mode & OUTPUT_GATE_COUNTS) {
+                const AttributeRow &row = m_pointmap->getAttributeTable().getRow(AttributeKey(m_node));
                 int obj = (int)row.getValue(g_col_gate);
                 if (m_gate != obj) {
                     m_gate = obj;
                     if (m_gate != -1) {
-                        row.incrValue(g_col_gate_counts);
+                        counts.gates.push_back(m_node);
                         // actually crossed into a new gate:
                         m_gate_encountered = true;
                     }
@@ -157,7 +177,7 @@ bool Agent::diagonalStep() {
     int nextnode2 = m_pointmap->pixelate(nextloc2, false);
 
     bool good = false;
-    if (pafrand() % 2 == 0) {
+    if (m_random.rand() % 2 == 0) {
         if (goodStep(nextnode1)) {
             m_node = nextnode1;
             m_loc = nextloc1;
@@ -261,18 +281,12 @@ Point2f Agent::onStandardLook(bool wholeisovist) {
             return Point2f(0, 0);
         }
     } else {
-        int chosen = pafrand() % choices;
+        int chosen = m_random.rand() % choices;
         Node &node = m_pointmap->getPoint(m_node).getNode();
         for (; chosen >= node.bincount(directionbin % 32); directionbin++) {
             chosen -= node.bincount(directionbin % 32);
         }
-        Bin &bin = node.bin(directionbin % 32);
-        bin.first();
-        tarpixelate = bin.cursor();
-        for (; chosen > 0; chosen--) {
-            bin.next();
-            tarpixelate = bin.cursor();
-        }
+        tarpixelate = binPixel(node.bin(directionbin % 32), chosen);
     }
 
     m_target_pix = tarpixelate;
@@ -302,31 +316,27 @@ Point2f Agent::onWeightedLook(bool wholeisovist) {
         vbin = 32;
     }
     for (int i = 0; i < vbin; i++) {
-        Bin &bin = m_pointmap->getPoint(m_node).getNode().bin((directionbin + i) % 32);
-        bin.first();
-
-        // Quick mod - TV
+        const Bin &bin = m_pointmap->getPoint(m_node).getNode().bin((directionbin + i) % 32);
+        // n.b. the runs of the bin are walked here rather than with its cursor, which is shared by all the
+        // agents in the cell
+        for (const PixelVec &pixVec : bin.m_pixel_vecs) {
+            for (PixelRef pix = pixVec.start(); pix.col(bin.m_dir) <= pixVec.end().col(bin.m_dir);
+                 pix.move(bin.m_dir)) {
+                // Quick mod - TV
 #if defined(_MSC_VER)
-        int node = bin.is_tail() ? -1 : bin.cursor();
+                int node = pix;
 #else
-        int node = bin.is_tail() ? -1 : bin.cursor().x;
-#endif
-        while (node != -1) {
-            weight += ((directionbin + i) % 32 == aheadbin) ? 5.0 : 1.0;
-            weightmap.push_back(wpair(weight, node));
-            bin.next();
-            // Quick mod - TV
-#if defined(_MSC_VER)
-            node = bin.is_tail() ? -1 : bin.cursor();
-#else
-            node = bin.is_tail() ? -1 : bin.cursor().x;
+                int node = pix.x;
 #endif
+                weight += ((directionbin + i) % 32 == aheadbin) ? 5.0 : 1.0;
+                weightmap.push_back(wpair(weight, node));
+            }
         }
     }
     if (weightmap.size() == 0) {
         return onWeightedLook(true);
     } else {
-        double chosen = prandomr() * weight;
+        double chosen = m_random.randomr() * weight;
         for (size_t i = 0; i < weightmap.size(); i++) {
             if (chosen < weightmap[i].weight) {
                 tarpixelate = weightmap[i].node;
@@ -380,7 +390,7 @@ Point2f Agent::onOcclusionLook(bool wholeisovist, int looktype) {
                 return Point2f(0, 0);
             }
         } else {
-            size_t chosen = pafrand() % choices;
+            size_t chosen = m_random.rand() % choices;
             for (; chosen >= node.m_occlusion_bins[directionbin % 32].size(); directionbin++) {
                 chosen -= node.m_occlusion_bins[directionbin % 32].size();
             }
@@ -446,7 +456,7 @@ Point2f Agent::onOcclusionLook(bool wholeisovist, int looktype) {
                 return Point2f(0, 0);
             }
         } else {
-            double chosen = prandomr() * weight;
+            double chosen = m_random.randomr() * weight;
             for (size_t i = 0; i < weightmap.size(); i++) {
                 if (chosen < weightmap[i].weight) {
                     tarpixelate = weightmap[i].node;
@@ -506,7 +516,7 @@ Point2f Agent::onLoSLook(bool wholeisovist, int look_type) {
             return Point2f(0, 0);
         }
     } else {
-        double chosen = prandomr() * weight;
+        double chosen = m_random.randomr() * weight;
         for (size_t i = 0; i < weightmap.size(); i++) {
             if (chosen < weightmap[i].weight) {
                 targetbin = weightmap[i].node;
@@ -515,7 +525,7 @@ Point2f Agent::onLoSLook(bool wholeisovist, int look_type) {
         }
     }
 
-    float angle = (float)anglefrombin2(targetbin);
+    float angle = (float)anglefrombin2(targetbin, m_random.random());
 
     return Point2f(cosf(angle), sinf(angle));
 }
@@ -555,7 +565,7 @@ Point2f Agent::onDirectedLoSLook(bool wholeisovist, int look_type) {
             return Point2f(0, 0);
         }
     } else {
-        double chosen = prandomr() * weight;
+        double chosen = m_random.randomr() * weight;
         for (size_t i = 0; i < weightmap.size(); i++) {
             if (chosen < weightmap[i].weight) {
                 targetbin = weightmap[i].node;
@@ -564,7 +574,7 @@ Point2f Agent::onDirectedLoSLook(bool wholeisovist, int look_type) {
         }
     }
 
-    float angle = (float)anglefrombin2(targetbin);
+    float angle = (float)anglefrombin2(targetbin, m_random.random());
 
     return Point2f(cosf(angle), sinf(angle));
 }
@@ -593,7 +603,7 @@ Point2f Agent::onGibsonianLook(bool wholeisovist) {
     float angle = 0.0;
 
     if (rule_choice != -1) {
-        angle = (float)anglefrombin2((binfromvec(m_vector) + (2 * rule_choice + 1) * dir + 32) % 32);
+        angle = (float)anglefrombin2((binfromvec(m_vector) + (2 * rule_choice + 1) * dir + 32) % 32, m_random.random());
     }
 
     // if no rule selection made, carry on in current direction
@@ -643,13 +653,13 @@ int Agent::onGibsonianRule(int rule) {
         break;
     }
     int dir = 0;
-    if (option == 0x01 && m_program->m_rule_probability[0] > prandomr()) {
+    if (option == 0x01 && m_program->m_rule_probability[0] > m_random.randomr()) {
         dir = -1;
-    } else if (option == 0x10 && m_program->m_rule_probability[0] > prandomr()) {
+    } else if (option == 0x10 && m_program->m_rule_probability[0] > m_random.randomr()) {
         dir = +1;
-    } else if (option == 0x11 && m_program->m_rule_probability[0] > prandomr() * prandomr()) {
+    } else if (option == 0x11 && m_program->m_rule_probability[0] > m_random.randomr() * m_random.randomr()) {
         // note, use random * random event as there are two ways to do this
-        dir = (rand() % 2) ? -1 : +1;
+        dir = (m_random.rand() % 2) ? -1 : +1;
     }
     return dir;
 }
@@ -682,12 +692,12 @@ Point2f Agent::onGibsonianLook2(bool wholeisovist) {
     if ((m_curr_los[2] - m_last_los[2]) / m_curr_los[2] > m_program->m_feeler_threshold) {
         dir |= 0x10;
     }
-    if (dir == 0x01 && m_program->m_feeler_probability > prandomr()) {
+    if (dir == 0x01 && m_program->m_feeler_probability > m_random.randomr()) {
         maxbin = -m_program->m_vbin;
-    } else if (dir == 0x10 && m_program->m_feeler_probability > prandomr()) {
+    } else if (dir == 0x10 && m_program->m_feeler_probability > m_random.randomr()) {
         maxbin = m_program->m_vbin;
-    } else if (dir == 0x11 && m_program->m_feeler_probability > prandomr() * prandomr()) {
-        maxbin = (pafrand() % 2) ? m_program->m_vbin : -m_program->m_vbin;
+    } else if (dir == 0x11 && m_program->m_feeler_probability > m_random.randomr() * m_random.randomr()) {
+        maxbin = (m_random.rand() % 2) ? m_program->m_vbin : -m_program->m_vbin;
     }
     // third action: detect heading for dead-end
     if (maxbin == 0 && (m_curr_los[0] / m_pointmap->getSpacing() < m_program->m_ahead_threshold)) {
@@ -699,7 +709,7 @@ Point2f Agent::onGibsonianLook2(bool wholeisovist) {
     }
 
     int bin = binfromvec(m_vector) + maxbin;
-    float angle = (float)anglefrombin2(bin);
+    float angle = (float)anglefrombin2(bin, m_random.random());
 
     return (maxbin == 0) ? m_vector : Point2f(cosf(angle), sinf(angle));
 }
@@ -24,8 +24,20 @@
 #include "salalib/pointdata.h"
 
 #include "genlib/p2dpoly.h"
+#include "genlib/pafmath.h"
 #include "genlib/pflipper.h"
 
+// the cells the agents of a timestep have moved into, collected separately for each thread and only added to the
+// counts of the map once the timestep is over, so that the agents can move at the same time
+struct AgentCounts {
+    PixelRefVector entered; // for the total counts
+    PixelRefVector gates;   // for the gate counts
+    void clear() {
+        entered.clear();
+        gates.clear();
+    }
+};
+
 class Agent {
   public:
     enum { OUTPUT_NOTHING = 0x00, OUTPUT_COUNTS = 0x01, OUTPUT_GATE_COUNTS = 0x02, OUTPUT_TRAILS = 0x04 };
@@ -61,6 +73,9 @@ class Agent {
     // extra memory of last observed values for Gibsonian agents:
     float m_last_los[9];
     float m_curr_los[9];
+    //
+    // every agent draws from its own random numbers, so that its path does not depend on the other agents
+    PafRandomStream m_random;
 
   public:
     Agent() {
@@ -68,7 +83,8 @@ class Agent {
         m_pointmap = NULL;
         m_output_mode = OUTPUT_NOTHING;
     }
-    Agent(AgentProgram *program, PointMap *pointmap, int output_mode = OUTPUT_NOTHING);
+    Agent(AgentProgram *program, PointMap *pointmap, int output_mode = OUTPUT_NOTHING,
+          const PafRandomStream &random = PafRandomStream());
     void onInit(PixelRef node, int trail_num = -1);
     void onClose();
     Point2f onLook(bool wholeisovist);
@@ -82,7 +98,7 @@ class Agent {
     int onGibsonianRule(int rule);
     void calcLoS(int directionbin, bool curr);
     void calcLoS2(int directionbin, bool curr);
-    void onMove();
+    void onMove(AgentCounts &counts);
     void onTarget();
     void onDestination();
     void onStep();
@@ -104,8 +120,10 @@ class Agent {
 // note the add 0.5 means angles from e.g., -1/32 to 1/32 are in bin 0
 inline int binfromvec(const Point2f &p) { return int(32.0 * (0.5 * p.angle() / M_PI) + 0.5); }
 
-// a random angle based on a bin direction
-inline double anglefrombin2(int here) { return (2.0 * M_PI) * ((double(here) - 0.5) / 32.0 + prandom() / 32.0); }
+// a random angle based on a bin direction, from a random number from 0 to 1
+inline double anglefrombin2(int here, double random) {
+    return (2.0 * M_PI) * ((double(here) - 0.5) / 32.0 + random / 32.0);
+}
 
 inline int binsbetween(int bin1, int bin2) {
     int b = abs(bin1 - bin2);
@@ -19,6 +19,10 @@
 #include "agentengine.h"
 #include "agenthelpers.h"
 
+#include "genlib/parallel.h"
+
+#include <algorithm>
+
 // run one agent engine only
 
 AgentEngine::AgentEngine() {
@@ -33,21 +37,15 @@ void AgentEngine::run(Communicator *comm, PointMap *pointmap) {
             pointmap->requireIsovistAnalysis();
         }
     }
-    time_t atime = 0;
-    if (comm) {
-        qtimer(atime, 0);
-        comm->CommPostMessage(Communicator::NUM_RECORDS, m_timesteps);
-    }
 
     AttributeTable &table = pointmap->getAttributeTable();
-    int displaycol = table.getOrInsertColumn(g_col_total_counts);
+    int gatecol = m_gatelayer != -1 ? table.getColumnIndex(g_col_gate_counts) : -1;
 
     int output_mode = Agent::OUTPUT_COUNTS;
     if (m_gatelayer != -1) {
         output_mode |= Agent::OUTPUT_GATE_COUNTS;
     }
 
-    int trail_num = -1;
     if (m_record_trails) {
         if (m_trail_count < 1) {
             m_trail_count = 1;
@@ -55,7 +53,6 @@ void AgentEngine::run(Communicator *comm, PointMap *pointmap) {
         for (auto& agentSet: agentSets) {
             agentSet.m_trails = std::vector<std::vector<Event2f>>(m_trail_count);
         }
-        trail_num = 0;
     }
 
     // remove any agents that are left from a previous run
@@ -63,13 +60,134 @@ void AgentEngine::run(Communicator *comm, PointMap *pointmap) {
         agentSet.agents.clear();
     }
 
+    if (m_replicates > 1) {
+        runReplicates(comm, pointmap, output_mode);
+        return;
+    }
+
+    int displaycol = table.getOrInsertColumn(g_col_total_counts);
+    simulate(comm, true, pointmap, agentSets, m_random_seed, m_num_threads, output_mode, m_record_trails,
+             [&](const AgentCounts &counts) {
+                 for (PixelRef pix : counts.entered) {
+                     table.getRow(AttributeKey(pix)).incrValue(displaycol);
+                 }
+                 for (PixelRef pix : counts.gates) {
+                     table.getRow(AttributeKey(pix)).incrValue(gatecol);
+                 }
+             });
+
+    pointmap->overrideDisplayedAttribute(-2);
+    pointmap->setDisplayedAttribute(displaycol);
+}
+
+void AgentEngine::runReplicates(Communicator *comm, PointMap *pointmap, int output_mode) {
+    // the replicates all read the same point map, but each moves agent sets of its own and counts into a grid of
+    // its own, as the attribute table can not be written to from more than one thread. The first replicate uses
+    // the agent sets of the engine, so that it leaves the same agents and trails as a single run
+    std::vector<std::vector<AgentSet>> replicateSets(m_replicates - 1, agentSets);
+    size_t rows = pointmap->getRows();
+    size_t cellCount = pointmap->getCols() * rows;
+    auto cellIndex = [rows](PixelRef pix) { return size_t(pix.x) * rows + size_t(pix.y); };
+    std::vector<std::vector<int>> totalCounts(m_replicates);
+    std::vector<std::vector<int>> gateCounts(m_replicates);
+
+    // the replicates are spread over the threads, rather than the agents of each replicate
+    depthmapX::parallelFor(m_num_threads, size_t(m_replicates), [&](int threadIndex, size_t r) {
+        std::vector<AgentSet> &sets = (r == 0) ? agentSets : replicateSets[r - 1];
+        std::vector<int> &total = totalCounts[r];
+        std::vector<int> &gates = gateCounts[r];
+        total.resize(cellCount, 0);
+        if (output_mode & Agent::OUTPUT_GATE_COUNTS) {
+            gates.resize(cellCount, 0);
+        }
+        // every replicate stops on a cancel, but only the first thread reports progress
+        simulate(comm, threadIndex == 0, pointmap, sets, m_random_seed + static_cast<unsigned int>(r), 1,
+                 output_mode, m_record_trails && r == 0, [&](const AgentCounts &counts) {
+                     for (PixelRef pix : counts.entered) {
+                         total[cellIndex(pix)]++;
+                     }
+                     for (PixelRef pix : counts.gates) {
+                         gates[cellIndex(pix)]++;
+                     }
+                 });
+        if (r != 0) {
+            std::vector<AgentSet>().swap(sets);
+        }
+    });
+
+    AttributeTable &table = pointmap->getAttributeTable();
+    std::vector<int> replicateCols;
+    for (int r = 0; r < m_replicates; r++) {
+        replicateCols.push_back(
+            table.getOrInsertColumn(g_col_total_counts + g_col_replicate_suffix + std::to_string(r + 1)));
+    }
+    int meancol = table.getOrInsertColumn(g_col_total_counts + g_col_mean_suffix);
+    int variancecol = table.getOrInsertColumn(g_col_total_counts + g_col_variance_suffix);
+    int gatecol = (output_mode & Agent::OUTPUT_GATE_COUNTS) ? table.getColumnIndex(g_col_gate_counts) : -1;
+
+    // as for a single run, cells no agent has entered are left without a value
+    for (auto iter = table.begin(); iter != table.end(); iter++) {
+        size_t cell = cellIndex(PixelRef(iter->getKey().value));
+        AttributeRow &row = iter->getRow();
+        double sum = 0.0, sumSquares = 0.0;
+        for (int r = 0; r < m_replicates; r++) {
+            int count = totalCounts[r][cell];
+            if (count > 0) {
+                row.setValue(replicateCols[r], float(count));
+            }
+            sum += count;
+            sumSquares += double(count) * double(count);
+        }
+        if (sum > 0) {
+            double mean = sum / m_replicates;
+            // the sample variance, over the replicates
+            double variance = (sumSquares - sum * mean) / (m_replicates - 1);
+            row.setValue(meancol, float(mean));
+            row.setValue(variancecol, float(std::max(variance, 0.0)));
+        }
+        // the gate counts stay those of a single run, here the last replicate, and are added to as a run would
+        if (gatecol != -1) {
+            int gateCount = gateCounts[m_replicates - 1][cell];
+            if (gateCount > 0) {
+                row.incrValue(gatecol, float(gateCount));
+            }
+        }
+    }
+
+    pointmap->overrideDisplayedAttribute(-2);
+    pointmap->setDisplayedAttribute(meancol);
+}
+
+void AgentEngine::simulate(Communicator *comm, bool reportProgress, PointMap *pointmap, std::vector<AgentSet> &sets,
+                           unsigned int seed, int numThreads, int output_mode, bool recordTrails,
+                           const std::function<void(const AgentCounts &)> &addCounts) const {
+    time_t atime = 0;
+    if (comm && reportProgress) {
+        qtimer(atime, 0);
+        comm->CommPostMessage(Communicator::NUM_RECORDS, m_timesteps);
+    }
+
+    int trail_num = recordTrails ? 0 : -1;
+
+    // the random numbers of the run: stream 0 for the numbers of agents released, stream 1 + i for the release
+    // locations of agent set i, and then a stream for each agent, in the order they are released
+    PafRandomStream releaseRandom(seed, 0);
+    for (size_t i = 0; i < sets.size(); i++) {
+        sets[i].m_release_random = PafRandomStream(seed + sets[i].m_release_locations_seed, 1 + i);
+    }
+    uint64_t nextStream = 1 + sets.size();
+
+    numThreads = depthmapX::resolveThreadCount(numThreads);
+    std::vector<AgentCounts> counts(numThreads);
+
     for (int i = 0; i < m_timesteps; i++) {
-        for (auto &agentSet : agentSets) {
-            int q = invcumpoisson(prandomr(), agentSet.m_release_rate);
+        for (auto &agentSet : sets) {
+            int q = invcumpoisson(releaseRandom.randomr(), agentSet.m_release_rate);
             int length = agentSet.agents.size();
             int k;
             for (k = 0; k < q; k++) {
-                agentSet.agents.push_back(Agent(&(agentSet), pointmap, output_mode));
+                agentSet.agents.push_back(
+                    Agent(&(agentSet), pointmap, output_mode, PafRandomStream(seed, nextStream++)));
             }
             for (k = 0; k < q; k++) {
                 agentSet.init(length + k, trail_num);
@@ -83,22 +201,25 @@ void AgentEngine::run(Communicator *comm, PointMap *pointmap) {
             }
         }
 
-        for (auto &agentSet : agentSets) {
-            agentSet.move();
+        for (auto &agentSet : sets) {
+            agentSet.move(numThreads, counts);
+        }
+
+        // the counts are only added up once all the agents have moved
+        for (auto &threadCounts : counts) {
+            addCounts(threadCounts);
+            threadCounts.clear();
         }
 
         if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    throw Communicator::CancelledException();
-                }
+            if (comm->IsCancelled()) {
+                throw Communicator::CancelledException();
+            }
+            if (reportProgress && qtimer(atime, 500)) {
                 comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
             }
         }
     }
-
-    pointmap->overrideDisplayedAttribute(-2);
-    pointmap->setDisplayedAttribute(displaycol);
 }
 
 void AgentEngine::insertTrailsInMap(ShapeMap& trailsMap) {
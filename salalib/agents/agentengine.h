@@ -20,6 +20,8 @@
 
 #include "agentset.h"
 
+#include <functional>
+
 class AgentEngine {
   public: // public for now for speed
     std::vector<AgentSet> agentSets;
@@ -29,9 +31,23 @@ class AgentEngine {
   public:
     bool m_record_trails;
     int m_trail_count = 50;
+    // the same seed gives the same results, whatever the number of threads
+    unsigned int m_random_seed = 0;
+    int m_num_threads = 1; // 0 for all available cores
+    // more than one replicate runs the agents that many times, with the seeds m_random_seed, m_random_seed + 1
+    // and so on, and gives the counts of each as well as their mean and variance
+    int m_replicates = 1;
 
   public:
     AgentEngine();
     void run(Communicator *comm, PointMap *pointmap);
     void insertTrailsInMap(ShapeMap& trailsMap);
+
+  private:
+    void runReplicates(Communicator *comm, PointMap *pointmap, int output_mode);
+    // one run of the agents of the sets, with addCounts called with the cells entered at every timestep. The run
+    // stops on a cancel of the communicator, and posts its progress to it only if reportProgress is set
+    void simulate(Communicator *comm, bool reportProgress, PointMap *pointmap, std::vector<AgentSet> &sets,
+                  unsigned int seed, int numThreads, int output_mode, bool recordTrails,
+                  const std::function<void(const AgentCounts &)> &addCounts) const;
 };
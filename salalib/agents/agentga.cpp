@@ -18,14 +18,17 @@
 
 #include "agentga.h"
 
-#include "genlib/pafmath.h"
+#include "agent.h"
 
-int thisrun = 0;
+#include "genlib/parallel.h"
+
+#include <algorithm>
+#include <unordered_set>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-static int rankselect(int popsize) {
-    int num = int(prandom() * popsize * (popsize + 1) * 0.5);
+static int rankselect(int popsize, PafRandomStream &random) {
+    int num = int(random.random() * popsize * (popsize + 1) * 0.5);
     for (int i = 0; i < popsize; i++) {
         if (num < (popsize - i)) {
             return i;
@@ -35,27 +38,97 @@ static int rankselect(int popsize) {
     return 0; // <- this shouldn't happen
 }
 
-// note: this is tested and right: higher fitness, lower rank (so population[0] is best)
-int progcompare(const void *a, const void *b) {
-    double test = (((AgentProgram *)a)->m_fitness - ((AgentProgram *)b)->m_fitness);
-    if (test < 0.0) {
-        return 1;
-    } else if (test > 0.0) {
-        return -1;
+double evaluateProgram(AgentProgram &program, PointMap &pointmap, int assays, int timesteps,
+                       PafRandomStream random) {
+    if (assays < 1 || pointmap.getFilledPointCount() == 0) {
+        return 0.0;
+    }
+    double total = 0.0;
+    std::unordered_set<int> visited;
+    AgentCounts counts; // n.b. the agents here do not count anything
+    for (int assay = 0; assay < assays; assay++) {
+        PixelRef pix;
+        do {
+            pix = pointmap.pickPixel(random.random());
+        } while (!pointmap.getPoint(pix).filled());
+        Agent agent(&program, &pointmap, Agent::OUTPUT_NOTHING, PafRandomStream(random.rand(), assay));
+        agent.onInit(pix);
+        visited.clear();
+        visited.insert(agent.getNode());
+        for (int i = 0; i < timesteps; i++) {
+            agent.onMove(counts);
+            visited.insert(agent.getNode());
+        }
+        total += visited.size();
     }
-    return 0;
+    return total / assays;
 }
 
-AgentProgram *ProgramPopulation::makeChild() {
-    int a = rankselect(POPSIZE);
-    int b = rankselect(POPSIZE);
+void ProgramPopulation::init(const AgentProgram &program) {
+    m_random = PafRandomStream(m_random_seed, 0);
+    m_next_stream = 1;
+    for (auto &member : m_population) {
+        member = program;
+        member.m_trails.clear();
+        member.randomise(m_random);
+        member.m_fitness = 0.0;
+    }
+}
+
+AgentProgram ProgramPopulation::makeChild() {
+    int popsize = static_cast<int>(m_population.size());
+    int a = rankselect(popsize, m_random);
+    int b = rankselect(popsize, m_random);
     while (a == b)
-        b = rankselect(POPSIZE);
-    m_population[POPSIZE - 1] = crossover(m_population[a], m_population[b]);
-    m_population[POPSIZE - 1].mutate();
+        b = rankselect(popsize, m_random);
+    AgentProgram child = crossover(m_population[a], m_population[b], m_random);
+    child.mutate(m_random);
+
+    return child;
+}
 
-    return &(m_population[POPSIZE - 1]);
+// note: higher fitness, lower rank (so population[0] is best), and programs of equal fitness keep their order
+void ProgramPopulation::sort() {
+    std::stable_sort(m_population.begin(), m_population.end(),
+                     [](const AgentProgram &a, const AgentProgram &b) { return a.m_fitness > b.m_fitness; });
 }
 
-// note: this is correct -- do not use &m_population!
-void ProgramPopulation::sort() { qsort(m_population, POPSIZE, sizeof(AgentProgram), progcompare); }
+void ProgramPopulation::evaluate(PointMap &pointmap, size_t first) {
+    if (first >= m_population.size()) {
+        return;
+    }
+    // the streams are handed out in order here, so that each program gets the same one on any thread
+    uint64_t firstStream = m_next_stream;
+    m_next_stream += m_population.size() - first;
+    depthmapX::parallelFor(m_num_threads, m_population.size() - first, [&](int, size_t i) {
+        AgentProgram &program = m_population[first + i];
+        program.m_fitness =
+            evaluateProgram(program, pointmap, m_assays, m_timesteps, PafRandomStream(m_random_seed, firstStream + i));
+    });
+}
+
+void ProgramPopulation::evolve(Communicator *comm, PointMap &pointmap, int generations) {
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, generations);
+    }
+    evaluate(pointmap);
+    sort();
+    size_t parents = (m_population.size() + 1) / 2;
+    for (int generation = 0; generation < generations; generation++) {
+        // all the children are bred before any of them replaces a program
+        std::vector<AgentProgram> children;
+        for (size_t i = parents; i < m_population.size(); i++) {
+            children.push_back(makeChild());
+        }
+        std::move(children.begin(), children.end(), m_population.begin() + parents);
+        evaluate(pointmap, parents);
+        sort();
+
+        if (comm) {
+            if (comm->IsCancelled()) {
+                throw Communicator::CancelledException();
+            }
+            comm->CommPostMessage(Communicator::CURRENT_RECORD, generation + 1);
+        }
+    }
+}
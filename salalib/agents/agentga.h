@@ -20,21 +20,47 @@
 
 #include "agentprogram.h"
 
+#include "salalib/pointdata.h"
+
+#include "genlib/comm.h"
+#include "genlib/pafmath.h"
+
+#include <vector>
+
 const int POPSIZE = 500;
-// redo ASSAYs -- assaysize * assays (3 * 200 = 600 evaluations total)
-// then take mean fitness: due to large variation in fitnesses with
-// short assays such as this
+// redo ASSAYs and take the mean fitness: due to large variation in
+// fitnesses with short assays such as this
 const int ASSAYS = 3;
-const int ASSAYSIZE = 25000;
-const int GENERATIONS = 10000;
 const int TIMESTEPS = 1600;
 
+// the fitness of a program: the mean number of distinct cells an agent following it enters in a number of
+// timesteps, over a number of agents (assays) released at random cells
+double evaluateProgram(AgentProgram &program, PointMap &pointmap, int assays, int timesteps,
+                       PafRandomStream random);
+
 struct ProgramPopulation {
   public:
-    AgentProgram m_population[POPSIZE];
+    std::vector<AgentProgram> m_population;
+    int m_assays = ASSAYS;
+    int m_timesteps = TIMESTEPS;
+    // the same seed evolves the same programs, whatever the number of threads
+    unsigned int m_random_seed = 0;
+    int m_num_threads = 1; // 0 for all available cores
 
   public:
-    ProgramPopulation() {}
-    AgentProgram *makeChild();
+    ProgramPopulation(int popsize = POPSIZE) : m_population(popsize) {}
+    // a population of the kind of program given (selection type, steps and bins), with random rules
+    void init(const AgentProgram &program);
+    AgentProgram makeChild();
     void sort();
+    // evaluates the programs from first onwards, at the same time on different threads
+    void evaluate(PointMap &pointmap, size_t first = 0);
+    // each generation replaces the less fit half of the population with children of the whole of it,
+    // ranked by fitness, so the best program is always kept. Call init first
+    void evolve(Communicator *comm, PointMap &pointmap, int generations);
+
+  private:
+    // stream 0 is for breeding, and every evaluation has one of its own after that
+    PafRandomStream m_random;
+    uint64_t m_next_stream = 1;
 };
@@ -21,3 +21,7 @@
 const static std::string g_col_total_counts = "Gate Counts";
 const static std::string g_col_gate_counts = "__Internal_Gate_Counts";
 const static std::string g_col_gate = "__Internal_Gate";
+// for the counts of replicated runs
+const static std::string g_col_replicate_suffix = " Replicate ";
+const static std::string g_col_mean_suffix = " Mean";
+const static std::string g_col_variance_suffix = " Variance";
@@ -31,39 +31,54 @@ AgentProgram::AgentProgram() {
     m_los_sqrd = false;
 }
 
-void AgentProgram::mutate() {
+// random rules, for a first generation
+void AgentProgram::randomise(PafRandomStream &random) {
+    randomiseRuleOrder(random);
+    for (int i = 0; i < 4; i++) {
+        m_rule_threshold[i] = float(random.random() * 100.0);
+        m_rule_probability[i] = float(random.random());
+    }
+}
+
+void AgentProgram::mutate(PafRandomStream &random) {
     // do mutate rule order occassionally:
-    if (pafrand() % 20 == 0) {
-        // rule order relies on putting rules into slots:
-        for (int i = 0; i < 4; i++) {
-            m_rule_order[i] = -1;
-        }
-        for (int j = 0; j < 4; j++) {
-            int choice = pafrand() % (4 - j);
-            for (int k = 0; k < choice + 1; k++) {
-                if (m_rule_order[k] != -1) {
-                    choice++;
-                }
-            }
-            m_rule_order[choice] = j;
-        }
+    if (random.rand() % 20 == 0) {
+        randomiseRuleOrder(random);
     }
     // mutate the rule threshold / probabilities
     for (int i = 0; i < 4; i++) {
-        if (pafrand() % 20 == 0) { // 5% mutation rate
-            m_rule_threshold[i] = float(prandom() * 100.0);
+        if (random.rand() % 20 == 0) { // 5% mutation rate
+            m_rule_threshold[i] = float(random.random() * 100.0);
+        }
+        if (random.rand() % 20 == 0) { // 5% mutation rate
+            m_rule_probability[i] = float(random.random());
         }
-        if (pafrand() % 20 == 0) { // 5% mutation rate
-            m_rule_probability[i] = float(prandom());
+    }
+}
+
+void AgentProgram::randomiseRuleOrder(PafRandomStream &random) {
+    // rule order relies on putting rules into slots:
+    for (int i = 0; i < 4; i++) {
+        m_rule_order[i] = -1;
+    }
+    for (int j = 0; j < 4; j++) {
+        int choice = random.rand() % (4 - j);
+        for (int k = 0; k < choice + 1; k++) {
+            if (m_rule_order[k] != -1) {
+                choice++;
+            }
         }
+        m_rule_order[choice] = j;
     }
 }
 
-AgentProgram crossover(const AgentProgram &prog_a, const AgentProgram &prog_b) {
-    AgentProgram child;
+AgentProgram crossover(const AgentProgram &prog_a, const AgentProgram &prog_b, PafRandomStream &random) {
+    // the child is of the same kind as its parents, only its rules are mixed:
+    AgentProgram child = prog_a;
+    child.m_trails.clear();
 
     // either one rule priority order or the other (don't try to mix!)
-    if (pafrand() % 2) {
+    if (random.rand() % 2) {
         for (int i = 0; i < 4; i++) {
             child.m_rule_order[i] = prog_a.m_rule_order[i];
         }
@@ -74,12 +89,12 @@ AgentProgram crossover(const AgentProgram &prog_a, const AgentProgram &prog_b) {
     }
     // for each rule, either one rule threshold / probability or the other:
     for (int i = 0; i < 4; i++) {
-        if (pafrand() % 2) {
+        if (random.rand() % 2) {
             child.m_rule_threshold[i] = prog_a.m_rule_threshold[i];
         } else {
             child.m_rule_threshold[i] = prog_b.m_rule_threshold[i];
         }
-        if (pafrand() % 2) {
+        if (random.rand() % 2) {
             child.m_rule_probability[i] = prog_a.m_rule_probability[i];
         } else {
             child.m_rule_probability[i] = prog_b.m_rule_probability[i];
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "genlib/p2dpoly.h"
+#include "genlib/pafmath.h"
 
 #include <string>
 
@@ -70,8 +71,10 @@ struct AgentProgram {
     AgentProgram();
     //
     // for evolution
-    void mutate();
-    friend AgentProgram crossover(const AgentProgram &prog_a, const AgentProgram &prog_b);
+    void randomise(PafRandomStream &random);
+    void mutate(PafRandomStream &random);
+    void randomiseRuleOrder(PafRandomStream &random);
+    friend AgentProgram crossover(const AgentProgram &prog_a, const AgentProgram &prog_b, PafRandomStream &random);
     // to reload later:
     void save(const std::string &filename);
     bool open(const std::string &filename);
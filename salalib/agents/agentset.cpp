@@ -20,6 +20,10 @@
 
 #include "salalib/pixelref.h"
 
+#include "genlib/parallel.h"
+
+#include <algorithm>
+
 AgentSet::AgentSet() {
     m_release_rate = 0.1;
     m_lifetime = 1000;
@@ -27,24 +31,24 @@ AgentSet::AgentSet() {
 
 void AgentSet::init(int agent, int trail_num) {
     if (m_release_locations.size()) {
-        int which = pafrand() % m_release_locations.size();
+        int which = m_release_random.rand() % m_release_locations.size();
         agents[agent].onInit(m_release_locations[which], trail_num);
     } else {
         const PointMap &map = agents[agent].getPointMap();
         PixelRef pix;
         do {
-            pix = map.pickPixel(prandom(m_release_locations_seed));
+            pix = map.pickPixel(m_release_random.random());
         } while (!map.getPoint(pix).filled());
         agents[agent].onInit(pix, trail_num);
     }
 }
 
-void AgentSet::move() {
-    // go through backwards so remove does not affect later agents
-    for (auto rev_iter = agents.rbegin(); rev_iter != agents.rend(); ++rev_iter) {
-        rev_iter->onMove();
-        if (rev_iter->getFrame() >= m_lifetime) {
-            agents.erase(std::next(rev_iter).base());
-        }
-    }
+void AgentSet::move(int num_threads, std::vector<AgentCounts> &counts) {
+    // the agents only change themselves and their own trails, and the cells they move into are collected
+    // per thread (counts must have one entry per thread), so they can all move at the same time
+    depthmapX::parallelFor(
+        num_threads, agents.size(), [&](int threadIndex, size_t i) { agents[i].onMove(counts[threadIndex]); }, 64);
+    agents.erase(std::remove_if(agents.begin(), agents.end(),
+                                [&](const Agent &agent) { return agent.getFrame() >= m_lifetime; }),
+                 agents.end());
 }
@@ -27,7 +27,9 @@ struct AgentSet : public AgentProgram {
     int m_release_locations_seed = 0;
     double m_release_rate;
     int m_lifetime;
+    // for the release locations, set up by the engine at the start of a run
+    PafRandomStream m_release_random;
     AgentSet();
-    void move();
+    void move(int num_threads, std::vector<AgentCounts> &counts);
     void init(int agent, int trail_num = -1);
 };
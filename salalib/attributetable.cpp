@@ -19,6 +19,8 @@
 #include <genlib/stringutils.h>
 #include <genlib/readwritehelpers.h>
 
+#include <cmath>
+#include <limits>
 #include <sstream>
 #include <numeric>
 
@@ -230,6 +232,126 @@ AttributeRow &AttributeRowImpl::incrValue(const std::string &colName, float valu
     return incrValue(m_colManager.getColumnIndex(colName), value);
 }
 
+// AttributeRowView implementation
+float AttributeRowView::getValue(const std::string &column) const
+{
+    return getValue(m_table->getColumnIndex(column));
+}
+
+float AttributeRowView::getValue(size_t index) const
+{
+    checkIndex(index);
+    return m_table->m_values[index][m_index];
+}
+
+float AttributeRowView::getNormalisedValue(size_t index) const
+{
+    checkIndex(index);
+    auto& colStats = m_table->m_columns[index].getStats();
+    if (colStats.max == colStats.min)
+    {
+        return 0.5f;
+    }
+    float value = m_table->m_values[index][m_index];
+    return value < 0 ? -1.0f : float((value - colStats.min)/(colStats.max - colStats.min));
+}
+
+AttributeRow& AttributeRowView::setValue(const std::string &column, float value)
+{
+    return setValue(m_table->getColumnIndex(column), value);
+}
+
+AttributeRow& AttributeRowView::setValue(size_t index, float value)
+{
+    checkIndex(index);
+    float& data = m_table->m_values[index][m_index];
+    float oldVal = data;
+    data = value;
+    if (oldVal < 0.0f)
+    {
+        oldVal = 0.0f;
+    }
+    m_table->m_columns[index].updateStats(value, oldVal);
+    return *this;
+}
+
+AttributeRow &AttributeRowView::incrValue(const std::string &colName, float value)
+{
+    return incrValue(m_table->getColumnIndex(colName), value);
+}
+
+AttributeRow &AttributeRowView::incrValue(size_t index, float value)
+{
+    checkIndex(index);
+    float val = m_table->m_values[index][m_index];
+    if ( val < 0)
+    {
+        setValue(index, value);
+    }
+    else
+    {
+        setValue(index, val + value);
+    }
+    return *this;
+}
+
+AttributeRow& AttributeRowView::setSelection(bool selected)
+{
+    m_selected = selected;
+    return *this;
+}
+
+bool AttributeRowView::isSelected() const
+{
+    return m_selected;
+}
+
+void AttributeRowView::checkIndex(size_t index) const
+{
+    if( index >= m_table->m_values.size())
+    {
+        throw std::out_of_range("AttributeColumn index out of range");
+    }
+}
+
+
+// AttributeTable implementation
+AttributeTable::AttributeTable(AttributeTable &&other)
+    : m_rows(std::move(other.m_rows)), m_values(std::move(other.m_values)), m_ordered(other.m_ordered),
+      m_rowViews(std::move(other.m_rowViews)), m_freeRowViews(std::move(other.m_freeRowViews)),
+      m_rowsByKey(std::move(other.m_rowsByKey)), m_columnMapping(std::move(other.m_columnMapping)),
+      m_columns(std::move(other.m_columns)), m_keyColumn(std::move(other.m_keyColumn)),
+      m_displayParams(other.m_displayParams)
+{
+    // the rows have to follow their values (moving the deque leaves the views where they are)
+    for (auto& row : m_rowViews)
+    {
+        row.m_table = this;
+    }
+}
+
+AttributeTable &AttributeTable::operator =(AttributeTable &&other)
+{
+    if (this != &other)
+    {
+        m_rows = std::move(other.m_rows);
+        m_values = std::move(other.m_values);
+        m_ordered = other.m_ordered;
+        m_rowViews = std::move(other.m_rowViews);
+        m_freeRowViews = std::move(other.m_freeRowViews);
+        m_rowsByKey = std::move(other.m_rowsByKey);
+        m_columnMapping = std::move(other.m_columnMapping);
+        m_columns = std::move(other.m_columns);
+        m_keyColumn = std::move(other.m_keyColumn);
+        m_displayParams = other.m_displayParams;
+        for (auto& row : m_rowViews)
+        {
+            row.m_table = this;
+        }
+    }
+    return *this;
+}
+
 AttributeRow &AttributeTable::getRow(const AttributeKey &key)
 {
     auto* row = getRowPtr(key);
@@ -252,43 +374,46 @@ const AttributeRow& AttributeTable::getRow(const AttributeKey &key) const
 
 AttributeRow *AttributeTable::getRowPtr(const AttributeKey &key)
 {
-    auto iter = m_rows.find(key);
-    if (iter == m_rows.end())
-    {
-        return 0;
-    }
-    return iter->second.get();
+    return findRow(key);
 }
 
 const AttributeRow *AttributeTable::getRowPtr(const AttributeKey &key) const
 {
-    auto iter = m_rows.find(key);
-    if (iter == m_rows.end())
-    {
-        return 0;
-    }
-    return iter->second.get();
+    return findRow(key);
 }
 
 AttributeRow &AttributeTable::addRow(const AttributeKey &key)
 {
-    auto iter = m_rows.find(key);
-    if (iter != m_rows.end())
+    if (findRow(key) != nullptr)
     {
         throw new std::invalid_argument("Duplicate key");
     }
-    auto res = m_rows.insert(std::make_pair(key, std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this))));
-    return *res.first->second;
+    return insertRow(key);
 }
 
 void AttributeTable::removeRow(const AttributeKey &key)
 {
-    auto iter = m_rows.find(key);
-    if (iter == m_rows.end())
+    auto iter = m_rowsByKey.find(key.value);
+    if (iter == m_rowsByKey.end())
     {
         throw new std::invalid_argument("Row does not exist");
     }
-    m_rows.erase(iter);
+    AttributeRowView *row = iter->second;
+    m_rowsByKey.erase(iter);
+    m_freeRowViews.push_back(row);
+    if (m_ordered && row->m_index + 1 == m_rows.size())
+    {
+        // the last row can go without breaking the order
+        m_rows.pop_back();
+        for (auto& values : m_values)
+        {
+            values.pop_back();
+        }
+        return;
+    }
+    m_rows[row->m_index] = nullptr;
+    m_ordered = false;
+    restoreOrder();
 }
 
 AttributeColumn &AttributeTable::getColumn(size_t index)
@@ -309,11 +434,15 @@ size_t AttributeTable::insertOrResetColumn(const std::string &columnName, const
     }
 
     // it exists - we need to reset it
-    m_columns[iter->second].m_stats = AttributeColumnStats();
-    m_columns[iter->second].setLock(false);
-    for (auto& row : m_rows)
+    AttributeColumnImpl& column = m_columns[iter->second];
+    column.m_stats = AttributeColumnStats();
+    column.setLock(false);
+    // n.b. the stats are updated value by value, as they would be by resetting every row separately
+    for (float& value : m_values[iter->second])
     {
-        row.second->setValue(iter->second, -1.0f);
+        float oldVal = value < 0.0f ? 0.0f : value;
+        value = -1.0f;
+        column.updateStats(-1.0f, oldVal);
     }
     return iter->second;
 }
@@ -356,10 +485,7 @@ void AttributeTable::removeColumn(size_t colIndex)
         }
     }
     m_columns.erase(m_columns.begin()+colIndex);
-    for (auto& row : m_rows)
-    {
-        row.second->removeColumn(colIndex);
-    }
+    m_values.erase(m_values.begin()+colIndex);
 }
 
 void AttributeTable::renameColumn(const std::string &oldName, const std::string &newName)
@@ -379,7 +505,7 @@ void AttributeTable::renameColumn(const std::string &oldName, const std::string
 
 void AttributeTable::deselectAllRows()
 {
-    for (auto& row : m_rows)
+    for (auto& row : m_rowsByKey)
     {
         row.second->setSelection(false);
     }
@@ -409,15 +535,29 @@ void AttributeTable::read(std::istream &stream, LayerManager &layerManager)
     {
         m_columnMapping[c.second.getName()] = m_columns.size();
         m_columns.push_back(c.second);
+        m_values.emplace_back();
     }
 
     int rowcount, rowkey;
     stream.read((char *)&rowcount, sizeof(rowcount));
+    m_rows.reserve(rowcount);
+    m_rowsByKey.reserve(rowcount);
+    for (auto& values : m_values)
+    {
+        values.reserve(rowcount);
+    }
+    std::vector<float> data;
     for (int i = 0; i < rowcount; i++) {
         stream.read((char *)&rowkey, sizeof(rowkey));
-        auto row = std::unique_ptr<AttributeRowImpl>(new AttributeRowImpl(*this));
-        row->read(stream);
-        m_rows.insert(std::make_pair(AttributeKey(rowkey),std::move(row)));
+        AttributeRowView& row = insertRow(AttributeKey(rowkey));
+        LayerManager::KeyType layerKey;
+        stream.read((char *)&layerKey, sizeof(layerKey));
+        row.setLayerKey(layerKey);
+        dXreadwrite::readIntoVector(stream, data);
+        for (size_t col = 0; col < m_values.size() && col < data.size(); col++)
+        {
+            m_values[col][row.m_index] = data[col];
+        }
     }
 
     // ref column display params
@@ -447,16 +587,28 @@ void AttributeTable::write(std::ostream &stream, const LayerManager &layerManage
 
     int rowcount = (int)m_rows.size();
     stream.write((char *)&rowcount, sizeof(int));
-    for ( auto &kvp : m_rows)
+    // the values of each row are written together, as they were when the rows held their own values
+    std::vector<float> data(m_values.size());
+    for (size_t i = 0; i < m_rows.size(); i++)
     {
-        kvp.first.write(stream);
-        kvp.second->write(stream);
+        m_rows[i]->getKey().write(stream);
+        stream.write((const char *)&m_rows[i]->getLayerKey(), sizeof(LayerManager::KeyType));
+        for (size_t col = 0; col < m_values.size(); col++)
+        {
+            data[col] = m_values[col][i];
+        }
+        dXreadwrite::writeVector(stream, data);
     }
     stream.write((const char *)&m_displayParams, sizeof(DisplayParams));
 }
 
 void AttributeTable::clear() {
     m_rows.clear();
+    m_values.clear();
+    m_ordered = true;
+    m_rowViews.clear();
+    m_freeRowViews.clear();
+    m_rowsByKey.clear();
     m_columns.clear();
     m_columnMapping.clear();
 }
@@ -485,6 +637,22 @@ size_t AttributeTable::getColumnSortedIndex(size_t index) const
 }
 
 
+const std::vector<float> &AttributeTable::getColumnValues(size_t index) const
+{
+    checkColumnIndex(index);
+    return m_values[index];
+}
+
+size_t AttributeTable::getRowIndex(const AttributeKey &key) const
+{
+    const AttributeRowView *row = findRow(key);
+    if (row == nullptr)
+    {
+        throw std::out_of_range("Invalid row key");
+    }
+    return row->m_index;
+}
+
 const AttributeColumn &AttributeTable::getColumn(size_t index) const
 {
     if(index == size_t(-1)) {
@@ -523,9 +691,135 @@ size_t AttributeTable::addColumnInternal(const std::string &name, const std::str
     size_t colIndex = m_columns.size();
     m_columns.push_back(AttributeColumnImpl(name, formula));
     m_columnMapping[name] = colIndex;
-    for (auto& elem : m_rows)
+    m_values.emplace_back(m_rows.size(), -1.0f);
+    return colIndex;
+}
+
+AttributeRowView *AttributeTable::findRow(const AttributeKey &key) const
+{
+    auto iter = m_rowsByKey.find(key.value);
+    if (iter == m_rowsByKey.end())
     {
-        elem.second->addColumn();
+        return nullptr;
+    }
+    return iter->second;
+}
+
+AttributeRowView &AttributeTable::insertRow(const AttributeKey &key)
+{
+    size_t index = m_rows.size();
+    // rows are most often added in key order, in which case the order holds
+    if (m_ordered && !m_rows.empty() && key < m_rows.back()->getKey())
+    {
+        m_ordered = false;
+    }
+    AttributeRowView *row;
+    if (m_freeRowViews.empty())
+    {
+        m_rowViews.emplace_back(*this, key, index);
+        row = &m_rowViews.back();
+    }
+    else
+    {
+        row = m_freeRowViews.back();
+        m_freeRowViews.pop_back();
+        row->m_key = key;
+        row->m_index = index;
+        row->m_selected = false;
+        row->m_layerKey = 1;
+    }
+    for (auto& values : m_values)
+    {
+        values.push_back(-1.0f);
+    }
+    m_rows.push_back(row);
+    m_rowsByKey[key.value] = row;
+    restoreOrder();
+    return *row;
+}
+
+void AttributeTable::restoreOrder()
+{
+    if (m_ordered || m_openRowChanges > 0)
+    {
+        return;
+    }
+    StorageType rows;
+    rows.reserve(m_rowsByKey.size());
+    for (auto* row : m_rows)
+    {
+        if (row != nullptr)
+        {
+            rows.push_back(row);
+        }
+    }
+    std::sort(rows.begin(), rows.end(), [](const AttributeRowView *a, const AttributeRowView *b) {
+        return a->getKey() < b->getKey();
+    });
+    std::vector<float> column(rows.size());
+    for (auto& values : m_values)
+    {
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            column[i] = values[rows[i]->m_index];
+        }
+        values.assign(column.begin(), column.end());
+    }
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        rows[i]->m_index = i;
+    }
+    m_rows.swap(rows);
+    m_ordered = true;
+}
+
+// AttributeBulkWriter implementation
+void AttributeBulkWriter::reserve(size_t column)
+{
+    WrittenColumn& writtenColumn = m_columns.at(column);
+    if (writtenColumn.reserved)
+    {
+        return;
+    }
+    m_table.checkColumnIndex(column);
+    const std::vector<float>& values = m_table.m_values[column];
+    writtenColumn.written.assign(values.size(), 0);
+    for (size_t row = 0; row < values.size(); row++)
+    {
+        // values below zero count as zero when they are replaced
+        if (!(values[row] <= 0.0f))
+        {
+            writtenColumn.oldValues.emplace_back(row, values[row]);
+        }
+    }
+    writtenColumn.reserved = true;
+}
+
+void AttributeBulkWriter::commit()
+{
+    for (size_t column = 0; column < m_columns.size(); column++)
+    {
+        WrittenColumn& writtenColumn = m_columns[column];
+        if (!writtenColumn.reserved)
+        {
+            continue;
+        }
+        const std::vector<float>& values = m_table.m_values[column];
+        const AttributeColumnImpl& columnImpl = m_table.m_columns[column];
+        auto oldValue = writtenColumn.oldValues.begin();
+        for (size_t row = 0; row < writtenColumn.written.size(); row++)
+        {
+            float oldVal = 0.0f;
+            if (oldValue != writtenColumn.oldValues.end() && oldValue->first == row)
+            {
+                oldVal = oldValue->second;
+                ++oldValue;
+            }
+            if (writtenColumn.written[row])
+            {
+                columnImpl.updateStats(values[row], oldVal);
+            }
+        }
+        m_columns[column] = WrittenColumn();
     }
-    return colIndex;
 }
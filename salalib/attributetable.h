@@ -18,6 +18,8 @@
 #include "layermanager.h"
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <deque>
 #include <vector>
 #include <memory>
 #include <sstream>
@@ -170,7 +172,8 @@ public:
 };
 
 
-// Implementation of AttributeRow
+// Implementation of AttributeRow that holds its own values, for rows that are not part of a table
+// (the rows of an AttributeTable are AttributeRowViews on the columns of the table)
 class AttributeRowImpl : public AttributeRow
 {
 public:
@@ -234,6 +237,49 @@ struct AttributeKey
     }
 };
 
+class AttributeTable;
+
+///
+/// \brief Row of an AttributeTable
+/// The table stores its values by column, so a row is only a view into the table, that knows its key and
+/// its position in the columns. The selection and layer of a row are kept in the view itself. The views are
+/// kept by the table in blocks, and a view stays where it is for as long as its row is in the table.
+///
+class AttributeRowView : public AttributeRow
+{
+    friend class AttributeTable;
+public:
+    AttributeRowView(AttributeTable &table, const AttributeKey &key, size_t index) : m_table(&table), m_key(key), m_index(index), m_selected(false)
+    {
+        m_layerKey = 1;
+    }
+    AttributeRowView(const AttributeRowView&) = delete;
+    AttributeRowView& operator =(const AttributeRowView&) = delete;
+
+    // AttributeRow interface
+public:
+    virtual float getValue(const std::string &column) const;
+    virtual float getValue(size_t index) const;
+    virtual float getNormalisedValue(size_t index) const;
+    virtual AttributeRow& setValue(const std::string &column, float value);
+    virtual AttributeRow& setValue(size_t index, float value);
+    virtual AttributeRow& incrValue(const std::string &column, float value);
+    virtual AttributeRow& incrValue(size_t index, float value);
+    virtual AttributeRow& setSelection(bool selected);
+    virtual bool isSelected() const;
+
+    const AttributeKey& getKey() const { return m_key; }
+
+private:
+    AttributeTable *m_table;
+    AttributeKey m_key;
+    // position of the row in the columns of the table
+    size_t m_index;
+    bool m_selected;
+
+    void checkIndex(size_t index) const;
+};
+
 ///
 /// AttributeTable
 ///
@@ -243,8 +289,8 @@ class AttributeTable : public AttributeColumnManager
 public:
     AttributeTable(){}
     virtual ~AttributeTable(){}
-    AttributeTable(AttributeTable&&) = default;
-    AttributeTable& operator =(AttributeTable&&) = default;
+    AttributeTable(AttributeTable&& other);
+    AttributeTable& operator =(AttributeTable&& other);
     AttributeTable(const AttributeTable& ) = delete;
     AttributeTable& operator =(const AttributeTable&) = delete;
 
@@ -284,7 +330,7 @@ public:
     void removeRow(const AttributeKey& key);
     void removeColumn(size_t colIndex);
     void renameColumn(const std::string& oldName, const std::string& newName);
-    size_t getNumRows() const { return m_rows.size(); }
+    size_t getNumRows() const { return m_rowsByKey.size(); }
     void deselectAllRows();
     const DisplayParams& getDisplayParams() const { return m_displayParams; }
     void setDisplayParams(const DisplayParams& params){m_displayParams = params;}
@@ -295,9 +341,9 @@ public:
     float getSelAvg(size_t columnIndex) {
         float selTotal = 0;
         int selNum = 0;
-        for(auto& pair: m_rows) {
-            if(pair.second->isSelected()) {
-                selTotal += pair.second->getValue(columnIndex);
+        for(auto& row: m_rows) {
+            if(row->isSelected()) {
+                selTotal += row->getValue(columnIndex);
                 selNum++;
             }
         }
@@ -319,9 +365,42 @@ public:
     // if the set of columns was sorted
     size_t getColumnSortedIndex(size_t index) const;
 
+    ///
+    /// \brief Get all the values of a column at once, for scanning a whole column
+    /// \param index of the column
+    /// \return the values of the column, in the same (key) order as the iteration over the rows
+    ///
+    const std::vector<float>& getColumnValues(size_t index) const;
+
+    ///
+    /// \brief Get the position of a row, i.e. its index in the values of a column
+    /// \param key of the row
+    /// \return the position of the row, throws if key not found
+    ///
+    size_t getRowIndex(const AttributeKey& key) const;
+
 private:
-    typedef std::map<AttributeKey, std::unique_ptr<AttributeRowImpl>> StorageType;
+    friend class AttributeRowView;
+    friend class AttributeBulkWriter;
+    friend class AttributeRowChanges;
+
+    // The values are stored by column, each column in one contiguous array indexed by the position of
+    // the row, and a row is found from its key through a hash map. The rows are kept in key order, so that
+    // the position of a row is also its position when iterating over the table. Rows added out of key order
+    // are appended and removed rows leave a gap, and the key order is restored (in one sort) straight after
+    // the change, or, while an AttributeRowChanges is open, once it closes. So removing many rows out of order
+    // together does not move the columns each time, and reading the table never changes it.
+    typedef std::vector<AttributeRowView *> StorageType;
+    // the rows by position, null for a row removed since the order was last restored
     StorageType m_rows;
+    std::vector<std::vector<float>> m_values;
+    bool m_ordered = true;
+    // the number of AttributeRowChanges open on the table
+    int m_openRowChanges = 0;
+    // the views of the rows, which stay in place, and those of removed rows, to be reused
+    std::deque<AttributeRowView> m_rowViews;
+    std::vector<AttributeRowView *> m_freeRowViews;
+    std::unordered_map<int, AttributeRowView *> m_rowsByKey;
     std::map<std::string, size_t> m_columnMapping;
     std::vector<AttributeColumnImpl> m_columns;
     KeyColumn m_keyColumn;
@@ -330,6 +409,11 @@ private:
 private:
     void checkColumnIndex(size_t index) const;
     size_t addColumnInternal(const std::string &name, const std::string &formula);
+    AttributeRowView *findRow(const AttributeKey &key) const;
+    // add a row with all values set to -1, after the others
+    AttributeRowView &insertRow(const AttributeKey &key);
+    // put the rows back in key order, without gaps, unless the changes are part of a larger set
+    void restoreOrder();
 
 // warning - here be dragons!
 // This is the implementation of stl style iterators on attribute table, allowing efficient
@@ -369,17 +453,17 @@ private:
 
         const AttributeKey& getKey() const
         {
-            return m_iter->first;
+            return (*m_iter)->getKey();
         }
 
         const AttributeRow& getRow() const
         {
-            return *m_iter->second;
+            return **m_iter;
         }
 
        AttributeRow& getRow()
        {
-           return *m_iter->second;
+           return **m_iter;
        }
 
         void forward() const
@@ -455,7 +539,7 @@ public:
     // stl style iteration methods
     const_iterator begin() const
     {
-        return const_iterator(m_rows.begin());
+        return const_iterator(m_rows.cbegin());
     }
 
     iterator begin()
@@ -465,7 +549,7 @@ public:
 
     const_iterator end() const
     {
-        return const_iterator(m_rows.end());
+        return const_iterator(m_rows.cend());
     }
 
     iterator end()
@@ -475,12 +559,85 @@ public:
 
     iterator find(AttributeKey key)
     {
-        return iterator(m_rows.find(key));
+        AttributeRowView *row = findRow(key);
+        if (row == nullptr)
+        {
+            return end();
+        }
+        return iterator(m_rows.begin() + static_cast<std::ptrdiff_t>(row->m_index));
     }
 
-    std::pair<const AttributeKey, std::unique_ptr<AttributeRowImpl>>& back()
+    AttributeRowView& back()
     {
-        return *m_rows.rbegin();
+        return *m_rows.back();
     }
 };
 
+///
+/// \brief Bulk writer for the results of an analysis
+/// Writes the values of any number of columns straight into the table, indexed by row position
+/// (see AttributeTable::getRowIndex), and keeps track of which rows were written to, so that the stats of the
+/// columns can be brought up to date all at once on commit. Separate rows can be written in any order and from
+/// any thread, but a column is only set up the first time it is written to, so columns that are written from
+/// several threads at once have to be reserved first. No rows may be added or removed while writing.
+///
+class AttributeBulkWriter
+{
+public:
+    AttributeBulkWriter(AttributeTable &table) : m_table(table), m_columns(table.getNumColumns())
+    {}
+
+    void reserve(size_t column);
+
+    ///
+    /// \brief Access a value of a column, for writing. The value is in the table straight away
+    ///
+    float &value(size_t row, size_t column)
+    {
+        reserve(column);
+        m_columns[column].written[row] = 1;
+        return m_table.m_values[column][row];
+    }
+
+    ///
+    /// \brief Update the stats of the columns that were written to, as if the values had been set row by row
+    ///
+    void commit();
+
+private:
+    struct WrittenColumn
+    {
+        bool reserved = false;
+        // one flag per row (not vector<bool>, so that separate rows can be flagged from separate threads)
+        std::vector<char> written;
+        // the values from before the writing that count in the stats, which are only the positive ones
+        std::vector<std::pair<size_t, float>> oldValues;
+    };
+    AttributeTable &m_table;
+    std::vector<WrittenColumn> m_columns;
+};
+
+///
+/// \brief A set of rows added to or removed from a table together
+/// While it is open, rows added out of key order and removed rows are left where they are, and the key order
+/// is only restored once, when the last set open on the table closes. The rows of the table can be looked up by
+/// key in the meantime, but not iterated over or looked up by position.
+///
+class AttributeRowChanges
+{
+public:
+    AttributeRowChanges(AttributeTable &table) : m_table(table)
+    {
+        m_table.m_openRowChanges++;
+    }
+    ~AttributeRowChanges()
+    {
+        m_table.m_openRowChanges--;
+        m_table.restoreOrder();
+    }
+    AttributeRowChanges(const AttributeRowChanges &) = delete;
+    AttributeRowChanges &operator=(const AttributeRowChanges &) = delete;
+
+private:
+    AttributeTable &m_table;
+};
@@ -42,9 +42,11 @@ std::vector<ConstAttributeIndexItem> makeAttributeIndex(const AttributeTable &ta
     else if (colIndex >= 0 )
     {
         double perturbationFactor = table.getColumn(colIndex).getStats().max * 1e-9 / numRows;
+        // the values are in the same order as the rows
+        const std::vector<float> &values = table.getColumnValues(colIndex);
         for (auto & item : table)
         {
-            double value = item.getRow().getValue(colIndex);
+            double value = values[idx];
             value += idx * perturbationFactor;
 
             index.push_back(ConstAttributeIndexItem(item.getKey(), value, item.getRow()));
@@ -85,9 +87,11 @@ std::vector<AttributeIndexItem> makeAttributeIndex(AttributeTable &table, int co
     else if (colIndex >= 0 )
     {
         double perturbationFactor = table.getColumn(colIndex).getStats().max * 1e-9 / numRows;
+        // the values are in the same order as the rows
+        const std::vector<float> &values = table.getColumnValues(colIndex);
         for (auto & item : table)
         {
-            double value = item.getRow().getValue(colIndex);
+            double value = values[idx];
             value += idx * perturbationFactor;
 
             index.push_back(AttributeIndexItem(item.getKey(), value, item.getRow()));
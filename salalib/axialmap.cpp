@@ -60,6 +60,7 @@ void ShapeGraph::initialiseAttributesAxial()
 
 void ShapeGraph::makeConnections(const KeyVertices &keyvertices)
 {
+   connectionsChanged();
    m_connectors.clear();
    m_links.clear();
    m_unlinks.clear();
@@ -180,6 +181,7 @@ void ShapeGraph::outputNet(std::ostream& netfile) const
 
 bool ShapeGraph::read(std::istream &stream)
 {
+   connectionsChanged();
    m_attributes->clear();
    m_connectors.clear();
    m_map_type = ShapeMap::EMPTYMAP;
@@ -365,6 +367,7 @@ void ShapeGraph::writeSegmentConnectionsAsPairsCSV(std::ostream &stream)
 }
 
 void ShapeGraph::unlinkAtPoint(const Point2f& unlinkPoint) {
+    connectionsChanged();
     std::vector<Point2f> closepoints;
     std::vector<std::pair<int, int>> intersections;
     PixelRef pix = pixelate(unlinkPoint);
@@ -565,6 +568,7 @@ void ShapeGraph::makeNewSegMap(Communicator *comm) {
 
 void ShapeGraph::makeSegmentMap(std::vector<Line>& lines, std::vector<Connector>& connectors, double stubremoval)
 {
+   connectionsChanged();
    // the first (key) pair is the line / line intersection, second is the pair of associated segments for the first line
    std::map<OrderedIntPair, std::pair<int, int>> segmentlist;
 
@@ -735,6 +739,7 @@ void ShapeGraph::initialiseAttributesSegment()
 
 void ShapeGraph::makeSegmentConnections(std::vector<Connector>& connectionset)
 {
+   connectionsChanged();
    m_connectors.clear();
 
    // note, expects these in alphabetical order to preserve numbering:
@@ -801,3 +806,13 @@ void ShapeGraph::pushAxialValues(ShapeGraph& axialmap)
       }
    }
 }
+
+const SegmentGraph &ShapeGraph::getSegmentGraph()
+{
+   std::lock_guard<std::mutex> lock(m_segmentGraphMutex);
+   if (!m_segmentGraph || m_segmentGraphVersion != m_connectionsVersion) {
+      m_segmentGraph.reset(new SegmentGraph(m_connectors));
+      m_segmentGraphVersion = m_connectionsVersion;
+   }
+   return *m_segmentGraph;
+}
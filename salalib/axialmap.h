@@ -20,6 +20,10 @@
 #include "salalib/spacepixfile.h"
 #include "salalib/spacepix.h"
 #include "salalib/connector.h"
+#include "salalib/segmentgraph.h"
+
+#include <memory>
+#include <mutex>
 
 struct AxialVertex;
 struct AxialVertexKey;
@@ -82,4 +86,10 @@ public:
    void writeLinksUnlinksAsPairsCSV(std::ostream &stream, char delimiter = ',');
    void unlinkAtPoint(const Point2f& unlinkPoint);
    void unlinkFromShapeMap(const ShapeMap& shapemap);
+   // compact copy of the segment connections for the segment analyses, kept until the connections change
+   const SegmentGraph &getSegmentGraph();
+private:
+   std::unique_ptr<SegmentGraph> m_segmentGraph;
+   size_t m_segmentGraphVersion = 0;
+   std::mutex m_segmentGraphMutex;
 };
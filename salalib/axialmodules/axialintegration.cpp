@@ -18,9 +18,119 @@
 
 #include "salalib/axialmodules/axialintegration.h"
 
+#include "genlib/pafmath.h"
+#include "genlib/parallel.h"
 #include "genlib/pflipper.h"
 #include "genlib/stringutils.h"
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace {
+    // choice accumulated for one line and radius
+    struct ChoiceTotals {
+        double choice = 0.0;
+        double weighted_choice = 0.0;
+    };
+
+    // The working space of the analysis of one root, reused for all the roots a thread analyses. Only the
+    // entries of the lines reached from a root are reset for the next one
+    struct AxialScratch {
+        std::vector<char> covered;
+        // the line each line was reached from
+        std::vector<int> previous;
+        // per line and radius, the choice values of the paths from the current root
+        std::vector<ChoiceTotals> choicevalues;
+        // the lines reached from the current root
+        std::vector<int> reached;
+        size_t radiussize;
+
+        AxialScratch(size_t lineCount, size_t radiussize)
+            : covered(lineCount, false), previous(lineCount, -1), choicevalues(lineCount * radiussize),
+              radiussize(radiussize) {}
+
+        ChoiceTotals &choice(size_t ref, size_t r) { return choicevalues[ref * radiussize + r]; }
+
+        void cover(int ref) {
+            covered[ref] = true;
+            reached.push_back(ref);
+        }
+
+        void clear() {
+            for (int ref : reached) {
+                covered[ref] = false;
+                previous[ref] = -1;
+                std::fill_n(choicevalues.begin() + ref * radiussize, radiussize, ChoiceTotals());
+            }
+            reached.clear();
+        }
+    };
+
+    // The number of lines the analysis of a root takes off its list, i.e., the lines found up to one step
+    // before the largest radius
+    size_t countExpandedLines(const ShapeGraph &map, int root, int maxradius, AxialScratch &scratch) {
+        scratch.clear();
+        std::vector<int> level, next;
+        level.push_back(root);
+        scratch.cover(root);
+        size_t expanded = 0;
+        for (int depth = 1; !level.empty(); depth++) {
+            for (int index : level) {
+                expanded++;
+                for (int connection : map.getConnections()[index].m_connections) {
+                    if (!scratch.covered[connection]) {
+                        scratch.cover(connection);
+                        next.push_back(connection);
+                    }
+                }
+            }
+            // as in the analysis, the lines found are only expanded if they are within the radius
+            if (maxradius != -1 && depth + 1 > maxradius) {
+                break;
+            }
+            level.swap(next);
+            next.clear();
+        }
+        return expanded;
+    }
+
+    // At radius n the analysis of a root takes off its list all the lines that can be reached from it. As the
+    // connections of axial lines always go both ways, these are the lines of its connected set, which are found
+    // for all the lines in a single pass
+    std::vector<size_t> countConnectedLines(const std::vector<Connector> &connectors) {
+        std::vector<int> group(connectors.size(), -1);
+        std::vector<size_t> groupsizes;
+        std::vector<int> open;
+        for (size_t root = 0; root < connectors.size(); root++) {
+            if (group[root] != -1) {
+                continue;
+            }
+            int current = static_cast<int>(groupsizes.size());
+            groupsizes.push_back(0);
+            group[root] = current;
+            open.push_back(static_cast<int>(root));
+            while (!open.empty()) {
+                int index = open.back();
+                open.pop_back();
+                groupsizes[current]++;
+                for (int connection : connectors[index].m_connections) {
+                    if (group[connection] == -1) {
+                        group[connection] = current;
+                        open.push_back(connection);
+                    }
+                }
+            }
+        }
+        std::vector<size_t> counts(connectors.size());
+        for (size_t i = 0; i < connectors.size(); i++) {
+            counts[i] = groupsizes[group[i]];
+        }
+        return counts;
+    }
+} // namespace
+
 bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_version) {
     // note, from 10.0, Depthmap no longer includes *self* connections on axial lines
     // self connections are stripped out on loading graph files, as well as no longer made
@@ -217,299 +327,370 @@ bool AxialIntegration::run(Communicator *comm, ShapeGraph &map, bool simple_vers
         }
     }
 
-    // for choice
-    AnalysisInfo **audittrail;
-    if (m_choice) {
-        audittrail = new AnalysisInfo *[map.getShapeCount()];
-        for (size_t i = 0; i < map.getShapeCount(); i++) {
-            audittrail[i] = new AnalysisInfo[radii.size()];
-        }
-    }
-
     // n.b., for this operation we assume continuous line referencing from zero (this is silly?)
     // has already failed due to this!  when intro hand drawn fewest line (where user may have deleted)
     // it's going to get worse...
+    size_t lineCount = attributes.getNumRows();
+    size_t radiussize = radii.size();
+
+    // the results are collected by row position and entered into the table at the end
+    AttributeBulkWriter writer(attributes);
+    // all the columns are allocated up front, so that the threads only ever write to separate values
+    for (const std::vector<int> *cols :
+         {&choice_col, &n_choice_col, &w_choice_col, &nw_choice_col, &entropy_col, &integ_dv_col, &integ_pv_col,
+          &integ_tk_col, &intensity_col, &depth_col, &count_col, &rel_entropy_col, &penn_norm_col, &w_depth_col,
+          &total_weight_col, &ra_col, &rra_col, &td_col, &harmonic_col}) {
+        for (int col : *cols) {
+            writer.reserve(col);
+        }
+    }
+    if (control_col != -1) {
+        writer.reserve(control_col);
+        writer.reserve(controllability_col);
+    }
 
-    bool *covered = new bool[map.getShapeCount()];
-
-    size_t i = -1;
-    for (auto & iter : attributes) {
-        i++;
-        AttributeRow &row = iter.getRow();
-        for (size_t j = 0; j < map.getShapeCount(); j++) {
-            covered[j] = false;
+    int numThreads = depthmapX::resolveThreadCount(m_num_threads);
+    std::vector<std::unique_ptr<AxialScratch>> scratches(numThreads);
+    auto getScratch = [&](int threadIndex) -> AxialScratch & {
+        if (!scratches[threadIndex]) {
+            scratches[threadIndex].reset(new AxialScratch(lineCount, m_choice ? radiussize : 0));
         }
-        if (m_choice) {
-            for (size_t k = 0; k < map.getShapeCount(); k++) {
-                audittrail[k][0].previous.ref = -1; // note, 0th member used as radius doesn't matter
-                // note, choice columns are not cleared, but cummulative over all shortest path pairs
-            }
+        return *scratches[threadIndex];
+    };
+
+    // the connections are only read, from all the threads at once
+    const std::vector<Connector> &connectors = std::as_const(map).getConnections();
+
+    // Choice picks the next line at random, and the lines picked decide the paths that are counted. Each root
+    // starts from the state the random numbers would have reached after all the roots before it, so that any
+    // root can be analysed on any thread and still follow exactly the same paths as when they run in sequence.
+    // The state depends on how many lines the roots before it take off their lists, which has to be known before
+    // the root starts, so it can not be counted as the roots are analysed
+    std::vector<uint64_t> randstates;
+    if (m_choice) {
+        std::vector<size_t> expanded;
+        if (radii.back() == -1) {
+            expanded = countConnectedLines(connectors);
+        } else {
+            expanded.resize(lineCount);
+            depthmapX::parallelFor(numThreads, lineCount, [&](int threadIndex, size_t i) {
+                expanded[i] = countExpandedLines(map, static_cast<int>(i), radii.back(), getScratch(threadIndex));
+            });
+        }
+        uint64_t randstate = pafrandstate();
+        randstates.reserve(lineCount);
+        for (size_t i = 0; i < lineCount; i++) {
+            randstates.push_back(randstate);
+            randstate = pafrandskip(randstate, expanded[i]);
         }
+        // leave the random numbers as they would be after the analysis
+        pafsetrandstate(randstate);
+    }
 
-        if (m_local) {
-            double control = 0.0;
-            const std::vector<int> &connections = map.getConnections()[i].m_connections;
-            std::vector<int> totalneighbourhood;
-            for (int connection : connections) {
-                // n.b., as of Depthmap 10.0, connections[j] and i cannot coexist
-                // if (connections[j] != i) {
-                depthmapX::addIfNotExists(totalneighbourhood, connection);
-                int retro_size = 0;
-                auto &retconnectors = map.getConnections()[size_t(connection)].m_connections;
-                for (auto retconnector : retconnectors) {
-                    retro_size++;
-                    depthmapX::addIfNotExists(totalneighbourhood, retconnector);
+    // choice values are cumulative over all the roots, and are added to these from each root in turn
+    std::vector<ChoiceTotals> choicetotals(m_choice ? lineCount * radiussize : 0);
+
+    // The roots may be analysed in any order, but each adds its choice values to the totals strictly in root
+    // order, so that the totals are the same whatever the number of threads. The values of a root are summed
+    // before they are added, so the weighted choice may differ in the last digits from when every path was
+    // added to the totals directly (the choice itself only sums whole numbers, so it is always the same)
+    std::mutex commitMutex;
+    std::condition_variable commitTurn;
+    size_t nextCommit = 0;
+    bool aborted = false;
+
+    depthmapX::parallelFor(numThreads, lineCount, [&](int threadIndex, size_t i) {
+        try {
+            AxialScratch &scratch = getScratch(threadIndex);
+            scratch.clear();
+            uint64_t randstate = m_choice ? randstates[i] : 0;
+
+            if (m_local) {
+                double control = 0.0;
+                const std::vector<int> &connections = connectors[i].m_connections;
+                std::vector<int> totalneighbourhood;
+                for (int connection : connections) {
+                    // n.b., as of Depthmap 10.0, connections[j] and i cannot coexist
+                    // if (connections[j] != i) {
+                    depthmapX::addIfNotExists(totalneighbourhood, connection);
+                    int retro_size = 0;
+                    auto &retconnectors = connectors[size_t(connection)].m_connections;
+                    for (auto retconnector : retconnectors) {
+                        retro_size++;
+                        depthmapX::addIfNotExists(totalneighbourhood, retconnector);
+                    }
+                    control += 1.0 / double(retro_size);
+                    //}
                 }
-                control += 1.0 / double(retro_size);
-                //}
-            }
 
-            if (!simple_version) {
-                if (connections.size() > 0) {
-                    row.setValue(control_col, float(control));
-                    row.setValue(controllability_col,
-                                 float(double(connections.size()) / double(totalneighbourhood.size() - 1)));
-                } else {
-                    row.setValue(control_col, -1);
-                    row.setValue(controllability_col, -1);
+                if (!simple_version) {
+                    if (connections.size() > 0) {
+                        writer.value(i, control_col) = float(control);
+                        writer.value(i, controllability_col) =
+                            float(double(connections.size()) / double(totalneighbourhood.size() - 1));
+                    } else {
+                        writer.value(i, control_col) = -1;
+                        writer.value(i, controllability_col) = -1;
+                    }
                 }
             }
-        }
 
-        std::vector<int> depthcounts;
-        depthcounts.push_back(0);
+            std::vector<int> depthcounts;
+            depthcounts.push_back(0);
 
-        pflipper<std::vector<std::pair<int, int>>> foundlist;
-        foundlist.a().push_back(std::pair<int, int>(i, -1));
-        covered[i] = true;
-        int total_depth = 0, depth = 1, node_count = 1, pos = -1, previous = -1; // node_count includes this 1
-        double weight = 0.0, rootweight = 0.0, total_weight = 0.0, w_total_depth = 0.0;
-        if (m_weighted_measure_col != -1) {
-            rootweight = weights[i];
-            // include this line in total weights (as per nodecount)
-            total_weight += rootweight;
-        }
-        int index = -1;
-        int r = 0;
-        for (int radius : radii) {
-            while (foundlist.a().size()) {
-                if (!m_choice) {
-                    index = foundlist.a().back().first;
-                } else {
-                    pos = pafrand() % foundlist.a().size();
-                    index = foundlist.a().at(pos).first;
-                    previous = foundlist.a().at(pos).second;
-                    audittrail[index][0].previous.ref =
-                        previous; // note 0th member used here: can be used individually different radius previous
-                }
-                Connector &line = map.getConnections()[index];
-                for (size_t k = 0; k < line.m_connections.size(); k++) {
-                    if (!covered[line.m_connections[k]]) {
-                        covered[line.m_connections[k]] = true;
-                        foundlist.b().push_back(std::pair<int, int>(line.m_connections[k], index));
-                        if (m_weighted_measure_col != -1) {
-                            // the weight is taken from the discovered node:
-                            weight = weights[line.m_connections[k]];
-                            total_weight += weight;
-                            w_total_depth += depth * weight;
-                        }
-                        if (m_choice && previous != -1) {
-                            // both directional paths are now recorded for choice
-                            // (coincidentally fixes choice problem which was completely wrong)
-                            size_t here = index;   // note: start counting from index as actually looking ahead here
-                            while (here != i) { // not i means not the current root for the path
-                                audittrail[here][r].choice += 1;
-                                audittrail[here][r].weighted_choice += weight * rootweight;
-                                here =
-                                    audittrail[here][0].previous.ref; // <- note, just using 0th position: radius for
-                                                                      // the previous doesn't matter in this analysis
-                            }
+            pflipper<std::vector<std::pair<int, int>>> foundlist;
+            foundlist.a().push_back(std::pair<int, int>(i, -1));
+            scratch.cover(i);
+            int total_depth = 0, depth = 1, node_count = 1, pos = -1, previous = -1; // node_count includes this 1
+            double weight = 0.0, rootweight = 0.0, total_weight = 0.0, w_total_depth = 0.0;
+            if (m_weighted_measure_col != -1) {
+                rootweight = weights[i];
+                // include this line in total weights (as per nodecount)
+                total_weight += rootweight;
+            }
+            int index = -1;
+            int r = 0;
+            for (int radius : radii) {
+                while (foundlist.a().size()) {
+                    if (!m_choice) {
+                        index = foundlist.a().back().first;
+                    } else {
+                        pos = pafrandnext(randstate) % foundlist.a().size();
+                        index = foundlist.a().at(pos).first;
+                        previous = foundlist.a().at(pos).second;
+                        scratch.previous[index] =
+                            previous; // note: can be used individually different radius previous
+                    }
+                    const Connector &line = connectors[index];
+                    for (size_t k = 0; k < line.m_connections.size(); k++) {
+                        if (!scratch.covered[line.m_connections[k]]) {
+                            scratch.cover(line.m_connections[k]);
+                            foundlist.b().push_back(std::pair<int, int>(line.m_connections[k], index));
                             if (m_weighted_measure_col != -1) {
-                                // in weighted choice, root node and current node receive values:
-                                audittrail[i][r].weighted_choice += (weight * rootweight) * 0.5;
-                                audittrail[line.m_connections[k]][r].weighted_choice += (weight * rootweight) * 0.5;
+                                // the weight is taken from the discovered node:
+                                weight = weights[line.m_connections[k]];
+                                total_weight += weight;
+                                w_total_depth += depth * weight;
+                            }
+                            if (m_choice && previous != -1) {
+                                // both directional paths are now recorded for choice
+                                // (coincidentally fixes choice problem which was completely wrong)
+                                size_t here = index; // note: start counting from index as actually looking ahead here
+                                while (here != i) {  // not i means not the current root for the path
+                                    scratch.choice(here, r).choice += 1;
+                                    scratch.choice(here, r).weighted_choice += weight * rootweight;
+                                    here = scratch.previous[here]; // <- note, radius for the previous doesn't matter
+                                                                   // in this analysis
+                                }
+                                if (m_weighted_measure_col != -1) {
+                                    // in weighted choice, root node and current node receive values:
+                                    scratch.choice(i, r).weighted_choice += (weight * rootweight) * 0.5;
+                                    scratch.choice(line.m_connections[k], r).weighted_choice +=
+                                        (weight * rootweight) * 0.5;
+                                }
                             }
+                            total_depth += depth;
+                            node_count++;
+                            depthcounts.back() += 1;
                         }
-                        total_depth += depth;
-                        node_count++;
-                        depthcounts.back() += 1;
                     }
-                }
-                if (!m_choice)
-                    foundlist.a().pop_back();
-                else
-                    foundlist.a().erase(foundlist.a().begin() + pos);
-                if (!foundlist.a().size()) {
-                    foundlist.flip();
-                    depth++;
-                    depthcounts.push_back(0);
-                    if (radius != -1 && depth > radius) {
-                        break;
+                    if (!m_choice)
+                        foundlist.a().pop_back();
+                    else
+                        foundlist.a().erase(foundlist.a().begin() + pos);
+                    if (!foundlist.a().size()) {
+                        foundlist.flip();
+                        depth++;
+                        depthcounts.push_back(0);
+                        if (radius != -1 && depth > radius) {
+                            break;
+                        }
                     }
                 }
-            }
-            // set the attributes for this node:
-            row.setValue(count_col[r], float(node_count));
-            if (m_weighted_measure_col != -1) {
-                row.setValue(total_weight_col[r], float(total_weight));
-            }
-            // node count > 1 to avoid divide by zero (was > 2)
-            if (node_count > 1) {
-                // note -- node_count includes this one -- mean depth as per p.108 Social Logic of Space
-                double mean_depth = double(total_depth) / double(node_count - 1);
-                row.setValue(depth_col[r], float(mean_depth));
+                // set the attributes for this node:
+                writer.value(i, count_col[r]) = float(node_count);
                 if (m_weighted_measure_col != -1) {
-                    // weighted mean depth:
-                    row.setValue(w_depth_col[r], float(w_total_depth / total_weight));
+                    writer.value(i, total_weight_col[r]) = float(total_weight);
                 }
-                // total nodes > 2 to avoid divide by 0 (was > 3)
-                if (node_count > 2 && mean_depth > 1.0) {
-                    double ra = 2.0 * (mean_depth - 1.0) / double(node_count - 2);
-                    // d-value / p-value from Depthmap 4 manual, note: node_count includes this one
-                    double rra_d = ra / dvalue(node_count);
-                    double rra_p = ra / dvalue(node_count);
-                    double integ_tk = teklinteg(node_count, total_depth);
-                    row.setValue(integ_dv_col[r], float(1.0 / rra_d));
-
-                    if (!simple_version) {
-                        row.setValue(integ_pv_col[r], float(1.0 / rra_p));
-                        if (total_depth - node_count + 1 > 1) {
-                            row.setValue(integ_tk_col[r], float(integ_tk));
-                        } else {
-                            row.setValue(integ_tk_col[r], -1.0f);
-                        }
+                // node count > 1 to avoid divide by zero (was > 2)
+                if (node_count > 1) {
+                    // note -- node_count includes this one -- mean depth as per p.108 Social Logic of Space
+                    double mean_depth = double(total_depth) / double(node_count - 1);
+                    writer.value(i, depth_col[r]) = float(mean_depth);
+                    if (m_weighted_measure_col != -1) {
+                        // weighted mean depth:
+                        writer.value(i, w_depth_col[r]) = float(w_total_depth / total_weight);
                     }
-
-                    if (m_fulloutput) {
-                        row.setValue(ra_col[r], float(ra));
+                    // total nodes > 2 to avoid divide by 0 (was > 3)
+                    if (node_count > 2 && mean_depth > 1.0) {
+                        double ra = 2.0 * (mean_depth - 1.0) / double(node_count - 2);
+                        // d-value / p-value from Depthmap 4 manual, note: node_count includes this one
+                        double rra_d = ra / dvalue(node_count);
+                        double rra_p = ra / dvalue(node_count);
+                        double integ_tk = teklinteg(node_count, total_depth);
+                        writer.value(i, integ_dv_col[r]) = float(1.0 / rra_d);
 
                         if (!simple_version) {
-                            row.setValue(rra_col[r], float(rra_d));
+                            writer.value(i, integ_pv_col[r]) = float(1.0 / rra_p);
+                            if (total_depth - node_count + 1 > 1) {
+                                writer.value(i, integ_tk_col[r]) = float(integ_tk);
+                            } else {
+                                writer.value(i, integ_tk_col[r]) = -1.0f;
+                            }
                         }
-                        row.setValue(td_col[r], float(total_depth));
 
-                        if (!simple_version) {
-                            // alan's palm-tree normalisation: palmtree
-                            double dmin = node_count - 1;
-                            double dmax = palmtree(node_count, depth - 1);
-                            if (dmax != dmin) {
-                                row.setValue(penn_norm_col[r], float((dmax - total_depth) / (dmax - dmin)));
+                        if (m_fulloutput) {
+                            writer.value(i, ra_col[r]) = float(ra);
+
+                            if (!simple_version) {
+                                writer.value(i, rra_col[r]) = float(rra_d);
+                            }
+                            writer.value(i, td_col[r]) = float(total_depth);
+
+                            if (!simple_version) {
+                                // alan's palm-tree normalisation: palmtree
+                                double dmin = node_count - 1;
+                                double dmax = palmtree(node_count, depth - 1);
+                                if (dmax != dmin) {
+                                    writer.value(i, penn_norm_col[r]) = float((dmax - total_depth) / (dmax - dmin));
+                                }
                             }
                         }
-                    }
-                } else {
-                    row.setValue(integ_dv_col[r], -1.0f);
-
-                    if (!simple_version) {
-                        row.setValue(integ_pv_col[r], -1.0f);
-                        row.setValue(integ_tk_col[r], -1.0f);
-                    }
-                    if (m_fulloutput) {
-                        row.setValue(ra_col[r], -1.0f);
+                    } else {
+                        writer.value(i, integ_dv_col[r]) = -1.0f;
 
                         if (!simple_version) {
-                            row.setValue(rra_col[r], -1.0f);
+                            writer.value(i, integ_pv_col[r]) = -1.0f;
+                            writer.value(i, integ_tk_col[r]) = -1.0f;
                         }
+                        if (m_fulloutput) {
+                            writer.value(i, ra_col[r]) = -1.0f;
 
-                        row.setValue(td_col[r], -1.0f);
+                            if (!simple_version) {
+                                writer.value(i, rra_col[r]) = -1.0f;
+                            }
 
-                        if (!simple_version) {
-                            row.setValue(penn_norm_col[r], -1.0f);
+                            writer.value(i, td_col[r]) = -1.0f;
+
+                            if (!simple_version) {
+                                writer.value(i, penn_norm_col[r]) = -1.0f;
+                            }
                         }
                     }
-                }
 
-                if (!simple_version) {
-                    double entropy = 0.0, intensity = 0.0, rel_entropy = 0.0, factorial = 1.0, harmonic = 0.0;
-                    for (size_t k = 0; k < depthcounts.size(); k++) {
-                        if (depthcounts[k] != 0) {
-                            // some debate over whether or not this should be node count - 1
-                            // (i.e., including or not including the node itself)
-                            double prob = double(depthcounts[k]) / double(node_count);
-                            entropy -= prob * log2(prob);
-                            // Formula from Turner 2001, "Depthmap"
-                            factorial *= double(k + 1);
-                            double q = (pow(mean_depth, double(k)) / double(factorial)) * exp(-mean_depth);
-                            rel_entropy += (double)prob * log2(prob / q);
-                            //
-                            harmonic += 1.0 / double(depthcounts[k]);
+                    if (!simple_version) {
+                        double entropy = 0.0, intensity = 0.0, rel_entropy = 0.0, factorial = 1.0, harmonic = 0.0;
+                        for (size_t k = 0; k < depthcounts.size(); k++) {
+                            if (depthcounts[k] != 0) {
+                                // some debate over whether or not this should be node count - 1
+                                // (i.e., including or not including the node itself)
+                                double prob = double(depthcounts[k]) / double(node_count);
+                                entropy -= prob * log2(prob);
+                                // Formula from Turner 2001, "Depthmap"
+                                factorial *= double(k + 1);
+                                double q = (pow(mean_depth, double(k)) / double(factorial)) * exp(-mean_depth);
+                                rel_entropy += (double)prob * log2(prob / q);
+                                //
+                                harmonic += 1.0 / double(depthcounts[k]);
+                            }
                         }
+                        harmonic = double(depthcounts.size()) / harmonic;
+                        if (total_depth > node_count) {
+                            intensity = node_count * entropy / (total_depth - node_count);
+                        } else {
+                            intensity = -1;
+                        }
+                        writer.value(i, entropy_col[r]) = float(entropy);
+                        writer.value(i, rel_entropy_col[r]) = float(rel_entropy);
+                        writer.value(i, intensity_col[r]) = float(intensity);
+                        writer.value(i, harmonic_col[r]) = float(harmonic);
                     }
-                    harmonic = double(depthcounts.size()) / harmonic;
-                    if (total_depth > node_count) {
-                        intensity = node_count * entropy / (total_depth - node_count);
-                    } else {
-                        intensity = -1;
-                    }
-                    row.setValue(entropy_col[r], float(entropy));
-                    row.setValue(rel_entropy_col[r], float(rel_entropy));
-                    row.setValue(intensity_col[r], float(intensity));
-                    row.setValue(harmonic_col[r], float(harmonic));
-                }
-            } else {
-                row.setValue(depth_col[r], -1.0f);
-                row.setValue(integ_dv_col[r], -1.0f);
+                } else {
+                    writer.value(i, depth_col[r]) = -1.0f;
+                    writer.value(i, integ_dv_col[r]) = -1.0f;
 
-                if (!simple_version) {
-                    row.setValue(integ_pv_col[r], -1.0f);
-                    row.setValue(integ_tk_col[r], -1.0f);
-                    row.setValue(entropy_col[r], -1.0f);
-                    row.setValue(rel_entropy_col[r], -1.0f);
-                    row.setValue(harmonic_col[r], -1.0f);
+                    if (!simple_version) {
+                        writer.value(i, integ_pv_col[r]) = -1.0f;
+                        writer.value(i, integ_tk_col[r]) = -1.0f;
+                        writer.value(i, entropy_col[r]) = -1.0f;
+                        writer.value(i, rel_entropy_col[r]) = -1.0f;
+                        writer.value(i, harmonic_col[r]) = -1.0f;
+                    }
                 }
+                ++r;
             }
-            ++r;
-        }
-        //
-        if (comm) {
-            if (qtimer(atime, 500)) {
+            //
+            // every thread checks for a cancel, but only the calling thread reports back
+            if (comm) {
                 if (comm->IsCancelled()) {
-                    delete[] covered;
                     throw Communicator::CancelledException();
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
+                if (threadIndex == 0 && qtimer(atime, 500)) {
+                    comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
+                }
+            }
+
+            if (m_choice) {
+                std::unique_lock<std::mutex> lock(commitMutex);
+                commitTurn.wait(lock, [&]() { return nextCommit == i || aborted; });
+                if (aborted) {
+                    return;
+                }
+                for (int ref : scratch.reached) {
+                    for (size_t k = 0; k < radiussize; k++) {
+                        ChoiceTotals &totals = choicetotals[ref * radiussize + k];
+                        totals.choice += scratch.choice(ref, k).choice;
+                        totals.weighted_choice += scratch.choice(ref, k).weighted_choice;
+                    }
+                }
+                nextCommit++;
+                lock.unlock();
+                commitTurn.notify_all();
             }
+        } catch (...) {
+            // release any thread waiting for this root to be added to the totals
+            {
+                std::lock_guard<std::mutex> lock(commitMutex);
+                aborted = true;
+            }
+            commitTurn.notify_all();
+            throw;
         }
-    }
-    delete[] covered;
+    });
+
     if (m_choice) {
-        i = -1;
-        for (auto & iter: attributes) {
-            i++;
-            AttributeRow &row = iter.getRow();
+        for (size_t i = 0; i < lineCount; i++) {
             double total_choice = 0.0, w_total_choice = 0.0;
-            for (size_t r = 0; r < radii.size(); r++) {
-                total_choice += audittrail[i][r].choice;
-                w_total_choice += audittrail[i][r].weighted_choice;
+            for (size_t r = 0; r < radiussize; r++) {
+                total_choice += choicetotals[i * radiussize + r].choice;
+                w_total_choice += choicetotals[i * radiussize + r].weighted_choice;
                 // n.b., normalise choice according to (n-1)(n-2)/2 (maximum possible through routes)
-                double node_count = row.getValue(count_col[r]);
+                double node_count = writer.value(i, count_col[r]);
                 double total_weight = 0;
                 if (m_weighted_measure_col != -1) {
-                    total_weight = row.getValue(total_weight_col[r]);
+                    total_weight = writer.value(i, total_weight_col[r]);
                 }
                 if (node_count > 2) {
-                    row.setValue(choice_col[r], float(total_choice));
-                    row.setValue(n_choice_col[r], float(2.0 * total_choice / ((node_count - 1) * (node_count - 2))));
+                    writer.value(i, choice_col[r]) = float(total_choice);
+                    writer.value(i, n_choice_col[r]) = float(2.0 * total_choice / ((node_count - 1) * (node_count - 2)));
                     if (m_weighted_measure_col != -1) {
-                        row.setValue(w_choice_col[r], float(w_total_choice));
-                        row.setValue(nw_choice_col[r], float(2.0 * w_total_choice / (total_weight * total_weight)));
+                        writer.value(i, w_choice_col[r]) = float(w_total_choice);
+                        writer.value(i, nw_choice_col[r]) = float(2.0 * w_total_choice / (total_weight * total_weight));
                     }
                 } else {
-                    row.setValue(choice_col[r], -1);
-                    row.setValue(n_choice_col[r], -1);
+                    writer.value(i, choice_col[r]) = -1;
+                    writer.value(i, n_choice_col[r]) = -1;
                     if (m_weighted_measure_col != -1) {
-                        row.setValue(w_choice_col[r], -1);
-                        row.setValue(nw_choice_col[r], -1);
+                        writer.value(i, w_choice_col[r]) = -1;
+                        writer.value(i, nw_choice_col[r]) = -1;
                     }
                 }
             }
         }
-        for (size_t i = 0; i < map.getShapeCount(); i++) {
-            delete[] audittrail[i];
-        }
-        delete[] audittrail;
     }
 
+    writer.commit();
+
     map.setDisplayedAttribute(-1); // <- override if it's already showing
     map.setDisplayedAttribute(integ_dv_col.back());
 
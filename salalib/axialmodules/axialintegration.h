@@ -27,11 +27,13 @@ class AxialIntegration : IAxial {
     bool m_choice;
     bool m_fulloutput;
     bool m_local;
+    int m_num_threads;
 
   public:
     std::string getAnalysisName() const override { return "Angular Analysis"; }
     bool run(Communicator *, ShapeGraph &map, bool) override;
-    AxialIntegration(std::set<double> radius_set, int weighted_measure_col, bool choice, bool fulloutput, bool local)
+    AxialIntegration(std::set<double> radius_set, int weighted_measure_col, bool choice, bool fulloutput, bool local,
+                     int num_threads = 1)
         : m_radius_set(radius_set), m_weighted_measure_col(weighted_measure_col), m_choice(choice),
-          m_fulloutput(fulloutput), m_local(local) {}
+          m_fulloutput(fulloutput), m_local(local), m_num_threads(num_threads) {}
 };
@@ -0,0 +1,119 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/bspcache.h"
+
+#include "genlib/exceptions.h"
+
+BSPNode *BSPCache::getTree(Communicator *communicator, const std::vector<SpacePixelFile> &drawingFiles) {
+    std::vector<TaggedLine> partitionlines = getPartitionLines(drawingFiles);
+    if (partitionlines.empty()) {
+        return nullptr;
+    }
+    uint64_t key = makeKey(partitionlines);
+    if (m_root && m_key == key) {
+        return m_root.get();
+    }
+
+    time_t atime = 0;
+    if (communicator) {
+        communicator->CommPostMessage(Communicator::NUM_RECORDS, static_cast<int>(partitionlines.size()));
+        qtimer(atime, 0);
+    }
+
+    // the old tree is kept until the new one is complete, in case making it is cancelled
+    std::unique_ptr<BSPNode> root(new BSPNode());
+    BSPTree::make(communicator, atime, partitionlines, root.get());
+    m_root = std::move(root);
+    m_key = key;
+    return m_root.get();
+}
+
+void BSPCache::clear() {
+    m_root.reset();
+    m_key = 0;
+}
+
+bool BSPCache::read(std::istream &stream) {
+    clear();
+    uint64_t key;
+    stream.read((char *)&key, sizeof(key));
+    std::unique_ptr<BSPNode> root(new BSPNode());
+    try {
+        if (stream.fail()) {
+            return false;
+        }
+        BSPTree::read(stream, *root);
+    } catch (depthmapX::RuntimeException &) {
+        return false;
+    }
+    m_root = std::move(root);
+    m_key = key;
+    return true;
+}
+
+void BSPCache::write(std::ostream &stream) const {
+    stream.write((char *)&m_key, sizeof(m_key));
+    BSPTree::write(stream, *m_root);
+}
+
+std::vector<TaggedLine> BSPCache::getPartitionLines(const std::vector<SpacePixelFile> &drawingFiles) {
+    std::vector<TaggedLine> partitionlines;
+    for (const auto &pixelGroup : drawingFiles) {
+        for (const auto &pixel : pixelGroup.m_spacePixels) {
+            // chooses the first editable layer it can find:
+            if (pixel.isShown()) {
+                auto refShapes = pixel.getAllShapes();
+                int k = -1;
+                for (const auto &refShape : refShapes) {
+                    k++;
+                    std::vector<Line> newLines = refShape.second.getAsLines();
+                    // I'm not sure what the tagging was meant for any more,
+                    // tagging at the moment tags the *polygon* it was original attached to
+                    // must check it is not a zero length line:
+                    for (const Line &line : newLines) {
+                        if (line.length() > 0.0) {
+                            partitionlines.push_back(TaggedLine(line, k));
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return partitionlines;
+}
+
+// FNV-1a over the line coordinates and tags
+uint64_t BSPCache::makeKey(const std::vector<TaggedLine> &lines) {
+    uint64_t key = 14695981039346656037ULL;
+    auto hash = [&key](const void *data, size_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            key ^= bytes[i];
+            key *= 1099511628211ULL;
+        }
+    };
+    for (const TaggedLine &taggedLine : lines) {
+        Point2f start = taggedLine.line.start();
+        Point2f end = taggedLine.line.end();
+        hash(&start.x, sizeof(start.x));
+        hash(&start.y, sizeof(start.y));
+        hash(&end.x, sizeof(end.x));
+        hash(&end.y, sizeof(end.y));
+        hash(&taggedLine.tag, sizeof(taggedLine.tag));
+    }
+    return key;
+}
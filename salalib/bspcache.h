@@ -0,0 +1,53 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "salalib/spacepixfile.h"
+
+#include "genlib/bsptree.h"
+#include "genlib/comm.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * Keeps the BSP tree of the lines on the shown drawing layers between isovist calculations, so that the tree is
+ * only made again when those lines change (a layer is shown or hidden, or a drawing is loaded or edited).
+ * The lines are recognised by a hash of their coordinates and tags, which is kept and stored with the tree.
+ */
+class BSPCache {
+  public:
+    /**
+     * @brief The tree for the lines shown in the drawing files, made only if the cached one is for other lines
+     * @return nullptr if no lines are shown
+     */
+    BSPNode *getTree(Communicator *communicator, const std::vector<SpacePixelFile> &drawingFiles);
+    bool hasTree() const { return m_root != nullptr; }
+    void clear();
+
+    // false if the tree could not be read, in which case the cache is left empty to be made again
+    bool read(std::istream &stream);
+    void write(std::ostream &stream) const;
+
+    // the lines the tree is made from, tagged by the shape they come from
+    static std::vector<TaggedLine> getPartitionLines(const std::vector<SpacePixelFile> &drawingFiles);
+    static uint64_t makeKey(const std::vector<TaggedLine> &lines);
+
+  private:
+    std::unique_ptr<BSPNode> m_root;
+    uint64_t m_key = 0;
+};
@@ -17,6 +17,7 @@
 #include <exception>
 #include <cstdlib>
 #include <sstream>
+#include <limits>
 
 #include "genlib/stringutils.h"
 
@@ -204,7 +205,15 @@ namespace EntityParsing {
     std::vector<IsovistDefinition> parseIsovists(std::istream &stream, char delimiter)
     {
         std::vector<IsovistDefinition> isovists;
+        IsovistReader reader(stream, delimiter);
+        while (reader.read(isovists, std::numeric_limits<size_t>::max()))
+        {
+        }
+        return isovists;
+    }
 
+    IsovistReader::IsovistReader(std::istream &stream, char delimiter) : m_stream(stream), m_delimiter(delimiter)
+    {
         std::string inputline;
         std::getline(stream, inputline);
 
@@ -224,40 +233,44 @@ namespace EntityParsing {
            }
         }
 
-        int xcol = -1, ycol = -1, anglecol = -1, viewcol = -1;
+        m_xcol = -1, m_ycol = -1, m_anglecol = -1, m_viewcol = -1;
         for (i = 0; i < strings.size(); i++) {
             if (strings[i] == "x")
             {
-                xcol = i;
+                m_xcol = i;
             }
             else if (strings[i] == "y")
             {
-                ycol = i;
+                m_ycol = i;
             }
             else if (strings[i] == "angle")
             {
-                anglecol = i;
+                m_anglecol = i;
             }
             else if (strings[i] == "viewangle")
             {
-                viewcol = i;
+                m_viewcol = i;
             }
         }
 
-        if(xcol == -1 || ycol == -1 )
+        if(m_xcol == -1 || m_ycol == -1 )
         {
             throw EntityParseException("Badly formatted header (should contain x and y, might also have angle and viewangle for partial isovists)");
         }
+    }
 
-
-        bool partialIsovists =  anglecol != -1 && viewcol != -1;
-        int maxCol = std::max({xcol, ycol, anglecol, viewcol});
-        while ( !stream.eof())
+    bool IsovistReader::read(std::vector<IsovistDefinition> &isovists, size_t maxCount)
+    {
+        bool partialIsovists =  m_anglecol != -1 && m_viewcol != -1;
+        int maxCol = std::max({m_xcol, m_ycol, m_anglecol, m_viewcol});
+        std::string inputline;
+        size_t count = 0;
+        while ( count < maxCount && !m_stream.eof())
         {
-            std::getline(stream, inputline);
+            std::getline(m_stream, inputline);
             if (!inputline.empty())
             {
-                strings = dXstring::split(inputline, delimiter);
+                std::vector<std::string> strings = dXstring::split(inputline, m_delimiter);
                 if (!strings.size())
                 {
                     continue;
@@ -269,22 +282,23 @@ namespace EntityParsing {
                     throw EntityParseException(message.str().c_str());
                 }
 
-                double x = std::atof(strings[xcol].c_str());
-                double y = std::atof(strings[ycol].c_str());
+                double x = std::atof(strings[m_xcol].c_str());
+                double y = std::atof(strings[m_ycol].c_str());
 
                 if (partialIsovists)
                 {
-                    double angle = std::atof(strings[anglecol].c_str()) / 180.0 * M_PI;
-                    double viewAngle = std::atof(strings[viewcol].c_str())/180.0 * M_PI;
+                    double angle = std::atof(strings[m_anglecol].c_str()) / 180.0 * M_PI;
+                    double viewAngle = std::atof(strings[m_viewcol].c_str())/180.0 * M_PI;
                     isovists.push_back(IsovistDefinition(x,y,angle,viewAngle));
                 }
                 else
                 {
                     isovists.push_back(IsovistDefinition(x,y));
                 }
+                count++;
             }
         }
-        return isovists;
+        return !m_stream.eof();
     }
 
     IsovistDefinition parseIsovist(const std::string &isovist)
@@ -37,6 +37,20 @@ namespace EntityParsing {
     std::vector<Point2f> parsePoints(std::istream& stream, char delimiter);
     Point2f parsePoint(const std::string &point, char delimiter = ',');
     std::vector<IsovistDefinition> parseIsovists(std::istream &stream, char delimiter);
+
+    // reads isovist definitions from a csv stream a number at a time, for files too long to hold in memory
+    class IsovistReader
+    {
+    public:
+        // reads the header, which must contain x and y, and can also have angle and viewangle
+        IsovistReader(std::istream &stream, char delimiter);
+        // appends up to maxCount isovists, returns false once the stream has run out
+        bool read(std::vector<IsovistDefinition> &isovists, size_t maxCount);
+    private:
+        std::istream &m_stream;
+        char m_delimiter;
+        int m_xcol, m_ycol, m_anglecol, m_viewcol;
+    };
     IsovistDefinition parseIsovist(const std::string &isovist);
     std::vector<std::pair<int, int> > parseRefPairs(std::istream& stream, char delimiter);
 }
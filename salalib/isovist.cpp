@@ -17,6 +17,7 @@
 
 #include "salalib/isovist.h"
 
+#include <algorithm>
 #include <math.h>
 #include <float.h>
 #include <time.h>
@@ -36,6 +37,7 @@ void Isovist::makeit(BSPNode *root, const Point2f& p, const QtRegion& region, do
    m_centre = p;
    m_blocks.clear();
    m_gaps.clear();
+   m_gaps_deleted = false;
 
    // still doesn't work when need centre point, but this will work for 180 degree isovists
    bool complete = false;
@@ -49,12 +51,12 @@ void Isovist::makeit(BSPNode *root, const Point2f& p, const QtRegion& region, do
    bool parity = false;
 
    if (startangle > endangle) {
-      m_gaps.insert(IsoSeg(0.0,endangle));
-      m_gaps.insert(IsoSeg(startangle,2.0*M_PI));
+      m_gaps.push_back(IsoSeg(0.0,endangle));
+      m_gaps.push_back(IsoSeg(startangle,2.0*M_PI));
    }
    else {
       parity = true;
-      m_gaps.insert(IsoSeg(startangle,endangle));
+      m_gaps.push_back(IsoSeg(startangle,endangle));
    }
 
    make(root);
@@ -124,8 +126,9 @@ int Isovist::getClosestLine(BSPNode *root, const Point2f& p)
    m_centre = p;
    m_blocks.clear();
    m_gaps.clear();
+   m_gaps_deleted = false;
 
-   m_gaps.insert(IsoSeg(0.0,2.0*M_PI));
+   m_gaps.push_back(IsoSeg(0.0,2.0*M_PI));
 
    make(root);
 
@@ -195,79 +198,74 @@ void Isovist::drawnode(const Line& li, int tag)
       }
    }
    //
-   for (auto it = m_gaps.begin(); it != m_gaps.end(); ) {
-       if (it->tagdelete) {
-           it = m_gaps.erase(it);
-       }
-       else {
-           ++it;
-       }
+   if (m_gaps_deleted) {
+      m_gaps.erase(std::remove_if(m_gaps.begin(), m_gaps.end(), [](const IsoSeg& gap) { return gap.tagdelete; }),
+                   m_gaps.end());
+      m_gaps_deleted = false;
    }
 }
 
 void Isovist::addBlock(const Line& li, int tag, double startangle, double endangle)
 {
-   auto gap = m_gaps.begin();
+   size_t gap = 0;
    bool finished = false;
 
    while (!finished) {
-      while (gap != m_gaps.end() && gap->endangle < startangle) {
+      while (gap < m_gaps.size() && m_gaps[gap].endangle < startangle) {
          gap++;
       }
-      if (gap != m_gaps.end() && gap->startangle < endangle + 1e-9) {
+      if (gap < m_gaps.size() && m_gaps[gap].startangle < endangle + 1e-9) {
          double a,b;
-         if (gap->startangle > startangle - 1e-9) {
-            a = gap->startangle;
-            if (gap->endangle < endangle + 1e-9) {
-               b = gap->endangle;
-               gap->tagdelete = true;
+         if (m_gaps[gap].startangle > startangle - 1e-9) {
+            a = m_gaps[gap].startangle;
+            if (m_gaps[gap].endangle < endangle + 1e-9) {
+               b = m_gaps[gap].endangle;
+               m_gaps[gap].tagdelete = true;
+               m_gaps_deleted = true;
             }
             else {
                b = endangle;
-               IsoSeg isoseg = *gap;
-               isoseg.startangle = endangle;
-               auto hint = gap;
-               hint++;
-               m_gaps.erase(gap);
-               gap = m_gaps.insert(hint, isoseg);
+               m_gaps[gap].startangle = endangle;
             }
          }
          else {
             a = startangle;
-            if (gap->endangle < endangle + 1e-9) {
-               b = gap->endangle;
-               IsoSeg isoseg = *gap;
-               isoseg.endangle = startangle;
-               auto hint = gap;
-               hint++;
-               m_gaps.erase(gap);
-               gap = m_gaps.insert(hint, isoseg);
+            if (m_gaps[gap].endangle < endangle + 1e-9) {
+               b = m_gaps[gap].endangle;
+               m_gaps[gap].endangle = startangle;
             }
             else {
                b = endangle;
-               m_gaps.insert(IsoSeg(endangle, gap->endangle, gap->quadrant));
-               IsoSeg isoseg = *gap;
-               isoseg.endangle = startangle;
-               auto hint = gap;
-               hint++;
-               m_gaps.erase(gap);
-               gap = m_gaps.insert(hint, isoseg);
+               IsoSeg isoseg(endangle, m_gaps[gap].endangle, m_gaps[gap].quadrant);
+               m_gaps[gap].endangle = startangle;
+               m_gaps.insert(m_gaps.begin() + static_cast<std::ptrdiff_t>(gap) + 1, isoseg);
                gap++; // advance past gap just added
             }
          }
          Point2f pa = intersection_point(li,Line(m_centre,m_centre+pointfromangle(a)));
          Point2f pb = intersection_point(li,Line(m_centre,m_centre+pointfromangle(b)));
-         m_blocks.insert(IsoSeg(a,b,pa,pb,tag));
+         IsoSeg block(a,b,pa,pb,tag);
+         auto at = std::lower_bound(m_blocks.begin(), m_blocks.end(), block);
+         if (at == m_blocks.end() || block < *at) {
+            m_blocks.insert(at, block);
+         }
       }
       else {
          finished = true;
       }
-      if(gap == m_gaps.end()) break;
+      if(gap == m_gaps.size()) break;
       gap++;
    }
 }
 
 void Isovist::setData(AttributeTable& table, AttributeRow& row, bool simple_version)
+{
+   setMeasures(table, row, getMeasures(), simple_version);
+}
+
+// separate from setting the data, so that isovists can be made in parallel, and their measures
+// entered in the attribute table afterwards
+Isovist::Measures Isovist::getMeasures()
 {
    // the area / centre of gravity calculation is a duplicate of the SalaPolygon version,
    // included here for general information about the isovist
@@ -305,31 +303,45 @@ void Isovist::setData(AttributeTable& table, AttributeRow& row, bool simple_vers
    driftvec.normalise();
    double driftang = driftvec.angle();
    //
+   Measures measures;
+   measures.area = float(area);
+   measures.compactness = float(4.0 * M_PI * area / (m_perimeter*m_perimeter));
+   measures.drift_angle = float(180.0*driftang/M_PI);
+   measures.drift_magnitude = float(driftmag);
+   measures.min_radial = float(m_min_radial);
+   measures.max_radial = float(m_max_radial);
+   measures.occlusivity = float(m_occluded_perimeter);
+   measures.perimeter = float(m_perimeter);
+   return measures;
+}
+
+void Isovist::setMeasures(AttributeTable& table, AttributeRow& row, const Measures& measures, bool simple_version)
+{
    int col = table.getOrInsertColumn("Isovist Area");
-   row.setValue(col, float(area));
+   row.setValue(col, measures.area);
 
 
    if(!simple_version) {
        col = table.getOrInsertColumn("Isovist Compactness");
-       row.setValue(col, float(4.0 * M_PI * area / (m_perimeter*m_perimeter)));
+       row.setValue(col, measures.compactness);
 
        col = table.getOrInsertColumn("Isovist Drift Angle");
-       row.setValue(col, float(180.0*driftang/M_PI));
+       row.setValue(col, measures.drift_angle);
 
        col = table.getOrInsertColumn("Isovist Drift Magnitude");
-       row.setValue(col, float(driftmag));
+       row.setValue(col, measures.drift_magnitude);
 
        col = table.getOrInsertColumn("Isovist Min Radial");
-       row.setValue(col, float(m_min_radial));
+       row.setValue(col, measures.min_radial);
 
        col = table.getOrInsertColumn("Isovist Max Radial");
-       row.setValue(col, float(m_max_radial));
+       row.setValue(col, measures.max_radial);
 
        col = table.getOrInsertColumn("Isovist Occlusivity");
-       row.setValue(col, float(m_occluded_perimeter));
+       row.setValue(col, measures.occlusivity);
 
        col = table.getOrInsertColumn("Isovist Perimeter");
-       row.setValue(col, float(m_perimeter));
+       row.setValue(col, measures.perimeter);
    }
 
 }
@@ -23,7 +23,7 @@
 #include "salalib/attributetable.h"
 
 #include "genlib/bsptree.h"
-#include <set>
+#include <vector>
 
 // this is very much like sparksieve:
 
@@ -60,12 +60,17 @@ struct PointDist {
    { m_point = p; m_dist = d; }
 };
 
+// The gaps and blocks are kept as sorted arrays rather than sets. Gaps never overlap, so a gap cut
+// by a block stays in place, and the blocks are few enough that inserting into an array is quicker
+// than allocating a tree node. The arrays also keep their memory from one isovist to the next
+
 class Isovist
 {
 protected:
    Point2f m_centre;
-   std::set<IsoSeg> m_blocks;
-   std::set<IsoSeg> m_gaps;
+   std::vector<IsoSeg> m_blocks; // sorted, without duplicates
+   std::vector<IsoSeg> m_gaps;   // sorted, not overlapping
+   bool m_gaps_deleted;
    std::vector<Point2f> m_poly;
    std::vector<PointDist> m_occlusion_points;
    double m_perimeter;
@@ -73,7 +78,18 @@ protected:
    double m_max_radial;
    double m_min_radial;
 public:
-   Isovist() {;}
+   // the measures setData enters in the attribute table
+   struct Measures {
+      float area;
+      float compactness;
+      float drift_angle;
+      float drift_magnitude;
+      float min_radial;
+      float max_radial;
+      float occlusivity;
+      float perimeter;
+   };
+   Isovist() { m_gaps_deleted = false; }
    const std::vector<Point2f>& getPolygon() const { return m_poly; }
    const std::vector<PointDist>& getOcclusionPoints() const { return m_occlusion_points; }
    const Point2f& getCentre() const { return m_centre; }
@@ -83,6 +99,8 @@ public:
    void drawnode(const Line& li, int tag);
    void addBlock(const Line& li, int tag, double startangle, double endangle);
    void setData(AttributeTable &table, AttributeRow &row, bool simple_version);
+   Measures getMeasures();
+   static void setMeasures(AttributeTable &table, AttributeRow &row, const Measures &measures, bool simple_version);
    //
    int getClosestLine(BSPNode *root, const Point2f& p);
 };
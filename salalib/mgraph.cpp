@@ -53,13 +53,21 @@
 #include "genlib/pafmath.h"
 #include "genlib/p2dpoly.h"
 #include "genlib/comm.h"
+#include "genlib/mappedfile.h"
 
 #include "math.h"
 #include "time.h"
 
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 #include <tuple>
 
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
 
 MetaGraph::MetaGraph(std::string name)
 { 
@@ -75,15 +83,11 @@ MetaGraph::MetaGraph(std::string name)
    // bsp tree for making isovists:
    m_bsp_tree = false;
    m_bsp_root = NULL;
+   m_store_bsp_tree = false;
 }
 
 MetaGraph::~MetaGraph()
 {
-   if (m_bsp_root) {
-      delete m_bsp_root;
-      m_bsp_root = NULL;
-   }
-   m_bsp_tree = false;
 }
 
 QtRegion MetaGraph::getBoundingBox() const
@@ -261,7 +265,7 @@ bool MetaGraph::clearPoints()
    return b_return;
 }
 
-bool MetaGraph::makeGraph( Communicator *communicator, int algorithm, double maxdist )
+bool MetaGraph::makeGraph( Communicator *communicator, int algorithm, double maxdist, int num_threads )
 {
    // this is essentially a version tag, and remains for historical reasons:
    m_state |= ANGULARGRAPH;
@@ -270,7 +274,7 @@ bool MetaGraph::makeGraph( Communicator *communicator, int algorithm, double max
    
    try {
       // algorithm is now used for boundary graph option (as a simple boolean)
-      graphMade = getDisplayedPointMap().sparkGraph2(communicator, (algorithm != 0), maxdist);
+      graphMade = getDisplayedPointMap().sparkGraph2(communicator, (algorithm != 0), maxdist, num_threads);
    } 
    catch (Communicator::CancelledException) {
       graphMade = false;
@@ -294,6 +298,40 @@ bool MetaGraph::unmakeGraph(bool removeLinks)
    return graphUnmade;
 }
 
+bool MetaGraph::setLineLayerShown( Communicator *communicator, int file, int layer, bool show, double maxdist, int num_threads )
+{
+   ShapeMap& lineLayer = getLineLayer(file, layer);
+   if (lineLayer.isShown() == show) {
+      return true;
+   }
+   lineLayer.setShow(show);
+   redoPointMapBlockLines();
+   resetBSPtree();
+
+   if (m_displayed_pointmap == -1 || !getDisplayedPointMap().isProcessed()) {
+      return true;
+   }
+
+   std::vector<Line> changedlines;
+   for (const auto& line: lineLayer.getAllShapesAsLines()) {
+      changedlines.push_back(Line(line.start(), line.end()));
+   }
+
+   bool graphRemade = false;
+
+   try {
+      graphRemade = getDisplayedPointMap().regenerateGraph(communicator, changedlines, maxdist, num_threads) != -1;
+   }
+   catch (Communicator::CancelledException) {
+      // a cancelled regeneration leaves the graph unmade
+      graphRemade = false;
+   }
+
+   setViewClass(SHOWVGATOP);
+
+   return graphRemade;
+}
+
 bool MetaGraph::analyseGraph( Communicator *communicator, Options options , bool simple_version )   // <- options copied to keep thread safe
 {
    bool analysisCompleted = false;
@@ -344,7 +382,9 @@ bool MetaGraph::analyseGraph( Communicator *communicator, Options options , bool
          }
       }
       else if (options.output_type == Options::OUTPUT_ISOVIST) {
-         analysisCompleted = VGAIsovist().run(communicator, getDisplayedPointMap(), simple_version);
+         analysisCompleted = VGAIsovist(&m_bsp_cache, options.num_threads).run(communicator, getDisplayedPointMap(), simple_version);
+         // the cache may have made a new tree
+         m_bsp_tree = false;
       }
       else if (options.output_type == Options::OUTPUT_VISUAL) {
           bool localResult = true;
@@ -353,7 +393,7 @@ bool MetaGraph::analyseGraph( Communicator *communicator, Options options , bool
               localResult = VGAVisualLocal(options.gates_only).run(communicator, getDisplayedPointMap(), simple_version);
           }
           if (options.global) {
-              globalResult = VGAVisualGlobal(options.radius, options.gates_only).run(communicator, getDisplayedPointMap(), simple_version);
+              globalResult = VGAVisualGlobal(options.radius, options.gates_only, options.num_threads).run(communicator, getDisplayedPointMap(), simple_version);
           }
           analysisCompleted = globalResult & localResult;
       }
@@ -371,6 +411,11 @@ bool MetaGraph::analyseGraph( Communicator *communicator, Options options , bool
       analysisCompleted = false;
    }
 
+   // the compact visibility graph is only kept while the analysis runs
+   if (m_displayed_pointmap != -1) {
+      getDisplayedPointMap().releaseVisibilityGraph();
+   }
+
    return analysisCompleted;
 }
 
@@ -625,10 +670,10 @@ int MetaGraph::makeIsovistPath(Communicator *communicator, double fov, bool simp
 }
 
 // this version uses your own isovist (and assumes no communicator required for BSP tree
-bool MetaGraph::makeIsovist(const Point2f& p, Isovist& iso)
+bool MetaGraph::makeIsovist(const Point2f& p, Isovist& iso, double startangle, double endangle)
 {
    if (makeBSPtree()) {
-      iso.makeit(m_bsp_root, p, m_region);
+      iso.makeit(m_bsp_root, p, m_region, startangle, endangle);
       return true;
    }
    return false;
@@ -640,59 +685,16 @@ bool MetaGraph::makeBSPtree(Communicator *communicator)
       return true;
    }
 
-   std::vector<TaggedLine> partitionlines;
-   for (const auto& pixelGroup: m_drawingFiles) {
-      for (const auto& pixel: pixelGroup.m_spacePixels) {
-         // chooses the first editable layer it can find:
-         if (pixel.isShown()) {
-             auto refShapes = pixel.getAllShapes();
-             int k = -1;
-             for (const auto& refShape: refShapes) {
-                 k++;
-                 std::vector<Line> newLines = refShape.second.getAsLines();
-                 // I'm not sure what the tagging was meant for any more,
-                 // tagging at the moment tags the *polygon* it was original attached to
-                 // must check it is not a zero length line:
-                 for(const Line& line: newLines) {
-                     if(line.length() > 0.0) {
-                         partitionlines.push_back(TaggedLine(line,k));
-                     }
-                 }
-            }
-         }
-      }
+   // the cache only makes the tree again if the shown lines have changed since it was last made (or read)
+   try {
+      m_bsp_root = m_bsp_cache.getTree(communicator, m_drawingFiles);
+      m_bsp_tree = (m_bsp_root != NULL);
    }
-
-   if (partitionlines.size()) {
-      //
-      // Now we'll try the BSP tree:
-      //
-      if (m_bsp_root) {
-         delete m_bsp_root;
-         m_bsp_root = NULL;
-      }
-      m_bsp_root = new BSPNode();
-
-      time_t atime = 0;
-      if (communicator) {
-          communicator->CommPostMessage( Communicator::NUM_RECORDS, partitionlines.size() );
-          qtimer( atime, 0 );
-      }
-
-      try {
-         BSPTree::make(communicator,atime,partitionlines,m_bsp_root);
-         m_bsp_tree = true;
-      } 
-      catch (Communicator::CancelledException) {
-         m_bsp_tree = false;
-         // probably best to delete the half made bastard of a tree:
-         delete m_bsp_root;
-         m_bsp_root = NULL;
-      }
+   catch (Communicator::CancelledException) {
+      m_bsp_tree = false;
+      m_bsp_root = NULL;
    }
 
-   partitionlines.clear();
-
    return m_bsp_tree;
 }
 
@@ -1282,7 +1284,7 @@ bool MetaGraph::analyseAxial( Communicator *communicator, Options options, bool
 
    try {
        analysisCompleted = AxialIntegration(options.radius_set, options.weighted_measure_col, options.choice, options.fulloutput,
-                        options.local)
+                        options.local, options.num_threads)
            .run(communicator, getDisplayedShapeGraph(), false);
    } 
    catch (Communicator::CancelledException) {
@@ -1302,7 +1304,7 @@ bool MetaGraph::analyseSegmentsTulip( Communicator *communicator, Options option
 
    try {
        analysisCompleted = SegmentTulip(options.radius_set, options.sel_only, options.tulip_bins, options.weighted_measure_col,
-                    options.radius_type, options.choice)
+                    options.radius_type, options.choice, false, -1, -1, options.num_threads)
            .run(communicator, getDisplayedShapeGraph(), false);
    }
    catch (Communicator::CancelledException) {
@@ -1340,14 +1342,11 @@ bool MetaGraph::analyseTopoMetMultipleRadii( Communicator *communicator, Options
 
    try {
       // note: "output_type" reused for analysis type (either 0 = topological or 1 = metric)
-      for(size_t r = 0; r < options.radius_set.size(); r++) {
-          if(options.output_type == 0) {
-              if(!SegmentTopological(options.radius, options.sel_only).run(communicator, getDisplayedShapeGraph(), false))
-                  analysisCompleted = false;
-          } else {
-              if(!SegmentMetric(options.radius, options.sel_only).run(communicator, getDisplayedShapeGraph(), false))
-                  analysisCompleted = false;
-          }
+      // all the radii are analysed together, in one search from each segment
+      if(options.output_type == 0) {
+          analysisCompleted = SegmentTopological(options.radius_set, options.sel_only, options.num_threads).run(communicator, getDisplayedShapeGraph(), false);
+      } else {
+          analysisCompleted = SegmentMetric(options.radius_set, options.sel_only, options.num_threads).run(communicator, getDisplayedShapeGraph(), false);
       }
    }
    catch (Communicator::CancelledException) {
@@ -1392,10 +1391,8 @@ int MetaGraph::loadLineData( Communicator *communicator, int load_type )
    m_state &= ~LINEDATA;      // Clear line data flag (stops accidental redraw during reload) 
 
    // if bsp tree exists 
-   if (m_bsp_root) {
-      delete m_bsp_root;
-      m_bsp_root = NULL;
-   }
+   m_bsp_cache.clear();
+   m_bsp_root = NULL;
    m_bsp_tree = false;
 
    if (load_type & REPLACE) {
@@ -2135,6 +2132,7 @@ bool MetaGraph::analyseThruVision(Communicator *comm, int gatelayer)
    catch (Communicator::CancelledException) {
       analysisCompleted = false;
    }
+   getDisplayedPointMap().releaseVisibilityGraph();
 
    // note after the analysis, the column order might have changed... retrieve:
    colgates = table.getColumnIndex(g_col_gate);
@@ -2479,6 +2477,14 @@ int MetaGraph::readFromFile( const std::string& filename )
        return NOT_A_GRAPH;
     }
 
+    // read straight from the mapped file where possible, so that whole arrays
+    // are copied out of it in one go rather than through the stream's buffer
+    depthmapX::MappedFile mappedfile(filename);
+    if (mappedfile.isOpen()) {
+       std::istream stream(&mappedfile);
+       return readFromStream(stream, filename);
+    }
+
  #ifdef _WIN32
     std::ifstream stream( filename.c_str(), std::ios::binary | std::ios::in );
  #else
@@ -2489,16 +2495,74 @@ int MetaGraph::readFromFile( const std::string& filename )
     return result;
 }
 
+int MetaGraph::readFromOlderVersion( const std::string& filename )
+{
+   std::unique_ptr<mgraph440::MetaGraph> mgraph(new mgraph440::MetaGraph);
+   auto result = mgraph->read(filename);
+   if ( result != mgraph440::MetaGraph::OK)
+   {
+       return DAMAGED_FILE;
+   }
+
+#ifndef _WIN32
+   // write the converted graph out to a temporary file rather than to memory
+   // so that the file is never held twice, and map it to read it back. The
+   // file is made by mkstemp, so that it is always a new one of our own
+   std::string pattern = (std::filesystem::temp_directory_path() / "depthmapX-XXXXXX").string();
+   std::vector<char> temppath(pattern.begin(), pattern.end());
+   temppath.push_back('\0');
+   int fd = mkstemp(temppath.data());
+   if (fd == -1) {
+      return DISK_ERROR;
+   }
+   close(fd);
+   // the file is removed however the reading ends
+   struct TempFileRemover {
+      std::string path;
+      ~TempFileRemover() {
+         std::error_code error;
+         std::filesystem::remove(path, error);
+      }
+   } remover{temppath.data()};
+   {
+      std::ofstream tempstream(remover.path, std::ios::binary | std::ios::out | std::ios::trunc);
+      if (!tempstream) {
+         return DISK_ERROR;
+      }
+      // n.b. the converter writes the points in the older format
+      mgraph->writeToStream(tempstream, VERSION_ALWAYS_RECORD_BINDISTANCES, 0);
+      if (tempstream.fail()) {
+         return DISK_ERROR;
+      }
+   }
+   // the old graph is not needed any more
+   mgraph.reset();
+
+   depthmapX::MappedFile mappedfile(remover.path);
+   if (!mappedfile.isOpen()) {
+      return DISK_ERROR;
+   }
+   std::istream stream(&mappedfile);
+   // the graph is still the one of the original file, which the converted
+   // graph is always recent enough not to be read through again
+   return readFromStream(stream, filename);
+#else
+   // no mapping on windows, so the converted graph is read back from memory
+   std::stringstream tempstream;
+   mgraph->writeToStream(tempstream, VERSION_ALWAYS_RECORD_BINDISTANCES, 0);
+   return readFromStream(tempstream, filename);
+#endif
+}
+
 int MetaGraph::readFromStream( std::istream &stream, const std::string& filename )
 {
    m_state = 0;   // <- clear the state out
 
    // clear BSP tree if it exists:
-   if (m_bsp_root) {
-      delete m_bsp_root;
-      m_bsp_root = NULL;
-   }
+   m_bsp_cache.clear();
+   m_bsp_root = NULL;
    m_bsp_tree = false;
+   m_store_bsp_tree = false;
 
    char header[3];
    stream.read( header, 3 );
@@ -2511,17 +2575,8 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
    if (version > METAGRAPH_VERSION) {
       return NEWER_VERSION;
    }
-   if (version < METAGRAPH_VERSION) {
-       std::unique_ptr<mgraph440::MetaGraph> mgraph(new mgraph440::MetaGraph);
-       auto result = mgraph->read(filename);
-       if ( result != mgraph440::MetaGraph::OK)
-       {
-           return DAMAGED_FILE;
-       }
-       std::stringstream tempstream;
-       mgraph->writeToStream(tempstream, METAGRAPH_VERSION, 0);
-
-       return readFromStream(tempstream, filename);
+   if (version < VERSION_ALWAYS_RECORD_BINDISTANCES) {
+       return readFromOlderVersion(filename);
    }
 
    // have to use temporary state here as redraw attempt may come too early:
@@ -2538,22 +2593,14 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
    //             l --- layer data
    //             p --- point data
    //             d --- data summary layers
+   //             b --- bsp tree of the drawing layers
 
    char type;
    stream.read( &type, 1 );
    if (type == 'd') {
        // contains deprecated datalayers. Read through mgraph440 which will
        // convert them into shapemaps
-       std::unique_ptr<mgraph440::MetaGraph> mgraph(new mgraph440::MetaGraph);
-       auto result = mgraph->read(filename);
-       if ( result != mgraph440::MetaGraph::OK)
-       {
-           return DAMAGED_FILE;
-       }
-       std::stringstream tempstream;
-       mgraph->writeToStream(tempstream, METAGRAPH_VERSION, 0);
-
-       return readFromStream(tempstream, filename);
+       return readFromOlderVersion(filename);
    }
    if (type == 'x') {
       FileProperties::read(stream);
@@ -2613,7 +2660,7 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
       }
    }
    if (type == 'p') {
-      readPointMaps( stream );
+      readPointMaps( stream, version );
       temp_state |= POINTMAPS;
       if (!stream.eof()) {
          stream.read( &type, 1 );         
@@ -2647,6 +2694,15 @@ int MetaGraph::readFromStream( std::istream &stream, const std::string& filename
          stream.read( &type, 1 );         
       }
    }
+   if (type == 'b' && !stream.eof()) {
+      // written after everything else, so that older readers stop before it. A tree that can not be
+      // read (the file is cut short) is dropped, and made again when it is next needed
+      m_bsp_cache.read(stream);
+      m_store_bsp_tree = true;
+      if (!stream.eof()) {
+         stream.read( &type, 1 );
+      }
+   }
    m_state = temp_state;
    m_view_class = temp_view_class;
 
@@ -2706,7 +2762,7 @@ int MetaGraph::write( const std::string& filename, int version, bool currentlaye
       if (m_view_class & MetaGraph::VIEWVGA) {
          type = 'p';
          stream.write(&type, 1);
-         writePointMaps( stream, true );
+         writePointMaps( stream, version, true );
       }
       else if (m_view_class & MetaGraph::VIEWAXIAL) {
          type = 'x';
@@ -2736,7 +2792,7 @@ int MetaGraph::write( const std::string& filename, int version, bool currentlaye
       if (oldstate & POINTMAPS) {
          type = 'p';
          stream.write(&type, 1);
-         writePointMaps( stream );
+         writePointMaps( stream, version );
       }
       if (oldstate & SHAPEGRAPHS) {
          type = 'x';
@@ -2748,6 +2804,11 @@ int MetaGraph::write( const std::string& filename, int version, bool currentlaye
          stream.write(&type, 1);
          writeDataMaps( stream );
       }
+      if (m_store_bsp_tree && (oldstate & LINEDATA) && makeBSPtree()) {
+         type = 'b';
+         stream.write(&type, 1);
+         m_bsp_cache.write( stream );
+      }
    }
 
    stream.close();
@@ -2808,26 +2869,26 @@ int MetaGraph::addNewPointMap(const std::string& name)
    return m_pointMaps.size() - 1;
 }
 
-bool MetaGraph::readPointMaps(std::istream& stream)
+bool MetaGraph::readPointMaps(std::istream& stream, int version)
 {
    stream.read((char *) &m_displayed_pointmap, sizeof(m_displayed_pointmap));
    int count;
    stream.read((char *) &count, sizeof(count));
    for (int i = 0; i < count; i++) {
       m_pointMaps.push_back(PointMap(m_region, m_drawingFiles));
-      m_pointMaps.back().read( stream );
+      m_pointMaps.back().read( stream, version, m_num_threads );
    }
    return true;
 }
 
-bool MetaGraph::writePointMaps(std::ofstream& stream, bool displayedmaponly)
+bool MetaGraph::writePointMaps(std::ofstream& stream, int version, bool displayedmaponly)
 {
    if (!displayedmaponly) {
       stream.write((char *) &m_displayed_pointmap, sizeof(m_displayed_pointmap));
       int count = m_pointMaps.size();
       stream.write((char *) &count, sizeof(count));
       for (auto& pointmap: m_pointMaps) {
-         pointmap.write( stream );
+         pointmap.write( stream, version, m_num_threads );
       }
    }
    else {
@@ -2839,7 +2900,7 @@ bool MetaGraph::writePointMaps(std::ofstream& stream, bool displayedmaponly)
       dummy = 1;
       stream.write((char *) &dummy, sizeof(dummy));
       //
-      m_pointMaps[m_displayed_pointmap].write(stream);
+      m_pointMaps[m_displayed_pointmap].write(stream, version, m_num_threads);
    }
    return true;
 }
@@ -33,6 +33,7 @@
 #include "salalib/shapemap.h"
 #include "salalib/pointdata.h"
 #include "salalib/axialmap.h"
+#include "salalib/bspcache.h"
 
 
 #include "genlib/p2dpoly.h"
@@ -125,8 +126,8 @@ private:
        m_pointMaps.erase(m_pointMaps.begin() + i);
    }
 
-   bool readPointMaps(std::istream &stream);
-   bool writePointMaps(std::ofstream& stream, bool displayedmaponly = false );
+   bool readPointMaps(std::istream &stream, int version);
+   bool writePointMaps(std::ofstream& stream, int version, bool displayedmaponly = false );
 
    std::recursive_mutex mLock;
 public:
@@ -154,8 +155,11 @@ public:
    bool clearPoints();
    bool setGrid( double spacing, const Point2f& offset = Point2f() );                 // override of PointMap
    bool makePoints( const Point2f& p, int semifilled, Communicator *communicator = NULL);  // override of PointMap
-   bool makeGraph( Communicator *communicator, int algorithm, double maxdist );
+   bool makeGraph( Communicator *communicator, int algorithm, double maxdist, int num_threads = 1 );
    bool unmakeGraph(bool removeLinks);
+   // shows or hides a drawing layer, and if the displayed point map has a graph remakes it where the lines
+   // of the layer change what can be seen. maxdist should be the one the graph was made with
+   bool setLineLayerShown( Communicator *communicator, int file, int layer, bool show, double maxdist, int num_threads = 1 );
    bool analyseGraph(Communicator *communicator, Options options , bool simple_version); // <- options copied to keep thread safe
    //
    // helpers for editing maps
@@ -468,16 +472,23 @@ public:
    bool analyseThruVision(Communicator *comm = NULL, int gatelayer = -1);
    // BSP tree for making isovists
 protected:
-   BSPNode *m_bsp_root;
+   BSPCache m_bsp_cache;
+   BSPNode *m_bsp_root; // <- owned by the cache
    bool m_bsp_tree;
+   bool m_store_bsp_tree;
 public:
    bool makeBSPtree(Communicator *communicator = NULL);
    void resetBSPtree() { m_bsp_tree = false; }
+   // the tree is written with the graph, so that isovists made after reading it do not have to make it again
+   // (set when reading a graph with a tree in it)
+   void setStoreBSPtree(bool store) { m_store_bsp_tree = store; }
+   bool getStoreBSPtree() const { return m_store_bsp_tree; }
    // returns 0: fail, 1: made isovist, 2: made isovist and added new shapemap layer
    int makeIsovist(Communicator *communicator, const Point2f& p, double startangle = 0, double endangle = 0, bool simple_version = true);
    // returns 0: fail, 1: made isovist, 2: made isovist and added new shapemap layer
    int makeIsovistPath(Communicator *communicator, double fov_angle = 2.0 * M_PI, bool simple_version = true);
-   bool makeIsovist(const Point2f& p, Isovist& iso);
+   // once the BSP tree has been made, this only reads it, so isovists can be made on several threads at once
+   bool makeIsovist(const Point2f& p, Isovist& iso, double startangle = 0, double endangle = 0);
 protected:
    // properties
 public:
@@ -487,8 +498,14 @@ public:
    int readFromFile( const std::string& filename );
    int readFromStream( std::istream &stream, const std::string& filename );
    int write( const std::string& filename, int version, bool currentlayer = false);
+   // the threads the points of the point maps are coded and decoded on when the graph is written and read,
+   // 1 runs serially, 0 uses all available cores
+   void setNumThreads(int num_threads) { m_num_threads = num_threads; }
+   int getNumThreads() const { return m_num_threads; }
    //
    std::vector<SimpleLine> getVisibleDrawingLines();
 protected:
+   int m_num_threads = 1;
    std::streampos skipVirtualMem(std::istream &stream);
+   int readFromOlderVersion( const std::string& filename );
 };
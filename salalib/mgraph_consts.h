@@ -19,9 +19,10 @@
 // Human readable(ish) metagraph version changes
 
 const int VERSION_ALWAYS_RECORD_BINDISTANCES    = 440;
+const int VERSION_COMPRESSED_POINT_NODES        = 441;
 
 // Current metagraph version
-const int METAGRAPH_VERSION = VERSION_ALWAYS_RECORD_BINDISTANCES;
+const int METAGRAPH_VERSION = VERSION_COMPRESSED_POINT_NODES;
 
 ///////////////////////////////////////////////////////////////////////////////
 
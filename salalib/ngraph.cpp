@@ -57,35 +57,6 @@ void Node::make(const PixelRef pix, PixelRefVector *bins, float *bin_far_dists,
    }
 }
 
-void Node::extractUnseen(PixelRefVector& pixels, PointMap *pointdata)
-{
-   for (int i = 0; i < 32; i++) {
-         m_bins[i].extractUnseen(pixels, pointdata, (1 << i));
-   }
-}
-
-void Node::extractMetric(std::set<MetricTriple>& pixels, PointMap *pointdata, const MetricTriple& curs)
-{
-   //if (dist == 0.0f || concaveConnected()) { // increases effiency but is too inaccurate
-   //if (dist == 0.0f || !fullyConnected()) { // increases effiency but can miss lines
-   if (curs.dist == 0.0f || pointdata->getPoint(curs.pixel).blocked() || pointdata->blockedAdjacent(curs.pixel)) { 
-      for (int i = 0; i < 32; i++) {
-         m_bins[i].extractMetric(pixels, pointdata, curs);
-      }
-   }
-}
-
-// based on extract metric
-
-void Node::extractAngular(std::set<AngularTriple>& pixels, PointMap *pointdata, const AngularTriple& curs)
-{
-   if (curs.angle == 0.0f || pointdata->getPoint(curs.pixel).blocked() || pointdata->blockedAdjacent(curs.pixel)) {
-      for (int i = 0; i < 32; i++) {
-         m_bins[i].extractAngular(pixels, pointdata, curs);
-      }
-   }
-}
-
 bool Node::concaveConnected()
 {
    // not quite correct -- sometimes at corners you 'see through' the very first connection
@@ -219,6 +190,39 @@ std::ostream& Node::write(std::ostream& stream)
    return stream;
 }
 
+void Node::encode(depthmapX::ByteWriter& writer, PixelRef pix) const
+{
+   for (int i = 0; i < 32; i++) {
+      m_bins[i].encode(writer, pix);
+   }
+   // the occlusion pixels as steps from one to the next
+   for (int i = 0; i < 32; i++) {
+      writer.writeVarint(m_occlusion_bins[i].size());
+      PixelRef context = pix;
+      for (const PixelRef& occlusion: m_occlusion_bins[i]) {
+         writer.writeSignedVarint(occlusion.x - context.x);
+         writer.writeSignedVarint(occlusion.y - context.y);
+         context = occlusion;
+      }
+   }
+}
+
+void Node::decode(depthmapX::ByteReader& reader, PixelRef pix)
+{
+   for (int i = 0; i < 32; i++) {
+      m_bins[i].decode(reader, pix);
+   }
+   for (int i = 0; i < 32; i++) {
+      m_occlusion_bins[i].resize(static_cast<size_t>(reader.readVarint()));
+      PixelRef context = pix;
+      for (PixelRef& occlusion: m_occlusion_bins[i]) {
+         occlusion.x = static_cast<short>(context.x + reader.readSignedVarint());
+         occlusion.y = static_cast<short>(context.y + reader.readSignedVarint());
+         context = occlusion;
+      }
+   }
+}
+
 std::ostream& operator << (std::ostream& stream, const Node& node)
 {
    for (int i = 0; i < 32; i++) {
@@ -305,67 +309,6 @@ void Bin::make(const PixelRefVector& pixels, char dir)
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
-void Bin::extractUnseen(PixelRefVector& pixels, PointMap *pointdata, int binmark)
-{
-   for (auto pixVec: m_pixel_vecs) {
-      for (PixelRef pix = pixVec.start(); pix.col(m_dir) <= pixVec.end().col(m_dir); ) {
-         Point& pt = pointdata->getPoint(pix);
-         if (pointdata->getPoint(pix).m_misc == 0) {
-            pixels.push_back(pix);
-            pointdata->getPoint(pix).m_misc |= binmark;
-         }
-         // 10.2.02 revised --- diagonal was breaking this as it was extent in diagonal or horizontal
-         if (!(m_dir & PixelRef::DIAGONAL)) {
-            if (pt.m_extent.col(m_dir) >= pixVec.end().col(m_dir))
-               break;
-            pt.m_extent.col(m_dir) = pixVec.end().col(m_dir);
-         }
-         pix.move(m_dir);
-      }
-   }
-}
-
-///////////////////////////////////////////////////////////////////////////////////////
-
-void Bin::extractMetric(std::set<MetricTriple>& pixels, PointMap *pointdata, const MetricTriple& curs)
-{
-   for (auto pixVec: m_pixel_vecs) {
-      for (PixelRef pix = pixVec.start(); pix.col(m_dir) <= pixVec.end().col(m_dir); ) {
-         Point& pt = pointdata->getPoint(pix);
-         if (pt.m_misc == 0 && 
-            (pt.m_dist == -1.0 || (curs.dist + dist(pix,curs.pixel) < pt.m_dist))) {
-            pt.m_dist = curs.dist + (float) dist(pix,curs.pixel);
-            // n.b. dmap v4.06r now sets angle in range 0 to 4 (1 = 90 degrees)
-            pt.m_cumangle = pointdata->getPoint(curs.pixel).m_cumangle + (curs.lastpixel == NoPixel ? 0.0f : (float) (angle(pix,curs.pixel,curs.lastpixel) / (M_PI * 0.5)));
-            pixels.insert(MetricTriple(pt.m_dist, pix, curs.pixel));
-         }
-         pix.move(m_dir);
-      }
-   }
-}
-
-// based on metric
-
-void Bin::extractAngular(std::set<AngularTriple>& pixels, PointMap *pointdata, const AngularTriple& curs)
-{
-   for (auto pixVec: m_pixel_vecs) {
-      for (PixelRef pix = pixVec.start(); pix.col(m_dir) <= pixVec.end().col(m_dir); ) {
-         Point& pt = pointdata->getPoint(pix);
-         if (pt.m_misc == 0) {
-            // n.b. dmap v4.06r now sets angle in range 0 to 4 (1 = 90 degrees)
-            float ang = (curs.lastpixel == NoPixel) ? 0.0f : (float) (angle(pix,curs.pixel,curs.lastpixel) / (M_PI * 0.5));
-            if (pt.m_cumangle == -1.0 || curs.angle + ang < pt.m_cumangle) {
-               pt.m_cumangle = pointdata->getPoint(curs.pixel).m_cumangle + ang;
-               pixels.insert(AngularTriple(pt.m_cumangle, pix, curs.pixel));
-            }
-         }
-         pix.move(m_dir);
-      }
-   }
-}
-
-///////////////////////////////////////////////////////////////////////////////////////
-
 bool Bin::containsPoint(const PixelRef p) const
 {
    for (auto pixVec: m_pixel_vecs) {
@@ -471,6 +414,71 @@ std::ostream& Bin::write(std::ostream& stream)
    return stream;
 }
 
+void Bin::encode(depthmapX::ByteWriter& writer, PixelRef pix) const
+{
+   writer.writeRaw(m_dir);
+   writer.writeVarint(m_node_count);
+   // most bins have no occlusion distance, and empty ones no distance either
+   unsigned char distances = (m_distance != 0.0f ? 0x01 : 0x00) | (m_occ_distance != 0.0f ? 0x02 : 0x00);
+   writer.writeRaw(distances);
+   if (distances & 0x01) {
+      writer.writeRaw(m_distance);
+   }
+   if (distances & 0x02) {
+      writer.writeRaw(m_occ_distance);
+   }
+
+   if (m_node_count) {
+      // each run starts a few pixels from the start of the one before, the first from the node itself
+      writer.writeVarint(m_pixel_vecs.size());
+      PixelRef context = pix;
+      for (const PixelVec& run: m_pixel_vecs) {
+         writer.writeSignedVarint(run.m_start.x - context.x);
+         writer.writeSignedVarint(run.m_start.y - context.y);
+         writer.writeVarint(static_cast<uint64_t>(run.m_end.col(m_dir) - run.m_start.col(m_dir)));
+         context = run.m_start;
+      }
+   }
+}
+
+void Bin::decode(depthmapX::ByteReader& reader, PixelRef pix)
+{
+   m_dir = reader.readRaw<char>();
+   m_node_count = static_cast<unsigned short>(reader.readVarint());
+   unsigned char distances = reader.readRaw<unsigned char>();
+   m_distance = (distances & 0x01) ? reader.readRaw<float>() : 0.0f;
+   m_occ_distance = (distances & 0x02) ? reader.readRaw<float>() : 0.0f;
+
+   m_pixel_vecs.clear();
+   if (m_node_count) {
+      m_pixel_vecs.resize(static_cast<size_t>(reader.readVarint()));
+      PixelRef context = pix;
+      for (PixelVec& run: m_pixel_vecs) {
+         run.m_start.x = static_cast<short>(context.x + reader.readSignedVarint());
+         run.m_start.y = static_cast<short>(context.y + reader.readSignedVarint());
+         short runlength = static_cast<short>(reader.readVarint());
+         run.m_end = run.m_start;
+         switch (m_dir) {
+            case PixelRef::POSDIAGONAL:
+               run.m_end.x += runlength;
+               run.m_end.y += runlength;
+               break;
+            case PixelRef::NEGDIAGONAL:
+               run.m_end.x += runlength;
+               run.m_end.y -= runlength;
+               break;
+            case PixelRef::HORIZONTAL:
+               run.m_end.x += runlength;
+               break;
+            case PixelRef::VERTICAL:
+               run.m_end.y += runlength;
+               break;
+         }
+         context = run.m_start;
+      }
+   }
+}
+
 std::ostream& operator << (std::ostream& stream, const Bin& bin)
 {
    int c = 0;
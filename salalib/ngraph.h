@@ -21,12 +21,12 @@
 
 #include "salalib/pixelref.h"
 
+#include "genlib/bytecoding.h"
+
 #include <set>
 
 class PointMap;
 struct MetricPair;
-struct MetricTriple;
-struct AngularTriple;
 
 struct PixelVec
 {
@@ -59,9 +59,6 @@ public:
    { m_dir = PixelRef::NODIR; m_node_count = 0; m_distance = 0.0f; m_occ_distance = 0.0f; }
    //
    void make(const PixelRefVector& pixels, char m_dir);
-   void extractUnseen(PixelRefVector& pixels, PointMap *pointdata, int binmark);
-   void extractMetric(std::set<MetricTriple> &pixels, PointMap *pointdata, const MetricTriple& curs);
-   void extractAngular(std::set<AngularTriple> &pixels, PointMap *pointdata, const AngularTriple& curs);
    //
    int count() const 
    { return m_node_count; }
@@ -88,6 +85,10 @@ public:
    //
    std::istream &read(std::istream &stream);
    std::ostream &write(std::ostream &stream);
+   // compact coding of the graph files from VERSION_COMPRESSED_POINT_NODES, with the runs relative to the
+   // pixel of the node
+   void encode(depthmapX::ByteWriter &writer, PixelRef pix) const;
+   void decode(depthmapX::ByteReader &reader, PixelRef pix);
    //
    friend std::ostream& operator << (std::ostream& stream, const Bin& bin);
 };
@@ -103,9 +104,6 @@ public:
 public:
    // Note: this function clears the bins as it goes
    void make(const PixelRef pix, PixelRefVector *bins, float *bin_far_dists, int q_octants);
-   void extractUnseen(PixelRefVector& pixels, PointMap *pointdata);
-   void extractMetric(std::set<MetricTriple> &pixels, PointMap *pointdata, const MetricTriple& curs);
-   void extractAngular(std::set<AngularTriple> &pixels, PointMap *pointdata, const AngularTriple& curs);
    bool concaveConnected();
    bool fullyConnected();
    //
@@ -144,6 +142,8 @@ public:
    //
    std::istream &read(std::istream &stream);
    std::ostream &write(std::ostream &stream);
+   void encode(depthmapX::ByteWriter &writer, PixelRef pix) const;
+   void decode(depthmapX::ByteReader &reader, PixelRef pix);
    //
    friend std::ostream& operator << (std::ostream& stream, const Node& node);
 };
@@ -53,6 +53,8 @@ struct Options
    int weighted_measure_col2;  //EFEF
     int routeweight_col;			//EFEF
    std::string output_file; // To save an output graph (for example)
+   // number of threads for analyses that can run in parallel, 0 to use all available cores
+   int num_threads;
    // default values
    Options()
    { local = 0; global = 1; cliques = 0;
@@ -61,5 +63,6 @@ struct Options
      radius = -1; radius_type = 0;
      output_type = OUTPUT_ISOVIST; process_in_memory = false; gates_only = false; sel_only = false;
      gatelayer = -1;
-     weighted_measure_col = -1;}
+     weighted_measure_col = -1;
+     num_threads = 1;}
 };
@@ -17,6 +17,8 @@
 #include "salalib/point.h"
 #include "salalib/ngraph.h"
 
+#include <cstring>
+
 float Point::getBinDistance(int i)
 {
    return m_node->bindistance(i);
@@ -71,3 +73,35 @@ std::ostream &Point::write(std::ostream& stream)
    stream.write((char *) &m_location, sizeof(m_location));
    return stream;
 }
+
+void Point::encode(depthmapX::ByteWriter& writer, PixelRef pix, const Point2f& gridLocation) const
+{
+   writer.writeSignedVarint(m_state);
+   writer.writeSignedVarint(m_block);
+   writer.writeRaw(m_grid_connections);
+   writer.writeSignedVarint(static_cast<int>(m_merge));
+   // n.b. the location is compared bit for bit, so that it is read back exactly
+   bool offGrid = std::memcmp(&m_location, &gridLocation, sizeof(Point2f)) != 0;
+   unsigned char contents = (m_node ? 0x01 : 0x00) | (offGrid ? 0x02 : 0x00);
+   writer.writeRaw(contents);
+   if (m_node) {
+      m_node->encode(writer, pix);
+   }
+   if (offGrid) {
+      writer.writeRaw(m_location);
+   }
+}
+
+void Point::decode(depthmapX::ByteReader& reader, PixelRef pix, const Point2f& gridLocation)
+{
+   m_state = static_cast<int>(reader.readSignedVarint());
+   m_block = static_cast<int>(reader.readSignedVarint());
+   m_grid_connections = reader.readRaw<char>();
+   m_merge = static_cast<int>(reader.readSignedVarint());
+   unsigned char contents = reader.readRaw<unsigned char>();
+   if (contents & 0x01) {
+      m_node = std::unique_ptr<Node>(new Node());
+      m_node->decode(reader, pix);
+   }
+   m_location = (contents & 0x02) ? reader.readRaw<Point2f>() : gridLocation;
+}
@@ -172,6 +172,10 @@ public:
 public:
    std::istream &read(std::istream &stream);
    std::ostream& write(std::ostream &stream);
+   // compact coding of the graph files from VERSION_COMPRESSED_POINT_NODES. The location is only stored if it
+   // is not the one of the point's pixel on the grid
+   void encode(depthmapX::ByteWriter &writer, PixelRef pix, const Point2f &gridLocation) const;
+   void decode(depthmapX::ByteReader &reader, PixelRef pix, const Point2f &gridLocation);
    //
 protected:
    // for user processing, set their own data on the point:
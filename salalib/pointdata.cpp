@@ -32,10 +32,16 @@
 #include "genlib/comm.h"  // for communicator
 #include "genlib/stringutils.h"
 #include "genlib/containerutils.h"
+#include "genlib/parallel.h"
+#include "genlib/bytecoding.h"
+#include "genlib/lzcodec.h"
 
 #include <math.h>
+#include <algorithm>
+#include <map>
 #include <unordered_set>
 #include <numeric>
+#include <atomic>
 
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -164,6 +170,7 @@ bool PointMap::setGrid(double spacing, const Point2f& offset)
    m_blockedlines = false;
    m_processed = false;
    m_boundarygraph = false;
+   m_visibility_graph.clear();
 
    m_merge_lines.clear();
 
@@ -1008,6 +1015,16 @@ bool PointMap::setCurSel(const std::vector<int>& selset, bool add)
    return true;
 }
 
+const VisibilityGraph& PointMap::getVisibilityGraph()
+{
+   // made from the nodes by the first of any threads asking for it, and kept until the analysis lets go of it
+   std::lock_guard<std::mutex> lock(m_visibility_graph_mutex);
+   if (!m_visibility_graph.isBuilt()) {
+      m_visibility_graph.build(*this);
+   }
+   return m_visibility_graph;
+}
+
 // Helper function: is there a blocked point next to you?
 // ...rather scruffily goes round the eight adjacent points...
 
@@ -1070,7 +1087,7 @@ bool PointMap::blockedAdjacent( const PixelRef p ) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool PointMap::read(std::istream& stream )
+bool PointMap::read(std::istream& stream, int version, int num_threads)
 {
    m_name = dXstring::readString(stream);
 
@@ -1102,11 +1119,20 @@ bool PointMap::read(std::istream& stream )
    m_attributes->read( stream, m_layers );
 
    m_points = depthmapX::ColumnMatrix<Point>(m_rows, m_cols);
-   
+
+   if (version >= VERSION_COMPRESSED_POINT_NODES) {
+      readPointBlocks(stream, num_threads);
+   }
+   else {
+      for (size_t j = 0; j < m_cols; j++) {
+         for (size_t k = 0; k < m_rows; k++) {
+            m_points(k, j).read(stream);
+         }
+      }
+   }
+
    for (size_t j = 0; j < m_cols; j++) {
       for (size_t k = 0; k < m_rows; k++) {
-         m_points(k, j).read(stream);
-
          // check if occdistance of any pixel's bin is set, meaning that
          // the isovist analysis was done
          if(!m_hasIsovistAnalysis) {
@@ -1147,6 +1173,9 @@ bool PointMap::read(std::istream& stream )
    stream.read((char *) &m_processed, sizeof(m_processed));
    stream.read((char *) &m_boundarygraph, sizeof(m_boundarygraph));
 
+   // the compact graph is only made once an analysis asks for it
+   m_visibility_graph.clear();
+
    // now, as soon as loaded, must recalculate our screen display:
    // note m_displayed_attribute should be -2 in order to force recalc...
    m_displayed_attribute = -2;
@@ -1155,7 +1184,7 @@ bool PointMap::read(std::istream& stream )
    return true;
 }
 
-bool PointMap::write( std::ostream& stream )
+bool PointMap::write( std::ostream& stream, int version, int num_threads )
 {
    dXstring::writeString(stream, m_name);
 
@@ -1176,9 +1205,14 @@ bool PointMap::write( std::ostream& stream )
    stream.write( (char *) &sortedDisplayedAttribute, sizeof(sortedDisplayedAttribute) );
 
    m_attributes->write( stream, m_layers );
-   
-   for (auto& point: m_points) {
-       point.write( stream );
+
+   if (version >= VERSION_COMPRESSED_POINT_NODES) {
+      writePointBlocks(stream, num_threads);
+   }
+   else {
+      for (auto& point: m_points) {
+          point.write( stream );
+      }
    }
 
    stream.write((char *) &m_processed, sizeof(m_processed));
@@ -1187,6 +1221,93 @@ bool PointMap::write( std::ostream& stream )
    return false;
 }
 
+// about this many cells to a block, or a whole column if it is longer
+static const size_t POINT_BLOCK_CELLS = 16384;
+
+void PointMap::writePointBlocks(std::ostream& stream, int num_threads)
+{
+   int columnsPerBlock = static_cast<int>(std::max<size_t>(1, POINT_BLOCK_CELLS / std::max<size_t>(1, m_rows)));
+   size_t columns = static_cast<size_t>(columnsPerBlock);
+   int blockCount = static_cast<int>((m_cols + columns - 1) / columns);
+   stream.write(reinterpret_cast<const char *>(&columnsPerBlock), sizeof(columnsPerBlock));
+   stream.write(reinterpret_cast<const char *>(&blockCount), sizeof(blockCount));
+
+   // a batch of blocks at a time, so that the whole map is never held compressed in memory
+   int numThreads = depthmapX::resolveThreadCount(num_threads);
+   size_t batchSize = static_cast<size_t>(numThreads) * 4;
+   std::vector<std::vector<unsigned char>> compressed(batchSize);
+   std::vector<unsigned int> sizes(batchSize);
+   for (size_t batchStart = 0; batchStart < size_t(blockCount); batchStart += batchSize) {
+      size_t batchBlocks = std::min(batchSize, size_t(blockCount) - batchStart);
+      depthmapX::parallelFor(numThreads, batchBlocks, [&](int, size_t i) {
+         depthmapX::ByteWriter writer;
+         size_t firstColumn = (batchStart + i) * columns;
+         for (size_t j = firstColumn; j < std::min(firstColumn + columns, m_cols); j++) {
+            for (size_t k = 0; k < m_rows; k++) {
+               PixelRef pix(static_cast<short>(j), static_cast<short>(k));
+               m_points(k, j).encode(writer, pix, depixelate(pix));
+            }
+         }
+         sizes[i] = static_cast<unsigned int>(writer.size());
+         compressed[i] = depthmapX::lz::compress(writer.bytes().data(), writer.size());
+      });
+      for (size_t i = 0; i < batchBlocks; i++) {
+         unsigned int compressedSize = static_cast<unsigned int>(compressed[i].size());
+         stream.write(reinterpret_cast<const char *>(&sizes[i]), sizeof(sizes[i]));
+         stream.write(reinterpret_cast<const char *>(&compressedSize), sizeof(compressedSize));
+         stream.write(reinterpret_cast<const char *>(compressed[i].data()), compressedSize);
+      }
+   }
+}
+
+void PointMap::readPointBlocks(std::istream& stream, int num_threads)
+{
+   int columnsPerBlock, blockCount;
+   stream.read(reinterpret_cast<char *>(&columnsPerBlock), sizeof(columnsPerBlock));
+   stream.read(reinterpret_cast<char *>(&blockCount), sizeof(blockCount));
+   size_t columns = static_cast<size_t>(columnsPerBlock);
+   if (!stream || columnsPerBlock <= 0 || size_t(blockCount) != (m_cols + columns - 1) / columns) {
+      throw depthmapX::RuntimeException("The points of the map are damaged");
+   }
+
+   int numThreads = depthmapX::resolveThreadCount(num_threads);
+   size_t batchSize = static_cast<size_t>(numThreads) * 4;
+   std::vector<std::vector<unsigned char>> compressed(batchSize);
+   std::vector<unsigned int> sizes(batchSize);
+   for (size_t batchStart = 0; batchStart < size_t(blockCount); batchStart += batchSize) {
+      // the file is read in order, and only the decoding is in parallel
+      size_t batchBlocks = std::min(batchSize, size_t(blockCount) - batchStart);
+      for (size_t i = 0; i < batchBlocks; i++) {
+         unsigned int compressedSize;
+         stream.read(reinterpret_cast<char *>(&sizes[i]), sizeof(sizes[i]));
+         stream.read(reinterpret_cast<char *>(&compressedSize), sizeof(compressedSize));
+         if (!stream) {
+            throw depthmapX::RuntimeException("The points of the map are damaged");
+         }
+         compressed[i].resize(compressedSize);
+         stream.read(reinterpret_cast<char *>(compressed[i].data()), compressedSize);
+      }
+      if (!stream) {
+         throw depthmapX::RuntimeException("The points of the map are damaged");
+      }
+      depthmapX::parallelFor(numThreads, batchBlocks, [&](int, size_t i) {
+         std::vector<unsigned char> coded(sizes[i]);
+         depthmapX::lz::decompress(compressed[i].data(), compressed[i].size(), coded.data(), coded.size());
+         depthmapX::ByteReader reader(coded.data(), coded.size());
+         size_t firstColumn = (batchStart + i) * columns;
+         for (size_t j = firstColumn; j < std::min(firstColumn + columns, m_cols); j++) {
+            for (size_t k = 0; k < m_rows; k++) {
+               PixelRef pix(static_cast<short>(j), static_cast<short>(k));
+               m_points(k, j).decode(reader, pix, depixelate(pix));
+            }
+         }
+         if (!reader.atEnd()) {
+            throw depthmapX::RuntimeException("The points of the map are damaged");
+         }
+      });
+   }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Now what this class is actually for: making a visibility graph!
@@ -1243,7 +1364,7 @@ int PointMap::tagState(bool settag)
 // Then wouldn't have to 'test twice' for the grid point being blocked...
 // ...perhaps a tweak for a later date!
 
-bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdist )
+bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdist, int num_threads )
 {
    // Note, graph must be fixed (i.e., having blocking pixels filled in)
 
@@ -1280,43 +1401,76 @@ bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdi
       comm->CommPostMessage( Communicator::NUM_RECORDS, count );
    }
 
-   count = 0;
-
+   std::vector<PixelRef> filled;
+   filled.reserve(count);
    for (size_t i = 0; i < m_cols; i++) {
-
       for (size_t j = 0; j < m_rows; j++) {
-
          PixelRef curs = PixelRef( i, j );
-   
          if ( getPoint( curs ).getState() & Point::FILLED ) {
+            filled.push_back(curs);
+         }
+      }
+   }
 
-            getPoint( curs ).m_node = std::unique_ptr<Node>(new Node());
-            m_attributes->addRow( AttributeKey(curs) );
-
-            sparkPixel2(curs,1,maxdist); // make flag of 1 suggests make this node, don't set reciprocral process flags on those you can see
-                                         // maxdist controls how far to see out to
-
-            count++;    // <- increment count
-
-            if (comm) {
-               if (qtimer( atime, 500 )) {
-                  if (comm->IsCancelled()) {
-                     tagState( false );         // <- the state field has been used for tagging visited nodes... set back to a state variable
-                     // (well, actually, no it hasn't!)
-                     // Should clear all nodes and attributes here:
-                     // Clear nodes
-                     // Clear attributes
-                     m_attributes->clear();
-                     m_displayed_attribute = -2;
-                     //
-                     throw Communicator::CancelledException();
-                  }
-                  comm->CommPostMessage( Communicator::CURRENT_RECORD, count );
-               }         
-            } // if (comm)
-         } // if ( getPoint( curs ).getState() & Point::FILLED )
-      } // rows
-   } // cols
+   // Each pixel only makes its own node, so the pixels can be sparked in any order. The point stats are
+   // kept per pixel and only entered into the attribute table once all are done, in the same order as
+   // the serial version did, so that the table (including its column stats) does not depend on the
+   // number of threads
+   struct PixelStats {
+      int neighbourhood_size;
+      double total_dist;
+      double total_dist_sqr;
+   };
+   std::vector<PixelStats> stats(filled.size());
+
+   num_threads = depthmapX::resolveThreadCount(num_threads);
+   std::vector<std::unique_ptr<PixelVisibility> > visibilities(num_threads);
+   std::atomic<int> done(0);
+
+   try {
+      depthmapX::parallelFor(num_threads, filled.size(), [&](int thread, size_t index) {
+         PixelRef curs = filled[index];
+         if (!visibilities[thread]) {
+            visibilities[thread] = std::unique_ptr<PixelVisibility>(new PixelVisibility());
+         }
+         PixelVisibility& visibility = *visibilities[thread];
+
+         getPoint( curs ).m_node = std::unique_ptr<Node>(new Node());
+         sparkPixel2(curs,1,maxdist,visibility); // make flag of 1 suggests make this node, don't set reciprocral process flags on those you can see
+                                                 // maxdist controls how far to see out to
+         stats[index] = PixelStats{visibility.neighbourhood_size, visibility.total_dist, visibility.total_dist_sqr};
+
+         int current = ++done;    // <- increment count
+
+         // every thread checks for a cancel, but only the calling thread reports back
+         if (comm) {
+            if (comm->IsCancelled()) {
+               throw Communicator::CancelledException();
+            }
+            if (thread == 0 && qtimer( atime, 500 )) {
+               comm->CommPostMessage( Communicator::CURRENT_RECORD, current );
+            }
+         } // if (comm)
+      });
+   }
+   catch (Communicator::CancelledException&) {
+      tagState( false );         // <- the state field has been used for tagging visited nodes... set back to a state variable
+      // (well, actually, no it hasn't!)
+      // Should clear all nodes and attributes here:
+      // Clear nodes
+      // Clear attributes
+      m_attributes->clear();
+      m_displayed_attribute = -2;
+      //
+      throw;
+   }
+
+   for (size_t index = 0; index < filled.size(); index++) {
+      AttributeRow& row = m_attributes->addRow( AttributeKey(filled[index]) );
+      row.setValue( "Connectivity", float(stats[index].neighbourhood_size) );
+      row.setValue( "Point First Moment", float(stats[index].total_dist) );
+      row.setValue( "Point Second Moment", float(stats[index].total_dist_sqr) );
+   }
 
    tagState( false );  // <- the state field has been used for tagging visited nodes... set back to a state variable
 
@@ -1327,6 +1481,9 @@ bool PointMap::sparkGraph2( Communicator *comm, bool boundarygraph, double maxdi
    // (this is easier than trying to work it out per pixel as we calculate visibility)
    addGridConnections();
 
+   // any compact graph is of the old nodes, and is made again when an analysis asks for it
+   m_visibility_graph.clear();
+
    // the graph is processed:
    m_processed = true;
    if (boundarygraph) {
@@ -1364,6 +1521,7 @@ bool PointMap::unmake(bool removeLinks) {
     }
 
     m_attributes->clear();
+    m_visibility_graph.clear();
 
     m_processed = false;
     m_boundarygraph = false;
@@ -1373,14 +1531,210 @@ bool PointMap::unmake(bool removeLinks) {
     return true;
 }
 
+int PointMap::regenerateGraph( Communicator *comm, const std::vector<Line>& changedlines, double maxdist, int num_threads )
+{
+   // the points themselves must not have changed since the graph was made, only the drawing lines
+
+   if (!m_processed) {
+      return -1;
+   }
+
+   std::vector<PixelRef> filled;
+   for (size_t i = 0; i < m_cols; i++) {
+      for (size_t j = 0; j < m_rows; j++) {
+         PixelRef curs = PixelRef( i, j );
+         if (getPoint( curs ).filled()) {
+            filled.push_back(curs);
+         }
+      }
+   }
+
+   num_threads = depthmapX::resolveThreadCount(num_threads);
+
+   // The sieve only blocks the view of a point with the lines in the pixels met before it, and those
+   // in its own pixel, so a view changes only if the line between the two points crosses a changed line.
+   // Adding a line can only close views, all held in the old graph. Taking one away opens the views it
+   // was the first to block, and each of those ran up to the line through the points just short of it, so
+   // the old graph has a view into the region of the line there too. Either way the points remade are those
+   // in, or with a view that crosses, the bounding region of a changed line grown by a pixel to be safe.
+   // Only a line with no point near it to see it by leaves nothing to go on, and then every point is remade
+   std::vector<QtRegion> regions;
+   for (const Line& li: changedlines) {
+      QtRegion region = li;
+      region.bottom_left -= Point2f(m_spacing, m_spacing);
+      region.top_right += Point2f(m_spacing, m_spacing);
+      regions.push_back(region);
+   }
+   bool remakeAll = std::any_of(regions.begin(), regions.end(), [&](const QtRegion& region) {
+      return std::none_of(filled.begin(), filled.end(), [&](PixelRef curs) {
+         return region.contains_touch(depixelate(curs));
+      });
+   });
+
+   std::vector<PixelRef> affected;
+   if (remakeAll) {
+      affected = filled;
+   }
+   else {
+      std::vector<char> crosses(filled.size(), 0);
+      depthmapX::parallelFor(num_threads, filled.size(), [&](int, size_t index) {
+         PixelRef curs = filled[index];
+         Point2f centre = depixelate(curs);
+         for (const QtRegion& region: regions) {
+            if (region.contains_touch(centre)) {
+               crosses[index] = 1;
+               break;
+            }
+         }
+         const Node& node = getPoint(curs).getNode();
+         for (int b = 0; b < 32 && !crosses[index]; b++) {
+            const Bin& bin = node.bin(b);
+            for (bin.first(); !bin.is_tail() && !crosses[index]; bin.next()) {
+               Line view(centre, depixelate(bin.cursor()));
+               for (const QtRegion& region: regions) {
+                  Line cropped = view;
+                  if (intersect_region(view, region) && cropped.crop(region)) {
+                     crosses[index] = 1;
+                     break;
+                  }
+               }
+            }
+         }
+         // nothing has been changed yet, so a cancel here leaves the graph as it was
+         if (comm && comm->IsCancelled()) {
+            throw Communicator::CancelledException();
+         }
+      });
+      for (size_t index = 0; index < filled.size(); index++) {
+         if (crosses[index]) {
+            affected.push_back(filled[index]);
+         }
+      }
+   }
+
+   // now regenerate those points with all the lines in place
+   m_blockedlines = false;
+   blockLines();
+
+   time_t atime = 0;
+   if (comm) {
+      qtimer( atime, 0 );
+      comm->CommPostMessage( Communicator::NUM_RECORDS, affected.size() );
+   }
+
+   // the old stats of every point are kept so that the columns can be written again in full, as a
+   // patched column would keep the extremes of the old values
+   std::vector<AttributeKey> keys;
+   keys.reserve(m_attributes->getNumRows());
+   int connectivity_col = m_attributes->getColumnIndex("Connectivity");
+   int first_moment_col = m_attributes->getColumnIndex("Point First Moment");
+   int second_moment_col = m_attributes->getColumnIndex("Point Second Moment");
+   std::map<PixelRef, size_t> rowindices;
+   for (auto iter = m_attributes->begin(); iter != m_attributes->end(); iter++) {
+      rowindices[iter->getKey().value] = keys.size();
+      keys.push_back(iter->getKey());
+   }
+   struct PixelStats {
+      float neighbourhood_size;
+      float total_dist;
+      float total_dist_sqr;
+   };
+   std::vector<PixelStats> rowstats(keys.size());
+   for (size_t index = 0; index < keys.size(); index++) {
+      const AttributeRow& row = m_attributes->getRow(keys[index]);
+      rowstats[index] = PixelStats{row.getValue(connectivity_col), row.getValue(first_moment_col),
+                                   row.getValue(second_moment_col)};
+   }
+
+   std::vector<std::unique_ptr<PixelVisibility> > visibilities(num_threads);
+   std::atomic<int> done(0);
+
+   try {
+      depthmapX::parallelFor(num_threads, affected.size(), [&](int thread, size_t index) {
+         PixelRef curs = affected[index];
+         if (!visibilities[thread]) {
+            visibilities[thread] = std::unique_ptr<PixelVisibility>(new PixelVisibility());
+         }
+         PixelVisibility& visibility = *visibilities[thread];
+
+         Point& pt = getPoint( curs );
+         pt.m_processflag = 0x00FF;
+         pt.m_node = std::unique_ptr<Node>(new Node());
+         sparkPixel2(curs,1,maxdist,visibility);
+         rowstats[rowindices.at(curs)] = PixelStats{float(visibility.neighbourhood_size), float(visibility.total_dist),
+                                                    float(visibility.total_dist_sqr)};
+
+         int current = ++done;
+
+         // every thread checks for a cancel, but only the calling thread reports back
+         if (comm) {
+            if (comm->IsCancelled()) {
+               throw Communicator::CancelledException();
+            }
+            if (thread == 0 && qtimer( atime, 500 )) {
+               comm->CommPostMessage( Communicator::CURRENT_RECORD, current );
+            }
+         }
+      });
+   }
+   catch (Communicator::CancelledException&) {
+      // some of the points have been remade and some not, so the graph is unmade as a cancelled
+      // sparkGraph2 leaves none
+      unmake(false);
+      throw;
+   }
+
+   // the remade nodes have lost their occlusion distances
+   m_hasIsovistAnalysis = false;
+
+   m_attributes->insertOrResetLockedColumn("Connectivity");
+   m_attributes->insertOrResetColumn("Point First Moment");
+   m_attributes->insertOrResetColumn("Point Second Moment");
+   for (size_t index = 0; index < keys.size(); index++) {
+      AttributeRow& row = m_attributes->getRow( keys[index] );
+      row.setValue( connectivity_col, rowstats[index].neighbourhood_size );
+      row.setValue( first_moment_col, rowstats[index].total_dist );
+      row.setValue( second_moment_col, rowstats[index].total_dist_sqr );
+   }
+
+   unblockLines(false);
+
+   addGridConnections();
+
+   m_visibility_graph.clear();
+
+   if (m_displayed_attribute == connectivity_col ||
+       m_displayed_attribute == first_moment_col ||
+       m_displayed_attribute == second_moment_col) {
+      int displayed = m_displayed_attribute;
+      m_displayed_attribute = -2;
+      setDisplayedAttribute(displayed);
+   }
+
+   return static_cast<int>(affected.size());
+}
+
 // 'make' construct types are: 
 // 1 -- build this node
 // 2 -- register the reciprocal q octant in nodes you can see as requiring processing
 
 bool PointMap::sparkPixel2(PixelRef curs, int make, double maxdist)
 {
-   static std::vector<PixelRef> bins_b[32];
-   static float far_bin_dists[32];
+   PixelVisibility visibility;
+   sparkPixel2(curs, make, maxdist, visibility);
+   if (make & 1) {
+      AttributeRow& row = m_attributes->getRow( AttributeKey(curs) );
+      row.setValue( "Connectivity", float(visibility.neighbourhood_size) );
+      row.setValue( "Point First Moment", float(visibility.total_dist) );
+      row.setValue( "Point Second Moment", float(visibility.total_dist_sqr) );
+   }
+   return true;
+}
+
+bool PointMap::sparkPixel2(PixelRef curs, int make, double maxdist, PixelVisibility& visibility)
+{
+   std::vector<PixelRef> *bins_b = visibility.bins;
+   float *far_bin_dists = visibility.far_bin_dists;
    for (int i = 0; i < 32; i++) {
       far_bin_dists[i] = 0.0f;
    }
@@ -1491,10 +1845,6 @@ bool PointMap::sparkPixel2(PixelRef curs, int make, double maxdist)
       // The bins are cleared in the make function!
       Point& pt = getPoint( curs );
       pt.m_node->make(curs, bins_b, far_bin_dists, pt.m_processflag);   // note: make clears bins!
-      AttributeRow& row = m_attributes->getRow( AttributeKey(curs) );
-      row.setValue( "Connectivity", float(neighbourhood_size) );
-      row.setValue( "Point First Moment", float(total_dist) );
-      row.setValue( "Point Second Moment", float(total_dist_sqr) );
    }
    else {
       // Clear bins by hand if not using them to make
@@ -1503,6 +1853,10 @@ bool PointMap::sparkPixel2(PixelRef curs, int make, double maxdist)
       }
    }
 
+   visibility.neighbourhood_size = neighbourhood_size;
+   visibility.total_dist = total_dist;
+   visibility.total_dist_sqr = total_dist_sqr;
+
    // reset process flag
    getPoint(curs).m_processflag = 0;
 
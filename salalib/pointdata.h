@@ -23,9 +23,12 @@
 #include "salalib/point.h"
 #include "salalib/options.h"
 #include "salalib/attributetable.h"
+#include "salalib/visibilitygraph.h"
+#include "salalib/mgraph_consts.h"
 #include <vector>
 #include <set>
 #include <deque>
+#include <mutex>
 
 class MetaGraph;
 class PointMap;
@@ -100,10 +103,16 @@ protected:
    bool m_boundarygraph;
    int m_undocounter;
    std::vector<PixelRefPair> m_merge_lines;
+   VisibilityGraph m_visibility_graph;   // compact copy of the node bins, made on demand for analysis
+   std::mutex m_visibility_graph_mutex;  // held while the compact graph is made on demand
 private:
    std::unique_ptr<AttributeTable> m_attributes;
    std::unique_ptr<AttributeTableHandle> m_attribHandle;
    LayerManagerImpl m_layers;
+   // From VERSION_COMPRESSED_POINT_NODES the points are coded compactly (see Point::encode) and compressed,
+   // in blocks of whole columns that are coded and decoded in parallel on num_threads
+   void readPointBlocks(std::istream &stream, int num_threads);
+   void writePointBlocks(std::ostream &stream, int num_threads);
 public:
    PointMap(const QtRegion& parentRegion, const std::vector<SpacePixelFile>& drawingFiles,
             const std::string& name = std::string("VGA Map"));
@@ -116,6 +125,7 @@ public:
               m_parentRegion(std::move(other.m_parentRegion)),
               m_drawingFiles(std::move(other.m_drawingFiles)),
               m_points(std::move(other.m_points)),
+              m_visibility_graph(std::move(other.m_visibility_graph)),
               m_attributes(std::move(other.m_attributes)),
               m_attribHandle(std::move(other.m_attribHandle)),
               m_layers(std::move(other.m_layers)) {
@@ -125,6 +135,7 @@ public:
        m_parentRegion = std::move(other.m_parentRegion);
        m_drawingFiles = std::move(other.m_drawingFiles);
        m_points = std::move(other.m_points);
+       m_visibility_graph = std::move(other.m_visibility_graph);
        m_attributes = std::move(other.m_attributes);
        m_attribHandle = std::move(other.m_attribHandle);
        m_layers = std::move(other.m_layers);
@@ -168,9 +179,28 @@ public:
    void outputPoints(std::ostream& stream, char delim );
    void outputMergeLines(std::ostream& stream, char delim);
    int  tagState(bool settag);
-   bool sparkGraph2(Communicator *comm, bool boundarygraph, double maxdist );
+   // num_threads: 1 runs serially, 0 uses all available cores
+   bool sparkGraph2(Communicator *comm, bool boundarygraph, double maxdist, int num_threads = 1);
    bool unmake(bool removeLinks);
+   // updates a graph already made after lines have been added to or removed from the shown drawing layers,
+   // by remaking only the points near or with a view across the lines changed. The points themselves must
+   // not have changed, and maxdist should be the one the graph was made with. Returns the number of points
+   // remade, or -1 if there is no graph to update
+   int regenerateGraph(Communicator *comm, const std::vector<Line>& changedlines, double maxdist,
+                       int num_threads = 1);
+   // what sparkPixel2 finds from one pixel, also used as scratch space so that it can be reused
+   // from one pixel to the next
+   struct PixelVisibility {
+      std::vector<PixelRef> bins[32];
+      float far_bin_dists[32];
+      int neighbourhood_size;
+      double total_dist;
+      double total_dist_sqr;
+   };
    bool sparkPixel2(PixelRef curs, int make, double maxdist = -1.0);
+   // as above, but leaves the attribute table alone and returns the point stats in visibility instead.
+   // With make == 1 this only writes to the point itself, so separate pixels can be sparked concurrently
+   bool sparkPixel2(PixelRef curs, int make, double maxdist, PixelVisibility& visibility);
    bool sieve2(sparkSieve2& sieve, std::vector<PixelRef>& addlist, int q, int depth, PixelRef curs);
    // bool makeGraph( Graph& graph, int optimization_level = 0, Communicator *comm = NULL);
    //
@@ -193,6 +223,12 @@ public:
    Point& getPoint(const PixelRef& p)
       { return m_points(static_cast<size_t>(p.y), static_cast<size_t>(p.x)); }
    depthmapX::BaseMatrix<Point>& getPoints() { return m_points; }
+   // the visibility graph in compact form, made from the nodes if it is not available yet. Safe to call from
+   // several threads, but not while the nodes are changed
+   const VisibilityGraph& getVisibilityGraph();
+   // free the memory of the compact visibility graph, once an analysis is done with it
+   void releaseVisibilityGraph()
+      { m_visibility_graph.clear(); }
    const int& pointState( const PixelRef& p ) const
       { return m_points(static_cast<size_t>(p.y), static_cast<size_t>(p.x)).m_state; }
    // to be phased out
@@ -341,8 +377,10 @@ public:
    // this is an odd helper function, value in range 0 to 1
    PixelRef pickPixel(double value) const;
 public:
-   bool read(std::istream &stream);
-   bool write(std::ostream &stream);
+   // the points are stored in the format of the metagraph version given, see readPointBlocks.
+   // num_threads: 1 codes them serially, 0 uses all available cores
+   bool read(std::istream &stream, int version = METAGRAPH_VERSION, int num_threads = 1);
+   bool write(std::ostream &stream, int version = METAGRAPH_VERSION, int num_threads = 1);
    void addGridConnections(); // adds grid connections where graph does not include them
    void outputConnectionsAsCSV(std::ostream &myout, std::string delim = ",");
    void outputLinksAsCSV(std::ostream &myout, std::string delim = ",");
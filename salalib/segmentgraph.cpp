@@ -0,0 +1,48 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/segmentgraph.h"
+
+SegmentGraph::SegmentGraph(const std::vector<Connector> &connectors) {
+    // count first so that the arrays are allocated only once and at their exact size
+    size_t link_count = 0;
+    for (const Connector &connector : connectors) {
+        link_count += connector.m_back_segconns.size() + connector.m_forward_segconns.size();
+    }
+    m_offsets.reserve(connectors.size() * 2 + 1);
+    m_targets.reserve(link_count);
+    m_dirs.reserve(link_count);
+    m_weights.reserve(link_count);
+
+    auto add = [this](const std::map<SegmentRef, float> &segconns) {
+        m_offsets.push_back(static_cast<unsigned int>(m_targets.size()));
+        for (const auto &segconn : segconns) {
+            m_targets.push_back(segconn.first.ref);
+            m_dirs.push_back(segconn.first.dir);
+            m_weights.push_back(segconn.second);
+        }
+    };
+    for (const Connector &connector : connectors) {
+        add(connector.m_back_segconns);
+        add(connector.m_forward_segconns);
+    }
+    m_offsets.push_back(static_cast<unsigned int>(m_targets.size()));
+}
+
+size_t SegmentGraph::getMemoryUsage() const {
+    return sizeof(SegmentGraph) + m_offsets.capacity() * sizeof(unsigned int) + m_targets.capacity() * sizeof(int) +
+           m_dirs.capacity() * sizeof(char) + m_weights.capacity() * sizeof(float);
+}
@@ -0,0 +1,103 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "salalib/connector.h"
+
+#include <vector>
+
+/**
+ * Compact (compressed sparse row) copy of the segment connections of a set of Connectors, for the segment
+ * analyses that only need to walk from one segment to the next.
+ *
+ * The back and then the forward connections of every segment are packed one after the other, in the same
+ * order as they are found in the maps of the Connector, and the target, direction and angular weight of
+ * each connection are held in separate arrays. The graph is not updated when the Connectors change, which
+ * remain the editable form, and a ShapeGraph keeps one that it makes again once its connections have changed
+ * (see ShapeGraph::getSegmentGraph).
+ */
+class SegmentGraph {
+  public:
+    // a connection to another segment, as the key and value of the segment connection maps of Connector
+    struct Link {
+        SegmentRef segment;
+        float weight;
+    };
+
+    class Links {
+      public:
+        class iterator {
+          public:
+            iterator(const SegmentGraph &graph, size_t index) : m_graph(graph), m_index(index) {}
+            Link operator*() const {
+                return Link{SegmentRef(m_graph.m_dirs[m_index], m_graph.m_targets[m_index]),
+                            m_graph.m_weights[m_index]};
+            }
+            iterator &operator++() {
+                m_index++;
+                return *this;
+            }
+            bool operator!=(const iterator &other) const { return m_index != other.m_index; }
+
+          private:
+            const SegmentGraph &m_graph;
+            size_t m_index;
+        };
+
+        Links(const SegmentGraph &graph, size_t first, size_t last) : m_graph(graph), m_first(first), m_last(last) {}
+        iterator begin() const { return iterator(m_graph, m_first); }
+        iterator end() const { return iterator(m_graph, m_last); }
+        size_t size() const { return m_last - m_first; }
+
+      private:
+        const SegmentGraph &m_graph;
+        size_t m_first;
+        size_t m_last;
+    };
+
+    explicit SegmentGraph(const std::vector<Connector> &connectors);
+
+    size_t getSegmentCount() const { return m_offsets.size() / 2; }
+
+    /**
+     * @brief The connections at the back of a segment, as Connector::m_back_segconns. Not range checked
+     */
+    Links backLinks(int ref) const { return Links(*this, m_offsets[ref * 2], m_offsets[ref * 2 + 1]); }
+
+    /**
+     * @brief The connections at the front of a segment, as Connector::m_forward_segconns. Not range checked
+     */
+    Links forwardLinks(int ref) const { return Links(*this, m_offsets[ref * 2 + 1], m_offsets[ref * 2 + 2]); }
+
+    /**
+     * @brief All the connections of a segment, the back ones first. Not range checked
+     */
+    Links links(int ref) const { return Links(*this, m_offsets[ref * 2], m_offsets[ref * 2 + 2]); }
+
+    /**
+     * @brief Memory taken by the packed graph in bytes
+     */
+    size_t getMemoryUsage() const;
+
+  private:
+    // for each segment the index of its first back and first forward connection, followed by one past the
+    // last connection of the last segment
+    std::vector<unsigned int> m_offsets;
+    std::vector<int> m_targets;
+    std::vector<char> m_dirs;
+    std::vector<float> m_weights;
+};
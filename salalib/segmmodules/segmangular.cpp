@@ -18,6 +18,7 @@
 
 #include "salalib/segmmodules/segmangular.h"
 #include "salalib/options.h"
+#include "salalib/segmentgraph.h"
 
 #include "genlib/stringutils.h"
 
@@ -32,7 +33,7 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
     time_t atime = 0;
     if (comm) {
         qtimer(atime, 0);
-        comm->CommPostMessage(Communicator::NUM_RECORDS, map.getConnections().size());
+        comm->CommPostMessage(Communicator::NUM_RECORDS, map.getShapeCount());
     }
 
     // note: radius must be sorted lowest to highest, but if -1 occurs ("radius n") it needs to be last...
@@ -72,9 +73,10 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
         total_col.push_back(attributes.getColumnIndex(total_col_text.c_str()));
     }
 
+    const SegmentGraph &graph = map.getSegmentGraph();
     std::vector<bool> covered(map.getShapeCount());
-    size_t i = 0;
-    for (auto & iter : attributes){
+    AttributeBulkWriter writer(attributes);
+    for (size_t i = 0; i < attributes.getNumRows(); i++) {
         for (size_t j = 0; j < map.getShapeCount(); j++) {
             covered[j] = false;
         }
@@ -97,11 +99,10 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
                 total_depth[lineindex.coverage] += depth_to_line;
                 node_count[lineindex.coverage] += 1;
                 anglebins.erase(iter);
-                Connector &line = map.getConnections()[lineindex.ref];
                 if (lineindex.dir != -1) {
-                    for (auto &segconn : line.m_forward_segconns) {
-                        if (!covered[segconn.first.ref]) {
-                            double angle = depth_to_line + segconn.second;
+                    for (SegmentGraph::Link link : graph.forwardLinks(lineindex.ref)) {
+                        if (!covered[link.segment.ref]) {
+                            double angle = depth_to_line + link.weight;
                             size_t rbin = lineindex.coverage;
                             while (rbin != radii.size() && radii[rbin] != -1 && angle > radii[rbin]) {
                                 rbin++;
@@ -109,15 +110,15 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
                             if (rbin != radii.size()) {
                                 depthmapX::insert_sorted(
                                     anglebins, std::make_pair(float(angle),
-                                                              SegmentData(segconn.first, SegmentRef(), 0, 0.0, rbin)));
+                                                              SegmentData(link.segment, SegmentRef(), 0, 0.0, rbin)));
                             }
                         }
                     }
                 }
                 if (lineindex.dir != 1) {
-                    for (auto &segconn : line.m_back_segconns) {
-                        if (!covered[segconn.first.ref]) {
-                            double angle = depth_to_line + segconn.second;
+                    for (SegmentGraph::Link link : graph.backLinks(lineindex.ref)) {
+                        if (!covered[link.segment.ref]) {
+                            double angle = depth_to_line + link.weight;
                             size_t rbin = lineindex.coverage;
                             while (rbin != radii.size() && radii[rbin] != -1 && angle > radii[rbin]) {
                                 rbin++;
@@ -125,7 +126,7 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
                             if (rbin != radii.size()) {
                                 depthmapX::insert_sorted(
                                     anglebins, std::make_pair(float(angle),
-                                                              SegmentData(segconn.first, SegmentRef(), 0, 0.0, rbin)));
+                                                              SegmentData(link.segment, SegmentRef(), 0, 0.0, rbin)));
                             }
                         }
                     }
@@ -134,22 +135,21 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
                 anglebins.erase(iter);
             }
         }
-        AttributeRow &row = iter.getRow();
         // set the attributes for this node:
         int curs_node_count = 0;
         double curs_total_depth = 0.0;
         for (size_t r = 0; r < radii.size(); r++) {
             curs_node_count += node_count[r];
             curs_total_depth += total_depth[r];
-            row.setValue(count_col[r], float(curs_node_count));
+            writer.value(i, count_col[r]) = float(curs_node_count);
             if (curs_node_count > 1) {
                 // note -- node_count includes this one -- mean depth as per p.108 Social Logic of Space
                 double mean_depth = curs_total_depth / double(curs_node_count - 1);
-                row.setValue(depth_col[r], float(mean_depth));
-                row.setValue(total_col[r], float(curs_total_depth));
+                writer.value(i, depth_col[r]) = float(mean_depth);
+                writer.value(i, total_col[r]) = float(curs_total_depth);
             } else {
-                row.setValue(depth_col[r], -1);
-                row.setValue(total_col[r], -1);
+                writer.value(i, depth_col[r]) = -1;
+                writer.value(i, total_col[r]) = -1;
             }
         }
         //
@@ -161,8 +161,8 @@ bool SegmentAngular::run(Communicator *comm, ShapeGraph &map, bool) {
                 comm->CommPostMessage(Communicator::CURRENT_RECORD, i);
             }
         }
-        i++;
     }
+    writer.commit();
 
     map.setDisplayedAttribute(-2); // <- override if it's already showing
     map.setDisplayedAttribute(depth_col.back());
@@ -18,17 +18,12 @@
 
 #pragma once
 
-#include "salalib/segmmodules/segmhelpers.h"
-
-#include "salalib/isegment.h"
-
-class SegmentMetric : ISegment {
-  private:
-    double m_radius;
-    bool m_sel_only;
+#include "salalib/segmmodules/segmtopomet.h"
 
+class SegmentMetric : public SegmentTopoMet {
   public:
     std::string getAnalysisName() const override { return "Metric Analysis"; }
-    bool run(Communicator *comm, ShapeGraph &map, bool) override;
-    SegmentMetric(double radius, bool sel_only) : m_radius(radius), m_sel_only(sel_only) {}
+    SegmentMetric(std::set<double> radius_set, bool sel_only, int num_threads = 1)
+        : SegmentTopoMet(Type::METRIC, radius_set, sel_only, num_threads) {}
+    SegmentMetric(double radius, bool sel_only) : SegmentMetric(std::set<double>{radius}, sel_only) {}
 };
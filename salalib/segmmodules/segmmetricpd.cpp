@@ -17,6 +17,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "salalib/segmmodules/segmmetricpd.h"
+#include "salalib/segmentgraph.h"
 
 #include "genlib/stringutils.h"
 
@@ -48,6 +49,7 @@ bool SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
 
     attributes.insertOrResetColumn(depthcol.c_str());
 
+    const SegmentGraph &graph = map.getSegmentGraph();
     std::vector<unsigned int> seen(map.getShapeCount());
     std::vector<TopoMetSegmentRef> audittrail(map.getShapeCount());
     std::vector<int> list[512]; // 512 bins!
@@ -89,22 +91,8 @@ bool SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
             here.done = true;
         }
 
-        Connector &axline = map.getConnections().at(here.ref);
-        int connected_cursor = -2;
-
-        auto iter = axline.m_back_segconns.begin();
-        bool backsegs = true;
-
-        while (connected_cursor != -1) {
-            if (backsegs && iter == axline.m_back_segconns.end()) {
-                iter = axline.m_forward_segconns.begin();
-                backsegs = false;
-            }
-            if (!backsegs && iter == axline.m_forward_segconns.end()) {
-                break;
-            }
-
-            connected_cursor = iter->first.ref;
+        for (SegmentGraph::Link link : graph.links(here.ref)) {
+            int connected_cursor = link.segment.ref;
             if (seen[connected_cursor] > segdepth) {
                 float length = seglengths[connected_cursor];
                 seen[connected_cursor] = segdepth;
@@ -118,7 +106,6 @@ bool SegmentMetricPD::run(Communicator *, ShapeGraph &map, bool) {
                 AttributeRow &row = map.getAttributeRowFromShapeIndex(connected_cursor);
                 row.setValue(depthcol.c_str(), here.dist + length * 0.5);
             }
-            iter++;
         }
     }
 
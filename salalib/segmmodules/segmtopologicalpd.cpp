@@ -17,6 +17,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "salalib/segmmodules/segmtopologicalpd.h"
+#include "salalib/segmentgraph.h"
 
 #include "genlib/stringutils.h"
 
@@ -46,6 +47,7 @@ bool SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool) {
 
     attributes.insertOrResetColumn(depthcol.c_str());
 
+    const SegmentGraph &graph = map.getSegmentGraph();
     std::vector<unsigned int> seen(map.getShapeCount());
     std::vector<TopoMetSegmentRef> audittrail(map.getShapeCount());
     std::vector<int> list[512]; // 512 bins!
@@ -85,22 +87,8 @@ bool SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool) {
             here.done = true;
         }
 
-        Connector &axline = map.getConnections().at(here.ref);
-        int connected_cursor = -2;
-
-        auto iter = axline.m_back_segconns.begin();
-        bool backsegs = true;
-
-        while (connected_cursor != -1) {
-            if (backsegs && iter == axline.m_back_segconns.end()) {
-                iter = axline.m_forward_segconns.begin();
-                backsegs = false;
-            }
-            if (!backsegs && iter == axline.m_forward_segconns.end()) {
-                break;
-            }
-
-            connected_cursor = iter->first.ref;
+        for (SegmentGraph::Link link : graph.links(here.ref)) {
+            int connected_cursor = link.segment.ref;
             AttributeRow& row = map.getAttributeRowFromShapeIndex(connected_cursor);
             if (seen[connected_cursor] > segdepth) {
                 float length = seglengths[connected_cursor];
@@ -123,7 +111,6 @@ bool SegmentTopologicalPD::run(Communicator *, ShapeGraph &map, bool) {
                     row.setValue(depthcol.c_str(), segdepth + 1);
                 }
             }
-            iter++;
         }
     }
 
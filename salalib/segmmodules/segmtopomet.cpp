@@ -0,0 +1,488 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2000-2010, University College London, Alasdair Turner
+// Copyright (C) 2011-2012, Tasos Varoudis
+// Copyright (C) 2017-2018, Petros Koutsolampros
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/segmmodules/segmtopomet.h"
+#include "salalib/segmentgraph.h"
+
+#include "genlib/parallel.h"
+#include "genlib/stringutils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+    // a segment waiting in a bin, with the radii it was put there for
+    struct OpenSegment {
+        int ref;
+        unsigned int radiusmask;
+    };
+
+    // depths and totals of one root for one radius
+    struct RootTotals {
+        double total = 0.0;
+        double wtotal = 0.0;
+        double wtotaldepth = 0.0;
+        double totalsegdepth = 0.0;
+        double totalmetdepth = 0.0;
+    };
+
+    // what the search from every root works from
+    struct TopoMetGraph {
+        const SegmentGraph &graph;
+        // axial line refs for topological analysis
+        std::vector<int> axialrefs;
+        std::vector<float> seglengths;
+        float maxseglength;
+    };
+
+    // The working space of the search from one root, reused for all the roots. Only the entries of the segments
+    // reached from a root are reset for the next one, so starting a new root does not depend on the size of the map
+    struct TopoMetScratch {
+        // all the segments for the first radius, then all for the next and so on, so that following the trail of
+        // one radius back to the root stays as close in memory as with a single radius
+        std::vector<unsigned int> seen;
+        std::vector<TopoMetSegmentRef> audittrail;
+        // the segments reached from the current root, once for each radius they were reached within, up to the
+        // count. Made big enough to never need to grow during a search
+        std::vector<int> reached;
+        size_t reachedcount = 0;
+        std::vector<std::vector<OpenSegment>> bins;
+        // per radius
+        std::vector<RootTotals> totals;
+        // the choice values of the routes from the current root, laid out as the trail, if choice is wanted
+        std::vector<TopoMetSegmentChoice> choicevals;
+
+        TopoMetScratch(size_t segmentCount, size_t radiussize, int maxbin, bool choice)
+            : seen(segmentCount * radiussize, 0xffffffff), audittrail(segmentCount * radiussize),
+              reached(segmentCount * radiussize), bins(maxbin), totals(radiussize),
+              choicevals(choice ? segmentCount * radiussize : 0) {}
+
+        // the trail does not need resetting, as an entry is always set when its segment is first reached
+        void clear() {
+            size_t segmentCount = seen.size() / totals.size();
+            for (size_t i = 0; i < reachedcount; i++) {
+                for (size_t r = 0; r < totals.size(); r++) {
+                    seen[r * segmentCount + reached[i]] = 0xffffffff;
+                }
+            }
+            reachedcount = 0;
+            std::fill(totals.begin(), totals.end(), RootTotals());
+        }
+
+        // adds the choice values of the current root to the totals, and leaves them at zero for the next root.
+        // The routes only pass through the root and the segments it reached
+        void addChoiceTo(size_t root, std::vector<TopoMetSegmentChoice> &choicetotals) {
+            size_t segmentCount = seen.size() / totals.size();
+            auto add = [&](size_t ref) {
+                for (size_t r = 0; r < totals.size(); r++) {
+                    TopoMetSegmentChoice &choice = choicevals[r * segmentCount + ref];
+                    choicetotals[r * segmentCount + ref].choice += choice.choice;
+                    choicetotals[r * segmentCount + ref].wchoice += choice.wchoice;
+                    choice = TopoMetSegmentChoice();
+                }
+            };
+            add(root);
+            // a segment reached within several radii is listed for each, but is only added once as it is cleared
+            for (size_t i = 0; i < reachedcount; i++) {
+                add(reached[i]);
+            }
+        }
+    };
+
+    // the index of the lowest bit set in a mask that is not 0
+    inline size_t lowestBit(unsigned int mask) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // Adds a route to the choice of all the segments on the trail from a segment back to the root, for the radii in
+    // the mask. The trails of the radii mostly run together, so they are followed along the trail of the first one,
+    // and any other is only followed on its own from where it parts from it
+    inline void addChoice(const TopoMetSegmentRef *audittrail, size_t segmentCount, size_t radiussize, int ref,
+                          unsigned int radiusmask, double weight, TopoMetSegmentChoice *choicevals) {
+        size_t followed[32];
+        size_t followedcount = 0;
+        for (size_t r = 0; r < radiussize; r++) {
+            if (radiusmask & (1u << r)) {
+                followed[followedcount++] = r * segmentCount;
+            }
+        }
+        const TopoMetSegmentRef *leadtrail = audittrail + followed[0];
+        int subcur = ref;
+        while (subcur != -1) {
+            if (followedcount == 1) {
+                TopoMetSegmentChoice *leadchoice = choicevals + followed[0];
+                for (; subcur != -1; subcur = leadtrail[subcur].previous) {
+                    leadchoice[subcur].choice += 1;
+                    leadchoice[subcur].wchoice += weight;
+                }
+                break;
+            }
+            int previous = leadtrail[subcur].previous;
+            for (size_t i = 0; i < followedcount;) {
+                // in this method of choice, start and end lines are included
+                size_t index = followed[i] + subcur;
+                choicevals[index].choice += 1;
+                choicevals[index].wchoice += weight;
+                if (i != 0 && audittrail[index].previous != previous) {
+                    for (int partcur = audittrail[index].previous; partcur != -1;
+                         partcur = audittrail[followed[i] + partcur].previous) {
+                        choicevals[followed[i] + partcur].choice += 1;
+                        choicevals[followed[i] + partcur].wchoice += weight;
+                    }
+                    followed[i] = followed[--followedcount];
+                    continue;
+                }
+                i++;
+            }
+            subcur = previous;
+        }
+    }
+
+    // The search from one root for all the radii, leaving the depths in the totals of the scratch and adding the
+    // routes from the root to the choice values if given. The bins are shared by all the radii. A segment reached
+    // within some of the radii only is skipped by the others, and as the bins are taken in the same order whichever
+    // segments are in them, the segments of each radius come out in the order and at the depth they would if the
+    // radius were alone. With a single radius the loops over the radii are left to the compiler to take out
+    template <bool topological, bool singleradius>
+    void searchFromRoot(const TopoMetGraph &data, const std::vector<double> &radii, size_t cursor,
+                        TopoMetScratch &scratch, TopoMetSegmentChoice *choicevals) {
+        const size_t radiussize = singleradius ? 1 : radii.size();
+        const size_t segmentCount = data.seglengths.size();
+        const int maxbin = topological ? 2 : 512;
+        const unsigned int radiusmask = (radiussize == 32) ? ~0u : (1u << radiussize) - 1;
+        const float *seglengths = data.seglengths.data();
+        const int *axialrefs = data.axialrefs.data();
+        unsigned int *seenvals = scratch.seen.data();
+        TopoMetSegmentRef *audittrail = scratch.audittrail.data();
+        int *reached = scratch.reached.data();
+        std::vector<std::vector<OpenSegment>> &list = scratch.bins;
+
+        scratch.clear();
+        size_t reachedcount = 0;
+        double rootseglength = seglengths[cursor];
+        for (size_t r = 0; r < radiussize; r++) {
+            audittrail[r * segmentCount + cursor] =
+                TopoMetSegmentRef(cursor, Connector::SEG_CONN_ALL, rootseglength * 0.5, -1);
+        }
+        int bin = 0;
+        list[bin].push_back(OpenSegment{int(cursor), radiusmask});
+        int open = 1;
+        unsigned int segdepth = 0;
+        while (open != 0) {
+            while (list[bin].size() == 0) {
+                bin++;
+                segdepth += 1;
+                if (bin == maxbin) {
+                    bin = 0;
+                }
+            }
+            //
+            OpenSegment entry = list[bin].back();
+            list[bin].pop_back();
+            open--;
+            //
+            unsigned int livemask = 0;
+            for (unsigned int bits = entry.radiusmask; bits != 0; bits &= bits - 1) {
+                size_t r = singleradius ? 0 : lowestBit(bits);
+                TopoMetSegmentRef &here = audittrail[r * segmentCount + entry.ref];
+                if (here.done) {
+                    continue;
+                } else {
+                    here.done = true;
+                }
+                livemask |= 1u << r;
+                double len = seglengths[here.ref];
+                RootTotals &totals = scratch.totals[r];
+                totals.totalsegdepth += segdepth;
+                totals.totalmetdepth += here.dist - len * 0.5; // preloaded with length ahead
+                totals.wtotal += len;
+                if (topological) {
+                    totals.wtotaldepth += len * segdepth;
+                } else {
+                    totals.wtotaldepth += len * (here.dist - len * 0.5);
+                }
+                totals.total += 1;
+            }
+            if (livemask == 0) {
+                continue;
+            }
+            //
+            for (SegmentGraph::Link link : data.graph.links(entry.ref)) {
+                int connected_cursor = link.segment.ref;
+                if (static_cast<size_t>(connected_cursor) == cursor) {
+                    continue;
+                }
+                unsigned int pushmask = 0;
+                unsigned int choicemask = 0;
+                for (unsigned int bits = livemask; bits != 0; bits &= bits - 1) {
+                    size_t r = singleradius ? 0 : lowestBit(bits);
+                    unsigned int &seen = seenvals[r * segmentCount + connected_cursor];
+                    if (seen <= segdepth) {
+                        continue;
+                    }
+                    const TopoMetSegmentRef &here = audittrail[r * segmentCount + entry.ref];
+                    bool seenalready = (seen == 0xffffffff) ? false : true;
+                    if (!seenalready) {
+                        reached[reachedcount++] = connected_cursor;
+                    }
+                    float length = seglengths[connected_cursor];
+                    audittrail[r * segmentCount + connected_cursor] =
+                        TopoMetSegmentRef(connected_cursor, here.dir, here.dist + length, here.ref);
+                    seen = segdepth;
+                    if (radii[r] == -1 || here.dist + length < radii[r]) {
+                        pushmask |= 1u << r;
+                        if (topological && axialrefs[here.ref] != axialrefs[connected_cursor]) {
+                            seen = segdepth + 1; // this is so if another node is connected directly to this one but
+                                                 // is found later it is still handled -- note it can result in the
+                                                 // connected cursor being added twice
+                        }
+                    }
+                    // not sure why this is outside the radius restriction
+                    // (sel_only: with restricted selection set, not all lines will be labelled)
+                    // (seenalready: need to check that we're not doing this twice, given the seen can go twice)
+
+                    // Quick mod - TV
+                    if (choicevals && connected_cursor > int(cursor) &&
+                        !seenalready) { // only one way paths, saves doing this twice
+                        choicemask |= 1u << r;
+                    }
+                }
+                if (choicemask != 0) {
+                    double weight = rootseglength * seglengths[connected_cursor];
+                    if (singleradius) {
+                        for (int subcur = connected_cursor; subcur != -1; subcur = audittrail[subcur].previous) {
+                            // in this method of choice, start and end lines are included
+                            choicevals[subcur].choice += 1;
+                            choicevals[subcur].wchoice += weight;
+                        }
+                    } else {
+                        addChoice(audittrail, segmentCount, radiussize, connected_cursor, choicemask, weight,
+                                  choicevals);
+                    }
+                }
+                if (pushmask != 0) {
+                    // puts in a suitable bin ahead of us...
+                    open++;
+                    if (topological) {
+                        if (axialrefs[entry.ref] == axialrefs[connected_cursor]) {
+                            list[bin].push_back(OpenSegment{connected_cursor, pushmask});
+                        } else {
+                            list[(bin + 1) % 2].push_back(OpenSegment{connected_cursor, pushmask});
+                        }
+                    } else {
+                        // better to divide by 511 but have 512 bins...
+                        float length = seglengths[connected_cursor];
+                        list[(bin + int(floor(0.5 + 511 * length / data.maxseglength))) % 512].push_back(
+                            OpenSegment{connected_cursor, pushmask});
+                    }
+                }
+            }
+        }
+        scratch.reachedcount = reachedcount;
+    }
+} // namespace
+
+bool SegmentTopoMet::run(Communicator *comm, ShapeGraph &map, bool) {
+
+    if (m_radius_set.empty()) {
+        return true;
+    }
+
+    AttributeTable &attributes = map.getAttributeTable();
+    size_t segmentCount = map.getShapeCount();
+
+    // the radii are searched in groups of as many as there are bits in the masks of the bins
+    std::vector<double> radii(m_radius_set.begin(), m_radius_set.end());
+    const size_t groupsize = sizeof(unsigned int) * 8;
+    size_t groupcount = (radii.size() + groupsize - 1) / groupsize;
+
+    time_t atime = 0;
+
+    if (comm) {
+        qtimer(atime, 0);
+        comm->CommPostMessage(Communicator::NUM_RECORDS,
+                              groupcount * (m_sel_only ? map.getSelSet().size() : map.getShapeCount()));
+    }
+    std::atomic<int> reccount(0);
+
+    const SegmentGraph &graph = map.getSegmentGraph();
+    TopoMetGraph data{graph, {}, {}, 0.0f};
+    // quick through to find the longest seg length
+    for (size_t cursor = 0; cursor < segmentCount; cursor++) {
+        AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+        data.axialrefs.push_back(row.getValue(attributes.getColumnIndex("Axial Line Ref")));
+        data.seglengths.push_back(row.getValue(attributes.getColumnIndex("Segment Length")));
+        if (data.seglengths.back() > data.maxseglength) {
+            data.maxseglength = data.seglengths.back();
+        }
+    }
+
+    bool topological = m_type == Type::TOPOLOGICAL;
+    std::string prefix = topological ? "Topological " : "Metric ";
+    int maxbin = topological ? 2 : 512;
+
+    for (double radius : radii) {
+        std::string suffix;
+        if (radius != -1.0) {
+            suffix = dXstring::formatString(radius, " R%.f metric");
+        }
+        if (!m_sel_only) {
+            attributes.insertOrResetColumn((prefix + "Choice" + suffix).c_str());
+            attributes.insertOrResetColumn((prefix + "Choice [SLW]" + suffix).c_str());
+        }
+        attributes.insertOrResetColumn((prefix + "Mean Depth" + suffix).c_str());
+        attributes.insertOrResetColumn((prefix + "Mean Depth [SLW]" + suffix).c_str());
+        attributes.insertOrResetColumn((prefix + "Total Depth" + suffix).c_str());
+        attributes.insertOrResetColumn((prefix + "Total Nodes" + suffix).c_str());
+        attributes.insertOrResetColumn((prefix + "Total Length" + suffix).c_str());
+    }
+    // the columns are only looked up once all are in, as entering a column may move the others
+    std::vector<size_t> choice_col, wchoice_col, meandepth_col, wmeandepth_col, totald_col, total_col, wtotal_col;
+    for (double radius : radii) {
+        std::string suffix;
+        if (radius != -1.0) {
+            suffix = dXstring::formatString(radius, " R%.f metric");
+        }
+        if (!m_sel_only) {
+            choice_col.push_back(attributes.getColumnIndex(prefix + "Choice" + suffix));
+            wchoice_col.push_back(attributes.getColumnIndex(prefix + "Choice [SLW]" + suffix));
+        }
+        meandepth_col.push_back(attributes.getColumnIndex(prefix + "Mean Depth" + suffix));
+        wmeandepth_col.push_back(attributes.getColumnIndex(prefix + "Mean Depth [SLW]" + suffix));
+        totald_col.push_back(attributes.getColumnIndex(prefix + "Total Depth" + suffix));
+        total_col.push_back(attributes.getColumnIndex(prefix + "Total Nodes" + suffix));
+        wtotal_col.push_back(attributes.getColumnIndex(prefix + "Total Length" + suffix));
+    }
+    //
+    // n.b. the rows are ordered as the shapes, so the row of a shape is at its shape index
+    AttributeBulkWriter writer(attributes);
+    // all the columns are allocated up front, so that the threads only ever write to separate values
+    for (const std::vector<size_t> *cols :
+         {&choice_col, &wchoice_col, &meandepth_col, &wmeandepth_col, &totald_col, &total_col, &wtotal_col}) {
+        for (size_t col : *cols) {
+            writer.reserve(col);
+        }
+    }
+
+    int numThreads = depthmapX::resolveThreadCount(m_num_threads);
+    for (size_t first = 0; first < radii.size(); first += groupsize) {
+        std::vector<double> groupradii(radii.begin() + first,
+                                       radii.begin() + std::min(radii.size(), first + groupsize));
+        size_t radiussize = groupradii.size();
+        auto search = topological ? (radiussize == 1 ? searchFromRoot<true, true> : searchFromRoot<true, false>)
+                                  : (radiussize == 1 ? searchFromRoot<false, true> : searchFromRoot<false, false>);
+        // each thread reuses its own scratch for all its roots, and the choice values of each root are added to
+        // these strictly in root order, so that they are the same whatever the number of threads
+        std::vector<std::unique_ptr<TopoMetScratch>> scratches(numThreads);
+        std::vector<TopoMetSegmentChoice> choicevals(m_sel_only ? 0 : segmentCount * radiussize);
+        std::mutex commitMutex;
+        std::condition_variable commitTurn;
+        size_t nextCommit = 0;
+        bool aborted = false;
+        depthmapX::parallelFor(numThreads, segmentCount, [&](int threadIndex, size_t cursor) {
+            try {
+                const AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+                // n.b. choice is only ever calculated for all the roots, so no root is left without its turn
+                if (m_sel_only && !row.isSelected()) {
+                    return;
+                }
+                if (!scratches[threadIndex]) {
+                    scratches[threadIndex].reset(new TopoMetScratch(segmentCount, radiussize, maxbin, !m_sel_only));
+                }
+                TopoMetScratch &scratch = *scratches[threadIndex];
+                search(data, groupradii, cursor, scratch, m_sel_only ? nullptr : scratch.choicevals.data());
+                // also put in mean depth:
+                //
+                double rootseglength = data.seglengths[cursor];
+                for (size_t r = 0; r < radiussize; r++) {
+                    const RootTotals &totals = scratch.totals[r];
+                    double totaldepth = topological ? totals.totalsegdepth : totals.totalmetdepth;
+                    writer.value(cursor, meandepth_col[first + r]) = float(totaldepth / (totals.total - 1));
+                    writer.value(cursor, totald_col[first + r]) = float(totaldepth);
+                    writer.value(cursor, wmeandepth_col[first + r]) =
+                        float(totals.wtotaldepth / (totals.wtotal - rootseglength));
+                    writer.value(cursor, total_col[first + r]) = float(totals.total);
+                    writer.value(cursor, wtotal_col[first + r]) = float(totals.wtotal);
+                }
+                //
+                int processed = ++reccount;
+                // every thread checks for a cancel, but only the calling thread reports back
+                if (comm) {
+                    if (comm->IsCancelled()) {
+                        throw Communicator::CancelledException();
+                    }
+                    if (threadIndex == 0) {
+                        comm->CommPostMessage(Communicator::CURRENT_RECORD, processed);
+                    }
+                }
+
+                if (!m_sel_only) {
+                    std::unique_lock<std::mutex> lock(commitMutex);
+                    commitTurn.wait(lock, [&]() { return nextCommit == cursor || aborted; });
+                    if (aborted) {
+                        return;
+                    }
+                    scratch.addChoiceTo(cursor, choicevals);
+                    nextCommit++;
+                    lock.unlock();
+                    commitTurn.notify_all();
+                }
+            } catch (...) {
+                // release any thread waiting for this root to be added to the totals
+                {
+                    std::lock_guard<std::mutex> lock(commitMutex);
+                    aborted = true;
+                }
+                commitTurn.notify_all();
+                throw;
+            }
+        });
+        if (!m_sel_only) {
+            // note, I've stopped sel only from calculating choice values:
+            for (size_t cursor = 0; cursor < segmentCount; cursor++) {
+                for (size_t r = 0; r < radiussize; r++) {
+                    const TopoMetSegmentChoice &choice = choicevals[r * segmentCount + cursor];
+                    writer.value(cursor, choice_col[first + r]) = float(choice.choice);
+                    writer.value(cursor, wchoice_col[first + r]) = float(choice.wchoice);
+                }
+            }
+        }
+    }
+    writer.commit();
+
+    if (!m_sel_only) {
+        map.setDisplayedAttribute(choice_col.back());
+    } else {
+        map.setDisplayedAttribute(meandepth_col.back());
+    }
+
+    return true;
+}
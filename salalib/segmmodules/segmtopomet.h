@@ -0,0 +1,52 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2000-2010, University College London, Alasdair Turner
+// Copyright (C) 2011-2012, Tasos Varoudis
+// Copyright (C) 2017-2018, Petros Koutsolampros
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "salalib/segmmodules/segmhelpers.h"
+
+#include "salalib/isegment.h"
+
+#include <set>
+
+/**
+ * The topological and metric segment analyses, for any number of radii at once.
+ *
+ * All the radii are analysed in a single search from each root: every segment in the bins carries a mask of the
+ * radii it was reached within, and each radius keeps its own depths and trail, so the results for a radius are
+ * exactly those of analysing it on its own. The search through the bins and the connections of the segments is
+ * shared by all the radii instead of being repeated for each one. The roots are shared out between threads, each
+ * with its own working space and choice values.
+ */
+class SegmentTopoMet : ISegment {
+  public:
+    enum class Type { TOPOLOGICAL, METRIC };
+
+  private:
+    Type m_type;
+    std::set<double> m_radius_set;
+    bool m_sel_only;
+    int m_num_threads;
+
+  public:
+    bool run(Communicator *comm, ShapeGraph &map, bool) override;
+
+  protected:
+    SegmentTopoMet(Type type, std::set<double> radius_set, bool sel_only, int num_threads)
+        : m_type(type), m_radius_set(radius_set), m_sel_only(sel_only), m_num_threads(num_threads) {}
+};
@@ -18,8 +18,116 @@
 
 #include "salalib/segmmodules/segmtulip.h"
 
+#include "salalib/segmentgraph.h"
+
+#include "genlib/parallel.h"
 #include "genlib/stringutils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace {
+    // choice accumulated over all the roots, for one segment, radius and direction
+    struct ChoiceTotals {
+        double choice = 0.0;
+        double weighted_choice = 0.0;
+        double weighted_choice2 = 0.0;
+    };
+
+    // an open segment in a bin, with the order it was added in
+    struct OpenSegment {
+        SegmentData data;
+        unsigned int order;
+    };
+
+    // The working space of the analysis of one root, reused for all the roots a thread analyses. Only the
+    // entries of the segments reached from a root are reset for the next one, so starting a new root does not
+    // depend on the size of the map
+    struct TulipScratch {
+        // per segment, radius * 2 + direction
+        std::vector<AnalysisInfo> audittrail;
+        // per segment, the two directions
+        std::vector<unsigned int> uncovered;
+        // the segments reached from the current root
+        std::vector<int> reached;
+        size_t columns;
+        unsigned int radiusmask;
+
+        // Each bin is a flat array kept as a heap, from which the segment of the shortest metric depth is taken
+        // out first, and segments of equal depth in the reverse order they were added, as with insert_sorted and
+        // pop_back on the original sorted bins
+        std::vector<std::vector<OpenSegment>> bins;
+        unsigned int pushed = 0;
+
+        TulipScratch(size_t segmentCount, int radiussize, unsigned int radiusmask, int tulipBins)
+            : audittrail(segmentCount * radiussize * 2), uncovered(segmentCount * 2, radiusmask),
+              columns(radiussize * 2), radiusmask(radiusmask), bins(tulipBins) {}
+
+        AnalysisInfo &info(int ref, int column) { return audittrail[ref * columns + column]; }
+        unsigned int &coverage(int ref, int dir) { return uncovered[ref * 2 + dir]; }
+
+        void clear() {
+            for (int ref : reached) {
+                std::fill_n(audittrail.begin() + ref * columns, columns, AnalysisInfo());
+                uncovered[ref * 2] = radiusmask;
+                uncovered[ref * 2 + 1] = radiusmask;
+            }
+            reached.clear();
+            for (auto &bin : bins) {
+                bin.clear();
+            }
+            pushed = 0;
+        }
+
+        // true if a is to be taken out after b
+        static bool later(const OpenSegment &a, const OpenSegment &b) {
+            if (a.data.metricdepth != b.data.metricdepth) {
+                return a.data.metricdepth > b.data.metricdepth;
+            }
+            return a.order < b.order;
+        }
+
+        void push(size_t bin, const SegmentData &data) {
+            std::vector<OpenSegment> &open = bins[bin];
+            open.push_back(OpenSegment{data, pushed++});
+            std::push_heap(open.begin(), open.end(), later);
+        }
+
+        SegmentData pop(size_t bin) {
+            std::vector<OpenSegment> &open = bins[bin];
+            std::pop_heap(open.begin(), open.end(), later);
+            SegmentData data = open.back().data;
+            open.pop_back();
+            return data;
+        }
+
+        void sortReached() {
+            size_t segmentCount = uncovered.size() / 2;
+            if (reached.size() * 16 < segmentCount) {
+                std::sort(reached.begin(), reached.end());
+            } else {
+                // most of the map has been reached, and finding them again in order is quicker than sorting
+                reached.clear();
+                for (size_t ref = 0; ref < segmentCount; ref++) {
+                    if (uncovered[ref * 2] != radiusmask || uncovered[ref * 2 + 1] != radiusmask) {
+                        reached.push_back(static_cast<int>(ref));
+                    }
+                }
+            }
+        }
+
+        // to be called before a segment's coverage is changed, which always clears at least one bit
+        void reach(int ref) {
+            if (uncovered[ref * 2] == radiusmask && uncovered[ref * 2 + 1] == radiusmask) {
+                reached.push_back(ref);
+            }
+        }
+    };
+} // namespace
+
 bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
     if (map.getMapType() != ShapeMap::SEGMENTMAP) {
@@ -33,14 +141,14 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
     AttributeTable &attributes = map.getAttributeTable();
 
-    int processed_rows = 0;
+    std::atomic<int> processed_rows(0);
 
     time_t atime = 0;
 
     if (comm) {
         qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS,
-                              (m_sel_only ? map.getSelSet().size() : map.getConnections().size()));
+                              (m_sel_only ? map.getSelSet().size() : map.getShapeCount()));
     }
 
     // note: radius must be sorted lowest to highest, but if -1 occurs ("radius n") it needs to be last...
@@ -67,11 +175,11 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
 
     if (m_weighted_measure_col != -1) {
         weighting_col_text = attributes.getColumnName(m_weighted_measure_col);
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
+        for (size_t i = 0; i < map.getShapeCount(); i++) {
             weights.push_back(map.getAttributeRowFromShapeIndex(i).getValue(m_weighted_measure_col));
         }
     } else { // Normal run // TV
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
+        for (size_t i = 0; i < map.getShapeCount(); i++) {
             weights.push_back(1.0f);
         }
     }
@@ -82,12 +190,12 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         // cost' - similar to the angular cost
         double max_value = attributes.getColumn(routeweight_col).getStats().max;
         routeweight_col_text = attributes.getColumnName(routeweight_col);
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
+        for (size_t i = 0; i < map.getShapeCount(); i++) {
             routeweights.push_back(1.0 - (map.getAttributeRowFromShapeIndex(i).getValue(routeweight_col) /
                                           max_value)); // scale and revert!
         }
     } else { // Normal run // TV
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
+        for (size_t i = 0; i < map.getShapeCount(); i++) {
             routeweights.push_back(1.0f);
         }
     }
@@ -99,11 +207,11 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
     std::string weighting_col_text2;
     if (weighting_col2 != -1) {
         weighting_col_text2 = attributes.getColumnName(weighting_col2);
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
+        for (size_t i = 0; i < map.getShapeCount(); i++) {
             weights2.push_back(map.getAttributeRowFromShapeIndex(i).getValue(weighting_col2));
         }
     } else { // Normal run // TV
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
+        for (size_t i = 0; i < map.getShapeCount(); i++) {
             weights2.push_back(1.0f);
         }
     }
@@ -303,20 +411,6 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
     tulip_bins /= 2; // <- actually use semicircle of tulip bins
     tulip_bins += 1;
 
-    std::vector<std::vector<SegmentData>> bins(tulip_bins);
-
-    // TODO: Replace these with STL
-    AnalysisInfo ***audittrail;
-    unsigned int **uncovered;
-    audittrail = new AnalysisInfo **[map.getConnections().size()];
-    uncovered = new unsigned int *[map.getConnections().size()];
-    for (size_t i = 0; i < map.getConnections().size(); i++) {
-        audittrail[i] = new AnalysisInfo *[radius_unconverted.size()];
-        for (size_t j = 0; j < radius_unconverted.size(); j++) {
-            audittrail[i][j] = new AnalysisInfo[2];
-        }
-        uncovered[i] = new unsigned int[2];
-    }
     std::vector<double> radius;
     for (r = 0; r < radius_unconverted.size(); r++) {
         if (m_radius_type == Options::RADIUS_ANGULAR && radius_unconverted[r] != -1) {
@@ -329,7 +423,7 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
     int length_col = attributes.getColumnIndex("Segment Length");
     std::vector<float> lengths;
     if (length_col != -1) {
-        for (size_t i = 0; i < map.getConnections().size(); i++) {
+        for (size_t i = 0; i < map.getShapeCount(); i++) {
             AttributeRow& row = map.getAttributeRowFromShapeIndex(i);
             lengths.push_back(row.getValue(length_col));
         }
@@ -341,346 +435,403 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
         radiusmask |= (1 << i);
     }
 
-    for (size_t cursor = 0; cursor < map.getConnections().size(); cursor++) {
-        AttributeRow &row =
-            map.getAttributeRowFromShapeIndex(cursor);
+    size_t segmentCount = map.getShapeCount();
+    const SegmentGraph &graph = map.getSegmentGraph();
 
-        if (m_sel_only) {
-            // could use m_selection_set.searchindex(rowid) to find
-            // if this row is selected as m_selection_set is ordered for axial and segment maps, etc
-            // BUT, actually quicker to check the tag in the attributes that shows it's selected
-            if (!row.isSelected()) {
-                continue;
-            }
+    // n.b. the rows are ordered as the shapes, so the row of a shape is at its shape index
+    AttributeBulkWriter writer(attributes);
+    // all the columns are allocated up front, so that the threads only ever write to separate values
+    for (const std::vector<int> *cols : {&choice_col, &w_choice_col, &w_choice_col2, &count_col, &integ_col,
+                                         &w_integ_col, &td_col, &w_td_col, &total_weight_col}) {
+        for (int col : *cols) {
+            writer.reserve(col);
         }
+    }
 
-        for (int k = 0; k < tulip_bins; k++) {
-            bins[k].clear();
-        }
-        for (size_t j = 0; j < map.getConnections().size(); j++) {
-            for (int dir = 0; dir < 2; dir++) {
-                for (int k = 0; k < radiussize; k++) {
-                    audittrail[j][k][dir].clearLine();
-                }
-                uncovered[j][dir] = radiusmask;
-            }
-        }
+    int numThreads = depthmapX::resolveThreadCount(m_num_threads);
+    std::vector<std::unique_ptr<TulipScratch>> scratches(numThreads);
 
-        double rootseglength = row.getValue(length_col);
-        double rootweight = (m_weighted_measure_col != -1) ? weights[cursor] : 0.0;
+    // in non-interactive mode a cancel stops the analysis, but retains the roots processed so far
+    std::atomic<bool> stopped(false);
 
-        // setup: direction 0 (both ways), segment i, previous -1, segdepth (step depth) 0, metricdepth 0.5 *
-        // rootseglength, bin 0
-        SegmentData segmentData(0, cursor, SegmentRef(), 0, 0.5 * rootseglength, radiusmask);
-        auto it = std::lower_bound(bins[0].begin(), bins[0].end(), segmentData);
-        if (it == bins[0].end() || segmentData != *it) {
-            bins[0].insert(it, segmentData);
+    // analyses one root, leaving its choice values in the scratch of the thread, and returns whether it did
+    auto analyseRoot = [&](int threadIndex, size_t cursor) {
+        if (!scratches[threadIndex]) {
+            scratches[threadIndex].reset(new TulipScratch(segmentCount, radiussize, radiusmask, tulip_bins));
         }
-        // this version below is only designed to be used temporarily --
-        // could be on an option?
-        // bins[0].push_back(SegmentData(0,rowid,SegmentRef(),0,0.0,radiusmask));
-        int depthlevel = 0;
-        int opencount = 1;
-        size_t currentbin = 0;
-        while (opencount) {
-            while (!bins[currentbin].size()) {
-                depthlevel++;
-                currentbin++;
-                if (currentbin == static_cast<size_t>(tulip_bins)) {
-                    currentbin = 0;
-                }
-            }
-            SegmentData lineindex = bins[currentbin].back();
-            bins[currentbin].pop_back();
-            //
-            opencount--;
-
-            int ref = lineindex.ref;
-            int dir = (lineindex.dir == 1) ? 0 : 1;
-            int coverage = lineindex.coverage & uncovered[ref][dir];
-            if (coverage != 0) {
-                int rbin = 0;
-                int rbinbase;
-                if (lineindex.previous.ref != -1) {
-                    uncovered[ref][dir] &= ~coverage;
-                    while (((coverage >> rbin) & 0x1) == 0)
-                        rbin++;
-                    rbinbase = rbin;
-                    while (rbin < radiussize) {
-                        if (((coverage >> rbin) & 0x1) == 1) {
-                            audittrail[ref][rbin][dir].depth = depthlevel;
-                            audittrail[ref][rbin][dir].previous = lineindex.previous;
-                            audittrail[lineindex.previous.ref][rbin][(lineindex.previous.dir == 1) ? 0 : 1].leaf =
-                                false;
-                        }
-                        rbin++;
+        TulipScratch &scratch = *scratches[threadIndex];
+
+        const AttributeRow &row = map.getAttributeRowFromShapeIndex(cursor);
+
+        // could use m_selection_set.searchindex(rowid) to find
+        // if this row is selected as m_selection_set is ordered for axial and segment maps, etc
+        // BUT, actually quicker to check the tag in the attributes that shows it's selected
+        bool analyse = !stopped && (!m_sel_only || row.isSelected());
+        if (analyse) {
+            scratch.clear();
+
+            double rootseglength = row.getValue(length_col);
+            double rootweight = (m_weighted_measure_col != -1) ? weights[cursor] : 0.0;
+
+            // setup: direction 0 (both ways), segment i, previous -1, segdepth (step depth) 0, metricdepth 0.5 *
+            // rootseglength, bin 0
+            scratch.push(0, SegmentData(0, cursor, SegmentRef(), 0, 0.5 * rootseglength, radiusmask));
+            // this version below is only designed to be used temporarily --
+            // could be on an option?
+            // bins[0].push_back(SegmentData(0,rowid,SegmentRef(),0,0.0,radiusmask));
+            int depthlevel = 0;
+            int opencount = 1;
+            size_t currentbin = 0;
+            while (opencount) {
+                while (scratch.bins[currentbin].empty()) {
+                    depthlevel++;
+                    currentbin++;
+                    if (currentbin == static_cast<size_t>(tulip_bins)) {
+                        currentbin = 0;
                     }
-                } else {
-                    rbinbase = 0;
-                    uncovered[ref][0] &= ~coverage;
-                    uncovered[ref][1] &= ~coverage;
                 }
-                Connector &line = map.getConnections()[ref];
-                float seglength;
-                int extradepth;
-                if (lineindex.dir != -1) {
-                    for (auto &segconn : line.m_forward_segconns) {
-                        rbin = rbinbase;
-                        SegmentRef conn = segconn.first;
-                        if ((uncovered[conn.ref][(conn.dir == 1 ? 0 : 1)] & coverage) != 0) {
-                            // EF routeweight*
-                            if (routeweight_col != -1) { // EF here we do the weighting of the angular cost by the
-                                                         // weight of the next segment
-                                // note that the content of the routeweights array is scaled between 0 and 1 and is
-                                // reversed
-                                // such that: = 1.0-(attributes.getValue(i, routeweight_col)/max_value)
-                                extradepth = (int)floor(segconn.second * tulip_bins * 0.5 * routeweights[conn.ref]);
-                            }
-                            //*EF routeweight
-                            else {
-                                extradepth = (int)floor(segconn.second * tulip_bins * 0.5);
+                SegmentData lineindex = scratch.pop(currentbin);
+                //
+                opencount--;
+
+                int ref = lineindex.ref;
+                int dir = (lineindex.dir == 1) ? 0 : 1;
+                int coverage = lineindex.coverage & scratch.coverage(ref, dir);
+                if (coverage != 0) {
+                    scratch.reach(ref);
+                    int rbin = 0;
+                    int rbinbase;
+                    if (lineindex.previous.ref != -1) {
+                        scratch.coverage(ref, dir) &= ~coverage;
+                        while (((coverage >> rbin) & 0x1) == 0)
+                            rbin++;
+                        rbinbase = rbin;
+                        while (rbin < radiussize) {
+                            if (((coverage >> rbin) & 0x1) == 1) {
+                                AnalysisInfo &info = scratch.info(ref, rbin * 2 + dir);
+                                info.depth = depthlevel;
+                                info.previous = lineindex.previous;
+                                scratch.info(lineindex.previous.ref, rbin * 2 + ((lineindex.previous.dir == 1) ? 0 : 1))
+                                    .leaf = false;
                             }
-                            seglength = lengths[conn.ref];
-                            switch (m_radius_type) {
-                            case Options::RADIUS_ANGULAR:
-                                while (rbin != radiussize && radius[rbin] != -1 &&
-                                       depthlevel + extradepth > (int)radius[rbin]) {
-                                    rbin++;
+                            rbin++;
+                        }
+                    } else {
+                        rbinbase = 0;
+                        scratch.coverage(ref, 0) &= ~coverage;
+                        scratch.coverage(ref, 1) &= ~coverage;
+                    }
+                    float seglength;
+                    int extradepth;
+                    if (lineindex.dir != -1) {
+                        for (SegmentGraph::Link link : graph.forwardLinks(ref)) {
+                            rbin = rbinbase;
+                            SegmentRef conn = link.segment;
+                            if ((scratch.coverage(conn.ref, (conn.dir == 1 ? 0 : 1)) & coverage) != 0) {
+                                // EF routeweight*
+                                if (routeweight_col != -1) { // EF here we do the weighting of the angular cost
+                                                             // by the weight of the next segment
+                                    // note that the content of the routeweights array is scaled between 0 and 1
+                                    // and is reversed
+                                    // such that: = 1.0-(attributes.getValue(i, routeweight_col)/max_value)
+                                    extradepth =
+                                        (int)floor(link.weight * tulip_bins * 0.5 * routeweights[conn.ref]);
                                 }
-                                break;
-                            case Options::RADIUS_METRIC:
-                                while (rbin != radiussize && radius[rbin] != -1 &&
-                                       lineindex.metricdepth + seglength * 0.5 > radius[rbin]) {
-                                    rbin++;
+                                //*EF routeweight
+                                else {
+                                    extradepth = (int)floor(link.weight * tulip_bins * 0.5);
                                 }
-                                break;
-                            case Options::RADIUS_STEPS:
-                                if (rbin != radiussize && radius[rbin] != -1 &&
-                                    lineindex.segdepth >= (int)radius[rbin]) {
-                                    rbin++;
+                                seglength = lengths[conn.ref];
+                                switch (m_radius_type) {
+                                case Options::RADIUS_ANGULAR:
+                                    while (rbin != radiussize && radius[rbin] != -1 &&
+                                           depthlevel + extradepth > (int)radius[rbin]) {
+                                        rbin++;
+                                    }
+                                    break;
+                                case Options::RADIUS_METRIC:
+                                    while (rbin != radiussize && radius[rbin] != -1 &&
+                                           lineindex.metricdepth + seglength * 0.5 > radius[rbin]) {
+                                        rbin++;
+                                    }
+                                    break;
+                                case Options::RADIUS_STEPS:
+                                    if (rbin != radiussize && radius[rbin] != -1 &&
+                                        lineindex.segdepth >= (int)radius[rbin]) {
+                                        rbin++;
+                                    }
+                                    break;
+                                }
+                                if ((coverage >> rbin) != 0) {
+                                    SegmentData sd(conn, SegmentRef(1, lineindex.ref), lineindex.segdepth + 1,
+                                                   lineindex.metricdepth + seglength, (coverage >> rbin) << rbin);
+                                    size_t bin = (currentbin + tulip_bins + extradepth) % tulip_bins;
+                                    scratch.push(bin, sd);
+                                    opencount++;
                                 }
-                                break;
-                            }
-                            if ((coverage >> rbin) != 0) {
-                                SegmentData sd(conn, SegmentRef(1, lineindex.ref), lineindex.segdepth + 1,
-                                               lineindex.metricdepth + seglength, (coverage >> rbin) << rbin);
-                                size_t bin = (currentbin + tulip_bins + extradepth) % tulip_bins;
-                                depthmapX::insert_sorted(bins[bin], sd);
-                                opencount++;
                             }
                         }
                     }
-                }
-                if (lineindex.dir != 1) {
-                    for (auto &segconn : line.m_back_segconns) {
-                        rbin = rbinbase;
-                        SegmentRef conn = segconn.first;
-                        if ((uncovered[conn.ref][(conn.dir == 1 ? 0 : 1)] & coverage) != 0) {
-                            // EF routeweight*
-                            if (routeweight_col != -1) { // EF here we do the weighting of the angular cost by the
-                                                         // weight of the next segment
-                                // note that the content of the routeweights array is scaled between 0 and 1 and is
-                                // reversed
-                                // such that: = 1.0-(attributes.getValue(i, routeweight_col)/max_value)
-                                extradepth = (int)floor(segconn.second * tulip_bins * 0.5 * routeweights[conn.ref]);
-                            }
-                            //*EF routeweight
-                            else {
-                                extradepth = (int)floor(segconn.second * tulip_bins * 0.5);
-                            }
-                            seglength = lengths[conn.ref];
-                            switch (m_radius_type) {
-                            case Options::RADIUS_ANGULAR:
-                                while (rbin != radiussize && radius[rbin] != -1 &&
-                                       depthlevel + extradepth > (int)radius[rbin]) {
-                                    rbin++;
+                    if (lineindex.dir != 1) {
+                        for (SegmentGraph::Link link : graph.backLinks(ref)) {
+                            rbin = rbinbase;
+                            SegmentRef conn = link.segment;
+                            if ((scratch.coverage(conn.ref, (conn.dir == 1 ? 0 : 1)) & coverage) != 0) {
+                                // EF routeweight*
+                                if (routeweight_col != -1) { // EF here we do the weighting of the angular cost
+                                                             // by the weight of the next segment
+                                    // note that the content of the routeweights array is scaled between 0 and 1
+                                    // and is reversed
+                                    // such that: = 1.0-(attributes.getValue(i, routeweight_col)/max_value)
+                                    extradepth =
+                                        (int)floor(link.weight * tulip_bins * 0.5 * routeweights[conn.ref]);
                                 }
-                                break;
-                            case Options::RADIUS_METRIC:
-                                while (rbin != radiussize && radius[rbin] != -1 &&
-                                       lineindex.metricdepth + seglength * 0.5 > radius[rbin]) {
-                                    rbin++;
+                                //*EF routeweight
+                                else {
+                                    extradepth = (int)floor(link.weight * tulip_bins * 0.5);
                                 }
-                                break;
-                            case Options::RADIUS_STEPS:
-                                if (rbin != radiussize && radius[rbin] != -1 &&
-                                    lineindex.segdepth >= (int)radius[rbin]) {
-                                    rbin++;
+                                seglength = lengths[conn.ref];
+                                switch (m_radius_type) {
+                                case Options::RADIUS_ANGULAR:
+                                    while (rbin != radiussize && radius[rbin] != -1 &&
+                                           depthlevel + extradepth > (int)radius[rbin]) {
+                                        rbin++;
+                                    }
+                                    break;
+                                case Options::RADIUS_METRIC:
+                                    while (rbin != radiussize && radius[rbin] != -1 &&
+                                           lineindex.metricdepth + seglength * 0.5 > radius[rbin]) {
+                                        rbin++;
+                                    }
+                                    break;
+                                case Options::RADIUS_STEPS:
+                                    if (rbin != radiussize && radius[rbin] != -1 &&
+                                        lineindex.segdepth >= (int)radius[rbin]) {
+                                        rbin++;
+                                    }
+                                    break;
+                                }
+                                if ((coverage >> rbin) != 0) {
+                                    SegmentData sd(conn, SegmentRef(-1, lineindex.ref), lineindex.segdepth + 1,
+                                                   lineindex.metricdepth + seglength, (coverage >> rbin) << rbin);
+                                    size_t bin = (currentbin + tulip_bins + extradepth) % tulip_bins;
+                                    scratch.push(bin, sd);
+                                    opencount++;
                                 }
-                                break;
-                            }
-                            if ((coverage >> rbin) != 0) {
-                                SegmentData sd(conn, SegmentRef(-1, lineindex.ref), lineindex.segdepth + 1,
-                                               lineindex.metricdepth + seglength, (coverage >> rbin) << rbin);
-                                size_t bin = (currentbin + tulip_bins + extradepth) % tulip_bins;
-                                depthmapX::insert_sorted(bins[bin], sd);
-                                opencount++;
                             }
                         }
                     }
                 }
             }
-        }
-        // set the attributes for this node:
-        for (int k = 0; k < radiussize; k++) {
-            // note, curs_total_depth must use double as mantissa can get too long for int in large systems
-            double curs_node_count = 0.0, curs_total_depth = 0.0;
-            double curs_total_weight = 0.0, curs_total_weighted_depth = 0.0;
-            size_t j;
-            for (j = 0; j < map.getConnections().size(); j++) {
-                // find dir according
-                bool m0 = ((uncovered[j][0] >> k) & 0x1) == 0;
-                bool m1 = ((uncovered[j][1] >> k) & 0x1) == 0;
-                if ((m0 | m1) != 0) {
-                    int dir;
-                    if (m0 & m1) {
-                        // dir is the one with the lowest depth:
-                        if (audittrail[j][k][0].depth < audittrail[j][k][1].depth)
-                            dir = 0;
-                        else
-                            dir = 1;
-                    } else {
-                        // dir is simply the one that's filled in:
-                        dir = m0 ? 0 : 1;
-                    }
-                    curs_node_count++;
-                    curs_total_depth += audittrail[j][k][dir].depth;
-                    curs_total_weight += weights[j];
-                    curs_total_weighted_depth += audittrail[j][k][dir].depth * weights[j];
-                    //
-                    if (m_choice && audittrail[j][k][dir].leaf) {
-                        // note, graph may be directed (e.g., for one way streets), so both ways must be included from
-                        // now on:
-                        SegmentRef here = SegmentRef(dir == 0 ? 1 : -1, j);
-                        if (here.ref != static_cast<int>(cursor)) {
-                            int choicecount = 0;
-                            double choiceweight = 0.0;
-                            // EFEF*
-                            double choiceweight2 = 0.0;
-                            //*EFEF
-                            while (here.ref != static_cast<int>(cursor)) { // not rowid means not the current root for the path
-                                int heredir = (here.dir == 1) ? 0 : 1;
-                                // each node has the existing choicecount and choiceweight from previously encountered
-                                // nodes added to it
-                                audittrail[here.ref][k][heredir].choice += choicecount;
-                                // nb, weighted values calculated anyway to save time on 'if'
-                                audittrail[here.ref][k][heredir].weighted_choice += choiceweight;
+            // only the reached segments can contribute, and they are summed in segment order as any other
+            // order could change the rounding of the totals
+            scratch.sortReached();
+            // set the attributes for this node:
+            for (int k = 0; k < radiussize; k++) {
+                // note, curs_total_depth must use double as mantissa can get too long for int in large systems
+                double curs_node_count = 0.0, curs_total_depth = 0.0;
+                double curs_total_weight = 0.0, curs_total_weighted_depth = 0.0;
+                for (int j : scratch.reached) {
+                    // find dir according
+                    bool m0 = ((scratch.coverage(j, 0) >> k) & 0x1) == 0;
+                    bool m1 = ((scratch.coverage(j, 1) >> k) & 0x1) == 0;
+                    if ((m0 | m1) != 0) {
+                        int dir;
+                        if (m0 & m1) {
+                            // dir is the one with the lowest depth:
+                            if (scratch.info(j, k * 2).depth < scratch.info(j, k * 2 + 1).depth)
+                                dir = 0;
+                            else
+                                dir = 1;
+                        } else {
+                            // dir is simply the one that's filled in:
+                            dir = m0 ? 0 : 1;
+                        }
+                        int depth = scratch.info(j, k * 2 + dir).depth;
+                        curs_node_count++;
+                        curs_total_depth += depth;
+                        curs_total_weight += weights[j];
+                        curs_total_weighted_depth += depth * weights[j];
+                        //
+                        if (m_choice && scratch.info(j, k * 2 + dir).leaf) {
+                            // note, graph may be directed (e.g., for one way streets), so both ways must be
+                            // included from now on:
+                            SegmentRef here = SegmentRef(dir == 0 ? 1 : -1, j);
+                            if (here.ref != static_cast<int>(cursor)) {
+                                int choicecount = 0;
+                                double choiceweight = 0.0;
                                 // EFEF*
-                                audittrail[here.ref][k][heredir].weighted_choice2 += choiceweight2;
+                                double choiceweight2 = 0.0;
                                 //*EFEF
-                                // if the node hasn't been encountered before, the choicecount and choiceweight is
-                                // incremented for all remaining nodes to be encountered on the backwards route from it
-                                if (!audittrail[here.ref][k][heredir].choicecovered) {
-                                    // this node has not been encountered before: this adds the choicecount and weight
-                                    // for this node, and flags it as visited
-                                    choicecount++;
-                                    choiceweight += weights[here.ref] * rootweight;
+                                while (here.ref != static_cast<int>(cursor)) { // not rowid means not the current
+                                                                               // root for the path
+                                    AnalysisInfo &info = scratch.info(here.ref, k * 2 + ((here.dir == 1) ? 0 : 1));
+                                    // each node has the existing choicecount and choiceweight from previously
+                                    // encountered nodes added to it
+                                    info.choice += choicecount;
+                                    // nb, weighted values calculated anyway to save time on 'if'
+                                    info.weighted_choice += choiceweight;
                                     // EFEF*
-                                    choiceweight2 += weights2[here.ref] * rootweight; // rootweight!
+                                    info.weighted_choice2 += choiceweight2;
                                     //*EFEF
-
-                                    audittrail[here.ref][k][heredir].choicecovered = true;
-                                    // note, for weighted choice, the start and end points have choice added to them:
-                                    if (m_weighted_measure_col != -1) {
-                                        audittrail[here.ref][k][heredir].weighted_choice +=
-                                            (weights[here.ref] * rootweight) / 2.0;
+                                    // if the node hasn't been encountered before, the choicecount and
+                                    // choiceweight is incremented for all remaining nodes to be encountered on
+                                    // the backwards route from it
+                                    if (!info.choicecovered) {
+                                        // this node has not been encountered before: this adds the choicecount
+                                        // and weight for this node, and flags it as visited
+                                        choicecount++;
+                                        choiceweight += weights[here.ref] * rootweight;
                                         // EFEF*
-                                        if (weighting_col2 != -1) {
-                                            audittrail[here.ref][k][heredir].weighted_choice2 +=
-                                                (weights2[here.ref] * rootweight) / 2.0; // rootweight!
-                                        }
+                                        choiceweight2 += weights2[here.ref] * rootweight; // rootweight!
                                         //*EFEF
+
+                                        info.choicecovered = true;
+                                        // note, for weighted choice, the start and end points have choice added
+                                        // to them:
+                                        if (m_weighted_measure_col != -1) {
+                                            info.weighted_choice += (weights[here.ref] * rootweight) / 2.0;
+                                            // EFEF*
+                                            if (weighting_col2 != -1) {
+                                                info.weighted_choice2 +=
+                                                    (weights2[here.ref] * rootweight) / 2.0; // rootweight!
+                                            }
+                                            //*EFEF
+                                        }
                                     }
+                                    here = info.previous;
                                 }
-                                here = audittrail[here.ref][k][heredir].previous;
-                            }
-                            // note, for weighted choice, the start and end points have choice added to them:
-                            // (this is the summed weight for all starting nodes encountered in this path)
-                            if (m_weighted_measure_col != -1) {
-                                audittrail[here.ref][k][(here.dir == 1) ? 0 : 1].weighted_choice += choiceweight / 2.0;
-                                // EFEF*
-                                if (weighting_col2 != -1) {
-                                    audittrail[here.ref][k][(here.dir == 1) ? 0 : 1].weighted_choice2 +=
-                                        choiceweight2 / 2.0;
+                                // note, for weighted choice, the start and end points have choice added to them:
+                                // (this is the summed weight for all starting nodes encountered in this path)
+                                if (m_weighted_measure_col != -1) {
+                                    AnalysisInfo &info = scratch.info(here.ref, k * 2 + ((here.dir == 1) ? 0 : 1));
+                                    info.weighted_choice += choiceweight / 2.0;
+                                    // EFEF*
+                                    if (weighting_col2 != -1) {
+                                        info.weighted_choice2 += choiceweight2 / 2.0;
+                                    }
+                                    //*EFEF
                                 }
-                                //*EFEF
                             }
                         }
                     }
                 }
-            }
-            double total_depth_conv = curs_total_depth / ((tulip_bins - 1.0f) * 0.5f);
-            double total_weighted_depth_conv = curs_total_weighted_depth / ((tulip_bins - 1.0f) * 0.5f);
-            //
-            row.setValue(count_col[k], float(curs_node_count));
-            if (curs_node_count > 1) {
-                // for dmap 8 and above, mean depth simply isn't calculated as for radius measures it is meaningless
-                row.setValue(td_col[k], total_depth_conv);
-                if (m_weighted_measure_col != -1) {
-                    row.setValue(total_weight_col[k], float(curs_total_weight));
-                    row.setValue(w_td_col[k], float(total_weighted_depth_conv));
-                }
-            } else {
-                row.setValue(td_col[k], -1);
-                if (m_weighted_measure_col != -1) {
-                    row.setValue(total_weight_col[k], -1.0f);
-                    row.setValue(w_td_col[k], -1.0f);
-                }
-            }
-            // for dmap 10 an above, integration is included!
-            if (total_depth_conv > 1e-9) {
-                row.setValue(integ_col[k], (float)(curs_node_count * curs_node_count / total_depth_conv));
-                if (m_weighted_measure_col != -1) {
-                    row.setValue(w_integ_col[k],
-                                 (float)(curs_total_weight * curs_total_weight / total_weighted_depth_conv));
+                double total_depth_conv = curs_total_depth / ((tulip_bins - 1.0f) * 0.5f);
+                double total_weighted_depth_conv = curs_total_weighted_depth / ((tulip_bins - 1.0f) * 0.5f);
+                //
+                writer.value(cursor, count_col[k]) = float(curs_node_count);
+                if (curs_node_count > 1) {
+                    // for dmap 8 and above, mean depth simply isn't calculated as for radius measures it is
+                    // meaningless
+                    writer.value(cursor, td_col[k]) = total_depth_conv;
+                    if (m_weighted_measure_col != -1) {
+                        writer.value(cursor, total_weight_col[k]) = float(curs_total_weight);
+                        writer.value(cursor, w_td_col[k]) = float(total_weighted_depth_conv);
+                    }
+                } else {
+                    writer.value(cursor, td_col[k]) = -1;
+                    if (m_weighted_measure_col != -1) {
+                        writer.value(cursor, total_weight_col[k]) = -1.0f;
+                        writer.value(cursor, w_td_col[k]) = -1.0f;
+                    }
                 }
-            } else {
-                row.setValue(integ_col[k], -1);
-                if (m_weighted_measure_col != -1) {
-                    row.setValue(w_integ_col[k], -1.0f);
+                // for dmap 10 an above, integration is included!
+                if (total_depth_conv > 1e-9) {
+                    writer.value(cursor, integ_col[k]) =
+                        (float)(curs_node_count * curs_node_count / total_depth_conv);
+                    if (m_weighted_measure_col != -1) {
+                        writer.value(cursor, w_integ_col[k]) =
+                            (float)(curs_total_weight * curs_total_weight / total_weighted_depth_conv);
+                    }
+                } else {
+                    writer.value(cursor, integ_col[k]) = -1;
+                    if (m_weighted_measure_col != -1) {
+                        writer.value(cursor, w_integ_col[k]) = -1.0f;
+                    }
                 }
             }
         }
         //
-        processed_rows++;
-        //
+        // every thread checks for a cancel, but only the calling thread reports back
         if (comm) {
-            if (qtimer(atime, 500)) {
-                if (comm->IsCancelled()) {
-                    // interactive is usual Depthmap: throw an exception if cancelled
-                    if (interactive) {
-                        for (size_t i = 0; i < map.getConnections().size(); i++) {
-                            for (size_t j = 0; j < size_t(radiussize); j++) {
-                                delete[] audittrail[i][j];
-                            }
-                            delete[] audittrail[i];
-                            delete[] uncovered[i];
+            if (comm->IsCancelled()) {
+                // interactive is usual Depthmap: throw an exception if cancelled
+                if (interactive) {
+                    throw Communicator::CancelledException();
+                } else {
+                    // in non-interactive mode, retain what's been processed already
+                    stopped = true;
+                }
+            }
+            if (threadIndex == 0 && qtimer(atime, 500)) {
+                comm->CommPostMessage(Communicator::CURRENT_RECORD, cursor);
+            }
+        }
+
+        if (analyse) {
+            processed_rows++;
+        }
+        return analyse;
+    };
+
+    // choice values are cumulative over all the roots, and are added to these from each root in turn,
+    // per segment, radius * 2 + direction
+    std::vector<ChoiceTotals> choicetotals(m_choice ? segmentCount * radiussize * 2 : 0);
+
+    // The roots may be analysed in any order, but each adds its choice values to the totals strictly in root
+    // order, so that the totals are the same whatever the number of threads
+    std::mutex commitMutex;
+    std::condition_variable commitTurn;
+    size_t nextCommit = 0;
+    bool aborted = false;
+
+    depthmapX::parallelFor(numThreads, segmentCount, [&](int threadIndex, size_t cursor) {
+        try {
+            bool analysed = analyseRoot(threadIndex, cursor);
+
+            if (m_choice) {
+                std::unique_lock<std::mutex> lock(commitMutex);
+                commitTurn.wait(lock, [&]() { return nextCommit == cursor || aborted; });
+                if (aborted) {
+                    return;
+                }
+                if (analysed) {
+                    TulipScratch &scratch = *scratches[threadIndex];
+                    for (int j : scratch.reached) {
+                        for (int col = 0; col < radiussize * 2; col++) {
+                            const AnalysisInfo &info = scratch.info(j, col);
+                            ChoiceTotals &totals = choicetotals[j * radiussize * 2 + col];
+                            totals.choice += info.choice;
+                            totals.weighted_choice += info.weighted_choice;
+                            totals.weighted_choice2 += info.weighted_choice2;
                         }
-                        delete[] audittrail;
-                        delete[] uncovered;
-                        throw Communicator::CancelledException();
-                    } else {
-                        // in non-interactive mode, retain what's been processed already
-                        break;
                     }
                 }
-                comm->CommPostMessage(Communicator::CURRENT_RECORD, cursor);
+                nextCommit++;
+                lock.unlock();
+                commitTurn.notify_all();
+            }
+        } catch (...) {
+            // release any thread waiting for this root to be added to the totals
+            {
+                std::lock_guard<std::mutex> lock(commitMutex);
+                aborted = true;
             }
+            commitTurn.notify_all();
+            throw;
         }
-    }
+    });
+
     if (m_choice) {
-        for (size_t cursor = 0; cursor < map.getConnections().size(); cursor++) {
-            AttributeRow &row =
-                attributes.getRow(AttributeKey(depthmapX::getMapAtIndex(map.getAllShapes(), cursor)->first));
+        for (size_t cursor = 0; cursor < segmentCount; cursor++) {
             for (size_t r = 0; r < radius.size(); r++) {
+                const ChoiceTotals *totals = &choicetotals[(cursor * radiussize + r) * 2];
                 // according to Eva's correction, total choice and total weighted choice
                 // should already have been accumulated by radius at this stage
-                double total_choice = audittrail[cursor][r][0].choice + audittrail[cursor][r][1].choice;
-                double total_weighted_choice =
-                    audittrail[cursor][r][0].weighted_choice + audittrail[cursor][r][1].weighted_choice;
+                double total_choice = totals[0].choice + totals[1].choice;
+                double total_weighted_choice = totals[0].weighted_choice + totals[1].weighted_choice;
                 // EFEF*
-                double total_weighted_choice2 =
-                    audittrail[cursor][r][0].weighted_choice2 + audittrail[cursor][r][1].weighted_choice2;
+                double total_weighted_choice2 = totals[0].weighted_choice2 + totals[1].weighted_choice2;
                 //*EFEF
 
                 // normalised choice now excluded for two reasons:
@@ -692,27 +843,19 @@ bool SegmentTulip::run(Communicator *comm, ShapeGraph &map, bool) {
                 // implementation
                 //
                 //
-                row.setValue(choice_col[r], float(total_choice));
+                writer.value(cursor, choice_col[r]) = float(total_choice);
                 if (m_weighted_measure_col != -1) {
-                    row.setValue(w_choice_col[r], float(total_weighted_choice));
+                    writer.value(cursor, w_choice_col[r]) = float(total_weighted_choice);
                     // EFEF*
                     if (weighting_col2 != -1) {
-                        row.setValue(w_choice_col2[r], float(total_weighted_choice2));
+                        writer.value(cursor, w_choice_col2[r]) = float(total_weighted_choice2);
                     }
                     //*EFEF
                 }
             }
         }
     }
-    for (size_t i = 0; i < map.getConnections().size(); i++) {
-        for (int j = 0; j < radiussize; j++) {
-            delete[] audittrail[i][j];
-        }
-        delete[] audittrail[i];
-        delete[] uncovered[i];
-    }
-    delete[] audittrail;
-    delete[] uncovered;
+    writer.commit();
 
     map.setDisplayedAttribute(-2); // <- override if it's already showing
     if (m_choice) {
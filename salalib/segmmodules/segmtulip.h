@@ -31,14 +31,16 @@ class SegmentTulip : ISegment {
     int m_radius_type;
     bool m_choice;
     bool m_interactive;
+    int m_num_threads;
 
   public:
     std::string getAnalysisName() const override { return "Tulip Analysis"; }
     bool run(Communicator *comm, ShapeGraph &map, bool) override;
     SegmentTulip(std::set<double> radius_set, bool sel_only, int tulip_bins, int weighted_measure_col, int radius_type,
-                 bool choice, bool interactive = false, int weighted_measure_col2 = -1, int routeweight_col = -1)
+                 bool choice, bool interactive = false, int weighted_measure_col2 = -1, int routeweight_col = -1,
+                 int num_threads = 1)
         : m_radius_set(radius_set), m_sel_only(sel_only), m_tulip_bins(tulip_bins),
           m_weighted_measure_col(weighted_measure_col), m_radius_type(radius_type), m_choice(choice),
           m_interactive(interactive), m_weighted_measure_col2(weighted_measure_col2),
-          m_routeweight_col(routeweight_col) {}
+          m_routeweight_col(routeweight_col), m_num_threads(num_threads) {}
 };
@@ -17,6 +17,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "salalib/segmmodules/segmtulipdepth.h"
+#include "salalib/segmentgraph.h"
 
 #include "genlib/stringutils.h"
 
@@ -33,8 +34,9 @@ bool SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
     // in order to duplicate previous code (using a semicircle of tulip bins)
     size_t tulip_bins = 513;
 
-    std::vector<bool> covered(map.getConnections().size());
-    for (size_t i = 0; i < map.getConnections().size(); i++) {
+    const SegmentGraph &graph = map.getSegmentGraph();
+    std::vector<bool> covered(map.getShapeCount());
+    for (size_t i = 0; i < map.getShapeCount(); i++) {
        covered[i] = false;
     }
     std::vector<std::vector<SegmentData> > bins(tulip_bins);
@@ -76,28 +78,27 @@ bool SegmentTulipDepth::run(Communicator *, ShapeGraph &map, bool) {
        opencount--;
        if (!covered[lineindex.ref]) {
           covered[lineindex.ref] = true;
-          Connector& line = map.getConnections()[lineindex.ref];
           // convert depth from tulip_bins normalised to standard angle
           // (note the -1)
           double depth_to_line = depthlevel / ((tulip_bins - 1) * 0.5);
           map.getAttributeRowFromShapeIndex(lineindex.ref).setValue(stepdepth_col,depth_to_line);
           int extradepth;
           if (lineindex.dir != -1) {
-             for (auto& segconn: line.m_forward_segconns) {
-                if (!covered[segconn.first.ref]) {
-                   extradepth = (int) floor(segconn.second * tulip_bins * 0.5);
+             for (SegmentGraph::Link link: graph.forwardLinks(lineindex.ref)) {
+                if (!covered[link.segment.ref]) {
+                   extradepth = (int) floor(link.weight * tulip_bins * 0.5);
                    bins[(currentbin + tulip_bins + extradepth) % tulip_bins].push_back(
-                       SegmentData(segconn.first,lineindex.ref,lineindex.segdepth+1,0.0,0));
+                       SegmentData(link.segment,lineindex.ref,lineindex.segdepth+1,0.0,0));
                    opencount++;
                 }
              }
           }
           if (lineindex.dir != 1) {
-             for (auto& segconn: line.m_back_segconns) {
-                if (!covered[segconn.first.ref]) {
-                   extradepth = (int) floor(segconn.second * tulip_bins * 0.5);
+             for (SegmentGraph::Link link: graph.backLinks(lineindex.ref)) {
+                if (!covered[link.segment.ref]) {
+                   extradepth = (int) floor(link.weight * tulip_bins * 0.5);
                    bins[(currentbin + tulip_bins + extradepth) % tulip_bins].push_back(
-                       SegmentData(segconn.first,lineindex.ref,lineindex.segdepth+1,0.0,0));
+                       SegmentData(link.segment,lineindex.ref,lineindex.segdepth+1,0.0,0));
                    opencount++;
                  }
              }
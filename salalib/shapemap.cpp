@@ -187,6 +187,7 @@ void ShapeMap::init(int size, const QtRegion &r) {
 // this makes an exact copy, keep the reference numbers and so on:
 
 void ShapeMap::copy(const ShapeMap &sourcemap, int copyflags) {
+    connectionsChanged();
     if ((copyflags & ShapeMap::COPY_GEOMETRY) == ShapeMap::COPY_GEOMETRY) {
         m_shapes.clear();
         init(sourcemap.m_shapes.size(), sourcemap.m_region);
@@ -244,6 +245,7 @@ void ShapeMap::copy(const ShapeMap &sourcemap, int copyflags) {
 
 // Zaps all memory structures, apart from mapinfodata
 void ShapeMap::clearAll() {
+    connectionsChanged();
     if (m_bsp_root) {
         delete m_bsp_root;
         m_bsp_root = NULL;
@@ -633,6 +635,7 @@ bool ShapeMap::convertPointsToPolys(double poly_radius, bool selected_only) {
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool ShapeMap::moveShape(int shaperef, const Line &line, bool undoing) {
+    connectionsChanged();
     bool bounds_good = true;
 
     auto shapeIter = m_shapes.find(shaperef);
@@ -766,6 +769,7 @@ bool ShapeMap::moveShape(int shaperef, const Line &line, bool undoing) {
 // some functions to make a polygon from the UI
 
 int ShapeMap::polyBegin(const Line &line) {
+    connectionsChanged();
     // add geometry
     bool bounds_good = true;
     if (!(m_region.contains_touch(line.start()) && m_region.contains_touch(line.end()))) {
@@ -902,8 +906,12 @@ bool ShapeMap::removeSelected() {
 
     // pray that the selection set is in order!
     // (it should be: code currently uses add() throughout)
-    for (auto &shapeRef : m_selection_set) {
-        removeShape(shapeRef);
+    {
+        // the rows of the attribute table are only put back in order once all the shapes are gone
+        AttributeRowChanges rowChanges(*m_attributes);
+        for (auto &shapeRef : m_selection_set) {
+            removeShape(shapeRef);
+        }
     }
     m_selection_set.clear();
 
@@ -913,6 +921,7 @@ bool ShapeMap::removeSelected() {
 }
 
 void ShapeMap::removeShape(int shaperef, bool undoing) {
+    connectionsChanged();
     // remove shape from four keys: the pixel grid, the poly list, the attributes and the connections
     removePolyPixels(shaperef); // done first, as all interface references use this list
 
@@ -988,6 +997,7 @@ void ShapeMap::removeShape(int shaperef, bool undoing) {
 }
 
 void ShapeMap::undo() {
+    connectionsChanged();
     if (m_undobuffer.size() == 0) {
         return;
     }
@@ -1986,6 +1996,7 @@ int ShapeMap::getClosestLine(const Point2f &p) const {
 
 // code to add intersections when shapes are added to the graph one by one:
 int ShapeMap::connectIntersected(int rowid, bool linegraph) {
+    connectionsChanged();
     auto shaperefIter = depthmapX::getMapAtIndex(m_shapes, rowid);
     int conn_col = m_attributes->getOrInsertLockedColumn("Connectivity");
     int leng_col = -1;
@@ -2100,6 +2111,7 @@ std::vector<int> ShapeMap::getShapeConnections(int shaperef, double tolerance) {
 
 // for any geometry, not just line to lines
 void ShapeMap::makeShapeConnections() {
+    connectionsChanged();
     if (m_hasgraph) {
         m_connectors.clear();
         m_attributes->clear();
@@ -2271,6 +2283,7 @@ bool ShapeMap::selectionToLayer(const std::string &name) {
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool ShapeMap::read(std::istream &stream) {
+    connectionsChanged();
     // turn off selection / editable etc
     m_editable = false;
     m_show = true; // <- by default show
@@ -2856,6 +2869,7 @@ bool ShapeMap::linkShapesFromRefs(int ref1, int ref2, bool refresh) {
 }
 
 bool ShapeMap::linkShapes(int index1, int index2, bool refresh) {
+    connectionsChanged();
     int conn_col = m_attributes->getOrInsertLockedColumn("Connectivity");
     bool update = false;
 
@@ -2900,6 +2914,7 @@ bool ShapeMap::linkShapes(int index1, int index2, bool refresh) {
 // this version is used to link segments in segment analysis
 // note it only links one way!
 bool ShapeMap::linkShapes(int id1, int dir1, int id2, int dir2, float weight) {
+    connectionsChanged();
     bool success = false;
     Connector &connector = m_connectors[size_t(id1)];
     if (dir1 == 1) {
@@ -2948,6 +2963,7 @@ bool ShapeMap::unlinkShapesFromRefs(int ref1, int ref2, bool refresh) {
 
 // note: uses rowids rather than shape key
 bool ShapeMap::unlinkShapes(int index1, int index2, bool refresh) {
+    connectionsChanged();
     int conn_col = m_attributes->getColumnIndex("Connectivity");
     bool update = false;
 
@@ -2989,6 +3005,7 @@ bool ShapeMap::unlinkShapes(int index1, int index2, bool refresh) {
 }
 
 bool ShapeMap::unlinkShapesByKey(int key1, int key2, bool refresh) {
+    connectionsChanged();
     int conn_col = m_attributes->getColumnIndex("Connectivity");
     bool update = false;
 
@@ -3033,6 +3050,7 @@ bool ShapeMap::unlinkShapesByKey(int key1, int key2, bool refresh) {
 }
 
 bool ShapeMap::clearLinks() {
+    connectionsChanged();
     for (size_t i = 0; i < m_unlinks.size(); i++) {
         OrderedIntPair link = m_unlinks[i];
         depthmapX::insert_sorted(m_connectors[size_t(link.a)].m_connections, link.b);
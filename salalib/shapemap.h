@@ -256,6 +256,9 @@ class ShapeMap : public PixelBase {
     // Note: this list is stored PACKED for optimal performance on graph analysis
     // ALWAYS check it is in the same order as the shape list and attribute table
     std::vector<Connector> m_connectors;
+    // counts the edits of the connectors, so that anything made from them can tell when it is out of date
+    size_t m_connectionsVersion = 0;
+    void connectionsChanged() { m_connectionsVersion++; }
     //
     // for geometric operations
     double m_tolerance;
@@ -270,6 +273,7 @@ private:
         m_shapes = std::move(other.m_shapes);
         m_hasgraph = other.m_hasgraph;
         m_connectors = std::move(other.m_connectors);
+        connectionsChanged();
         m_links = std::move(other.m_links);
         m_unlinks = std::move(other.m_unlinks);
         m_mapinfodata = std::move(other.m_mapinfodata);
@@ -422,7 +426,11 @@ private:
     bool makeBSPtree() const;
     //
     const std::vector<Connector> &getConnections() const { return m_connectors; }
-    std::vector<Connector> &getConnections() { return m_connectors; }
+    // n.b. anything can be changed through this, so the connections are taken to have changed
+    std::vector<Connector> &getConnections() {
+        connectionsChanged();
+        return m_connectors;
+    }
     //
     bool isAllLineMap() const { return m_map_type == ALLLINEMAP; }
     bool isSegmentMap() const { return m_map_type == SEGMENTMAP; }
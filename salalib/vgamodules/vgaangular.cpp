@@ -51,8 +51,15 @@ bool VGAAngular::run(Communicator *comm, PointMap &map, bool) {
     // TODO: Binary compatibility. Remove in re-examination
     total_depth_col = attributes.getOrInsertColumn(total_detph_col_text.c_str());
 
+    AttributeBulkWriter writer(attributes);
+
     int count = 0;
 
+    depthmapX::EpochMatrix<AngularPoint> points(map.getRows(), map.getCols());
+    const VisibilityGraph &graph = map.getVisibilityGraph();
+    // turns are in quarter turns, and most steps from a cell add little or nothing to the angle
+    depthmapX::BucketQueue<AngularTriple> search_list(0.25);
+
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
@@ -64,12 +71,7 @@ bool VGAAngular::run(Communicator *comm, PointMap &map, bool) {
                     continue;
                 }
 
-                // TODO: Break out miscs/dist/cumangle into local variables and remove from Point class
-                for (auto &point : map.getPoints()) {
-                    point.m_misc = 0;
-                    point.m_dist = 0.0f;
-                    point.m_cumangle = -1.0f;
-                }
+                points.clear();
 
                 float total_angle = 0.0f;
                 int total_nodes = 0;
@@ -77,41 +79,41 @@ bool VGAAngular::run(Communicator *comm, PointMap &map, bool) {
                 // note that m_misc is used in a different manner to analyseGraph / PointDepth
                 // here it marks the node as used in calculation only
 
-                std::set<AngularTriple> search_list;
-                search_list.insert(AngularTriple(0.0f, curs, NoPixel));
-                map.getPoint(curs).m_cumangle = 0.0f;
-                while (search_list.size()) {
-                    std::set<AngularTriple>::iterator it = search_list.begin();
-                    AngularTriple here = *it;
-                    search_list.erase(it);
+                search_list.clear();
+                search_list.push(0.0, AngularTriple(0.0f, curs, NoPixel));
+                points(curs.y, curs.x).cumangle = 0.0f;
+                while (!search_list.empty()) {
+                    AngularTriple here = search_list.pop();
                     if (m_radius != -1.0 && here.angle > m_radius) {
                         break;
                     }
                     Point &p = map.getPoint(here.pixel);
+                    AngularPoint &ap = points(here.pixel.y, here.pixel.x);
                     // nb, the filled check is necessary as diagonals seem to be stored with 'gaps' left in
-                    if (p.filled() && p.m_misc != ~0) {
-                        p.getNode().extractAngular(search_list, &map, here);
-                        p.m_misc = ~0;
+                    if (p.filled() && ap.misc != ~0) {
+                        extractAngular(graph, search_list, map, here, points);
+                        ap.misc = ~0;
                         if (!p.getMergePixel().empty()) {
-                            Point &p2 = map.getPoint(p.getMergePixel());
-                            if (p2.m_misc != ~0) {
-                                p2.m_cumangle = p.m_cumangle;
-                                p2.getNode().extractAngular(search_list, &map,
-                                                            AngularTriple(here.angle, p.getMergePixel(), NoPixel));
-                                p2.m_misc = ~0;
+                            PixelRef mergePixel = p.getMergePixel();
+                            AngularPoint &ap2 = points(mergePixel.y, mergePixel.x);
+                            if (ap2.misc != ~0) {
+                                ap2.cumangle = ap.cumangle;
+                                extractAngular(graph, search_list, map,
+                                               AngularTriple(here.angle, mergePixel, NoPixel), points);
+                                ap2.misc = ~0;
                             }
                         }
-                        total_angle += p.m_cumangle;
+                        total_angle += ap.cumangle;
                         total_nodes += 1;
                     }
                 }
 
-                AttributeRow &row = map.getAttributeTable().getRow(AttributeKey(curs));
+                size_t row = attributes.getRowIndex(AttributeKey(curs));
                 if (total_nodes > 0) {
-                    row.setValue(mean_depth_col, float(double(total_angle) / double(total_nodes)));
+                    writer.value(row, mean_depth_col) = float(double(total_angle) / double(total_nodes));
                 }
-                row.setValue(total_depth_col, total_angle);
-                row.setValue(count_col, float(total_nodes));
+                writer.value(row, total_depth_col) = total_angle;
+                writer.value(row, count_col) = float(total_nodes);
 
                 count++; // <- increment count
             }
@@ -126,8 +128,35 @@ bool VGAAngular::run(Communicator *comm, PointMap &map, bool) {
         }
     }
 
+    writer.commit();
+
     map.setDisplayedAttribute(-2);
     map.setDisplayedAttribute(mean_depth_col);
 
     return true;
 }
+
+void VGAAngular::extractAngular(const VisibilityGraph &graph, depthmapX::BucketQueue<AngularTriple> &pixels, PointMap &map,
+                                const AngularTriple &curs, depthmapX::EpochMatrix<AngularPoint> &points) {
+    if (curs.angle == 0.0f || map.getPoint(curs.pixel).blocked() || map.blockedAdjacent(curs.pixel)) {
+        float cursCumAngle = points(curs.pixel.y, curs.pixel.x).cumangle;
+        for (const VisibilityGraph::BinRuns &bin : graph.bins(curs.pixel)) {
+            for (const PixelVec &pixVec : graph.runs(bin)) {
+                for (PixelRef pix = pixVec.start(); pix.col(bin.dir) <= pixVec.end().col(bin.dir);) {
+                    AngularPoint &pt = points(pix.y, pix.x);
+                    if (pt.misc == 0) {
+                        // n.b. dmap v4.06r now sets angle in range 0 to 4 (1 = 90 degrees)
+                        float ang = (curs.lastpixel == NoPixel)
+                                        ? 0.0f
+                                        : (float)(angle(pix, curs.pixel, curs.lastpixel) / (M_PI * 0.5));
+                        if (pt.cumangle == -1.0 || curs.angle + ang < pt.cumangle) {
+                            pt.cumangle = cursCumAngle + ang;
+                            pixels.push(pt.cumangle, AngularTriple(pt.cumangle, pix, curs.pixel));
+                        }
+                    }
+                    pix.move(bin.dir);
+                }
+            }
+        }
+    }
+}
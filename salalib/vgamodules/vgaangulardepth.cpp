@@ -27,42 +27,38 @@ bool VGAAngularDepth::run(Communicator *, PointMap &map, bool) {
     // n.b., insert columns sets values to -1 if the column already exists
     int path_angle_col = attributes.insertOrResetColumn("Angular Step Depth");
 
-    for (auto iter = attributes.begin(); iter != attributes.end(); iter++) {
-        PixelRef pix = iter->getKey().value;
-        map.getPoint(pix).m_misc = 0;
-        map.getPoint(pix).m_dist = 0.0f;
-        map.getPoint(pix).m_cumangle = -1.0f;
-    }
+    depthmapX::EpochMatrix<AngularPoint> points(map.getRows(), map.getCols());
+    const VisibilityGraph &graph = map.getVisibilityGraph();
 
-    std::set<AngularTriple> search_list; // contains root point
+    depthmapX::BucketQueue<AngularTriple> search_list(0.25); // contains root point
 
     for (auto &sel : map.getSelSet()) {
-        search_list.insert(AngularTriple(0.0f, sel, NoPixel));
-        map.getPoint(sel).m_cumangle = 0.0f;
+        search_list.push(0.0, AngularTriple(0.0f, sel, NoPixel));
+        PixelRef selPixel = sel;
+        points(selPixel.y, selPixel.x).cumangle = 0.0f;
     }
 
     // note that m_misc is used in a different manner to analyseGraph / PointDepth
     // here it marks the node as used in calculation only
-    while (search_list.size()) {
-        std::set<AngularTriple>::iterator it = search_list.begin();
-        AngularTriple here = *it;
-        search_list.erase(it);
+    while (!search_list.empty()) {
+        AngularTriple here = search_list.pop();
         Point &p = map.getPoint(here.pixel);
+        AngularPoint &ap = points(here.pixel.y, here.pixel.x);
         // nb, the filled check is necessary as diagonals seem to be stored with 'gaps' left in
-        if (p.filled() && p.m_misc != ~0) {
-            p.getNode().extractAngular(search_list, &map, here);
-            p.m_misc = ~0;
+        if (p.filled() && ap.misc != ~0) {
+            extractAngular(graph, search_list, map, here, points);
+            ap.misc = ~0;
             AttributeRow &row = map.getAttributeTable().getRow(AttributeKey(here.pixel));
-            row.setValue(path_angle_col, float(p.m_cumangle));
+            row.setValue(path_angle_col, float(ap.cumangle));
             if (!p.getMergePixel().empty()) {
-                Point &p2 = map.getPoint(p.getMergePixel());
-                if (p2.m_misc != ~0) {
-                    p2.m_cumangle = p.m_cumangle;
+                AngularPoint &ap2 = points(p.getMergePixel().y, p.getMergePixel().x);
+                if (ap2.misc != ~0) {
+                    ap2.cumangle = ap.cumangle;
                     AttributeRow &mergePixelRow = map.getAttributeTable().getRow(AttributeKey(p.getMergePixel()));
-                    mergePixelRow.setValue(path_angle_col, float(p2.m_cumangle));
-                    p2.getNode().extractAngular(search_list, &map,
-                                                AngularTriple(here.angle, p.getMergePixel(), NoPixel));
-                    p2.m_misc = ~0;
+                    mergePixelRow.setValue(path_angle_col, float(ap2.cumangle));
+                    extractAngular(graph, search_list, map,
+                                   AngularTriple(here.angle, p.getMergePixel(), NoPixel), points);
+                    ap2.misc = ~0;
                 }
             }
         }
@@ -73,3 +69,28 @@ bool VGAAngularDepth::run(Communicator *, PointMap &map, bool) {
 
     return true;
 }
+
+void VGAAngularDepth::extractAngular(const VisibilityGraph &graph, depthmapX::BucketQueue<AngularTriple> &pixels, PointMap &map,
+                                     const AngularTriple &curs, depthmapX::EpochMatrix<AngularPoint> &points) {
+    if (curs.angle == 0.0f || map.getPoint(curs.pixel).blocked() || map.blockedAdjacent(curs.pixel)) {
+        float cursCumAngle = points(curs.pixel.y, curs.pixel.x).cumangle;
+        for (const VisibilityGraph::BinRuns &bin : graph.bins(curs.pixel)) {
+            for (const PixelVec &pixVec : graph.runs(bin)) {
+                for (PixelRef pix = pixVec.start(); pix.col(bin.dir) <= pixVec.end().col(bin.dir);) {
+                    AngularPoint &pt = points(pix.y, pix.x);
+                    if (pt.misc == 0) {
+                        // n.b. dmap v4.06r now sets angle in range 0 to 4 (1 = 90 degrees)
+                        float ang = (curs.lastpixel == NoPixel)
+                                        ? 0.0f
+                                        : (float)(angle(pix, curs.pixel, curs.lastpixel) / (M_PI * 0.5));
+                        if (pt.cumangle == -1.0 || curs.angle + ang < pt.cumangle) {
+                            pt.cumangle = cursCumAngle + ang;
+                            pixels.push(pt.cumangle, AngularTriple(pt.cumangle, pix, curs.pixel));
+                        }
+                    }
+                    pix.move(bin.dir);
+                }
+            }
+        }
+    }
+}
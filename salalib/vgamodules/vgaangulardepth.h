@@ -21,8 +21,22 @@
 #include "salalib/ivga.h"
 #include "salalib/pixelref.h"
 #include "salalib/pointdata.h"
+#include "salalib/visibilitygraph.h"
+
+#include "genlib/bucketqueue.h"
+#include "genlib/epochmatrix.h"
 
 class VGAAngularDepth : IVGA {
+  private:
+    // the traversal state of a cell, relative to the selection
+    struct AngularPoint {
+        int misc = 0;           // set to ~0 once the cell has been used in the calculation
+        float cumangle = -1.0f; // smallest cumulative angle found so far, -1 if not reached yet
+    };
+
+    void extractAngular(const VisibilityGraph &graph, depthmapX::BucketQueue<AngularTriple> &pixels, PointMap &map,
+                        const AngularTriple &curs, depthmapX::EpochMatrix<AngularPoint> &points);
+
   public:
     std::string getAnalysisName() const override { return "Angular Depth"; }
     bool run(Communicator *comm, PointMap &map, bool) override;
@@ -19,8 +19,12 @@
 #include "salalib/vgamodules/vgaisovist.h"
 #include "salalib/isovist.h"
 
+#include "genlib/parallel.h"
 #include "genlib/stringutils.h"
 
+#include <atomic>
+#include <memory>
+
 bool VGAIsovist::run(Communicator *comm, PointMap &map, bool simple_version) {
     map.m_hasIsovistAnalysis = false;
 
@@ -29,7 +33,11 @@ bool VGAIsovist::run(Communicator *comm, PointMap &map, bool simple_version) {
         comm->CommPostMessage(Communicator::NUM_STEPS, 2);
         comm->CommPostMessage(Communicator::CURRENT_STEP, 1);
     }
-    BSPNode bspRoot = makeBSPtree(comm, map.getDrawingFiles());
+    BSPNode emptyRoot;
+    BSPNode *bspRoot = m_bspCache.getTree(comm, map.getDrawingFiles());
+    if (!bspRoot) {
+        bspRoot = &emptyRoot;
+    }
 
     AttributeTable &attributes = map.getAttributeTable();
 
@@ -40,90 +48,77 @@ bool VGAIsovist::run(Communicator *comm, PointMap &map, bool simple_version) {
         qtimer(atime, 0);
         comm->CommPostMessage(Communicator::NUM_RECORDS, map.getFilledPointCount());
     }
-    int count = 0;
 
+    // the cells in the order the serial analysis would take them
+    std::vector<PixelRef> cells;
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
             if (map.getPoint(curs).filled()) {
-                count++;
-                if (map.getPoint(curs).contextfilled() && !curs.iseven()) {
-                    continue;
-                }
-                Isovist isovist;
-                isovist.makeit(&bspRoot, map.depixelate(curs), map.getRegion(), 0, 0);
-
-                AttributeRow &row = attributes.getRow(AttributeKey(curs));
-                isovist.setData(attributes, row, simple_version);
-                Node &node = map.getPoint(curs).getNode();
-                std::vector<PixelRef> *occ = node.m_occlusion_bins;
-                for (size_t k = 0; k < 32; k++) {
-                    occ[k].clear();
-                    node.bin(static_cast<int>(k)).setOccDistance(0.0f);
-                }
-                for (size_t k = 0; k < isovist.getOcclusionPoints().size(); k++) {
-                    const PointDist &pointdist = isovist.getOcclusionPoints().at(k);
-                    int bin = whichbin(pointdist.m_point - map.depixelate(curs));
-                    // only occlusion bins with a certain distance recorded (arbitrary scale note!)
-                    if (pointdist.m_dist > 1.5) {
-                        PixelRef pix = map.pixelate(pointdist.m_point);
-                        if (pix != curs) {
-                            occ[bin].push_back(pix);
-                        }
-                    }
-                    node.bin(bin).setOccDistance(static_cast<float>(pointdist.m_dist));
-                }
-            }
-            if (comm) {
-                if (qtimer(atime, 500)) {
-                    if (comm->IsCancelled()) {
-                        throw Communicator::CancelledException();
-                    }
-                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
-                }
+                cells.push_back(curs);
             }
         }
     }
-    map.m_hasIsovistAnalysis = true;
-
-    return true;
-}
 
-BSPNode VGAIsovist::makeBSPtree(Communicator *communicator, const std::vector<SpacePixelFile>& drawingFiles) {
-    std::vector<TaggedLine> partitionlines;
-    for (const auto &pixelGroup : drawingFiles) {
-        for (const auto &pixel : pixelGroup.m_spacePixels) {
-            // chooses the first editable layer it can find:
-            if (pixel.isShown()) {
-                auto refShapes = pixel.getAllShapes();
-                int k = -1;
-                for (const auto &refShape : refShapes) {
-                    k++;
-                    std::vector<Line> newLines = refShape.second.getAsLines();
-                    // I'm not sure what the tagging was meant for any more,
-                    // tagging at the moment tags the *polygon* it was original attached to
-                    // must check it is not a zero length line:
-                    for (const Line &line : newLines) {
-                        if (line.length() > 0.0) {
-                            partitionlines.push_back(TaggedLine(line, k));
-                        }
+    // the BSP tree is only read while making isovists, and each cell has its own occlusion bins and its own
+    // slot for the measures, so the threads only share the isovist of the thread, kept to reuse its memory
+    int num_threads = depthmapX::resolveThreadCount(m_num_threads);
+    std::vector<std::unique_ptr<Isovist>> isovists(static_cast<size_t>(num_threads));
+    std::vector<Isovist::Measures> measures(cells.size());
+    std::atomic<int> count(0);
+
+    depthmapX::parallelFor(num_threads, cells.size(), [&](int thread_index, size_t cell_index) {
+        PixelRef curs = cells[cell_index];
+        int done = ++count;
+        if (!(map.getPoint(curs).contextfilled() && !curs.iseven())) {
+            std::unique_ptr<Isovist> &isovist = isovists[static_cast<size_t>(thread_index)];
+            if (!isovist) {
+                isovist = std::unique_ptr<Isovist>(new Isovist());
+            }
+            isovist->makeit(bspRoot, map.depixelate(curs), map.getRegion(), 0, 0);
+            measures[cell_index] = isovist->getMeasures();
+
+            Node &node = map.getPoint(curs).getNode();
+            std::vector<PixelRef> *occ = node.m_occlusion_bins;
+            for (size_t k = 0; k < 32; k++) {
+                occ[k].clear();
+                node.bin(static_cast<int>(k)).setOccDistance(0.0f);
+            }
+            for (size_t k = 0; k < isovist->getOcclusionPoints().size(); k++) {
+                const PointDist &pointdist = isovist->getOcclusionPoints().at(k);
+                int bin = whichbin(pointdist.m_point - map.depixelate(curs));
+                // only occlusion bins with a certain distance recorded (arbitrary scale note!)
+                if (pointdist.m_dist > 1.5) {
+                    PixelRef pix = map.pixelate(pointdist.m_point);
+                    if (pix != curs) {
+                        occ[bin].push_back(pix);
                     }
                 }
+                node.bin(bin).setOccDistance(static_cast<float>(pointdist.m_dist));
             }
         }
-    }
-
-    BSPNode bspRoot;
-    if (partitionlines.size()) {
-
-        time_t atime = 0;
-        if(communicator) {
-            communicator->CommPostMessage(Communicator::NUM_RECORDS, static_cast<int>(partitionlines.size()));
-            qtimer(atime, 0);
+        // every thread checks for a cancel, but only the calling thread reports back
+        if (comm) {
+            if (comm->IsCancelled()) {
+                throw Communicator::CancelledException();
+            }
+            if (thread_index == 0 && qtimer(atime, 500)) {
+                comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+            }
         }
-
-        BSPTree::make(communicator, atime, partitionlines, &bspRoot);
+    }, 64);
+
+    // the measures are entered in row order, as in the serial analysis, so the columns and their stats
+    // come out the same
+    for (size_t cell_index = 0; cell_index < cells.size(); cell_index++) {
+        PixelRef curs = cells[cell_index];
+        if (map.getPoint(curs).contextfilled() && !curs.iseven()) {
+            continue;
+        }
+        AttributeRow &row = attributes.getRow(AttributeKey(curs));
+        Isovist::setMeasures(attributes, row, measures[cell_index], simple_version);
     }
+    map.m_hasIsovistAnalysis = true;
 
-    return bspRoot;
+    return true;
 }
@@ -18,13 +18,21 @@
 
 #pragma once
 
+#include "salalib/bspcache.h"
 #include "salalib/ivga.h"
 #include "salalib/pixelref.h"
 #include "salalib/pointdata.h"
 
 class VGAIsovist : IVGA {
+  private:
+    BSPCache m_ownBSPCache;
+    BSPCache &m_bspCache;
+    int m_num_threads;
+
   public:
+    // the BSP tree is taken from the cache given, if any, so that it is not made again for each analysis
+    VGAIsovist(BSPCache *bspCache = nullptr, int numThreads = 1)
+        : m_bspCache(bspCache ? *bspCache : m_ownBSPCache), m_num_threads(numThreads) {}
     std::string getAnalysisName() const override { return "Isovist Analysis"; }
     bool run(Communicator *comm, PointMap &map, bool simple_version) override;
-    BSPNode makeBSPtree(Communicator *communicator, const std::vector<SpacePixelFile> &drawingFiles);
 };
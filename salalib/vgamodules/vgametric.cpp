@@ -20,6 +20,8 @@
 
 #include "genlib/stringutils.h"
 
+#include <cmath>
+
 // This is a slow algorithm, but should give the correct answer
 // for demonstrative purposes
 
@@ -52,85 +54,143 @@ bool VGAMetric::run(Communicator *comm, PointMap &map, bool) {
     std::string count_col_text = std::string("Metric Node Count") + radius_text;
     int count_col = attributes.insertOrResetColumn(count_col_text.c_str());
 
+    AttributeBulkWriter writer(attributes);
+
     int count = 0;
 
-    for (size_t i = 0; i < map.getCols(); i++) {
-        for (size_t j = 0; j < map.getRows(); j++) {
-            PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
+    // with a radius, a search cannot get further from its root than the radius as no path is shorter than the
+    // straight line, so the map is analysed one tile at a time with the search state kept to a window around
+    // the root. The window has a cell to spare on each side for rounding. Merged points are connected
+    // whatever their distance, so a map with merges is always searched as a whole
+    int reach = -1;
+    if (m_radius != -1.0 && !VGATiles::hasMergedPoints(map)) {
+        double radius_cells = std::floor(m_radius / map.getSpacing()) + 2.0;
+        if (radius_cells < double(map.getCols() + map.getRows())) {
+            reach = static_cast<int>(radius_cells);
+        }
+    }
+    VGATiles tiles(map, reach, m_tile_size);
+    // the windows are packed from the Nodes, so the packed graph of the whole map is let go of while they are
+    // analysed, and made again when it is next asked for
+    if (tiles.isTiled()) {
+        map.releaseVisibilityGraph();
+    }
 
-            if (map.getPoint(curs).filled()) {
+    depthmapX::EpochMatrix<MetricPoint> points = tiles.makeRootWindow<MetricPoint>();
+    VisibilityGraph tile_graph;
+    // path lengths are in grid units, so a unit bucket holds the ring of cells one step out
+    depthmapX::BucketQueue<MetricTriple> search_list(1.0);
 
-                if (m_gates_only) {
-                    count++;
-                    continue;
-                }
+    for (const VGATiles::Tile &tile : tiles.getTiles()) {
+        if (tiles.isTiled()) {
+            tile_graph.build(map, tile.windowFirst, tile.windowLast);
+        }
+        const VisibilityGraph &graph = tiles.isTiled() ? tile_graph : map.getVisibilityGraph();
 
-                // TODO: Break out miscs/dist/cumangle into local variables and remove from Point class
-                for (auto &point : map.getPoints()) {
-                    point.m_misc = 0;
-                    point.m_dist = -1.0f;
-                    point.m_cumangle = 0.0f;
-                }
+        for (short i = tile.first.x; i <= tile.last.x; i++) {
+            for (short j = tile.first.y; j <= tile.last.y; j++) {
+                PixelRef curs = PixelRef(i, j);
+
+                if (map.getPoint(curs).filled()) {
 
-                float euclid_depth = 0.0f;
-                float total_depth = 0.0f;
-                float total_angle = 0.0f;
-                int total_nodes = 0;
-
-                // note that m_misc is used in a different manner to analyseGraph / PointDepth
-                // here it marks the node as used in calculation only
-
-                std::set<MetricTriple> search_list;
-                search_list.insert(MetricTriple(0.0f, curs, NoPixel));
-                while (search_list.size()) {
-                    std::set<MetricTriple>::iterator it = search_list.begin();
-                    MetricTriple here = *it;
-                    search_list.erase(it);
-                    if (m_radius != -1.0 && (here.dist * map.getSpacing()) > m_radius) {
-                        break;
+                    if (m_gates_only) {
+                        count++;
+                        continue;
                     }
-                    Point &p = map.getPoint(here.pixel);
-                    // nb, the filled check is necessary as diagonals seem to be stored with 'gaps' left in
-                    if (p.filled() && p.m_misc != ~0) {
-                        p.getNode().extractMetric(search_list, &map, here);
-                        p.m_misc = ~0;
-                        if (!p.getMergePixel().empty()) {
-                            Point &p2 = map.getPoint(p.getMergePixel());
-                            if (p2.m_misc != ~0) {
-                                p2.m_cumangle = p.m_cumangle;
-                                p2.getNode().extractMetric(search_list, &map,
-                                                           MetricTriple(here.dist, p.getMergePixel(), NoPixel));
-                                p2.m_misc = ~0;
+
+                    tiles.moveToRoot(points, curs);
+
+                    float euclid_depth = 0.0f;
+                    float total_depth = 0.0f;
+                    float total_angle = 0.0f;
+                    int total_nodes = 0;
+
+                    // note that m_misc is used in a different manner to analyseGraph / PointDepth
+                    // here it marks the node as used in calculation only
+
+                    search_list.clear();
+                    search_list.push(0.0, MetricTriple(0.0f, curs, NoPixel));
+                    while (!search_list.empty()) {
+                        MetricTriple here = search_list.pop();
+                        if (m_radius != -1.0 && (here.dist * map.getSpacing()) > m_radius) {
+                            break;
+                        }
+                        Point &p = map.getPoint(here.pixel);
+                        MetricPoint &mp = points(here.pixel.y, here.pixel.x);
+                        // nb, the filled check is necessary as diagonals seem to be stored with 'gaps' left in
+                        if (p.filled() && mp.misc != ~0) {
+                            extractMetric(graph, search_list, map, here, points);
+                            mp.misc = ~0;
+                            if (!p.getMergePixel().empty()) {
+                                PixelRef mergePixel = p.getMergePixel();
+                                MetricPoint &mp2 = points(mergePixel.y, mergePixel.x);
+                                if (mp2.misc != ~0) {
+                                    mp2.cumangle = mp.cumangle;
+                                    extractMetric(graph, search_list, map,
+                                                  MetricTriple(here.dist, mergePixel, NoPixel), points);
+                                    mp2.misc = ~0;
+                                }
                             }
+                            total_depth += float(here.dist * map.getSpacing());
+                            total_angle += mp.cumangle;
+                            euclid_depth += float(map.getSpacing() * dist(here.pixel, curs));
+                            total_nodes += 1;
                         }
-                        total_depth += float(here.dist * map.getSpacing());
-                        total_angle += p.m_cumangle;
-                        euclid_depth += float(map.getSpacing() * dist(here.pixel, curs));
-                        total_nodes += 1;
                     }
-                }
 
-                AttributeRow &row = attributes.getRow(AttributeKey(curs));
-                row.setValue(mspa_col, float(double(total_angle) / double(total_nodes)));
-                row.setValue(mspl_col, float(double(total_depth) / double(total_nodes)));
-                row.setValue(dist_col, float(double(euclid_depth) / double(total_nodes)));
-                row.setValue(count_col, float(total_nodes));
+                    size_t row = attributes.getRowIndex(AttributeKey(curs));
+                    writer.value(row, mspa_col) = float(double(total_angle) / double(total_nodes));
+                    writer.value(row, mspl_col) = float(double(total_depth) / double(total_nodes));
+                    writer.value(row, dist_col) = float(double(euclid_depth) / double(total_nodes));
+                    writer.value(row, count_col) = float(total_nodes);
 
-                count++; // <- increment count
-            }
-            if (comm) {
-                if (qtimer(atime, 500)) {
-                    if (comm->IsCancelled()) {
-                        throw Communicator::CancelledException();
+                    count++; // <- increment count
+                }
+                if (comm) {
+                    if (qtimer(atime, 500)) {
+                        if (comm->IsCancelled()) {
+                            throw Communicator::CancelledException();
+                        }
+                        comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
                     }
-                    comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
                 }
             }
         }
     }
 
+    writer.commit();
+
     map.overrideDisplayedAttribute(-2);
     map.setDisplayedAttribute(mspl_col);
 
     return true;
 }
+
+void VGAMetric::extractMetric(const VisibilityGraph &graph, depthmapX::BucketQueue<MetricTriple> &pixels, PointMap &map,
+                              const MetricTriple &curs, depthmapX::EpochMatrix<MetricPoint> &points) {
+    if (curs.dist == 0.0f || map.getPoint(curs.pixel).blocked() || map.blockedAdjacent(curs.pixel)) {
+        float cursCumAngle = points(curs.pixel.y, curs.pixel.x).cumangle;
+        for (const VisibilityGraph::BinRuns &bin : graph.bins(curs.pixel)) {
+            for (const PixelVec &pixVec : graph.runs(bin)) {
+                for (PixelRef pix = pixVec.start(); pix.col(bin.dir) <= pixVec.end().col(bin.dir);) {
+                    // a cell outside the window is further than the radius from the root
+                    if (!points.contains(pix.y, pix.x)) {
+                        pix.move(bin.dir);
+                        continue;
+                    }
+                    MetricPoint &pt = points(pix.y, pix.x);
+                    if (pt.misc == 0 && (pt.dist == -1.0 || (curs.dist + dist(pix, curs.pixel) < pt.dist))) {
+                        pt.dist = curs.dist + (float)dist(pix, curs.pixel);
+                        // n.b. dmap v4.06r now sets angle in range 0 to 4 (1 = 90 degrees)
+                        float ang = (curs.lastpixel == NoPixel)
+                                        ? 0.0f
+                                        : (float)(angle(pix, curs.pixel, curs.lastpixel) / (M_PI * 0.5));
+                        pt.cumangle = cursCumAngle + ang;
+                        pixels.push(pt.dist, MetricTriple(pt.dist, pix, curs.pixel));
+                    }
+                    pix.move(bin.dir);
+                }
+            }
+        }
+    }
+}
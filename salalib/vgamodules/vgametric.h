@@ -21,14 +21,32 @@
 #include "salalib/ivga.h"
 #include "salalib/pixelref.h"
 #include "salalib/pointdata.h"
+#include "salalib/visibilitygraph.h"
+#include "salalib/vgamodules/vgatiles.h"
+
+#include "genlib/bucketqueue.h"
+#include "genlib/epochmatrix.h"
 
 class VGAMetric : IVGA {
   private:
     double m_radius;
     bool m_gates_only;
+    int m_tile_size;
+
+    // the traversal state of a cell, relative to the current root
+    struct MetricPoint {
+        int misc = 0;          // set to ~0 once the cell has been used in the calculation
+        float dist = -1.0f;    // shortest path distance found so far
+        float cumangle = 0.0f; // cumulative angle along that path
+    };
+
+    void extractMetric(const VisibilityGraph &graph, depthmapX::BucketQueue<MetricTriple> &pixels, PointMap &map,
+                       const MetricTriple &curs, depthmapX::EpochMatrix<MetricPoint> &points);
 
   public:
     std::string getAnalysisName() const override { return "Metric Analysis"; }
     bool run(Communicator *comm, PointMap &map, bool) override;
-    VGAMetric(double radius, bool gates_only) : m_radius(radius), m_gates_only(gates_only) {}
+    // with a radius the map is analysed in tiles of tile_size by tile_size roots, see VGATiles
+    VGAMetric(double radius, bool gates_only, int tile_size = VGATiles::DEFAULT_TILE_SIZE)
+        : m_radius(radius), m_gates_only(gates_only), m_tile_size(tile_size) {}
 };
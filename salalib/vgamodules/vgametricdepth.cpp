@@ -33,53 +33,48 @@ bool VGAMetricDepth::run(Communicator *, PointMap &map, bool) {
         dist_col = attributes.insertOrResetColumn("Metric Straight-Line Distance");
     }
 
-    for (auto iter = attributes.begin(); iter != attributes.end(); iter++) {
-        PixelRef pix = iter->getKey().value;
-        map.getPoint(pix).m_misc = 0;
-        map.getPoint(pix).m_dist = -1.0f;
-        map.getPoint(pix).m_cumangle = 0.0f;
-    }
+    depthmapX::EpochMatrix<MetricPoint> points(map.getRows(), map.getCols());
+    const VisibilityGraph &graph = map.getVisibilityGraph();
 
     // in order to calculate Penn angle, the MetricPair becomes a metric triple...
-    std::set<MetricTriple> search_list; // contains root point
+    depthmapX::BucketQueue<MetricTriple> search_list(1.0); // contains root point
 
     for (auto &sel : map.getSelSet()) {
-        search_list.insert(MetricTriple(0.0f, sel, NoPixel));
+        search_list.push(0.0, MetricTriple(0.0f, sel, NoPixel));
     }
 
     // note that m_misc is used in a different manner to analyseGraph / PointDepth
     // here it marks the node as used in calculation only
-    while (search_list.size()) {
-        std::set<MetricTriple>::iterator it = search_list.begin();
-        MetricTriple here = *it;
-        search_list.erase(it);
+    while (!search_list.empty()) {
+        MetricTriple here = search_list.pop();
         Point &p = map.getPoint(here.pixel);
+        MetricPoint &mp = points(here.pixel.y, here.pixel.x);
         // nb, the filled check is necessary as diagonals seem to be stored with 'gaps' left in
-        if (p.filled() && p.m_misc != ~0) {
-            p.getNode().extractMetric(search_list, &map, here);
-            p.m_misc = ~0;
+        if (p.filled() && mp.misc != ~0) {
+            extractMetric(graph, search_list, map, here, points);
+            mp.misc = ~0;
             AttributeRow &row = map.getAttributeTable().getRow(AttributeKey(here.pixel));
             row.setValue(path_length_col, float(map.getSpacing() * here.dist));
-            row.setValue(path_angle_col, float(p.m_cumangle));
+            row.setValue(path_angle_col, float(mp.cumangle));
             if (map.getSelSet().size() == 1) {
                 // Note: Euclidean distance is currently only calculated from a single point
                 row.setValue(dist_col, float(map.getSpacing() * dist(here.pixel, *map.getSelSet().begin())));
             }
             if (!p.getMergePixel().empty()) {
-                Point &p2 = map.getPoint(p.getMergePixel());
-                if (p2.m_misc != ~0) {
-                    p2.m_cumangle = p.m_cumangle;
+                MetricPoint &mp2 = points(p.getMergePixel().y, p.getMergePixel().x);
+                if (mp2.misc != ~0) {
+                    mp2.cumangle = mp.cumangle;
                     AttributeRow &mergePixelRow =
                         map.getAttributeTable().getRow(AttributeKey(p.getMergePixel()));
                     mergePixelRow.setValue(path_length_col, float(map.getSpacing() * here.dist));
-                    mergePixelRow.setValue(path_angle_col, float(p2.m_cumangle));
+                    mergePixelRow.setValue(path_angle_col, float(mp2.cumangle));
                     if (map.getSelSet().size() == 1) {
                         // Note: Euclidean distance is currently only calculated from a single point
                         mergePixelRow.setValue(
                             dist_col, float(map.getSpacing() * dist(p.getMergePixel(), *map.getSelSet().begin())));
                     }
-                    p2.getNode().extractMetric(search_list, &map, MetricTriple(here.dist, p.getMergePixel(), NoPixel));
-                    p2.m_misc = ~0;
+                    extractMetric(graph, search_list, map, MetricTriple(here.dist, p.getMergePixel(), NoPixel), points);
+                    mp2.misc = ~0;
                 }
             }
         }
@@ -90,3 +85,27 @@ bool VGAMetricDepth::run(Communicator *, PointMap &map, bool) {
 
     return true;
 }
+
+void VGAMetricDepth::extractMetric(const VisibilityGraph &graph, depthmapX::BucketQueue<MetricTriple> &pixels, PointMap &map,
+                                   const MetricTriple &curs, depthmapX::EpochMatrix<MetricPoint> &points) {
+    if (curs.dist == 0.0f || map.getPoint(curs.pixel).blocked() || map.blockedAdjacent(curs.pixel)) {
+        float cursCumAngle = points(curs.pixel.y, curs.pixel.x).cumangle;
+        for (const VisibilityGraph::BinRuns &bin : graph.bins(curs.pixel)) {
+            for (const PixelVec &pixVec : graph.runs(bin)) {
+                for (PixelRef pix = pixVec.start(); pix.col(bin.dir) <= pixVec.end().col(bin.dir);) {
+                    MetricPoint &pt = points(pix.y, pix.x);
+                    if (pt.misc == 0 && (pt.dist == -1.0 || (curs.dist + dist(pix, curs.pixel) < pt.dist))) {
+                        pt.dist = curs.dist + (float)dist(pix, curs.pixel);
+                        // n.b. dmap v4.06r now sets angle in range 0 to 4 (1 = 90 degrees)
+                        float ang = (curs.lastpixel == NoPixel)
+                                        ? 0.0f
+                                        : (float)(angle(pix, curs.pixel, curs.lastpixel) / (M_PI * 0.5));
+                        pt.cumangle = cursCumAngle + ang;
+                        pixels.push(pt.dist, MetricTriple(pt.dist, pix, curs.pixel));
+                    }
+                    pix.move(bin.dir);
+                }
+            }
+        }
+    }
+}
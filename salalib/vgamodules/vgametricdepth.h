@@ -21,8 +21,23 @@
 #include "salalib/ivga.h"
 #include "salalib/pixelref.h"
 #include "salalib/pointdata.h"
+#include "salalib/visibilitygraph.h"
+
+#include "genlib/bucketqueue.h"
+#include "genlib/epochmatrix.h"
 
 class VGAMetricDepth : IVGA {
+  private:
+    // the traversal state of a cell, relative to the selection
+    struct MetricPoint {
+        int misc = 0;          // set to ~0 once the cell has been used in the calculation
+        float dist = -1.0f;    // shortest path distance found so far
+        float cumangle = 0.0f; // cumulative angle along that path
+    };
+
+    void extractMetric(const VisibilityGraph &graph, depthmapX::BucketQueue<MetricTriple> &pixels, PointMap &map,
+                       const MetricTriple &curs, depthmapX::EpochMatrix<MetricPoint> &points);
+
   public:
     std::string getAnalysisName() const override { return "Metric Depth"; }
     bool run(Communicator *, PointMap &map, bool) override;
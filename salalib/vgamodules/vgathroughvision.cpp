@@ -43,16 +43,18 @@ bool VGAThroughVision::run(Communicator *comm, PointMap &map, bool) {
 
     bool hasGateColumn = map.getAttributeTable().hasColumn(g_col_gate);
 
+    const VisibilityGraph &graph = map.getVisibilityGraph();
+    PixelRefVector visible;
+
     int count = 0;
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             std::vector<int> seengates;
             PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
-            Point &p = map.getPoint(curs);
             if (map.getPoint(curs).filled()) {
-                p.getNode().first();
-                while (!p.getNode().is_tail()) {
-                    PixelRef x = p.getNode().cursor();
+                visible.clear();
+                graph.contents(curs, visible);
+                for (PixelRef x : visible) {
                     PixelRefVector pixels = map.quickPixelateLine(x, curs);
                     for (size_t k = 1; k < pixels.size() - 1; k++) {
                         PixelRef key = pixels[k];
@@ -73,7 +75,6 @@ bool VGAThroughVision::run(Communicator *comm, PointMap &map, bool) {
                             }
                         }
                     }
-                    p.getNode().next();
                 }
                 // only increment count for actual filled points
                 count++;
@@ -0,0 +1,106 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/vgamodules/vgatiles.h"
+
+#include <algorithm>
+#include <cmath>
+
+VGATiles::VGATiles(PointMap &map, int reach, int tileSize)
+    : m_tiled(false), m_reach(reach), m_tileSize(tileSize), m_rows(map.getRows()), m_cols(map.getCols()),
+      m_tileRows(1) {
+    // a window has to be well under the size of the grid to make up for packing the overlaps between the
+    // tiles more than once
+    double side = 2.0 * double(reach) + 1.0;
+    m_tiled = tileSize > 0 && reach >= 0 && side * side * 4.0 <= double(m_rows) * double(m_cols);
+    if (!m_tiled) {
+        m_tiles.push_back(Tile{PixelRef(0, 0),
+                               PixelRef(static_cast<short>(m_cols - 1), static_cast<short>(m_rows - 1)),
+                               PixelRef(0, 0),
+                               PixelRef(static_cast<short>(m_cols - 1), static_cast<short>(m_rows - 1))});
+        return;
+    }
+    // the tiles are in column order, as the roots usually are
+    m_tileRows = (m_rows + static_cast<size_t>(tileSize) - 1) / static_cast<size_t>(tileSize);
+    for (size_t x = 0; x < m_cols; x += static_cast<size_t>(tileSize)) {
+        for (size_t y = 0; y < m_rows; y += static_cast<size_t>(tileSize)) {
+            Tile tile;
+            tile.first = PixelRef(static_cast<short>(x), static_cast<short>(y));
+            tile.last = PixelRef(static_cast<short>(std::min(x + static_cast<size_t>(tileSize), m_cols) - 1),
+                                 static_cast<short>(std::min(y + static_cast<size_t>(tileSize), m_rows) - 1));
+            tile.windowFirst = PixelRef(static_cast<short>(std::max(0, tile.first.x - reach)),
+                                        static_cast<short>(std::max(0, tile.first.y - reach)));
+            tile.windowLast = PixelRef(static_cast<short>(std::min(int(m_cols) - 1, tile.last.x + reach)),
+                                       static_cast<short>(std::min(int(m_rows) - 1, tile.last.y + reach)));
+            m_tiles.push_back(tile);
+        }
+    }
+}
+
+size_t VGATiles::getTileIndex(PixelRef root) const {
+    if (!m_tiled) {
+        return 0;
+    }
+    return static_cast<size_t>(root.x / m_tileSize) * m_tileRows + static_cast<size_t>(root.y / m_tileSize);
+}
+
+size_t VGATiles::getMaxWindowCells() const {
+    size_t cells = 0;
+    for (const Tile &tile : m_tiles) {
+        cells = std::max(cells, tile.windowCells());
+    }
+    return cells;
+}
+
+double VGATiles::getLongestView(PointMap &map) {
+    // each bin keeps the distance to its farthest cell, so the runs only have to be gone through for a bin without
+    // one, as in a graph from a file that does not record the distances. The farthest cell of a run is always at
+    // one of its ends
+    double longest = 0.0;
+    for (size_t i = 0; i < map.getCols(); i++) {
+        for (size_t j = 0; j < map.getRows(); j++) {
+            PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
+            Point &point = map.getPoint(curs);
+            if (!point.hasNode()) {
+                continue;
+            }
+            for (int b = 0; b < 32; b++) {
+                const Bin &bin = point.getNode().bin(b);
+                if (bin.distance() > 0.0f) {
+                    // n.b. the distance is kept in single precision, so it is rounded up to be sure
+                    longest = std::max(longest, std::nextafter(bin.distance(), HUGE_VALF) / map.getSpacing());
+                    continue;
+                }
+                for (const PixelVec &run : bin.m_pixel_vecs) {
+                    longest = std::max(longest, std::max(dist(curs, run.start()), dist(curs, run.end())));
+                }
+            }
+        }
+    }
+    return longest;
+}
+
+bool VGATiles::hasMergedPoints(PointMap &map) {
+    for (size_t i = 0; i < map.getCols(); i++) {
+        for (size_t j = 0; j < map.getRows(); j++) {
+            Point &point = map.getPoint(PixelRef(static_cast<short>(i), static_cast<short>(j)));
+            if (point.filled() && !point.getMergePixel().empty()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,101 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "salalib/pixelref.h"
+#include "salalib/pointdata.h"
+
+#include "genlib/epochmatrix.h"
+
+#include <vector>
+
+/**
+ * Splits the grid of a point map into square tiles of roots, for the analyses with a radius where the search
+ * from a root never gets further than a known number of cells (the reach) from it.
+ *
+ * Each tile comes with a window holding its roots and every cell within reach of them. The state of the search
+ * from one root only has to cover the cells within reach of that root, which usually fits in the cache where
+ * the whole grid would not, and the packed visibility graph is made for one window at a time rather than for
+ * the whole map. Without a reach, or when the windows would be about as large as the grid anyway, there is a
+ * single tile covering the grid.
+ *
+ * This is a speed measure only: the windows are packed from the Nodes, and the Points and Nodes of the whole
+ * map are still read into memory with the graph file, so a map has to fit in memory to be analysed in tiles.
+ */
+class VGATiles {
+  public:
+    struct Tile {
+        PixelRef first; // the roots of the tile are the cells from first to last inclusive
+        PixelRef last;
+        PixelRef windowFirst; // and the cells within reach of them, clipped to the grid
+        PixelRef windowLast;
+        size_t windowRows() const { return static_cast<size_t>(windowLast.y - windowFirst.y + 1); }
+        size_t windowCells() const {
+            return static_cast<size_t>(windowLast.x - windowFirst.x + 1) * windowRows();
+        }
+    };
+
+    static const int DEFAULT_TILE_SIZE = 64;
+
+    /**
+     * @param reach how many cells from its root a search may get, in both directions, or -1 for no limit
+     * @param tileSize the number of roots along each side of a tile, or 0 for a single tile
+     */
+    VGATiles(PointMap &map, int reach, int tileSize = DEFAULT_TILE_SIZE);
+
+    bool isTiled() const { return m_tiled; }
+    const std::vector<Tile> &getTiles() const { return m_tiles; }
+    size_t getTileIndex(PixelRef root) const;
+    size_t getMaxWindowCells() const;
+
+    /**
+     * @brief Make the matrix for the state of the search from one root, to be moved to each root with
+     * moveToRoot. It covers the cells within reach of the root, or the whole grid if the map is not tiled
+     */
+    template <typename T> depthmapX::EpochMatrix<T> makeRootWindow(T const &defaultValue = T()) const {
+        size_t side = static_cast<size_t>(2 * m_reach + 1);
+        return m_tiled ? depthmapX::EpochMatrix<T>(side, side, defaultValue)
+                       : depthmapX::EpochMatrix<T>(m_rows, m_cols, defaultValue);
+    }
+    template <typename T> void moveToRoot(depthmapX::EpochMatrix<T> &window, PixelRef root) const {
+        if (m_tiled) {
+            window.moveTo(long(root.y) - m_reach, long(root.x) - m_reach);
+        } else {
+            window.clear();
+        }
+    }
+
+    /**
+     * @brief The longest view from any point of the map in grid units, i.e. how far a single step through the
+     * visibility graph may get
+     */
+    static double getLongestView(PointMap &map);
+    /**
+     * @brief Whether any points are merged. Merged points are connected whatever their distance, so there is
+     * no reach to speak of
+     */
+    static bool hasMergedPoints(PointMap &map);
+
+  private:
+    bool m_tiled;
+    int m_reach;
+    int m_tileSize;
+    size_t m_rows;
+    size_t m_cols;
+    size_t m_tileRows;
+    std::vector<Tile> m_tiles;
+};
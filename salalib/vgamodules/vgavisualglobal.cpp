@@ -18,8 +18,12 @@
 
 #include "salalib/vgamodules/vgavisualglobal.h"
 
+#include "genlib/parallel.h"
 #include "genlib/stringutils.h"
 
+#include <atomic>
+#include <cmath>
+
 bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version) {
     time_t atime = 0;
     if (comm) {
@@ -62,178 +66,411 @@ bool VGAVisualGlobal::run(Communicator *comm, PointMap &map, bool simple_version
     }
 #endif
 
-    int count = 0;
-
-    depthmapX::RowMatrix<int> miscs(map.getRows(), map.getCols());
-    depthmapX::RowMatrix<PixelRef> extents(map.getRows(), map.getCols());
-
+    // the roots in the order the serial analysis would take them
+    std::vector<PixelRef> roots;
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
-            PixelRef curs = PixelRef(i, j);
+            PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
             if (map.getPoint(curs).filled()) {
+                roots.push_back(curs);
+            }
+        }
+    }
 
-                if ((map.getPoint(curs).contextfilled() && !curs.iseven()) || (m_gates_only)) {
-                    count++;
-                    continue;
-                }
+    // each thread gets its own traversal state, and each root its own result slot, so that the
+    // threads do not share anything writeable while the analysis is running
+    int num_threads = depthmapX::resolveThreadCount(m_num_threads);
+    std::vector<std::unique_ptr<ThreadData>> thread_data(static_cast<size_t>(num_threads));
+    std::vector<RootData> root_data(roots.size());
+
+    std::atomic<int> count(0);
+
+    // a merged cell is only counted if the search meets it before its partner, which depends on the order
+    // the cells are searched in, so a map with merges is searched one root at a time
+    bool has_merges = false;
+    for (PixelRef curs : roots) {
+        if (!map.getPoint(curs).getMergePixel().empty()) {
+            has_merges = true;
+            break;
+        }
+    }
+
+    if (!has_merges) {
+        // with a radius, a search cannot get further from its root than the radius times the longest view of
+        // the map, which is only much less than the size of the map if the graph was made with a restricted
+        // visual range. In that case the map is analysed one tile at a time, with the graph and the search
+        // state only covering the cells within reach of the roots of the tile
+        int reach = -1;
+        if ((int)m_radius != -1) {
+            double reach_cells = std::ceil(m_radius * VGATiles::getLongestView(map)) + 1.0;
+            if (reach_cells < double(map.getCols() + map.getRows())) {
+                reach = static_cast<int>(reach_cells);
+            }
+        }
+        VGATiles tiles(map, reach, m_tile_size);
+        // the windows are packed from the Nodes, so the packed graph of the whole map is let go of while they are
+        // analysed, and made again when it is next asked for
+        if (tiles.isTiled()) {
+            map.releaseVisibilityGraph();
+        }
+        std::vector<std::vector<size_t>> tile_roots(tiles.getTiles().size());
+        for (size_t root_index = 0; root_index < roots.size(); root_index++) {
+            tile_roots[tiles.getTileIndex(roots[root_index])].push_back(root_index);
+        }
 
-                for (size_t ii = 0; ii < map.getCols(); ii++) {
-                    for (size_t jj = 0; jj < map.getRows(); jj++) {
-                        miscs(jj, ii) = 0;
-                        extents(jj, ii) = PixelRef(ii, jj);
+        VisibilityGraph tile_graph;
+        std::vector<unsigned char> cell_flags;
+        std::vector<size_t> analysed_roots;
+        std::vector<std::unique_ptr<BatchData>> batch_data(static_cast<size_t>(num_threads));
+        for (size_t tile_index = 0; tile_index < tiles.getTiles().size(); tile_index++) {
+            const VGATiles::Tile &tile = tiles.getTiles()[tile_index];
+            // n.b. pack the graph before starting the threads, as it may have to be made
+            if (tiles.isTiled()) {
+                tile_graph.build(map, tile.windowFirst, tile.windowLast);
+            }
+            const VisibilityGraph &graph = tiles.isTiled() ? tile_graph : map.getVisibilityGraph();
+
+            // search batches of roots at once, sharing the scan of each cell's visible cells between the roots
+            // of the batch that reach it at the same depth
+            size_t rows = tile.windowRows();
+            cell_flags.assign(tile.windowCells(), 0);
+            for (short i = tile.windowFirst.x; i <= tile.windowLast.x; i++) {
+                for (short j = tile.windowFirst.y; j <= tile.windowLast.y; j++) {
+                    PixelRef curs(i, j);
+                    const Point &p = map.getPoint(curs);
+                    if (!p.filled()) {
+                        continue;
+                    }
+                    unsigned char &flags = cell_flags[static_cast<size_t>(i - tile.windowFirst.x) * rows +
+                                                      static_cast<size_t>(j - tile.windowFirst.y)];
+                    flags = CELL_FILLED;
+                    // n.b. the context filled cells are only passed through without a radius
+                    if ((int)m_radius == -1 || !p.contextfilled() || curs.iseven()) {
+                        flags |= CELL_EXPANDS;
                     }
                 }
+            }
+            analysed_roots.clear();
+            for (size_t root_index : tile_roots[tile_index]) {
+                PixelRef curs = roots[root_index];
+                if (!((map.getPoint(curs).contextfilled() && !curs.iseven()) || (m_gates_only))) {
+                    analysed_roots.push_back(root_index);
+                }
+            }
+            count += static_cast<int>(tile_roots[tile_index].size() - analysed_roots.size());
 
-                int total_depth = 0;
-                int total_nodes = 0;
-
-                std::vector<int> distribution;
-                std::vector<PixelRefVector> search_tree;
-                search_tree.push_back(PixelRefVector());
-                search_tree.back().push_back(curs);
-
-                int level = 0;
-                while (search_tree[level].size()) {
-                    search_tree.push_back(PixelRefVector());
-                    const PixelRefVector &searchTreeAtLevel = search_tree[level];
-                    distribution.push_back(0);
-                    for (auto currLvlIter = searchTreeAtLevel.rbegin(); currLvlIter != searchTreeAtLevel.rend();
-                         currLvlIter++) {
-                        int &pmisc = miscs(currLvlIter->y, currLvlIter->x);
-                        Point &p = map.getPoint(*currLvlIter);
-                        if (p.filled() && pmisc != ~0) {
-                            total_depth += level;
-                            total_nodes += 1;
-                            distribution.back() += 1;
-                            if ((int)m_radius == -1 ||
-                                (level < (int)m_radius &&
-                                    (!p.contextfilled() || currLvlIter->iseven()))) {
-                                extractUnseen(p.getNode(), search_tree[level + 1], miscs, extents);
-                                pmisc = ~0;
-                                if (!p.getMergePixel().empty()) {
-                                    PixelRef mergePixel = p.getMergePixel();
-                                    int &p2misc = miscs(mergePixel.y, mergePixel.x);
-                                    Point &p2 = map.getPoint(mergePixel);
-                                    if (p2misc != ~0) {
-                                        extractUnseen(p2.getNode(), search_tree[level + 1], miscs,
-                                                      extents); // did say p.misc
-                                        p2misc = ~0;
-                                    }
-                                }
-                            } else {
-                                pmisc = ~0;
-                            }
-                        }
-                        search_tree[level].pop_back();
+            size_t batch_count = (analysed_roots.size() + BATCH_SIZE - 1) / BATCH_SIZE;
+            depthmapX::parallelFor(num_threads, batch_count, [&](int thread_index, size_t batch_index) {
+                auto first = analysed_roots.begin() + static_cast<std::ptrdiff_t>(batch_index * BATCH_SIZE);
+                auto last = analysed_roots.begin() + static_cast<std::ptrdiff_t>(std::min(
+                                                         analysed_roots.size(), (batch_index + 1) * BATCH_SIZE));
+                std::vector<size_t> batch(first, last);
+                std::unique_ptr<BatchData> &data = batch_data[static_cast<size_t>(thread_index)];
+                if (!data) {
+                    data = std::unique_ptr<BatchData>(new BatchData(tiles.getMaxWindowCells()));
+                }
+                analyseBatch(graph, roots, batch, cell_flags, tile.windowFirst, rows, *data, root_data);
+                count += static_cast<int>(batch.size());
+                // every thread checks for a cancel, but only the calling thread reports back
+                if (comm) {
+                    if (comm->IsCancelled()) {
+                        throw Communicator::CancelledException();
+                    }
+                    if (thread_index == 0 && qtimer(atime, 500)) {
+                        comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
                     }
-                    level++;
                 }
-                AttributeRow &row = attributes.getRow(AttributeKey(curs));
-                // only set to single float precision after divide
-                // note -- total_nodes includes this one -- mean depth as per p.108 Social Logic of Space
+            });
+        }
+    } else {
+        // n.b. fetch the graph before starting the threads, as it may have to be made
+        const VisibilityGraph &graph = map.getVisibilityGraph();
+        depthmapX::parallelFor(num_threads, roots.size(), [&](int thread_index, size_t root_index) {
+            PixelRef curs = roots[root_index];
+            if (!((map.getPoint(curs).contextfilled() && !curs.iseven()) || (m_gates_only))) {
+                std::unique_ptr<ThreadData> &data = thread_data[static_cast<size_t>(thread_index)];
+                if (!data) {
+                    data = std::unique_ptr<ThreadData>(new ThreadData(map.getRows(), map.getCols()));
+                }
+                analyseRoot(map, graph, curs, *data, root_data[root_index]);
+            }
+            int done = ++count; // <- increment count
+            // every thread checks for a cancel, but only the calling thread reports back
+            if (comm) {
+                if (comm->IsCancelled()) {
+                    throw Communicator::CancelledException();
+                }
+                if (thread_index == 0 && qtimer(atime, 500)) {
+                    comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+                }
+            }
+        });
+    }
+
+    // the column stats are updated in row order, as in the serial analysis
+    AttributeBulkWriter writer(attributes);
+    for (size_t root_index = 0; root_index < roots.size(); root_index++) {
+        const RootData &data = root_data[root_index];
+        if (!data.analysed) {
+            continue;
+        }
+        int total_depth = data.total_depth;
+        int total_nodes = data.total_nodes;
+        size_t row = attributes.getRowIndex(AttributeKey(roots[root_index]));
+        // only set to single float precision after divide
+        // note -- total_nodes includes this one -- mean depth as per p.108 Social Logic of Space
+        if (!simple_version) {
+            writer.value(row, count_col) = float(total_nodes); // note: total nodes includes this one
+        }
+        // ERROR !!!!!!
+        if (total_nodes > 1) {
+            double mean_depth = double(total_depth) / double(total_nodes - 1);
+            if (!simple_version) {
+                writer.value(row, depth_col) = float(mean_depth);
+            }
+            // total nodes > 2 to avoid divide by 0 (was > 3)
+            if (total_nodes > 2 && mean_depth > 1.0) {
+                double ra = 2.0 * (mean_depth - 1.0) / double(total_nodes - 2);
+                // d-value / p-values from Depthmap 4 manual, note: node_count includes this one
+                double rra_d = ra / dvalue(total_nodes);
+                double rra_p = ra / pvalue(total_nodes);
+                double integ_tk = teklinteg(total_nodes, total_depth);
+                writer.value(row, integ_dv_col) = float(1.0 / rra_d);
                 if (!simple_version) {
-                    row.setValue(count_col, float(total_nodes)); // note: total nodes includes this one
+                    writer.value(row, integ_pv_col) = float(1.0 / rra_p);
                 }
-                // ERROR !!!!!!
-                if (total_nodes > 1) {
-                    double mean_depth = double(total_depth) / double(total_nodes - 1);
+                if (total_depth - total_nodes + 1 > 1) {
                     if (!simple_version) {
-                        row.setValue(depth_col, float(mean_depth));
-                    }
-                    // total nodes > 2 to avoid divide by 0 (was > 3)
-                    if (total_nodes > 2 && mean_depth > 1.0) {
-                        double ra = 2.0 * (mean_depth - 1.0) / double(total_nodes - 2);
-                        // d-value / p-values from Depthmap 4 manual, note: node_count includes this one
-                        double rra_d = ra / dvalue(total_nodes);
-                        double rra_p = ra / pvalue(total_nodes);
-                        double integ_tk = teklinteg(total_nodes, total_depth);
-                        row.setValue(integ_dv_col, float(1.0 / rra_d));
-                        if (!simple_version) {
-                            row.setValue(integ_pv_col, float(1.0 / rra_p));
-                        }
-                        if (total_depth - total_nodes + 1 > 1) {
-                            if (!simple_version) {
-                                row.setValue(integ_tk_col, float(integ_tk));
-                            }
-                        } else {
-                            if (!simple_version) {
-                                row.setValue(integ_tk_col, -1.0f);
-                            }
-                        }
-                    } else {
-                        row.setValue(integ_dv_col, (float)-1);
-                        if (!simple_version) {
-                            row.setValue(integ_pv_col, (float)-1);
-                            row.setValue(integ_tk_col, (float)-1);
-                        }
-                    }
-                    double entropy = 0.0, rel_entropy = 0.0, factorial = 1.0;
-                    // n.b., this distribution contains the root node itself in distribution[0]
-                    // -> chopped from entropy to avoid divide by zero if only one node
-                    for (size_t k = 1; k < distribution.size(); k++) {
-                        if (distribution[k] > 0) {
-                            double prob = double(distribution[k]) / double(total_nodes - 1);
-                            entropy -= prob * log2(prob);
-                            // Formula from Turner 2001, "Depthmap"
-                            factorial *= double(k + 1);
-                            double q = (pow(mean_depth, double(k)) / double(factorial)) * exp(-mean_depth);
-                            rel_entropy += (float)prob * log2(prob / q);
-                        }
-                    }
-                    if (!simple_version) {
-                        row.setValue(entropy_col, float(entropy));
-                        row.setValue(rel_entropy_col, float(rel_entropy));
+                        writer.value(row, integ_tk_col) = float(integ_tk);
                     }
                 } else {
                     if (!simple_version) {
-                        row.setValue(depth_col, (float)-1);
-                        row.setValue(entropy_col, (float)-1);
-                        row.setValue(rel_entropy_col, (float)-1);
+                        writer.value(row, integ_tk_col) = -1.0f;
                     }
                 }
-                count++; // <- increment count
-                if (comm) {
-                    if (qtimer(atime, 500)) {
-                        if (comm->IsCancelled()) {
-                            throw Communicator::CancelledException();
+            } else {
+                writer.value(row, integ_dv_col) = (float)-1;
+                if (!simple_version) {
+                    writer.value(row, integ_pv_col) = (float)-1;
+                    writer.value(row, integ_tk_col) = (float)-1;
+                }
+            }
+            if (!simple_version) {
+                writer.value(row, entropy_col) = float(data.entropy);
+                writer.value(row, rel_entropy_col) = float(data.rel_entropy);
+            }
+        } else {
+            if (!simple_version) {
+                writer.value(row, depth_col) = (float)-1;
+                writer.value(row, entropy_col) = (float)-1;
+                writer.value(row, rel_entropy_col) = (float)-1;
+            }
+        }
+    }
+    writer.commit();
+
+    // the search state is kept per thread and is not copied back onto the points: it would only hold whatever
+    // root was searched last, m_extent is read nowhere else, and m_misc is where undoPoints finds its fills
+    map.setDisplayedAttribute(integ_dv_col);
+
+    return true;
+}
+
+void VGAVisualGlobal::analyseRoot(PointMap &map, const VisibilityGraph &graph, PixelRef curs, ThreadData &threadData,
+                                  RootData &rootData) {
+    depthmapX::EpochMatrix<int> &miscs = threadData.miscs;
+    depthmapX::EpochMatrix<PixelRef> &extents = threadData.extents;
+
+    // only the cells reached from the previous root were touched, so there is nothing to reset
+    miscs.clear();
+    extents.clear();
+
+    int total_depth = 0;
+    int total_nodes = 0;
+
+    std::vector<int> distribution;
+    std::vector<PixelRefVector> search_tree;
+    search_tree.push_back(PixelRefVector());
+    search_tree.back().push_back(curs);
+
+    int level = 0;
+    while (search_tree[level].size()) {
+        search_tree.push_back(PixelRefVector());
+        const PixelRefVector &searchTreeAtLevel = search_tree[level];
+        distribution.push_back(0);
+        for (auto currLvlIter = searchTreeAtLevel.rbegin(); currLvlIter != searchTreeAtLevel.rend(); currLvlIter++) {
+            int &pmisc = miscs(currLvlIter->y, currLvlIter->x);
+            Point &p = map.getPoint(*currLvlIter);
+            if (p.filled() && pmisc != ~0) {
+                total_depth += level;
+                total_nodes += 1;
+                distribution.back() += 1;
+                if ((int)m_radius == -1 ||
+                    (level < (int)m_radius && (!p.contextfilled() || currLvlIter->iseven()))) {
+                    extractUnseen(graph, *currLvlIter, search_tree[level + 1], miscs, extents);
+                    pmisc = ~0;
+                    if (!p.getMergePixel().empty()) {
+                        PixelRef mergePixel = p.getMergePixel();
+                        int &p2misc = miscs(mergePixel.y, mergePixel.x);
+                        if (p2misc != ~0) {
+                            extractUnseen(graph, mergePixel, search_tree[level + 1], miscs, extents); // did say p.misc
+                            p2misc = ~0;
                         }
-                        comm->CommPostMessage(Communicator::CURRENT_RECORD, count);
                     }
+                } else {
+                    pmisc = ~0;
                 }
             }
+            search_tree[level].pop_back();
         }
+        level++;
     }
-    for (size_t i = 0; i < map.getCols(); i++) {
-        for (size_t j = 0; j < map.getRows(); j++) {
-            PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
-            map.getPoint(curs).m_misc = miscs(j, i);
-            map.getPoint(curs).m_extent = extents(j, i);
+
+    summariseRoot(total_depth, total_nodes, distribution, rootData);
+}
+
+void VGAVisualGlobal::analyseBatch(const VisibilityGraph &graph, const std::vector<PixelRef> &roots,
+                                   const std::vector<size_t> &batch, const std::vector<unsigned char> &cellFlags,
+                                   PixelRef windowFirst, size_t rows, BatchData &batchData,
+                                   std::vector<RootData> &rootData) {
+    std::vector<uint64_t> &seen = batchData.seen;
+    std::vector<uint64_t> &visit = batchData.visit;
+    std::vector<uint64_t> &visitNext = batchData.visitNext;
+    std::vector<size_t> &frontier = batchData.frontier;
+    std::vector<size_t> &next = batchData.next;
+    std::vector<size_t> &touched = batchData.touched;
+
+    // root i of the batch is bit i of the masks
+    std::vector<int> total_depth(batch.size(), 0);
+    std::vector<int> total_nodes(batch.size(), 1);
+    std::vector<std::vector<int>> distributions(batch.size(), std::vector<int>(1, 1));
+    for (size_t i = 0; i < batch.size(); i++) {
+        PixelRef root = roots[batch[i]];
+        size_t cell =
+            static_cast<size_t>(root.x - windowFirst.x) * rows + static_cast<size_t>(root.y - windowFirst.y);
+        seen[cell] = visit[cell] = uint64_t(1) << i;
+        frontier.push_back(cell);
+        touched.push_back(cell);
+    }
+
+    int level = 0;
+    while (!frontier.empty() && ((int)m_radius == -1 || level < (int)m_radius)) {
+        // pass the roots at each frontier cell on to the cells it can see that they have not reached yet
+        for (size_t cell : frontier) {
+            uint64_t reaching = visit[cell];
+            visit[cell] = 0;
+            if (!(cellFlags[cell] & CELL_EXPANDS)) {
+                continue;
+            }
+            PixelRef from(static_cast<short>(windowFirst.x + cell / rows),
+                          static_cast<short>(windowFirst.y + cell % rows));
+            for (const VisibilityGraph::BinRuns &bin : graph.bins(from)) {
+                for (const PixelVec &pixVec : graph.runs(bin)) {
+                    for (PixelRef pix = pixVec.start(); pix.col(bin.dir) <= pixVec.end().col(bin.dir);
+                         pix.move(bin.dir)) {
+                        size_t to = static_cast<size_t>(pix.x - windowFirst.x) * rows +
+                                    static_cast<size_t>(pix.y - windowFirst.y);
+                        // n.b. unfilled cells may appear in the diagonals, and are not part of the graph
+                        if (!(cellFlags[to] & CELL_FILLED)) {
+                            continue;
+                        }
+                        uint64_t reached = reaching & ~seen[to];
+                        if (reached) {
+                            if (!visitNext[to]) {
+                                next.push_back(to);
+                            }
+                            visitNext[to] |= reached;
+                        }
+                    }
+                }
+            }
         }
+        frontier.clear();
+        level++;
+
+        for (size_t cell : next) {
+            uint64_t reached = visitNext[cell];
+            visitNext[cell] = 0;
+            if (!seen[cell]) {
+                touched.push_back(cell);
+            }
+            seen[cell] |= reached;
+            visit[cell] = reached;
+            frontier.push_back(cell);
+            for (size_t i = 0; reached; i++, reached >>= 1) {
+                if (reached & 1) {
+                    total_depth[i] += level;
+                    total_nodes[i] += 1;
+                    std::vector<int> &distribution = distributions[i];
+                    if (distribution.size() <= static_cast<size_t>(level)) {
+                        distribution.resize(static_cast<size_t>(level) + 1, 0);
+                    }
+                    distribution[static_cast<size_t>(level)] += 1;
+                }
+            }
+        }
+        next.clear();
     }
-    map.setDisplayedAttribute(integ_dv_col);
 
-    return true;
+    // leave the masks clear for the next batch
+    for (size_t cell : frontier) {
+        visit[cell] = 0;
+    }
+    frontier.clear();
+    for (size_t cell : touched) {
+        seen[cell] = 0;
+    }
+    touched.clear();
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        summariseRoot(total_depth[i], total_nodes[i], distributions[i], rootData[batch[i]]);
+    }
+}
+
+void VGAVisualGlobal::summariseRoot(int total_depth, int total_nodes, const std::vector<int> &distribution,
+                                    RootData &rootData) {
+    rootData.analysed = true;
+    rootData.total_depth = total_depth;
+    rootData.total_nodes = total_nodes;
+    if (total_nodes > 1) {
+        double mean_depth = double(total_depth) / double(total_nodes - 1);
+        double entropy = 0.0, rel_entropy = 0.0, factorial = 1.0;
+        // n.b., this distribution contains the root node itself in distribution[0]
+        // -> chopped from entropy to avoid divide by zero if only one node
+        for (size_t k = 1; k < distribution.size(); k++) {
+            if (distribution[k] > 0) {
+                double prob = double(distribution[k]) / double(total_nodes - 1);
+                entropy -= prob * log2(prob);
+                // Formula from Turner 2001, "Depthmap"
+                factorial *= double(k + 1);
+                double q = (pow(mean_depth, double(k)) / double(factorial)) * exp(-mean_depth);
+                rel_entropy += (float)prob * log2(prob / q);
+            }
+        }
+        rootData.entropy = entropy;
+        rootData.rel_entropy = rel_entropy;
+    }
 }
 
-void VGAVisualGlobal::extractUnseen(Node &node, PixelRefVector &pixels, depthmapX::RowMatrix<int> &miscs,
-                                    depthmapX::RowMatrix<PixelRef> &extents) {
-    for (int i = 0; i < 32; i++) {
-        Bin &bin = node.bin(i);
-        for (auto pixVec : bin.m_pixel_vecs) {
-            for (PixelRef pix = pixVec.start(); pix.col(bin.m_dir) <= pixVec.end().col(bin.m_dir);) {
+void VGAVisualGlobal::extractUnseen(const VisibilityGraph &graph, PixelRef from, PixelRefVector &pixels,
+                                    depthmapX::EpochMatrix<int> &miscs, depthmapX::EpochMatrix<PixelRef> &extents) {
+    for (const VisibilityGraph::BinRuns &bin : graph.bins(from)) {
+        for (const PixelVec &pixVec : graph.runs(bin)) {
+            for (PixelRef pix = pixVec.start(); pix.col(bin.dir) <= pixVec.end().col(bin.dir);) {
                 int &misc = miscs(pix.y, pix.x);
-                PixelRef &extent = extents(pix.y, pix.x);
+                // a cell's extent starts out as the cell itself
+                PixelRef &extent = extents.get(pix.y, pix.x, pix);
                 if (misc == 0) {
                     pixels.push_back(pix);
-                    misc |= (1 << i);
+                    misc |= (1 << bin.bin);
                 }
                 // 10.2.02 revised --- diagonal was breaking this as it was extent in diagonal or horizontal
-                if (!(bin.m_dir & PixelRef::DIAGONAL)) {
-                    if (extent.col(bin.m_dir) >= pixVec.end().col(bin.m_dir))
+                if (!(bin.dir & PixelRef::DIAGONAL)) {
+                    if (extent.col(bin.dir) >= pixVec.end().col(bin.dir))
                         break;
-                    extent.col(bin.m_dir) = pixVec.end().col(bin.m_dir);
+                    extent.col(bin.dir) = pixVec.end().col(bin.dir);
                 }
-                pix.move(bin.m_dir);
+                pix.move(bin.dir);
             }
         }
     }
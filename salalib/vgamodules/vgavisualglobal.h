@@ -21,18 +21,68 @@
 #include "salalib/ivga.h"
 #include "salalib/pixelref.h"
 #include "salalib/pointdata.h"
+#include "salalib/visibilitygraph.h"
+#include "salalib/vgamodules/vgatiles.h"
 
-#include "genlib/simplematrix.h"
+#include "genlib/epochmatrix.h"
+
+#include <cstdint>
+#include <vector>
 
 class VGAVisualGlobal : IVGA {
   private:
     double m_radius;
     bool m_gates_only;
+    int m_num_threads;
+    int m_tile_size;
+
+    // the per-root results, kept until all roots are done and then written to the attribute table
+    struct RootData {
+        bool analysed = false;
+        int total_depth = 0;
+        int total_nodes = 0;
+        double entropy = 0.0;
+        double rel_entropy = 0.0;
+    };
+
+    // the per-thread traversal state, cleared in constant time for every root
+    struct ThreadData {
+        ThreadData(size_t rows, size_t cols) : miscs(rows, cols, 0), extents(rows, cols) {}
+        depthmapX::EpochMatrix<int> miscs;
+        depthmapX::EpochMatrix<PixelRef> extents;
+    };
+
+    // the per-thread state of the multi-source search, holding one bit per root of the batch for every cell
+    struct BatchData {
+        explicit BatchData(size_t cells) : seen(cells, 0), visit(cells, 0), visitNext(cells, 0) {}
+        std::vector<uint64_t> seen;      // the roots that have reached each cell
+        std::vector<uint64_t> visit;     // the roots that reached each cell of the frontier at this level
+        std::vector<uint64_t> visitNext; // the roots reaching each cell of the next level
+        std::vector<size_t> frontier;
+        std::vector<size_t> next;
+        std::vector<size_t> touched; // all the cells with a seen bit set, to reset after the batch
+    };
+
+    // the number of roots searched together in the multi-source search
+    static const size_t BATCH_SIZE = 64;
+    enum : unsigned char { CELL_FILLED = 1, CELL_EXPANDS = 2 };
+
+    void analyseRoot(PointMap &map, const VisibilityGraph &graph, PixelRef curs, ThreadData &threadData,
+                     RootData &rootData);
+    // the cells of cellFlags and of the batch data are those of a window of the grid, from windowFirst
+    // and with the given number of rows
+    void analyseBatch(const VisibilityGraph &graph, const std::vector<PixelRef> &roots,
+                      const std::vector<size_t> &batch, const std::vector<unsigned char> &cellFlags,
+                      PixelRef windowFirst, size_t rows, BatchData &batchData, std::vector<RootData> &rootData);
+    static void summariseRoot(int total_depth, int total_nodes, const std::vector<int> &distribution,
+                              RootData &rootData);
 
   public:
     std::string getAnalysisName() const override { return "Global Visibility Analysis"; }
     bool run(Communicator *comm, PointMap &map, bool simple_version) override;
-    void extractUnseen(Node &node, PixelRefVector &pixels, depthmapX::RowMatrix<int> &miscs,
-                       depthmapX::RowMatrix<PixelRef> &extents);
-    VGAVisualGlobal(double radius, bool gates_only) : m_radius(radius), m_gates_only(gates_only) {}
+    void extractUnseen(const VisibilityGraph &graph, PixelRef from, PixelRefVector &pixels,
+                       depthmapX::EpochMatrix<int> &miscs, depthmapX::EpochMatrix<PixelRef> &extents);
+    // with a radius the map may be analysed in tiles of tile_size by tile_size roots, see VGATiles
+    VGAVisualGlobal(double radius, bool gates_only, int num_threads = 1, int tile_size = VGATiles::DEFAULT_TILE_SIZE)
+        : m_radius(radius), m_gates_only(gates_only), m_num_threads(num_threads), m_tile_size(tile_size) {}
 };
@@ -27,11 +27,9 @@ bool VGAVisualGlobalDepth::run(Communicator *, PointMap &map, bool) {
     // n.b., insert columns sets values to -1 if the column already exists
     int col = attributes.insertOrResetColumn("Visual Step Depth");
 
-    for (auto iter = attributes.begin(); iter != attributes.end(); iter++) {
-        PixelRef pix = iter->getKey().value;
-        map.getPoint(pix).m_misc = 0;
-        map.getPoint(pix).m_extent = pix;
-    }
+    depthmapX::EpochMatrix<int> miscs(map.getRows(), map.getCols(), 0);
+    depthmapX::EpochMatrix<PixelRef> extents(map.getRows(), map.getCols());
+    const VisibilityGraph &graph = map.getVisibilityGraph();
 
     std::vector<PixelRefVector> search_tree;
     search_tree.push_back(PixelRefVector());
@@ -45,24 +43,26 @@ bool VGAVisualGlobalDepth::run(Communicator *, PointMap &map, bool) {
         search_tree.push_back(PixelRefVector());
         const PixelRefVector& searchTreeAtLevel = search_tree[level];
         for (auto currLvlIter = searchTreeAtLevel.rbegin(); currLvlIter != searchTreeAtLevel.rend(); currLvlIter++) {
+            int &pmisc = miscs(currLvlIter->y, currLvlIter->x);
             Point &p = map.getPoint(*currLvlIter);
-            if (p.filled() && p.m_misc != ~0) {
+            if (p.filled() && pmisc != ~0) {
                 AttributeRow &row = attributes.getRow(AttributeKey(*currLvlIter));
                 row.setValue(col, float(level));
                 if (!p.contextfilled() || currLvlIter->iseven() || level == 0) {
-                    p.getNode().extractUnseen(search_tree[level + 1], &map);
-                    p.m_misc = ~0;
+                    extractUnseen(graph, *currLvlIter, search_tree[level + 1], miscs, extents);
+                    pmisc = ~0;
                     if (!p.getMergePixel().empty()) {
-                        Point &p2 = map.getPoint(p.getMergePixel());
-                        if (p2.m_misc != ~0) {
-                            AttributeRow &mergePixelRow = attributes.getRow(AttributeKey(p.getMergePixel()));
+                        PixelRef mergePixel = p.getMergePixel();
+                        int &p2misc = miscs(mergePixel.y, mergePixel.x);
+                        if (p2misc != ~0) {
+                            AttributeRow &mergePixelRow = attributes.getRow(AttributeKey(mergePixel));
                             mergePixelRow.setValue(col, float(level));
-                            p2.getNode().extractUnseen(search_tree[level + 1], &map); // did say p.misc
-                            p2.m_misc = ~0;
+                            extractUnseen(graph, mergePixel, search_tree[level + 1], miscs, extents); // did say p.misc
+                            p2misc = ~0;
                         }
                     }
                 } else {
-                    p.m_misc = ~0;
+                    pmisc = ~0;
                 }
             }
         }
@@ -76,25 +76,25 @@ bool VGAVisualGlobalDepth::run(Communicator *, PointMap &map, bool) {
     return true;
 }
 
-void VGAVisualGlobalDepth::extractUnseen(Node &node, PixelRefVector &pixels, depthmapX::RowMatrix<int> &miscs,
-                   depthmapX::RowMatrix<PixelRef> &extents) {
-    for (int i = 0; i < 32; i++) {
-        Bin &bin = node.bin(i);
-        for (auto pixVec : bin.m_pixel_vecs) {
-            for (PixelRef pix = pixVec.start(); pix.col(bin.m_dir) <= pixVec.end().col(bin.m_dir);) {
+void VGAVisualGlobalDepth::extractUnseen(const VisibilityGraph &graph, PixelRef from, PixelRefVector &pixels,
+                                         depthmapX::EpochMatrix<int> &miscs,
+                                         depthmapX::EpochMatrix<PixelRef> &extents) {
+    for (const VisibilityGraph::BinRuns &bin : graph.bins(from)) {
+        for (const PixelVec &pixVec : graph.runs(bin)) {
+            for (PixelRef pix = pixVec.start(); pix.col(bin.dir) <= pixVec.end().col(bin.dir);) {
                 int &misc = miscs(pix.y, pix.x);
-                PixelRef &extent = extents(pix.y, pix.x);
+                PixelRef &extent = extents.get(pix.y, pix.x, pix);
                 if (misc == 0) {
                     pixels.push_back(pix);
-                    misc |= (1 << i);
+                    misc |= (1 << bin.bin);
                 }
                 // 10.2.02 revised --- diagonal was breaking this as it was extent in diagonal or horizontal
-                if (!(bin.m_dir & PixelRef::DIAGONAL)) {
-                    if (extent.col(bin.m_dir) >= pixVec.end().col(bin.m_dir))
+                if (!(bin.dir & PixelRef::DIAGONAL)) {
+                    if (extent.col(bin.dir) >= pixVec.end().col(bin.dir))
                         break;
-                    extent.col(bin.m_dir) = pixVec.end().col(bin.m_dir);
+                    extent.col(bin.dir) = pixVec.end().col(bin.dir);
                 }
-                pix.move(bin.m_dir);
+                pix.move(bin.dir);
             }
         }
     }
@@ -21,13 +21,14 @@
 #include "salalib/ivga.h"
 #include "salalib/pixelref.h"
 #include "salalib/pointdata.h"
+#include "salalib/visibilitygraph.h"
 
-#include "genlib/simplematrix.h"
+#include "genlib/epochmatrix.h"
 
 class VGAVisualGlobalDepth : IVGA {
   public:
     std::string getAnalysisName() const override { return "Global Visibility Depth"; }
     bool run(Communicator *comm, PointMap &map, bool simple_version) override;
-    void extractUnseen(Node &node, PixelRefVector &pixels, depthmapX::RowMatrix<int> &miscs,
-                       depthmapX::RowMatrix<PixelRef> &extents);
+    void extractUnseen(const VisibilityGraph &graph, PixelRef from, PixelRefVector &pixels,
+                       depthmapX::EpochMatrix<int> &miscs, depthmapX::EpochMatrix<PixelRef> &extents);
 };
@@ -18,6 +18,7 @@
 
 #include "salalib/vgamodules/vgavisuallocal.h"
 
+#include "genlib/epochmatrix.h"
 #include "genlib/stringutils.h"
 
 bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version) {
@@ -34,8 +35,16 @@ bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version)
         controllability_col = map.getAttributeTable().insertOrResetColumn("Visual Controllability");
     }
 
+    AttributeTable &attributes = map.getAttributeTable();
+    AttributeBulkWriter writer(attributes);
+
     int count = 0;
 
+    const VisibilityGraph &graph = map.getVisibilityGraph();
+    // marks the pixels seen from any of the neighbours of the current root
+    depthmapX::EpochMatrix<bool> seen(map.getRows(), map.getCols(), false);
+    PixelRefVector retro;
+
     for (size_t i = 0; i < map.getCols(); i++) {
         for (size_t j = 0; j < map.getRows(); j++) {
             PixelRef curs = PixelRef(static_cast<short>(i), static_cast<short>(j));
@@ -44,16 +53,19 @@ bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version)
                     count++;
                     continue;
                 }
-                AttributeRow &row = map.getAttributeTable().getRow(AttributeKey(curs));
+                size_t row = attributes.getRowIndex(AttributeKey(curs));
 
                 // This is much easier to do with a straight forward list:
                 PixelRefVector neighbourhood;
-                PixelRefVector totalneighbourhood;
-                map.getPoint(curs).getNode().contents(neighbourhood);
+                graph.contents(curs, neighbourhood);
 
                 // only required to match previous non-stl output. Without this
                 // the output differs by the last digit of the float
                 std::sort(neighbourhood.begin(), neighbourhood.end());
+                neighbourhood.erase(std::unique(neighbourhood.begin(), neighbourhood.end()), neighbourhood.end());
+
+                seen.clear();
+                size_t totalneighbourhood_size = 0;
 
                 int cluster = 0;
                 float control = 0.0f;
@@ -62,19 +74,18 @@ bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version)
                     int intersect_size = 0, retro_size = 0;
                     Point &retpt = map.getPoint(neighbourhood[i]);
                     if (retpt.filled() && retpt.hasNode()) {
-                        retpt.getNode().first();
-                        while (!retpt.getNode().is_tail()) {
+                        retro.clear();
+                        graph.contents(neighbourhood[i], retro);
+                        for (PixelRef retpix : retro) {
                             retro_size++;
-                            if (std::find(neighbourhood.begin(), neighbourhood.end(), retpt.getNode().cursor()) !=
-                                neighbourhood.end()) {
+                            if (std::binary_search(neighbourhood.begin(), neighbourhood.end(), retpix)) {
                                 intersect_size++;
                             }
-                            if (std::find(totalneighbourhood.begin(), totalneighbourhood.end(),
-                                          retpt.getNode().cursor()) == totalneighbourhood.end()) {
-                                totalneighbourhood.push_back(
-                                    retpt.getNode().cursor()); // <- note add does nothing if member already exists
+                            bool &retpixSeen = seen(retpix.y, retpix.x);
+                            if (!retpixSeen) {
+                                retpixSeen = true;
+                                totalneighbourhood_size++;
                             }
-                            retpt.getNode().next();
                         }
                         control += 1.0f / float(retro_size);
                         cluster += intersect_size;
@@ -83,15 +94,15 @@ bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version)
 #ifndef _COMPILE_dX_SIMPLE_VERSION
                 if (!simple_version) {
                     if (neighbourhood.size() > 1) {
-                        row.setValue(cluster_col,
-                                     float(cluster / double(neighbourhood.size() * (neighbourhood.size() - 1.0))));
-                        row.setValue(control_col, float(control));
-                        row.setValue(controllability_col,
-                                     float(double(neighbourhood.size()) / double(totalneighbourhood.size())));
+                        writer.value(row, cluster_col) =
+                            float(cluster / double(neighbourhood.size() * (neighbourhood.size() - 1.0)));
+                        writer.value(row, control_col) = float(control);
+                        writer.value(row, controllability_col) =
+                            float(double(neighbourhood.size()) / double(totalneighbourhood_size));
                     } else {
-                        row.setValue(cluster_col, -1);
-                        row.setValue(control_col, -1);
-                        row.setValue(controllability_col, -1);
+                        writer.value(row, cluster_col) = -1;
+                        writer.value(row, control_col) = -1;
+                        writer.value(row, controllability_col) = -1;
                     }
                 }
 #endif
@@ -108,6 +119,8 @@ bool VGAVisualLocal::run(Communicator *comm, PointMap &map, bool simple_version)
         }
     }
 
+    writer.commit();
+
 #ifndef _COMPILE_dX_SIMPLE_VERSION
     if (!simple_version)
         map.setDisplayedAttribute(cluster_col);
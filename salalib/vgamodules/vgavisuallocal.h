@@ -21,6 +21,7 @@
 #include "salalib/ivga.h"
 #include "salalib/pixelref.h"
 #include "salalib/pointdata.h"
+#include "salalib/visibilitygraph.h"
 
 class VGAVisualLocal : IVGA {
   private:
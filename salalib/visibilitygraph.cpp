@@ -0,0 +1,97 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "salalib/visibilitygraph.h"
+
+#include "salalib/pointdata.h"
+
+void VisibilityGraph::build(PointMap &map) {
+    build(map, PixelRef(0, 0),
+          PixelRef(static_cast<short>(map.getCols() - 1), static_cast<short>(map.getRows() - 1)));
+}
+
+void VisibilityGraph::build(PointMap &map, PixelRef first, PixelRef last) {
+    clear();
+    m_first = first;
+    m_rows = static_cast<size_t>(last.y - first.y + 1);
+    size_t cols = static_cast<size_t>(last.x - first.x + 1);
+
+    // count first so that the arrays are allocated only once and at their exact size
+    size_t bin_count = 0, run_count = 0;
+    for (short i = first.x; i <= last.x; i++) {
+        for (short j = first.y; j <= last.y; j++) {
+            Point &point = map.getPoint(PixelRef(i, j));
+            if (point.hasNode()) {
+                for (int b = 0; b < 32; b++) {
+                    const Bin &bin = point.getNode().bin(b);
+                    if (!bin.m_pixel_vecs.empty()) {
+                        bin_count++;
+                        run_count += bin.m_pixel_vecs.size();
+                    }
+                }
+            }
+        }
+    }
+    m_cell_offsets.reserve(cols * m_rows + 1);
+    m_bins.reserve(bin_count + 1);
+    m_runs.reserve(run_count);
+
+    for (short i = first.x; i <= last.x; i++) {
+        for (short j = first.y; j <= last.y; j++) {
+            m_cell_offsets.push_back(static_cast<unsigned int>(m_bins.size()));
+            Point &point = map.getPoint(PixelRef(i, j));
+            if (point.hasNode()) {
+                for (int b = 0; b < 32; b++) {
+                    const Bin &bin = point.getNode().bin(b);
+                    if (!bin.m_pixel_vecs.empty()) {
+                        m_bins.push_back(BinRuns{static_cast<unsigned int>(m_runs.size()), static_cast<char>(b),
+                                                 bin.m_dir});
+                        m_runs.insert(m_runs.end(), bin.m_pixel_vecs.begin(), bin.m_pixel_vecs.end());
+                    }
+                }
+            }
+        }
+    }
+    m_cell_offsets.push_back(static_cast<unsigned int>(m_bins.size()));
+    m_bins.push_back(BinRuns{static_cast<unsigned int>(m_runs.size()), 0, PixelRef::NODIR});
+
+    m_built = true;
+}
+
+void VisibilityGraph::clear() {
+    m_built = false;
+    m_first = PixelRef(0, 0);
+    m_rows = 0;
+    // swap to actually release the memory
+    std::vector<unsigned int>().swap(m_cell_offsets);
+    std::vector<BinRuns>().swap(m_bins);
+    std::vector<PixelVec>().swap(m_runs);
+}
+
+void VisibilityGraph::contents(PixelRef pix, PixelRefVector &pixels) const {
+    for (const BinRuns &bin : bins(pix)) {
+        for (const PixelVec &run : runs(bin)) {
+            for (PixelRef curs = run.start(); curs.col(bin.dir) <= run.end().col(bin.dir); curs.move(bin.dir)) {
+                pixels.push_back(curs);
+            }
+        }
+    }
+}
+
+size_t VisibilityGraph::getMemoryUsage() const {
+    return sizeof(VisibilityGraph) + m_cell_offsets.capacity() * sizeof(unsigned int) +
+           m_bins.capacity() * sizeof(BinRuns) + m_runs.capacity() * sizeof(PixelVec);
+}
@@ -0,0 +1,108 @@
+// sala - a component of the depthmapX - spatial network analysis platform
+// Copyright (C) 2026 depthmapX contributors
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "salalib/ngraph.h"
+#include "salalib/pixelref.h"
+
+#include <vector>
+
+class PointMap;
+
+/**
+ * Compact (compressed sparse row) form of the visibility graph of a PointMap, for the analyses that only
+ * need to know which pixels each pixel can see.
+ *
+ * The runs of every Bin of every Node are packed into a single array, in pixel and then bin order, and
+ * only the non-empty bins are recorded, each with the position of its first run. Looking up a pixel is a
+ * single offset into the bin array, and a traversal walks through contiguous memory instead of chasing
+ * the per-bin vectors of the Nodes. The Nodes themselves are left as they are, as they also hold
+ * information used elsewhere (bin distances, occlusions, iterators), so the packed graph is a copy of the
+ * runs held in addition to them. The PointMap only makes it when an analysis asks for it, and the analysis
+ * lets go of it again once done, so the extra memory is only taken while an analysis runs.
+ */
+class VisibilityGraph {
+  public:
+    // the runs of one bin of a pixel
+    struct BinRuns {
+        unsigned int firstRun; // index of the first run of the bin
+        char bin;              // the index of the bin in the Node, 0 to 31
+        char dir;              // the direction of the runs, as in Bin::m_dir
+    };
+
+    template <typename T> class Range {
+      public:
+        Range(const T *first, const T *last) : m_first(first), m_last(last) {}
+        const T *begin() const { return m_first; }
+        const T *end() const { return m_last; }
+        size_t size() const { return static_cast<size_t>(m_last - m_first); }
+
+      private:
+        const T *m_first;
+        const T *m_last;
+    };
+
+    /**
+     * @brief Pack the Nodes of all the points of the map. Any previous contents are discarded
+     */
+    void build(PointMap &map);
+    /**
+     * @brief Pack only the Nodes of the points in a rectangle of the map, from first to last inclusive, for the
+     * analyses that work on one part of the map at a time. Only the pixels in the rectangle may be looked up
+     */
+    void build(PointMap &map, PixelRef first, PixelRef last);
+    void clear();
+    bool isBuilt() const { return m_built; }
+
+    /**
+     * @brief The non-empty bins of a pixel, in bin order. The pixel is not range checked
+     */
+    Range<BinRuns> bins(PixelRef pix) const {
+        size_t cell = static_cast<size_t>(pix.x - m_first.x) * m_rows + static_cast<size_t>(pix.y - m_first.y);
+        return Range<BinRuns>(m_bins.data() + m_cell_offsets[cell], m_bins.data() + m_cell_offsets[cell + 1]);
+    }
+
+    /**
+     * @brief The runs of a bin, which must be one of the bins returned by bins()
+     */
+    Range<PixelVec> runs(const BinRuns &bin) const {
+        // n.b. there is always a sentinel after the last bin, so the next bin exists
+        return Range<PixelVec>(m_runs.data() + bin.firstRun, m_runs.data() + (&bin + 1)->firstRun);
+    }
+
+    /**
+     * @brief Add all the pixels visible from a pixel to a vector, in the order Node::first() / Node::next()
+     * visit them
+     */
+    void contents(PixelRef pix, PixelRefVector &pixels) const;
+
+    /**
+     * @brief Memory taken by the packed graph in bytes
+     */
+    size_t getMemoryUsage() const;
+
+  private:
+    bool m_built = false;
+    PixelRef m_first = PixelRef(0, 0); // the first pixel of the rectangle packed
+    size_t m_rows = 0;
+    // for each cell, in the same (column) order as the points of the PointMap, the index of its first bin
+    // in m_bins, followed by one past the last bin of the last cell
+    std::vector<unsigned int> m_cell_offsets;
+    // all the non-empty bins, followed by a sentinel holding the end of the last bin's runs
+    std::vector<BinRuns> m_bins;
+    std::vector<PixelVec> m_runs;
+};